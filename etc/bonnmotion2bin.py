@@ -0,0 +1,62 @@
+#!/usr/bin/env python
+
+#
+# bonnmotion2bin.py -- converts a BonnMotion trace file into the binary
+# format read by BonnMotionMobility
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+
+"""
+Usage: bonnmotion2bin.py <input.movements> <output.bin>
+
+The binary file contains the same numbers as the text file, so it can be
+used as the traceFile parameter of BonnMotionMobility instead of the text
+file; it is read without parsing. It is written in the byte order of the
+machine running this script, which must be that of the simulation.
+
+Layout (see BonnMotionFileCache.h):
+    char magic[8]                   "BMTRACE\\0"
+    uint32 byteOrderMagic           0x1A2B3C4D
+    uint32 numLines
+    uint64 lineStart[numLines + 1]  index of the first value of each line
+    double values[]
+"""
+
+import array
+import struct
+import sys
+
+
+def convert(inputName, outputName):
+    values = array.array('d')
+    starts = []
+    with open(inputName, 'r') as f:
+        for line in f:
+            starts.append(len(values))
+            for token in line.split():
+                try:
+                    values.append(float(token))
+                except ValueError:
+                    break   # like the text reader: a line ends at the first non-number
+    starts.append(len(values))
+
+    with open(outputName, 'wb') as f:
+        f.write(struct.pack('=8sII', b'BMTRACE\0', 0x1A2B3C4D, len(starts) - 1))
+        f.write(struct.pack('=%dQ' % len(starts), *starts))
+        values.tofile(f)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.stderr.write(__doc__)
+        sys.exit(1)
+    convert(sys.argv[1], sys.argv[2])
@@ -0,0 +1,358 @@
+#!/usr/bin/env python
+
+#
+# traci-mockserver.py -- minimal TraCI server for testing and benchmarking TraCI clients
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+Accepts a single TraCI connection and answers the commands used by
+TraCIScenarioManager, without running SUMO: vehicles depart at a fixed
+rate until the requested number is driving, drive along a straight road
+at constant speed, and arrive after a fixed number of steps. Set commands
+are acknowledged and otherwise ignored.
+
+When the client disconnects, the number of time steps, messages and
+commands is printed together with the steps per second, so the cost of
+a TraCI client's synchronisation can be measured without SUMO's own.
+"""
+
+from __future__ import print_function
+
+import socket
+import struct
+import sys
+import time
+from optparse import OptionParser
+
+CMD_GETVERSION = 0x00
+CMD_SIMSTEP2 = 0x02
+CMD_CLOSE = 0x7F
+CMD_GET_VEHICLE_VARIABLE = 0xa4
+RESPONSE_GET_VEHICLE_VARIABLE = 0xb4
+CMD_GET_SIM_VARIABLE = 0xab
+RESPONSE_GET_SIM_VARIABLE = 0xbb
+CMD_SET_TL_VARIABLE = 0xc2
+CMD_SET_VEHICLE_VARIABLE = 0xc4
+CMD_SET_POLYGON_VARIABLE = 0xc8
+CMD_SUBSCRIBE_VEHICLE_VARIABLE = 0xd4
+RESPONSE_SUBSCRIBE_VEHICLE_VARIABLE = 0xe4
+CMD_SUBSCRIBE_SIM_VARIABLE = 0xdb
+RESPONSE_SUBSCRIBE_SIM_VARIABLE = 0xeb
+
+POSITION_2D = 0x01
+TYPE_BOUNDINGBOX = 0x05
+TYPE_INTEGER = 0x09
+TYPE_DOUBLE = 0x0B
+TYPE_STRING = 0x0C
+TYPE_STRINGLIST = 0x0E
+
+RTYPE_OK = 0x00
+RTYPE_NOTIMPLEMENTED = 0x01
+RTYPE_ERR = 0xFF
+
+ID_LIST = 0x00
+VAR_SPEED = 0x40
+VAR_POSITION = 0x42
+VAR_ANGLE = 0x43
+VAR_ROAD_ID = 0x50
+VAR_LANE_ID = 0x51
+VAR_LANEPOSITION = 0x56
+VAR_SIGNALS = 0x5b
+VAR_TIME_STEP = 0x70
+VAR_DEPARTED_VEHICLES_IDS = 0x74
+VAR_ARRIVED_VEHICLES_IDS = 0x7a
+VAR_NET_BOUNDING_BOX = 0x7c
+
+API_VERSION = 3
+ROAD_LENGTH = 5000.0
+ROAD_SPACING = 10.0
+NUM_ROADS = 100
+
+
+def pack_string(s):
+    s = s.encode("ascii")
+    return struct.pack("!i", len(s)) + s
+
+
+def pack_stringlist(l):
+    return struct.pack("!Bi", TYPE_STRINGLIST, len(l)) + b"".join(pack_string(s) for s in l)
+
+
+def pack_command(commandId, payload, extended=False):
+    if extended or len(payload) + 2 > 0xFF:
+        return struct.pack("!BiB", 0, len(payload) + 6, commandId) + payload
+    return struct.pack("!BB", len(payload) + 2, commandId) + payload
+
+
+def pack_status(commandId, result=RTYPE_OK, description=""):
+    return pack_command(commandId, struct.pack("!B", result) + pack_string(description))
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def read(self, fmt):
+        values = struct.unpack_from("!" + fmt, self.data, self.pos)
+        self.pos += struct.calcsize("!" + fmt)
+        return values if len(values) > 1 else values[0]
+
+    def read_string(self):
+        length = self.read("i")
+        s = self.data[self.pos:self.pos + length].decode("ascii")
+        self.pos += length
+        return s
+
+    def eof(self):
+        return self.pos >= len(self.data)
+
+
+class Vehicle:
+    def __init__(self, vehicleId, index, departStep, speed):
+        self.id = vehicleId
+        self.road = index % NUM_ROADS
+        self.departStep = departStep
+        self.speed = speed
+        self.lanePosition = 0.0
+        self.roadId = struct.pack("!B", TYPE_STRING) + pack_string("road%d" % self.road)
+        self.laneId = struct.pack("!B", TYPE_STRING) + pack_string("road%d_0" % self.road)
+
+    def variable(self, variableId):
+        if variableId == VAR_POSITION:
+            return struct.pack("!Bdd", POSITION_2D, 100 + self.lanePosition, 100 + ROAD_SPACING * self.road)
+        if variableId == VAR_ROAD_ID:
+            return self.roadId
+        if variableId == VAR_LANE_ID:
+            return self.laneId
+        if variableId == VAR_SPEED:
+            return struct.pack("!Bd", TYPE_DOUBLE, self.speed)
+        if variableId == VAR_ANGLE:
+            return struct.pack("!Bd", TYPE_DOUBLE, 90.0)
+        if variableId == VAR_LANEPOSITION:
+            return struct.pack("!Bd", TYPE_DOUBLE, self.lanePosition)
+        if variableId == VAR_SIGNALS:
+            return struct.pack("!Bi", TYPE_INTEGER, 0)
+        return None
+
+
+class MockServer:
+    def __init__(self, options):
+        self.options = options
+        self.vehicles = {}
+        self.nextVehicleIndex = 0
+        self.departed = []
+        self.arrived = []
+        self.timeMs = 0
+        self.simSubscription = None
+        self.vehicleSubscriptions = {}  # vehicle id -> list of variables, in subscription order
+        self.subscriptionOrder = []
+        self.steps = 0
+        self.messages = 0
+        self.commands = 0
+        self.firstStepTime = None
+
+    # simulation
+
+    def step(self, targetTimeMs):
+        stepLength = self.options.stepLength
+        self.departed = []
+        self.arrived = []
+        while self.timeMs + stepLength <= targetTimeMs:
+            self.timeMs += stepLength
+            step = self.timeMs // stepLength
+            for vehicle in list(self.vehicles.values()):
+                vehicle.lanePosition = (vehicle.lanePosition + vehicle.speed * stepLength / 1000.0) % ROAD_LENGTH
+                if step - vehicle.departStep >= self.options.lifetime:
+                    del self.vehicles[vehicle.id]
+                    self.arrived.append(vehicle.id)
+            for i in range(self.options.departRate):
+                if len(self.vehicles) >= self.options.vehicles:
+                    break
+                vehicleId = "veh%d" % self.nextVehicleIndex
+                self.vehicles[vehicleId] = Vehicle(vehicleId, self.nextVehicleIndex, step, 10 + self.nextVehicleIndex % 20)
+                self.nextVehicleIndex += 1
+                self.departed.append(vehicleId)
+        for vehicleId in self.arrived:
+            if vehicleId in self.vehicleSubscriptions:
+                del self.vehicleSubscriptions[vehicleId]
+        self.timeMs = targetTimeMs
+
+    # subscription results
+
+    def sim_subscription_result(self, variables):
+        payload = pack_string("") + struct.pack("!B", len(variables))
+        for variableId in variables:
+            if variableId == VAR_DEPARTED_VEHICLES_IDS:
+                value = pack_stringlist(self.departed)
+            elif variableId == VAR_ARRIVED_VEHICLES_IDS:
+                value = pack_stringlist(self.arrived)
+            elif variableId == VAR_TIME_STEP:
+                value = struct.pack("!Bi", TYPE_INTEGER, self.timeMs)
+            else:
+                payload += struct.pack("!BB", variableId, RTYPE_ERR) + struct.pack("!B", TYPE_STRING) + pack_string("unsupported variable")
+                continue
+            payload += struct.pack("!BB", variableId, RTYPE_OK) + value
+        return pack_command(RESPONSE_SUBSCRIBE_SIM_VARIABLE, payload, True)
+
+    def vehicle_subscription_result(self, vehicleId, variables):
+        payload = [pack_string(vehicleId), struct.pack("!B", len(variables))]
+        vehicle = self.vehicles.get(vehicleId)
+        for variableId in variables:
+            if vehicleId == "" and variableId == ID_LIST:
+                value = pack_stringlist(sorted(self.vehicles.keys(), key=lambda v: int(v[3:])))
+            else:
+                value = vehicle.variable(variableId) if vehicle else None
+            if value is None:
+                payload.append(struct.pack("!BBB", variableId, RTYPE_ERR, TYPE_STRING) + pack_string("unsupported variable"))
+            else:
+                payload.append(struct.pack("!BB", variableId, RTYPE_OK))
+                payload.append(value)
+        return pack_command(RESPONSE_SUBSCRIBE_VEHICLE_VARIABLE, b"".join(payload), True)
+
+    def subscription_results(self):
+        results = []
+        if self.simSubscription is not None:
+            results.append(self.sim_subscription_result(self.simSubscription))
+        for vehicleId in self.subscriptionOrder:
+            if vehicleId in self.vehicleSubscriptions:
+                results.append(self.vehicle_subscription_result(vehicleId, self.vehicleSubscriptions[vehicleId]))
+        self.subscriptionOrder = [v for v in self.subscriptionOrder if v in self.vehicleSubscriptions]
+        return struct.pack("!i", len(results)) + b"".join(results)
+
+    # commands
+
+    def execute(self, commandId, r):
+        if commandId == CMD_GETVERSION:
+            return pack_status(commandId) + pack_command(CMD_GETVERSION, struct.pack("!i", API_VERSION) + pack_string("traci-mockserver"))
+
+        if commandId == CMD_SIMSTEP2:
+            targetTimeMs = r.read("i")
+            if self.firstStepTime is None:
+                self.firstStepTime = time.time()
+            self.step(targetTimeMs)
+            self.steps += 1
+            return pack_status(commandId) + self.subscription_results()
+
+        if commandId == CMD_GET_SIM_VARIABLE:
+            variableId = r.read("B")
+            objectId = r.read_string()
+            if variableId != VAR_NET_BOUNDING_BOX:
+                return pack_status(commandId, RTYPE_ERR, "unsupported variable")
+            bounds = struct.pack("!Bdddd", TYPE_BOUNDINGBOX, 0, 0, 200 + ROAD_LENGTH, 200 + ROAD_SPACING * NUM_ROADS)
+            return pack_status(commandId) + pack_command(RESPONSE_GET_SIM_VARIABLE, struct.pack("!B", variableId) + pack_string(objectId) + bounds)
+
+        if commandId == CMD_GET_VEHICLE_VARIABLE:
+            variableId = r.read("B")
+            objectId = r.read_string()
+            vehicle = self.vehicles.get(objectId)
+            value = vehicle.variable(variableId) if vehicle else None
+            if value is None:
+                return pack_status(commandId, RTYPE_ERR, "unknown vehicle or variable")
+            return pack_status(commandId) + pack_command(RESPONSE_GET_VEHICLE_VARIABLE, struct.pack("!B", variableId) + pack_string(objectId) + value)
+
+        if commandId in (CMD_SUBSCRIBE_SIM_VARIABLE, CMD_SUBSCRIBE_VEHICLE_VARIABLE):
+            beginTime, endTime = r.read("ii")
+            objectId = r.read_string()
+            variables = [r.read("B") for i in range(r.read("B"))]
+            if commandId == CMD_SUBSCRIBE_SIM_VARIABLE:
+                self.simSubscription = variables
+                return pack_status(commandId) + self.sim_subscription_result(variables)
+            if not variables:
+                self.vehicleSubscriptions.pop(objectId, None)
+                return pack_status(commandId)
+            if objectId != "" and objectId not in self.vehicles:
+                return pack_status(commandId, RTYPE_ERR, "unknown vehicle")
+            if objectId not in self.vehicleSubscriptions:
+                self.subscriptionOrder.append(objectId)
+            self.vehicleSubscriptions[objectId] = variables
+            return pack_status(commandId) + self.vehicle_subscription_result(objectId, variables)
+
+        if commandId in (CMD_SET_VEHICLE_VARIABLE, CMD_SET_TL_VARIABLE, CMD_SET_POLYGON_VARIABLE):
+            return pack_status(commandId)
+
+        if commandId == CMD_CLOSE:
+            return pack_status(commandId)
+
+        return pack_status(commandId, RTYPE_NOTIMPLEMENTED, "not implemented by traci-mockserver")
+
+    def handle_message(self, data):
+        self.messages += 1
+        r = Reader(data)
+        response = []
+        while not r.eof():
+            start = r.pos
+            length = r.read("B")
+            if length == 0:
+                length = r.read("i")
+            commandId = r.read("B")
+            self.commands += 1
+            response.append(self.execute(commandId, Reader(data[r.pos:start + length])))
+            r.pos = start + length
+        return b"".join(response)
+
+    def print_statistics(self):
+        elapsed = time.time() - self.firstStepTime if self.firstStepTime else 0
+        print("traci-mockserver: steps: %d, messages: %d (%.2f per step), commands: %d, vehicles departed: %d" %
+              (self.steps, self.messages, self.messages / float(max(self.steps, 1)), self.commands, self.nextVehicleIndex))
+        if elapsed > 0:
+            print("traci-mockserver: %.1f steps/s" % (self.steps / elapsed))
+
+
+def recv_exactly(conn, length):
+    data = b""
+    while len(data) < length:
+        chunk = conn.recv(length - len(data))
+        if not chunk:
+            return None
+        data += chunk
+    return data
+
+
+def main():
+    parser = OptionParser(description="Minimal TraCI server for testing and benchmarking TraCI clients")
+    parser.add_option("-p", "--port", dest="port", type="int", default=9999, help="listen for the client on PORT [default: %default]")
+    parser.add_option("-n", "--vehicles", dest="vehicles", type="int", default=100, help="number of vehicles driving at the same time [default: %default]")
+    parser.add_option("-r", "--depart-rate", dest="departRate", type="int", default=10, help="vehicles departing per time step [default: %default]")
+    parser.add_option("-l", "--lifetime", dest="lifetime", type="int", default=200, help="time steps until a vehicle arrives [default: %default]")
+    parser.add_option("-s", "--step-length", dest="stepLength", type="int", default=1000, help="length of a time step in ms [default: %default]")
+    (options, args) = parser.parse_args()
+
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(("127.0.0.1", options.port))
+    server.listen(1)
+    conn, addr = server.accept()
+    conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    server.close()
+
+    mock = MockServer(options)
+    while True:
+        header = recv_exactly(conn, 4)
+        if header is None:
+            break
+        length = struct.unpack("!i", header)[0]
+        data = recv_exactly(conn, length - 4)
+        if data is None:
+            break
+        response = mock.handle_message(data)
+        conn.sendall(struct.pack("!i", len(response) + 4) + response)
+    conn.close()
+    mock.print_statistics()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
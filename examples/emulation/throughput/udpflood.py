@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+#
+# usage: udpflood.py address port rate-pps duration-s [payload-bytes]
+#
+# Sends UDP packets at the given rate to an echo server, and prints the
+# achieved send rate, the rate of echoed packets and their round trip time.
+#
+
+import select
+import socket
+import struct
+import sys
+import time
+
+
+def main():
+    address, port = sys.argv[1], int(sys.argv[2])
+    rate, duration = float(sys.argv[3]), float(sys.argv[4])
+    payloadLength = int(sys.argv[5]) if len(sys.argv) > 5 else 64
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 22)
+    sock.setblocking(False)
+    padding = b'\0' * max(0, payloadLength - 16)
+
+    sent = received = 0
+    rttSum = 0.0
+    start = time.time()
+    end = start + duration
+    while True:
+        now = time.time()
+        if now >= end + 1.0:   # wait a second for late echoes
+            break
+        # send the packets that are due
+        while now < end and sent < (now - start) * rate:
+            try:
+                sock.sendto(struct.pack('!dQ', time.time(), sent) + padding, (address, port))
+                sent += 1
+            except BlockingIOError:
+                break
+        readable, _, _ = select.select([sock], [], [], 0.0005)
+        if readable:
+            while True:
+                try:
+                    data = sock.recv(65536)
+                except BlockingIOError:
+                    break
+                received += 1
+                rttSum += time.time() - struct.unpack('!d', data[:8])[0]
+
+    print("sent %d packets (%.0f packets/s), echoed %d packets (%.0f packets/s), mean round trip time %.3f ms"
+          % (sent, sent / duration, received, received / duration, 1000 * rttSum / max(received, 1)))
+
+
+if __name__ == '__main__':
+    main()
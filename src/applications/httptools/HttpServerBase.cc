@@ -31,6 +31,11 @@
 #include "HttpServerBase.h"
 
 
+HttpServerBase::HttpServerBase()
+: HttpNodeBase(), cachedReplyIndex(-1)
+{
+}
+
 void HttpServerBase::initialize()
 {
     ll = par("logLevel");
@@ -129,10 +134,13 @@ void HttpServerBase::initialize()
     activationTime = par("activationTime");
     EV_INFO << "Activation time is " << activationTime << endl;
 
+    sizeOnlyReplies = par("sizeOnlyReplies");
+
     std::string siteDefinition = (const char*)par("siteDefinition");
     scriptedMode = !siteDefinition.empty();
     if (scriptedMode)
         readSiteDefinition(siteDefinition);
+    buildReplyCache();
 
     // Register the server with the controller object
     registerWithController();
@@ -208,10 +216,27 @@ cPacket* HttpServerBase::handleReceivedMessage(cMessage *msg)
 
     HttpReplyMessage* replymsg;
 
-    // Parse the request string on spaces
-    cStringTokenizer tokenizer = cStringTokenizer(request->heading(), " ");
-    std::vector<std::string> res = tokenizer.asVector();
-    if (res.size() != 3)
+    // Parse the request string on spaces (in place; sequences of spaces separate tokens, as with cStringTokenizer)
+    const char *tokens[3];
+    size_t tokenLengths[3];
+    int numTokens = 0;
+    for (const char *p = request->heading(); *p; )
+    {
+        while (*p == ' ')
+            p++;
+        if (!*p)
+            break;
+        const char *start = p;
+        while (*p && *p != ' ')
+            p++;
+        if (numTokens < 3)
+        {
+            tokens[numTokens] = start;
+            tokenLengths[numTokens] = p - start;
+        }
+        numTokens++;
+    }
+    if (numTokens != 3)
     {
         EV_ERROR << "Invalid request string: " << request->heading() << endl;
         replymsg = generateErrorReply(request, 400);
@@ -225,13 +250,13 @@ cPacket* HttpServerBase::handleReceivedMessage(cMessage *msg)
         EV_ERROR << "Bad request - bad flag set. Message: " << request->getName() << endl;
         replymsg = generateErrorReply(request, 404);
     }
-    else if (res[0] == "GET")
+    else if (tokenLengths[0] == 3 && strncmp(tokens[0], "GET", 3) == 0)
     {
-        replymsg = handleGetRequest(request, res[1]); // Pass in the resource string part
+        replymsg = handleGetRequest(request, std::string(tokens[1], tokenLengths[1])); // Pass in the resource string part
     }
     else
     {
-        EV_ERROR << "Unsupported request type " << res[0] << " for " << request->heading() << endl;
+        EV_ERROR << "Unsupported request type " << std::string(tokens[0], tokenLengths[0]) << " for " << request->heading() << endl;
         replymsg = generateErrorReply(request, 400);
     }
 
@@ -245,28 +270,26 @@ HttpReplyMessage* HttpServerBase::handleGetRequest(HttpRequestMessage *request,
 {
     EV_DEBUG << "Handling GET request " << request->getName() << " resource: " << resource << endl;
 
-    resource = trimLeft(resource, "/");
-    std::vector<std::string> req = parseResourceName(resource);
-    if (req.size()!=3)
-    {
-        EV_ERROR << "Invalid GET request string: " << request->heading() << endl;
-        return generateErrorReply(request, 400);
-    }
-
-    HttpContentType cat = getResourceCategory(req);
+    // Strip everything up to the first slash, and get the category from the extension
+    // (the same as trimLeft(), parseResourceName() and getResourceCategory(), without the copies)
+    std::string::size_type slashpos = resource.find('/');
+    if (slashpos != std::string::npos)
+        resource.erase(0, slashpos + 1);
+    std::string::size_type dotpos = resource.rfind('.');
+    HttpContentType cat = getResourceCategory(dotpos == std::string::npos ? std::string() : resource.substr(dotpos + 1));
 
     if (cat==CT_HTML)
     {
         if (scriptedMode)
         {
-            if (resource.empty() && htmlPages.find("root") != htmlPages.end())
+            if (resource.empty() && findCachedReply("root", true) != NULL)
             {
                 EV_DEBUG << "Generating root resource" << endl;
                 return generateDocument(request, "root");
             }
-            if (htmlPages.find(resource) == htmlPages.end())
+            if (findCachedReply(resource, true) == NULL)
             {
-                if (htmlPages.find("default") != htmlPages.end())
+                if (findCachedReply("default", true) != NULL)
                 {
                     EV_DEBUG << "Generating default resource" << endl;
                     return generateDocument(request, "default");
@@ -282,7 +305,7 @@ HttpReplyMessage* HttpServerBase::handleGetRequest(HttpRequestMessage *request,
     }
     else if (cat==CT_TEXT || cat==CT_IMAGE)
     {
-        if (scriptedMode && resources.find(resource)==resources.end())
+        if (scriptedMode && findCachedReply(resource, false) == NULL)
         {
             EV_ERROR << "Resource not found: " << resource << endl;
             return generateErrorReply(request, 404);
@@ -300,26 +323,22 @@ HttpReplyMessage* HttpServerBase::generateDocument(HttpRequestMessage *request,
 {
     EV_DEBUG << "Generating HTML document for request " << request->getName() << " from " << request->getSenderModule()->getName() << endl;
 
-    char szReply[512];
-    sprintf(szReply, "HTTP/1.1 200 OK (%s)", resource);
-    HttpReplyMessage* replymsg = new HttpReplyMessage(szReply);
-    replymsg->setHeading("HTTP/1.1 200 OK");
-    replymsg->setOriginatorUrl(hostName.c_str());
-    replymsg->setTargetUrl(request->originatorUrl());
-    replymsg->setProtocol(request->protocol());
-    replymsg->setSerial(request->serial());
-    replymsg->setResult(200);
-    replymsg->setContentType(CT_HTML); // Emulates the content-type header field
-    replymsg->setKind(HTTPT_RESPONSE_MESSAGE);
-
+    HttpReplyMessage* replymsg;
     if (scriptedMode)
     {
-        replymsg->setPayload(htmlPages[resource].body.c_str());
-        size = htmlPages[resource].size;
+        const CachedReply *page = findCachedReply(resource, true);
+        if (page == NULL)
+            error("Page %s is not part of the site definition", resource);
+        replymsg = createReply(request, page, CT_HTML);
+        size = page->size;
     }
     else
     {
-        replymsg->setPayload(generateBody().c_str());
+        replyName.assign("HTTP/1.1 200 OK (").append(resource).append(")");
+        replymsg = createReply(request, replyName.c_str(), CT_HTML);
+        std::string body = generateBody();  // also when the body is omitted, so that the same random numbers are drawn
+        if (!sizeOnlyReplies)
+            replymsg->setPayload(body.c_str());
     }
 
     if (size==0)
@@ -345,20 +364,19 @@ HttpReplyMessage* HttpServerBase::generateResourceMessage(HttpRequestMessage *re
     else if (category==CT_IMAGE)
         imgResourcesServed++;
 
-    char szReply[512];
-    sprintf(szReply, "HTTP/1.1 200 OK (%s)", resource.c_str());
-    HttpReplyMessage* replymsg = new HttpReplyMessage(szReply);
-    replymsg->setHeading("HTTP/1.1 200 OK");
-    replymsg->setOriginatorUrl(hostName.c_str());
-    replymsg->setTargetUrl(request->originatorUrl());
-    replymsg->setProtocol(request->protocol()); // MIGRATE40: kvj
-    replymsg->setSerial(request->serial());
-    replymsg->setResult(200);
-    replymsg->setContentType(category); // Emulates the content-type header field
-    replymsg->setByteLength(resources[resource]); // Set the resource size
-    replymsg->setKind(HTTPT_RESPONSE_MESSAGE);
-
-    sprintf(szReply, "RESOURCE-BODY:%s", resource.c_str());
+    HttpReplyMessage* replymsg;
+    const CachedReply *cached = findCachedReply(resource, false);
+    if (cached != NULL)
+    {
+        replymsg = createReply(request, cached, category); // also sets the resource size
+    }
+    else
+    {
+        // Not part of a site definition (random mode): the reply has no size
+        replyName.assign("HTTP/1.1 200 OK (").append(resource).append(")");
+        replymsg = createReply(request, replyName.c_str(), category);
+        replymsg->setByteLength(0);
+    }
     return replymsg;
 }
 
@@ -386,7 +404,10 @@ std::string HttpServerBase::generateBody()
     int numImages = (int)(numResources*rdTextImageResourceRatio->draw());
     int numText = numResources - numImages;
 
-    std::string result;
+    // The body only depends on the number of images and text resources, so it is generated once for each
+    std::string& result = generatedBodies[std::make_pair(numImages, numText)];
+    if (!result.empty() || numResources <= 0)
+        return result;
 
     char tempBuf[128];
     for (int i=0; i<numImages; i++)
@@ -403,6 +424,81 @@ std::string HttpServerBase::generateBody()
     return result;
 }
 
+unsigned int HttpServerBase::CachedReplyKeyHash::operator()(const CachedReplyKey& key) const
+{
+    // FNV-1a
+    uint64 hash = 14695981039346656037ULL;
+    for (std::string::const_iterator it = key.url->begin(); it != key.url->end(); ++it)
+        hash = (hash ^ (unsigned char)*it) * 1099511628211ULL;
+    return fibonacciHash64(hash ^ key.page);
+}
+
+void HttpServerBase::buildReplyCache()
+{
+    // The entries refer to the keys and bodies of htmlPages and resources, which are not modified afterwards
+    cachedReplies.clear();
+    cachedReplyIndex.clear();
+    cachedReplies.reserve(htmlPages.size() + resources.size());
+
+    for (std::map<std::string,HtmlPageData>::iterator it = htmlPages.begin(); it != htmlPages.end(); ++it)
+    {
+        CachedReply cached;
+        cached.url = &it->first;
+        cached.page = true;
+        cached.name = "HTTP/1.1 200 OK (" + it->first + ")";
+        cached.body = &it->second.body;
+        cached.size = it->second.size;
+        cachedReplies.push_back(cached);
+    }
+    for (std::map<std::string,unsigned int>::iterator it = resources.begin(); it != resources.end(); ++it)
+    {
+        CachedReply cached;
+        cached.url = &it->first;
+        cached.page = false;
+        cached.name = "HTTP/1.1 200 OK (" + it->first + ")";
+        cached.body = NULL;
+        cached.size = it->second;
+        cachedReplies.push_back(cached);
+    }
+
+    for (unsigned int i = 0; i < cachedReplies.size(); i++)
+    {
+        CachedReplyKey key = {cachedReplies[i].url, cachedReplies[i].page};
+        cachedReplyIndex.insert(key, i);
+    }
+}
+
+const HttpServerBase::CachedReply* HttpServerBase::findCachedReply(const std::string& resource, bool page) const
+{
+    CachedReplyKey key = {&resource, page};
+    int index = cachedReplyIndex.find(key);
+    return index == -1 ? NULL : &cachedReplies[index];
+}
+
+HttpReplyMessage* HttpServerBase::createReply(HttpRequestMessage *request, const char *name, HttpContentType category)
+{
+    HttpReplyMessage* replymsg = new HttpReplyMessage(name);
+    replymsg->setHeading("HTTP/1.1 200 OK");
+    replymsg->setOriginatorUrl(hostName.c_str());
+    replymsg->setTargetUrl(request->originatorUrl());
+    replymsg->setProtocol(request->protocol());
+    replymsg->setSerial(request->serial());
+    replymsg->setResult(200);
+    replymsg->setContentType(category); // Emulates the content-type header field
+    replymsg->setKind(HTTPT_RESPONSE_MESSAGE);
+    return replymsg;
+}
+
+HttpReplyMessage* HttpServerBase::createReply(HttpRequestMessage *request, const CachedReply *cached, HttpContentType category)
+{
+    // A new message, not the dup() of a template message: that would carry the creation time and tree id of the template
+    HttpReplyMessage* replymsg = createReply(request, cached->name.c_str(), category);
+    if (cached->body != NULL && !sizeOnlyReplies)
+        replymsg->setPayload(cached->body->c_str());
+    replymsg->setByteLength(cached->size);
+    return replymsg;
+}
+
 void HttpServerBase::registerWithController()
 {
     // Find controller object and register
@@ -31,9 +31,11 @@
 #ifndef __INET_HTTPSERVERBASE_H
 #define __INET_HTTPSERVERBASE_H
 
+#include <map>
 #include <string>
 #include <vector>
 #include "HttpNodeBase.h"
+#include "OpenAddressingHashTable.h"
 
 // Event message kinds
 #define MSGKIND_START_SESSION 0
@@ -76,6 +78,40 @@ class INET_API HttpServerBase : public HttpNodeBase
             std::string body;
         };
 
+        /**
+         * Pre-rendered reply to a hosted page or resource: the fields of the reply that
+         * do not depend on the request, prepared when the site definition has been read.
+         * See createReply().
+         */
+        struct CachedReply
+        {
+            const std::string *url;     ///< The resource URL (a key of htmlPages or resources).
+            bool page;                  ///< True for pages, false for resources.
+            std::string name;           ///< The message name, "HTTP/1.1 200 OK (<resource URL>)".
+            const std::string *body;    ///< The body of a page (owned by htmlPages), or NULL for resources.
+            long size;                  ///< The size in bytes. 0 for pages without a size in the site definition: the size is drawn for each reply.
+        };
+
+        /**
+         * Key of the reply cache index. Refers to the URL instead of copying it,
+         * so that lookups do not allocate.
+         */
+        struct CachedReplyKey
+        {
+            const std::string *url;
+            bool page;
+            bool operator==(const CachedReplyKey& other) const {return page == other.page && *url == *other.url;}
+        };
+
+        /**
+         * Hash function object of the reply cache index: FNV-1a hash of the URL,
+         * mixed with fibonacciHash64().
+         */
+        struct CachedReplyKeyHash
+        {
+            unsigned int operator()(const CachedReplyKey& key) const;
+        };
+
         /** The server name, e.g. www.example.com. */
         std::string hostName;
         /** The listening port of the server */
@@ -88,6 +124,17 @@ class INET_API HttpServerBase : public HttpNodeBase
         /** A map of resource, keyed by a resource URL. Used in scripted mode. */
         std::map<std::string,unsigned int> resources;
 
+        /** @name Reply cache */
+        //@{
+        std::vector<CachedReply> cachedReplies;     ///< Pre-rendered replies to the pages and resources of a scripted site.
+        OpenAddressingHashTable<CachedReplyKey,int,CachedReplyKeyHash> cachedReplyIndex;   ///< (URL, page) -> index into cachedReplies.
+        std::map<std::pair<int,int>,std::string> generatedBodies;   ///< Generated bodies, keyed by the number of images and text resources.
+        std::string replyName;                  ///< Reused for building reply names.
+        //@}
+
+        /** If true, replies carry no body: only their size is modelled. */
+        bool sizeOnlyReplies;
+
         // Basic statistics
         long htmlDocsServed;
         long imgResourcesServed;
@@ -122,6 +169,8 @@ class INET_API HttpServerBase : public HttpNodeBase
         //@}
 
     public:
+        HttpServerBase();
+
         /** Return the name of the server */
         const std::string& getHostName() { return hostName; }
 
@@ -148,6 +197,15 @@ class INET_API HttpServerBase : public HttpNodeBase
         void readSiteDefinition(std::string file);
         /** Read a html body from a file. Used by readSiteDefinition. */
         std::string readHtmlBodyFile(std::string file, std::string path);
+
+        /** Prepare the replies of the pages and resources of the site definition. */
+        void buildReplyCache();
+        /** Return the prepared reply of a page or resource of the scripted site, or NULL if there is no such page or resource. */
+        const CachedReply* findCachedReply(const std::string& resource, bool page) const;
+        /** Create a 200 OK reply to the request, without body and size. */
+        HttpReplyMessage* createReply(HttpRequestMessage *request, const char *name, HttpContentType category);
+        /** Create the reply to the request from a pre-rendered reply, including body (unless sizeOnlyReplies is set) and size. */
+        HttpReplyMessage* createReply(HttpRequestMessage *request, const CachedReply *cached, HttpContentType category);
 };
 
 #endif
@@ -16,22 +16,139 @@
 #include "ByteArray.h"
 
 
-void ByteArray::setDataFromBuffer(const void *ptr, unsigned int length)
+uint64 ByteArray::copiedBytes = 0;
+
+void ByteArray::share(const ByteArray& other)
+{
+    if (other.storage)
+        other.storage->refCount++;
+    release();
+    storage = other.storage;
+    dataOffset = other.dataOffset;
+    dataLength = other.dataLength;
+}
+
+ByteArray& ByteArray::operator=(const ByteArray& other)
+{
+    if (this == &other)
+        return *this;
+    ByteArray_Base::operator=(other);
+    share(other);
+    return *this;
+}
+
+void ByteArray::release()
+{
+    if (storage && --storage->refCount == 0)
+    {
+        delete [] storage->data;
+        delete storage;
+    }
+    storage = NULL;
+    dataOffset = dataLength = 0;
+}
+
+void ByteArray::attach(char *ptr, unsigned int length)
 {
-    if (length != data_arraysize)
+    release();
+    if (length)
     {
-        delete [] data_var;
-        data_var = length ? new char[length] : NULL;
-        data_arraysize = length;
+        storage = new Storage;
+        storage->refCount = 1;
+        storage->size = length;
+        storage->data = ptr;
+        dataLength = length;
     }
+    else
+        delete [] ptr;
+}
+
+void ByteArray::makeUnique()
+{
+    // copy on write: detach from storage shared with other arrays
+    if (storage && (storage->refCount > 1 || dataOffset != 0 || dataLength != storage->size))
+    {
+        char *ndata = new char[dataLength];
+        memcpy(ndata, storage->data + dataOffset, dataLength);
+        copiedBytes += dataLength;
+        attach(ndata, dataLength);
+    }
+}
+
+void ByteArray::setDataArraySize(unsigned int size)
+{
+    if (size == dataLength)
+        return;
+    char *ndata = size ? new char[size] : NULL;
+    unsigned int length = std::min(size, dataLength);
     if (length)
-        memcpy(data_var, ptr, length);
+    {
+        memcpy(ndata, storage->data + dataOffset, length);
+        copiedBytes += length;
+    }
+    if (size > length)
+        memset(ndata + length, 0, size - length);
+    attach(ndata, size);
+}
+
+char ByteArray::getData(unsigned int k) const
+{
+    if (k >= dataLength)
+        throw cRuntimeError("Array of size %d indexed by %d", dataLength, k);
+    return storage->data[dataOffset + k];
+}
+
+void ByteArray::setData(unsigned int k, char data)
+{
+    if (k >= dataLength)
+        throw cRuntimeError("Array of size %d indexed by %d", dataLength, k);
+    makeUnique();
+    storage->data[k] = data;
+}
+
+void ByteArray::parsimPack(cCommBuffer *b)
+{
+    ByteArray_Base::parsimPack(b);
+    b->pack(dataLength);
+    if (dataLength)
+        b->pack(storage->data + dataOffset, dataLength);
+}
+
+void ByteArray::parsimUnpack(cCommBuffer *b)
+{
+    ByteArray_Base::parsimUnpack(b);
+    unsigned int length;
+    b->unpack(length);
+    char *ndata = length ? new char[length] : NULL;
+    if (length)
+        b->unpack(ndata, length);
+    attach(ndata, length);
+}
+
+void ByteArray::setDataFromBuffer(const void *ptr, unsigned int length)
+{
+    char *ndata = length ? new char[length] : NULL;
+    if (length)
+    {
+        memcpy(ndata, ptr, length);
+        copiedBytes += length;
+    }
+    attach(ndata, length);
 }
 
 void ByteArray::setDataFromByteArray(const ByteArray& other, unsigned int srcOffs, unsigned int length)
 {
-    ASSERT(srcOffs+length <= other.data_arraysize);
-    setDataFromBuffer(other.data_var+srcOffs, length);
+    ASSERT(srcOffs+length <= other.dataLength);
+    if (length == 0)
+    {
+        release();
+        return;
+    }
+    // other may be this array, so adjust offsets on a copy
+    ByteArray slice(other);
+    slice.dataOffset += srcOffs;
+    slice.dataLength = length;
+    share(slice);
 }
 
 void ByteArray::addDataFromBuffer(const void *ptr, unsigned int length)
@@ -39,48 +156,49 @@ void ByteArray::addDataFromBuffer(const void *ptr, unsigned int length)
     if (0 == length)
         return;
 
-    unsigned int nlength = data_arraysize + length;
-    char *ndata_var = new char[nlength];
-    if (data_arraysize)
-        memcpy(ndata_var, data_var, data_arraysize);
-    memcpy(ndata_var, data_var + data_arraysize, length);
-    delete [] data_var;
-    data_var = ndata_var;
+    unsigned int nlength = dataLength + length;
+    char *ndata = new char[nlength];
+    if (dataLength)
+        memcpy(ndata, storage->data + dataOffset, dataLength);
+    memcpy(ndata + dataLength, ptr, length);
+    copiedBytes += nlength;
+    attach(ndata, nlength);
 }
 
 unsigned int ByteArray::copyDataToBuffer(void *ptr, unsigned int length, unsigned int srcOffs) const
 {
-    if (srcOffs >= data_arraysize)
+    if (srcOffs >= dataLength)
         return 0;
 
-    if (srcOffs + length > data_arraysize)
-        length = data_arraysize - srcOffs;
-    memcpy(ptr, data_var+srcOffs, length);
+    if (srcOffs + length > dataLength)
+        length = dataLength - srcOffs;
+    memcpy(ptr, storage->data + dataOffset + srcOffs, length);
+    copiedBytes += length;
     return length;
 }
 
 void ByteArray::assignBuffer(void *ptr, unsigned int length)
 {
-    delete [] data_var;
-    data_var = (char *)ptr;
-    data_arraysize = length;
+    attach((char *)ptr, length);
 }
 
 void ByteArray::truncateData(unsigned int truncleft, unsigned int truncright)
 {
-    ASSERT(data_arraysize >= (truncleft + truncright));
+    ASSERT(dataLength >= (truncleft + truncright));
 
-    if ((truncleft || truncright))
+    if (dataLength == truncleft + truncright)
+        release();
+    else
     {
-        unsigned int nlength = data_arraysize - (truncleft + truncright);
-        char *ndata_var = NULL;
-        if (nlength)
-        {
-            ndata_var = new char[nlength];
-            memcpy(ndata_var, data_var+truncleft, nlength);
-        }
-        delete [] data_var;
-        data_var = ndata_var;
-        data_arraysize = nlength;
+        dataOffset += truncleft;
+        dataLength -= truncleft + truncright;
     }
 }
+
+bool ByteArray::join(const ByteArray& other)
+{
+    if (!storage || storage != other.storage || dataOffset + dataLength != other.dataOffset)
+        return false;
+    dataLength += other.dataLength;
+    return true;
+}
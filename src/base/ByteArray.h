@@ -20,30 +20,70 @@
 
 /**
  * Class that carries raw bytes.
+ *
+ * The bytes are kept in reference counted storage, and a ByteArray is a
+ * slice (offset and length) of that storage. Copying a ByteArray, taking
+ * a slice of it (setDataFromByteArray()) or truncating it does not copy
+ * the bytes; they are copied only when a shared ByteArray is modified
+ * (copy on write). This way TCP segments, the send queue and the receive
+ * queue can refer to the same application data.
  */
 class ByteArray : public ByteArray_Base
 {
+  protected:
+    struct Storage
+    {
+        unsigned int refCount;
+        unsigned int size;
+        char *data;
+    };
+
+    Storage *storage;         // NULL if the array is empty
+    unsigned int dataOffset;  // start of the slice within storage
+    unsigned int dataLength;  // length of the slice
+
+    static uint64 copiedBytes;
+
+  protected:
+    void share(const ByteArray& other);
+    void release();
+    void attach(char *ptr, unsigned int length);
+    void makeUnique();
+
   public:
     /**
      * Constructor
      */
-    ByteArray() : ByteArray_Base() {}
+    ByteArray() : ByteArray_Base(), storage(NULL), dataOffset(0), dataLength(0) {}
 
     /**
-     * Copy constructor
+     * Copy constructor. Shares the bytes with other.
      */
-    ByteArray(const ByteArray& other) : ByteArray_Base(other) { }
+    ByteArray(const ByteArray& other) : ByteArray_Base(other), storage(NULL) {share(other);}
 
     /**
-     * operator =
+     * operator =. Shares the bytes with other.
      */
-    ByteArray& operator=(const ByteArray& other) {ByteArray_Base::operator=(other); return *this;}
+    ByteArray& operator=(const ByteArray& other);
+
+    virtual ~ByteArray() {release();}
 
     /**
      * Creates and returns an exact copy of this object.
      */
     virtual ByteArray *dup() const {return new ByteArray(*this);}
 
+    /** @name Implementation of the data[] field */
+    //@{
+    virtual void setDataArraySize(unsigned int size);
+    virtual unsigned int getDataArraySize() const {return dataLength;}
+    virtual char getData(unsigned int k) const;
+    virtual void setData(unsigned int k, char data);
+    //@}
+
+    virtual void parsimPack(cCommBuffer *b);
+    virtual void parsimUnpack(cCommBuffer *b);
+
     /**
      * Copy data from buffer
      * @param ptr: pointer to buffer
@@ -52,7 +92,7 @@ class ByteArray : public ByteArray_Base
     virtual void setDataFromBuffer(const void *ptr, unsigned int length);
 
     /**
-     * Copy data from other ByteArray
+     * Set data to a slice of other ByteArray; the bytes are shared, not copied
      * @param other: reference to other ByteArray
      * @param offset: skipped first bytes from other
      * @param length: length of data
@@ -83,12 +123,32 @@ class ByteArray : public ByteArray_Base
     virtual void assignBuffer(void *ptr, unsigned int length);
 
     /**
-     * Truncate data content
+     * Truncate data content; the bytes are not copied
      * @param truncleft: The number of bytes from the beginning of the content be remove
      * @param truncright: The number of bytes from the end of the content be remove
      * Generate assert when not have enough bytes for truncation
      */
     virtual void truncateData(unsigned int truncleft, unsigned int truncright = 0);
+
+    /**
+     * Returns a read-only pointer to the data, or NULL if the array is empty.
+     * The pointer is valid until the array is modified.
+     */
+    const char *getDataPtr() const {return storage ? storage->data + dataOffset : NULL;}
+
+    /**
+     * If other is a slice of the same storage that immediately follows the
+     * slice of this array, extends this array to cover it too and returns
+     * true. Otherwise returns false and leaves this array unchanged.
+     */
+    bool join(const ByteArray& other);
+
+    /**
+     * Returns the total number of data bytes copied by ByteArray instances
+     * (filling from or copying to external buffers, and copies on write).
+     * Useful for measuring the copying overhead of protocol implementations.
+     */
+    static uint64 getCopiedBytes() {return copiedBytes;}
 };
 
 #endif //  __INET_BYTEARRAY_H
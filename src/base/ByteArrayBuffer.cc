@@ -37,18 +37,48 @@ ByteArrayBuffer& ByteArrayBuffer::operator=(const ByteArrayBuffer& other)
 
 void ByteArrayBuffer::push(const ByteArray& byteArrayP)
 {
-    dataListM.push_back(byteArrayP);
+    if (byteArrayP.getDataArraySize() == 0)
+        return;
+
+    // consecutive slices of the same storage are coalesced into one
+    if (dataListM.empty() || !dataListM.back().join(byteArrayP))
+        dataListM.push_back(byteArrayP);
     dataLengthM += byteArrayP.getDataArraySize();
 }
 
 void ByteArrayBuffer::push(const void* bufferP, unsigned int bufferLengthP)
 {
+    if (bufferLengthP == 0)
+        return;
+
     ByteArray byteArray;
     dataListM.push_back(byteArray);
     dataListM.back().setDataFromBuffer(bufferP, bufferLengthP);
     dataLengthM += bufferLengthP;
 }
 
+void ByteArrayBuffer::push(const ByteArrayBuffer& otherP, unsigned int srcOffsP, unsigned int lengthP)
+{
+    ASSERT(srcOffsP + lengthP <= otherP.dataLengthM);
+    ASSERT(&otherP != this);
+
+    for (DataList::const_iterator i = otherP.dataListM.begin(); lengthP > 0 && i != otherP.dataListM.end(); ++i)
+    {
+        unsigned int sliceLength = i->getDataArraySize();
+        if (srcOffsP >= sliceLength)
+        {
+            srcOffsP -= sliceLength;
+            continue;
+        }
+        unsigned int length = std::min(sliceLength - srcOffsP, lengthP);
+        ByteArray slice;
+        slice.setDataFromByteArray(*i, srcOffsP, length);
+        push(slice);
+        lengthP -= length;
+        srcOffsP = 0;
+    }
+}
+
 unsigned int ByteArrayBuffer::getBytesToBuffer(void* bufferP, unsigned int bufferLengthP, unsigned int srcOffsP) const
 {
     unsigned int copiedBytes = 0;
@@ -71,6 +101,36 @@ unsigned int ByteArrayBuffer::getBytesToBuffer(void* bufferP, unsigned int buffe
     return copiedBytes;
 }
 
+unsigned int ByteArrayBuffer::getBytesToByteArray(ByteArray& byteArrayP, unsigned int lengthP, unsigned int srcOffsP) const
+{
+    if (srcOffsP >= dataLengthM)
+    {
+        byteArrayP.setDataArraySize(0);
+        return 0;
+    }
+    if (srcOffsP + lengthP > dataLengthM)
+        lengthP = dataLengthM - srcOffsP;
+
+    DataList::const_iterator i = dataListM.begin();
+    while (srcOffsP >= i->getDataArraySize())
+    {
+        srcOffsP -= i->getDataArraySize();
+        ++i;
+    }
+
+    if (srcOffsP + lengthP <= i->getDataArraySize())
+        byteArrayP.setDataFromByteArray(*i, srcOffsP, lengthP);
+    else
+    {
+        char *buffer = new char[lengthP];
+        unsigned int copiedBytes = 0;
+        for ( ; copiedBytes < lengthP; ++i, srcOffsP = 0)
+            copiedBytes += i->copyDataToBuffer(buffer + copiedBytes, lengthP - copiedBytes, srcOffsP);
+        byteArrayP.assignBuffer(buffer, lengthP);
+    }
+    return lengthP;
+}
+
 unsigned int ByteArrayBuffer::popBytesToBuffer(void* bufferP, unsigned int bufferLengthP)
 {
     return drop(getBytesToBuffer(bufferP, bufferLengthP));
@@ -19,6 +19,11 @@
 
 /**
  * Buffer that carries BytesArrays.
+ *
+ * The buffer is a list of ByteArray slices. Pushing a ByteArray or a part
+ * of another buffer, dropping bytes and extracting bytes into a ByteArray
+ * share the underlying storage instead of copying the bytes, except when
+ * the extracted range spans several slices.
  */
 class ByteArrayBuffer : public cObject
 {
@@ -49,6 +54,14 @@ class ByteArrayBuffer : public cObject
     /** Push data to end of buffer */
     virtual void push(const void* bufferP, unsigned int bufferLengthP);
 
+    /**
+     * Push a range of another buffer to end of buffer, sharing its bytes
+     * @param otherP: source buffer
+     * @param srcOffsP: source offset
+     * @param lengthP: count of bytes
+     */
+    virtual void push(const ByteArrayBuffer& otherP, unsigned int srcOffsP, unsigned int lengthP);
+
     /** Returns length of stored data */
     virtual uint64 getLength() const { return dataLengthM; }
 
@@ -61,6 +74,16 @@ class ByteArrayBuffer : public cObject
      */
     virtual unsigned int getBytesToBuffer(void* bufferP, unsigned int bufferLengthP, unsigned int srcOffsP = 0) const;
 
+    /**
+     * Set a ByteArray to a range of the buffer. If the range lies within
+     * one slice, the bytes are shared, otherwise they are copied.
+     * @param byteArrayP: output array
+     * @param lengthP: maximum count of bytes
+     * @param srcOffsP: source offset
+     * @return count of bytes in the output array
+     */
+    virtual unsigned int getBytesToByteArray(ByteArray& byteArrayP, unsigned int lengthP, unsigned int srcOffsP = 0) const;
+
     /**
      * Move bytes to an external buffer
      * @param bufferP: pointer to output buffer
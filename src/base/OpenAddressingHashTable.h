@@ -0,0 +1,215 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_OPENADDRESSINGHASHTABLE_H
+#define __INET_OPENADDRESSINGHASHTABLE_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+
+/**
+ * Fibonacci hashing of a 64-bit key: multiplication by 2^64 / golden ratio
+ * mixes all bits of the key into the upper half of the product. Useful for
+ * keys whose low or high bits alone are poor hash values (MAC addresses
+ * with vendor prefixes, interface id + label pairs, etc).
+ */
+inline unsigned int fibonacciHash64(uint64 key)
+{
+    return (unsigned int)((key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+/**
+ * 32-bit variant of fibonacciHash64(); the upper bits of the product are
+ * folded into the lower ones, which are used as slot index.
+ */
+inline unsigned int fibonacciHash32(uint32 key)
+{
+    uint32 hash = key * 0x9E3779B1u;
+    return hash ^ (hash >> 16);
+}
+
+/**
+ * Hash function object for OpenAddressingHashTable with 64-bit keys.
+ */
+struct FibonacciHash64
+{
+    unsigned int operator()(uint64 key) const {return fibonacciHash64(key);}
+};
+
+/**
+ * Hash table with open addressing (linear probing) that maps keys to
+ * values, e.g. entry pointers or indices into an entry pool; a lookup
+ * costs O(1) on average. Empty slots hold a designated empty value, which
+ * must not be inserted.
+ *
+ * The number of slots is a power of two, and it is doubled whenever the
+ * table would become more than half full, so probe sequences stay short.
+ * Entries are removed with backward shift deletion (entries later in the
+ * probe sequence are moved into the hole), so no tombstones are needed.
+ *
+ * K must be copyable and comparable with ==; H is a function object that
+ * returns the hash value of a key as unsigned int. The low bits of the
+ * hash value are used as slot index, so they should depend on all bits
+ * of the key (see fibonacciHash64() and fibonacciHash32()).
+ */
+template <typename K, typename V, typename H = FibonacciHash64>
+class OpenAddressingHashTable
+{
+  protected:
+    struct Slot
+    {
+        K key;
+        V value;    // emptyValue if the slot is empty
+    };
+
+    std::vector<Slot> slots;    // size is a power of two
+    int numEntries;
+    unsigned int initialNumSlots;
+    V emptyValue;
+    H hash;
+
+  protected:
+    unsigned int getHomeSlot(const K& key) const {return hash(key) & (slots.size() - 1);}
+
+    int findSlot(const K& key) const
+    {
+        unsigned int mask = slots.size() - 1;
+        for (unsigned int i = getHomeSlot(key); slots[i].value != emptyValue; i = (i + 1) & mask)
+            if (slots[i].key == key)
+                return i;
+        return -1;
+    }
+
+    void rehash(unsigned int numSlots)
+    {
+        std::vector<Slot> oldSlots;
+        oldSlots.swap(slots);
+        Slot empty;
+        empty.value = emptyValue;
+        slots.assign(numSlots, empty);
+
+        unsigned int mask = numSlots - 1;
+        for (typename std::vector<Slot>::const_iterator it = oldSlots.begin(); it != oldSlots.end(); ++it)
+        {
+            if (it->value == emptyValue)
+                continue;
+            unsigned int i = getHomeSlot(it->key);
+            while (slots[i].value != emptyValue)
+                i = (i + 1) & mask;
+            slots[i] = *it;
+        }
+    }
+
+  public:
+    /**
+     * Creates an empty table. initialNumSlots must be a power of two.
+     */
+    OpenAddressingHashTable(const V& emptyValue, unsigned int initialNumSlots = 16)
+    {
+        ASSERT(initialNumSlots > 0 && (initialNumSlots & (initialNumSlots - 1)) == 0);
+        this->emptyValue = emptyValue;
+        this->initialNumSlots = initialNumSlots;
+        clear();
+    }
+
+    /**
+     * Returns the value for the given key, or the empty value if not found.
+     */
+    V find(const K& key) const
+    {
+        int i = findSlot(key);
+        return i == -1 ? emptyValue : slots[i].value;
+    }
+
+    /**
+     * Inserts the key with the given value; returns false (and leaves the
+     * table unchanged) if the key is already present.
+     */
+    bool insert(const K& key, const V& value)
+    {
+        ASSERT(value != emptyValue);
+        if (2 * (numEntries + 1) > (int)slots.size())
+            rehash(2 * slots.size());
+
+        // without tombstones, the key is not in the table if its probe sequence reaches an empty slot
+        unsigned int mask = slots.size() - 1;
+        unsigned int i = getHomeSlot(key);
+        for ( ; slots[i].value != emptyValue; i = (i + 1) & mask)
+            if (slots[i].key == key)
+                return false;
+        slots[i].key = key;
+        slots[i].value = value;
+        numEntries++;
+        return true;
+    }
+
+    /**
+     * Removes the entry with the given key; returns false if not found.
+     */
+    bool remove(const K& key)
+    {
+        int i = findSlot(key);
+        if (i == -1)
+            return false;
+
+        unsigned int mask = slots.size() - 1;
+        unsigned int hole = i;
+        for (unsigned int j = (hole + 1) & mask; slots[j].value != emptyValue; j = (j + 1) & mask)
+        {
+            unsigned int home = getHomeSlot(slots[j].key);
+            // the entry at j may fill the hole if its home slot is not in (hole, j] (cyclically)
+            bool homeInRange = hole <= j ? (hole < home && home <= j) : (hole < home || home <= j);
+            if (!homeInRange)
+            {
+                slots[hole] = slots[j];
+                hole = j;
+            }
+        }
+        slots[hole].value = emptyValue;
+        numEntries--;
+        return true;
+    }
+
+    /**
+     * Removes all entries.
+     */
+    void clear()
+    {
+        Slot empty;
+        empty.value = emptyValue;
+        slots.assign(initialNumSlots, empty);
+        numEntries = 0;
+    }
+
+    /**
+     * Returns the number of entries.
+     */
+    int size() const {return numEntries;}
+
+    /**
+     * Returns the number of slots. Together with getSlotValue(), it can be
+     * used to iterate over the entries, in no particular order.
+     */
+    unsigned int getNumSlots() const {return slots.size();}
+
+    /**
+     * Returns the value in the given slot, or the empty value if the slot is empty.
+     */
+    const V& getSlotValue(unsigned int i) const {return slots[i].value;}
+};
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2013 Opensim Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MACAddressTable.h"
+
+
+#define INITIAL_NUM_SLOTS 64   // must be a power of two
+
+
+MACAddressTable::MACAddressTable() : indices(-1, INITIAL_NUM_SLOTS)
+{
+    numEntries = 0;
+    freeList = oldest = newest = -1;
+}
+
+void MACAddressTable::unlink(int index)
+{
+    Entry& entry = entries[index];
+    if (entry.prev != -1)
+        entries[entry.prev].next = entry.next;
+    else
+        oldest = entry.next;
+    if (entry.next != -1)
+        entries[entry.next].prev = entry.prev;
+    else
+        newest = entry.prev;
+}
+
+void MACAddressTable::append(int index)
+{
+    Entry& entry = entries[index];
+    entry.prev = newest;
+    entry.next = -1;
+    if (newest != -1)
+        entries[newest].next = index;
+    else
+        oldest = index;
+    newest = index;
+}
+
+MACAddressTable::Entry *MACAddressTable::find(const MACAddress& address)
+{
+    int index = indices.find(address.getInt());
+    return index == -1 ? NULL : &entries[index];
+}
+
+MACAddressTable::Entry *MACAddressTable::insert(const MACAddress& address)
+{
+    ASSERT(indices.find(address.getInt()) == -1);
+
+    int index;
+    if (freeList != -1)
+    {
+        index = freeList;
+        freeList = entries[index].next;
+    }
+    else
+    {
+        index = entries.size();
+        entries.push_back(Entry());
+    }
+
+    Entry& entry = entries[index];
+    entry.address = address;
+    entry.portno = -1;
+    entry.insertionTime = SIMTIME_ZERO;
+    append(index);
+
+    indices.insert(address.getInt(), index);
+
+    numEntries++;
+    return &entry;
+}
+
+void MACAddressTable::touch(Entry *entry)
+{
+    int index = entry - &entries[0];
+    if (index != newest)
+    {
+        unlink(index);
+        append(index);
+    }
+}
+
+void MACAddressTable::remove(Entry *entry)
+{
+    int index = entry - &entries[0];
+    ASSERT(indices.find(entry->address.getInt()) == index);
+    indices.remove(entry->address.getInt());
+
+    unlink(index);
+    entry->next = freeList;
+    freeList = index;
+    numEntries--;
+}
+
+void MACAddressTable::clear()
+{
+    entries.clear();
+    indices.clear();
+    numEntries = 0;
+    freeList = oldest = newest = -1;
+}
+
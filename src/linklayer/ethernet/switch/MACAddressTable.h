@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2013 Opensim Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __INET_MACADDRESSTABLE_H
+#define __INET_MACADDRESSTABLE_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "MACAddress.h"
+#include "OpenAddressingHashTable.h"
+
+
+/**
+ * Forwarding database of an Ethernet switch (see MACRelayUnitBase).
+ *
+ * Entries are stored in a pool, indexed by an OpenAddressingHashTable
+ * keyed on the 48-bit address, so lookups cost O(1) on average. Entries
+ * are also chained into an aging list, ordered by the time they were
+ * last updated (see touch()); the oldest entry is at the front, so aged
+ * entries and the oldest entry can be removed without scanning the table.
+ *
+ * Entry pointers returned by the table remain valid until the next insert().
+ */
+class INET_API MACAddressTable
+{
+  public:
+    struct Entry
+    {
+        MACAddress address;
+        int portno;              // Input port
+        simtime_t insertionTime; // Arrival time of Lookup Address Table entry
+
+      private:
+        friend class MACAddressTable;
+        int prev;                // previous (older) entry in the aging list, or -1
+        int next;                // next (newer) entry in the aging list or in the free list, or -1
+    };
+
+  protected:
+    std::vector<Entry> entries;  // entry pool
+    OpenAddressingHashTable<uint64, int> indices;  // address -> index into entries
+    int numEntries;
+    int freeList;                // unused entries, chained via Entry::next
+    int oldest;                  // head of the aging list
+    int newest;                  // tail of the aging list
+
+  protected:
+    void unlink(int index);
+    void append(int index);
+
+  public:
+    MACAddressTable();
+
+    /**
+     * Returns the entry for the given address, or NULL if not found.
+     */
+    Entry *find(const MACAddress& address);
+
+    /**
+     * Inserts a new entry for the given address, which must not be in the
+     * table yet. The entry becomes the newest one in the aging list; the
+     * caller is expected to fill in portno and insertionTime.
+     */
+    Entry *insert(const MACAddress& address);
+
+    /**
+     * Makes the entry the newest in the aging list. To be called whenever
+     * insertionTime is updated.
+     */
+    void touch(Entry *entry);
+
+    /**
+     * Removes the entry from the table.
+     */
+    void remove(Entry *entry);
+
+    /**
+     * Removes all entries.
+     */
+    void clear();
+
+    /**
+     * Returns the least recently inserted/updated entry, or NULL if the table is empty.
+     */
+    Entry *getOldest() {return oldest == -1 ? NULL : &entries[oldest];}
+
+    /**
+     * Returns the entry inserted/updated after the given one, or NULL.
+     */
+    Entry *getNewer(Entry *entry) {return entry->next == -1 ? NULL : &entries[entry->next];}
+
+    /**
+     * Returns the number of entries.
+     */
+    int size() const {return numEntries;}
+};
+
+#endif
+
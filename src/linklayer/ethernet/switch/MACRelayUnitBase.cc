@@ -33,9 +33,9 @@ static std::ostream& operator<< (std::ostream& os, cMessage *msg)
 }
 */
 
-static std::ostream& operator<<(std::ostream& os, const MACRelayUnitBase::AddressEntry& e)
+static std::ostream& operator<<(std::ostream& os, const MACAddressTable& t)
 {
-    os << "port=" << e.portno << " insTime=" << e.insertionTime;
+    os << t.size() << " entries";
     return os;
 }
 
@@ -94,7 +94,20 @@ void MACRelayUnitBase::initialize()
 
     seqNum = 0;
 
-    WATCH_MAP(addresstable);
+    numLearnedAddresses.assign(numPorts, 0);
+
+    WATCH(addresstable);
+    WATCH_VECTOR(numLearnedAddresses);
+}
+
+void MACRelayUnitBase::finish()
+{
+    char name[40];
+    for (int i=0; i<numPorts; i++)
+    {
+        sprintf(name, "learned addresses on port %d", i);
+        recordScalar(name, numLearnedAddresses[i]);
+    }
 }
 
 void MACRelayUnitBase::handleAndDispatchFrame(EtherFrame *frame, int inputport)
@@ -144,101 +157,88 @@ void MACRelayUnitBase::broadcastFrame(EtherFrame *frame, int inputport)
 
 void MACRelayUnitBase::printAddressTable()
 {
-    AddressTable::iterator iter;
     EV << "Address Table (" << addresstable.size() << " entries):\n";
-    for (iter = addresstable.begin(); iter!=addresstable.end(); ++iter)
+    for (AddressEntry *entry = addresstable.getOldest(); entry; entry = addresstable.getNewer(entry))
     {
-        EV << "  " << iter->first << " --> port" << iter->second.portno <<
-              (iter->second.insertionTime+agingTime <= simTime() ? " (aged)" : "") << endl;
+        EV << "  " << entry->address << " --> port" << entry->portno <<
+              (entry->insertionTime+agingTime <= simTime() ? " (aged)" : "") << endl;
     }
 }
 
 void MACRelayUnitBase::removeAgedEntriesFromTable()
 {
-    for (AddressTable::iterator iter = addresstable.begin(); iter != addresstable.end();)
+    // the aging list is ordered by insertionTime, so aged entries are all at its front
+    AddressEntry *entry;
+    while ((entry = addresstable.getOldest()) != NULL && entry->insertionTime + agingTime <= simTime())
     {
-        AddressTable::iterator cur = iter++; // iter will get invalidated after erase()
-        AddressEntry& entry = cur->second;
-        if (entry.insertionTime + agingTime <= simTime())
-        {
-            EV << "Removing aged entry from Address Table: " <<
-                  cur->first << " --> port" << cur->second.portno << "\n";
-            addresstable.erase(cur);
-        }
+        EV << "Removing aged entry from Address Table: " <<
+              entry->address << " --> port" << entry->portno << "\n";
+        addresstable.remove(entry);
     }
 }
 
 void MACRelayUnitBase::removeOldestTableEntry()
 {
-    AddressTable::iterator oldest = addresstable.end();
-    simtime_t oldestInsertTime = simTime()+1;
-    for (AddressTable::iterator iter = addresstable.begin(); iter != addresstable.end(); iter++)
-    {
-        if (iter->second.insertionTime < oldestInsertTime)
-        {
-            oldest = iter;
-            oldestInsertTime = iter->second.insertionTime;
-        }
-    }
-    if (oldest != addresstable.end())
+    AddressEntry *oldest = addresstable.getOldest();
+    if (oldest)
     {
         EV << "Table full, removing oldest entry: " <<
-              oldest->first << " --> port" << oldest->second.portno << "\n";
-        addresstable.erase(oldest);
+              oldest->address << " --> port" << oldest->portno << "\n";
+        addresstable.remove(oldest);
     }
 }
 
 void MACRelayUnitBase::updateTableWithAddress(MACAddress& address, int portno)
 {
-    AddressTable::iterator iter;
-
-    iter = addresstable.find(address);
-    if (iter == addresstable.end())
+    AddressEntry *entry = addresstable.find(address);
+    if (!entry)
     {
         // Observe finite table size
-        if (addressTableSize!=0 && addresstable.size() == (unsigned int)addressTableSize)
+        if (addressTableSize!=0 && addresstable.size() == addressTableSize)
         {
             // lazy removal of aged entries: only if table gets full (this step is not strictly needed)
             EV << "Making room in Address Table by throwing out aged entries.\n";
             removeAgedEntriesFromTable();
 
-            if (addresstable.size() == (unsigned int)addressTableSize)
+            if (addresstable.size() == addressTableSize)
                 removeOldestTableEntry();
         }
 
         // Add entry to table
         EV << "Adding entry to Address Table: "<< address << " --> port" << portno << "\n";
-        AddressEntry entry;
-        entry.portno = portno;
-        entry.insertionTime = simTime();
-        addresstable[address] = entry;
+        entry = addresstable.insert(address);
+        entry->portno = portno;
+        entry->insertionTime = simTime();
+        numLearnedAddresses[portno]++;
     }
     else
     {
         // Update existing entry
         EV << "Updating entry in Address Table: "<< address << " --> port" << portno << "\n";
-        AddressEntry& entry = iter->second;
-        entry.insertionTime = simTime();
-        entry.portno = portno;
+        if (entry->portno != portno)
+            numLearnedAddresses[portno]++;
+        entry->insertionTime = simTime();
+        entry->portno = portno;
+        addresstable.touch(entry);
     }
 }
 
 int MACRelayUnitBase::getPortForAddress(MACAddress& address)
 {
-    AddressTable::iterator iter = addresstable.find(address);
-    if (iter == addresstable.end())
+    AddressEntry *entry = addresstable.find(address);
+    if (!entry)
     {
         // not found
         return -1;
     }
-    if (iter->second.insertionTime + agingTime <= simTime())
+    if (entry->insertionTime + agingTime <= simTime())
     {
         // don't use (and throw out) aged entries
-        EV << "Ignoring and deleting aged entry: "<< iter->first << " --> port" << iter->second.portno << "\n";
-        addresstable.erase(iter);
+        EV << "Ignoring and deleting aged entry: "<< entry->address << " --> port" << entry->portno << "\n";
+        addresstable.remove(entry);
         return -1;
     }
-    return iter->second.portno;
+    return entry->portno;
 }
 
 
@@ -282,12 +282,16 @@ void MACRelayUnitBase::readAddressTable(const char* fileName)
             error("line %d invalid in address table file `%s'", lineno, fileName);
 
         // Create an entry with address and portno and insert into table
-        AddressEntry entry;
-        entry.insertionTime = 0;
-        entry.portno = atoi(portno);
-        if (addresstable.size() >= (unsigned int)addressTableSize)
-            error("Too many entries in address table file '%s'", fileName);
-        addresstable[MACAddress(hexaddress)] = entry;
+        MACAddress address(hexaddress);
+        AddressEntry *entry = addresstable.find(address);
+        if (!entry)
+        {
+            if (addresstable.size() >= addressTableSize)
+                error("Too many entries in address table file '%s'", fileName);
+            entry = addresstable.insert(address);
+        }
+        entry->insertionTime = 0;
+        entry->portno = atoi(portno);
 
         // Garbage collection before next iteration
         delete [] line;
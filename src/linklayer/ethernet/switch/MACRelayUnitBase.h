@@ -19,12 +19,13 @@
 #ifndef __INET_MACRELAYUNITBASE_H
 #define __INET_MACRELAYUNITBASE_H
 
-#include <map>
 #include <string>
+#include <vector>
 
 #include "INETDefs.h"
 
 #include "MACAddress.h"
+#include "MACAddressTable.h"
 
 class EtherFrame;
 
@@ -39,20 +40,10 @@ class INET_API MACRelayUnitBase : public cSimpleModule
 {
   public:
     // An entry of the Address Lookup Table
-    struct AddressEntry
-    {
-        int portno;              // Input port
-        simtime_t insertionTime; // Arrival time of Lookup Address Table entry
-    };
+    typedef MACAddressTable::Entry AddressEntry;
 
   protected:
-    struct MAC_compare
-    {
-        bool operator()(const MACAddress& u1, const MACAddress& u2) const
-            {return u1.compareTo(u2) < 0;}
-    };
-
-    typedef std::map<MACAddress, AddressEntry, MAC_compare> AddressTable;
+    typedef MACAddressTable AddressTable;
 
     // Parameters controlling how the switch operates
     int numPorts;               // Number of ports of the switch
@@ -61,6 +52,9 @@ class INET_API MACRelayUnitBase : public cSimpleModule
 
     AddressTable addresstable;  // Address Lookup Table
 
+    // statistics
+    std::vector<long> numLearnedAddresses; // per port: addresses learned (new or moved) on the port
+
     int seqNum;                 // counter for PAUSE frames
     simtime_t *pauseFinished;   // finish time of last PAUSE (array of numPorts element)
 
@@ -74,6 +68,11 @@ class INET_API MACRelayUnitBase : public cSimpleModule
      */
     virtual void initialize();
 
+    /**
+     * Records per-port learning statistics.
+     */
+    virtual void finish();
+
     /**
      * Updates address table with source address, determines output port
      * and sends out (or broadcasts) frame on ports. Includes calls to
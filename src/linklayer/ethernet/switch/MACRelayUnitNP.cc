@@ -188,6 +188,8 @@ void MACRelayUnitNP::processFrame(cMessage *msg)
 
 void MACRelayUnitNP::finish()
 {
+    MACRelayUnitBase::finish();
+
     recordScalar("processed frames", numProcessedFrames);
     recordScalar("dropped frames", numDroppedFrames);
 }
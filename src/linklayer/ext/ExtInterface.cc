@@ -201,6 +201,8 @@ void ExtInterface::updateDisplayString()
 
 void ExtInterface::finish()
 {
+    if (connected)
+        rtScheduler->recordScalars(this);
     std::cout << getFullPath() << ": " << numSent << " packets sent, " <<
             numRcvd << " packets received, " << numDropped <<" packets dropped.\n";
 }
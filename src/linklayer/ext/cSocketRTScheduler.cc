@@ -32,6 +32,14 @@
 #define PCAP_SNAPLEN 65536 /* capture all data packets with up to pcap_snaplen bytes */
 #define PCAP_TIMEOUT 10    /* Timeout in ms */
 
+#if defined(LINUX) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 14))
+#define HAVE_SENDMMSG
+#endif
+
+Register_GlobalConfigOption(CFGID_SOCKETRTSCHEDULER_RECEIVE_BATCH_SIZE, "socketrtscheduler-receive-batch-size", CFG_INT, "64", "cSocketRTScheduler: the maximum number of frames taken from the capture buffer of an interface per wakeup.");
+Register_GlobalConfigOptionU(CFGID_SOCKETRTSCHEDULER_RING_BUFFER_SIZE, "socketrtscheduler-ring-buffer-size", "B", "4MiB", "cSocketRTScheduler: the size of the capture buffer (memory-mapped ring on Linux) of each interface.");
+Register_GlobalConfigOption(CFGID_SOCKETRTSCHEDULER_SEND_BATCH_SIZE, "socketrtscheduler-send-batch-size", CFG_INT, "32", "cSocketRTScheduler: the maximum number of outgoing packets sent together; 1 sends every packet immediately.");
+
 #ifdef HAVE_PCAP
 std::vector<cModule *>cSocketRTScheduler::modules;
 std::vector<pcap_t *>cSocketRTScheduler::pds;
@@ -39,6 +47,9 @@ std::vector<int32>cSocketRTScheduler::datalinks;
 std::vector<int32>cSocketRTScheduler::headerLengths;
 #endif
 timeval cSocketRTScheduler::baseTime;
+int cSocketRTScheduler::receiveBatchSize;
+unsigned long cSocketRTScheduler::numReceivedPackets;
+unsigned long cSocketRTScheduler::numReceiveBatches;
 
 Register_Class(cSocketRTScheduler);
 
@@ -51,6 +62,9 @@ inline std::ostream& operator<<(std::ostream& out, const timeval& tv)
 cSocketRTScheduler::cSocketRTScheduler() : cScheduler()
 {
     fd = INVALID_SOCKET;
+    numQueued = 0;
+    sendBatchSize = 1;
+    scalarsRecorded = false;
 }
 
 cSocketRTScheduler::~cSocketRTScheduler()
@@ -61,6 +75,15 @@ void cSocketRTScheduler::startRun()
 {
     gettimeofday(&baseTime, NULL);
 
+    receiveBatchSize = std::max(1L, ev.getConfig()->getAsInt(CFGID_SOCKETRTSCHEDULER_RECEIVE_BATCH_SIZE));
+    sendBatchSize = std::max(1L, ev.getConfig()->getAsInt(CFGID_SOCKETRTSCHEDULER_SEND_BATCH_SIZE));
+    numQueued = 0;
+    numReceivedPackets = numReceiveBatches = 0;
+    numEvents = numLateEvents = 0;
+    totalLag = maxLag = 0;
+    numSentPackets = numSendCalls = 0;
+    scalarsRecorded = false;
+
 #ifdef HAVE_PCAP
     // Enabling sending makes no sense when we can't receive...
     fd = socket(AF_INET, SOCK_RAW, IPPROTO_RAW);
@@ -75,15 +98,23 @@ void cSocketRTScheduler::startRun()
 
 void cSocketRTScheduler::endRun()
 {
+    if (fd != INVALID_SOCKET)
+        flushSendQueue();
     close(fd);
     fd = INVALID_SOCKET;
 
+    EV << "cSocketRTScheduler: " << numReceivedPackets << " packets received in " << numReceiveBatches << " batches, "
+       << numSentPackets << " packets sent in " << numSendCalls << " system calls; "
+       << numLateEvents << " of " << numEvents << " events late, mean lag "
+       << (numLateEvents > 0 ? totalLag / numLateEvents : 0) << "s, max lag " << maxLag << "s.\n";
+
 #ifdef HAVE_PCAP
     for (uint16 i=0; i<pds.size(); i++)
     {
+        // the simulation is being shut down, so errors are only logged
         pcap_stat ps;
         if (pcap_stats(pds.at(i), &ps) < 0)
-            throw cRuntimeError("cSocketRTScheduler::endRun(): Cannot query pcap statistics: %s", pcap_geterr(pds.at(i)));
+            EV << "cSocketRTScheduler::endRun(): Cannot query pcap statistics: " << pcap_geterr(pds.at(i)) << "\n";
         else
             EV << modules.at(i)->getFullPath() << ": Received Packets: " << ps.ps_recv << " Dropped Packets: " << ps.ps_drop << ".\n";
         pcap_close(pds.at(i));
@@ -97,6 +128,26 @@ void cSocketRTScheduler::endRun()
 #endif
 }
 
+void cSocketRTScheduler::recordScalars(cComponent *module)
+{
+    if (scalarsRecorded)
+        return;
+    scalarsRecorded = true;
+
+    // send the packets still in the queue, so that they are counted
+    if (fd != INVALID_SOCKET)
+        flushSendQueue();
+
+    module->recordScalar("cSocketRTScheduler received packets", numReceivedPackets);
+    module->recordScalar("cSocketRTScheduler receive batches", numReceiveBatches);
+    module->recordScalar("cSocketRTScheduler sent packets", numSentPackets);
+    module->recordScalar("cSocketRTScheduler send calls", numSendCalls);
+    module->recordScalar("cSocketRTScheduler events", numEvents);
+    module->recordScalar("cSocketRTScheduler late events", numLateEvents);
+    module->recordScalar("cSocketRTScheduler mean lag", numLateEvents > 0 ? totalLag / numLateEvents : 0, "s");
+    module->recordScalar("cSocketRTScheduler max lag", maxLag, "s");
+}
+
 void cSocketRTScheduler::executionResumed()
 {
     gettimeofday(&baseTime, NULL);
@@ -115,12 +166,23 @@ void cSocketRTScheduler::setInterfaceModule(cModule *mod, const char *dev, const
     if (!mod || !dev || !filter)
         throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): arguments must be non-NULL");
 
-    /* get pcap handle */
+    /* get pcap handle; on Linux, libpcap captures into a memory-mapped ring of the given buffer size */
     memset(&errbuf, 0, sizeof(errbuf));
-    if ((pd = pcap_open_live(dev, PCAP_SNAPLEN, 0, PCAP_TIMEOUT, errbuf)) == NULL)
+    if ((pd = pcap_create(dev, errbuf)) == NULL)
         throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Cannot open pcap device, error = %s", errbuf);
-    else if (strlen(errbuf) > 0)
-        EV << "cSocketRTScheduler::setInterfaceModule(): pcap_open_live returned warning: " << errbuf << "\n";
+    pcap_set_snaplen(pd, PCAP_SNAPLEN);
+    pcap_set_promisc(pd, 0);
+    pcap_set_timeout(pd, PCAP_TIMEOUT);
+    pcap_set_buffer_size(pd, (int)ev.getConfig()->getAsDouble(CFGID_SOCKETRTSCHEDULER_RING_BUFFER_SIZE));
+#ifdef HAVE_PCAP_IMMEDIATE_MODE
+    // deliver frames as soon as they arrive, not when a block of the ring is full
+    pcap_set_immediate_mode(pd, 1);
+#endif
+    int status = pcap_activate(pd);
+    if (status < 0)
+        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Cannot open pcap device, error = %s", pcap_geterr(pd));
+    else if (status > 0)
+        EV << "cSocketRTScheduler::setInterfaceModule(): pcap_activate returned warning: " << pcap_geterr(pd) << "\n";
 
     /* compile this command into a filter program */
     if (pcap_compile(pd, &fcode, (char *)filter, 0, 0) < 0)
@@ -195,12 +257,14 @@ static void packet_handler(u_char *user, const struct pcap_pkthdr *hdr, const u_
 
     // signalize new incoming packet to the interface via cMessage
     EV << "Captured " << hdr->caplen - headerLength << " bytes for an IP packet.\n";
-    timeval curTime;
-    gettimeofday(&curTime, NULL);
-    curTime = timeval_substract(curTime, cSocketRTScheduler::baseTime);
-    simtime_t t = curTime.tv_sec + curTime.tv_usec*1e-6;
-    // TBD assert that it's somehow not smaller than previous event's time
+    // frames of a batch arrived at different times: use the capture timestamp,
+    // but the packet cannot arrive before the current event
+    timeval captureTime = timeval_substract(hdr->ts, cSocketRTScheduler::baseTime);
+    simtime_t t = captureTime.tv_sec + captureTime.tv_usec*1e-6;
+    if (t < simulation.getSimTime())
+        t = simulation.getSimTime();
     notificationMsg->setArrival(module, -1, t);
+    cSocketRTScheduler::numReceivedPackets++;
 
     simulation.msgQueue.insert(notificationMsg);
 }
@@ -243,11 +307,13 @@ bool cSocketRTScheduler::receiveWithTimeout()
         if (!(FD_ISSET(fd[i], &rdfds)))
             continue;
 #endif
-        if ((n = pcap_dispatch(pds.at(i), 1, packet_handler, (uint8 *)&i)) < 0)
+        if ((n = pcap_dispatch(pds.at(i), receiveBatchSize, packet_handler, (uint8 *)&i)) < 0)
             throw cRuntimeError("cSocketRTScheduler::pcap_dispatch(): An error occured: %s", pcap_geterr(pds.at(i)));
         if (n > 0)
             found = true;
     }
+    if (found)
+        numReceiveBatches++;
 #ifndef LINUX
     if (!found)
         select(0, NULL, NULL, NULL, &timeout);
@@ -304,6 +370,9 @@ cMessage *cSocketRTScheduler::getNextEvent()
     gettimeofday(&curTime, NULL);
     if (timeval_greater(targetTime, curTime))
     {
+        // don't hold back outgoing packets while waiting
+        if (numQueued > 0)
+            flushSendQueue();
         int32 status = receiveUntil(targetTime);
         if (status == -1)
             return NULL; // interrupted by user
@@ -315,8 +384,14 @@ cMessage *cSocketRTScheduler::getNextEvent()
         // we're behind -- customized versions of this class may
         // alert if we're too much behind, whatever that means
         diffTime = timeval_substract(curTime, targetTime);
-        EV << "We are behind: " << diffTime.tv_sec + diffTime.tv_usec * 1e-6 << " seconds\n";
+        double lag = diffTime.tv_sec + diffTime.tv_usec * 1e-6;
+        EV << "We are behind: " << lag << " seconds\n";
+        numLateEvents++;
+        totalLag += lag;
+        maxLag = std::max(maxLag, lag);
     }
+    if (event)
+        numEvents++;
     return event;
 }
 #undef cEvent
@@ -326,10 +401,74 @@ void cSocketRTScheduler::sendBytes(uint8 *buf, size_t numBytes, struct sockaddr
     if (fd == INVALID_SOCKET)
         throw cRuntimeError("cSocketRTScheduler::sendBytes(): no raw socket.");
 
-    int sent = sendto(fd, (char *)buf, numBytes, 0, to, addrlen);  //note: no ssize_t on MSVC
+    if (numQueued == sendQueue.size())
+        sendQueue.resize(numQueued + 1);
+    OutgoingPacket& packet = sendQueue[numQueued++];
+    packet.data.assign(buf, buf + numBytes);
+    memcpy(&packet.to, to, addrlen);
+    packet.addrlen = addrlen;
 
-    if ((size_t)sent == numBytes)
-        EV << "Sent an IP packet with length of " << sent << " bytes.\n";
-    else
-        EV << "Sending of an IP packet FAILED! (sendto returned " << sent << " (" << strerror(errno) << ") instead of " << numBytes << ").\n";
+    if (numQueued >= sendBatchSize)
+        flushSendQueue();
+}
+
+void cSocketRTScheduler::flushSendQueue()
+{
+    unsigned int numSent = 0;
+
+#ifdef HAVE_SENDMMSG
+    std::vector<struct mmsghdr> messages(numQueued);
+    std::vector<struct iovec> iovecs(numQueued);
+    for (unsigned int i = 0; i < numQueued; i++)
+    {
+        iovecs[i].iov_base = &sendQueue[i].data[0];
+        iovecs[i].iov_len = sendQueue[i].data.size();
+        memset(&messages[i], 0, sizeof(struct mmsghdr));
+        messages[i].msg_hdr.msg_name = &sendQueue[i].to;
+        messages[i].msg_hdr.msg_namelen = sendQueue[i].addrlen;
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    while (numSent < numQueued)
+    {
+        int n = sendmmsg(fd, &messages[numSent], numQueued - numSent, 0);
+        numSendCalls++;
+        if (n <= 0)
+        {
+            // skip the packet that could not be sent
+            EV << "Sending of an IP packet FAILED! (sendmmsg returned " << n << " (" << strerror(errno) << ")).\n";
+            numSent++;
+            continue;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            if (messages[numSent + i].msg_len == iovecs[numSent + i].iov_len)
+            {
+                EV << "Sent an IP packet with length of " << messages[numSent + i].msg_len << " bytes.\n";
+                numSentPackets++;
+            }
+            else
+                EV << "Sending of an IP packet FAILED! (sent " << messages[numSent + i].msg_len << " bytes instead of " << iovecs[numSent + i].iov_len << ").\n";
+        }
+        numSent += n;
+    }
+#else
+    for ( ; numSent < numQueued; numSent++)
+    {
+        OutgoingPacket& packet = sendQueue[numSent];
+        size_t numBytes = packet.data.size();
+        int sent = sendto(fd, (char *)&packet.data[0], numBytes, 0, (struct sockaddr *)&packet.to, packet.addrlen);  //note: no ssize_t on MSVC
+        numSendCalls++;
+
+        if ((size_t)sent == numBytes)
+        {
+            EV << "Sent an IP packet with length of " << sent << " bytes.\n";
+            numSentPackets++;
+        }
+        else
+            EV << "Sending of an IP packet FAILED! (sendto returned " << sent << " (" << strerror(errno) << ") instead of " << numBytes << ").\n";
+    }
+#endif
+
+    numQueued = 0;
 }
@@ -36,13 +36,45 @@
 #endif
 #include "ExtFrame_m.h"
 
+/**
+ * Real-time scheduler that captures packets from real network interfaces
+ * with pcap, and sends packets through a raw socket (see ExtInterface).
+ *
+ * Frames are taken from the capture buffers in batches: the capture buffer
+ * of each interface is a memory-mapped ring where libpcap supports it
+ * (Linux), and up to socketrtscheduler-receive-batch-size frames are
+ * delivered per wakeup. Outgoing packets are queued and sent in batches of
+ * up to socketrtscheduler-send-batch-size packets (with one sendmmsg() call
+ * where available); the queue is also flushed whenever the scheduler is
+ * about to wait for the next event, so packets are never delayed while the
+ * simulation is idle.
+ */
 class cSocketRTScheduler : public cScheduler
 {
     protected:
+        struct OutgoingPacket
+        {
+            std::vector<uint8> data;
+            sockaddr_storage to;
+            socklen_t addrlen;
+        };
+
         int fd;
+        std::vector<OutgoingPacket> sendQueue;  // the first numQueued packets are to be sent
+        unsigned int numQueued;
+        unsigned int sendBatchSize;
+
+        // statistics
+        unsigned long numEvents;        // events returned by the scheduler
+        unsigned long numLateEvents;    // events returned after their wall clock time
+        double totalLag, maxLag;        // lag of the late events (s)
+        unsigned long numSentPackets;
+        unsigned long numSendCalls;     // number of system calls used for sending
+        bool scalarsRecorded;
 
         virtual bool receiveWithTimeout();
         virtual int receiveUntil(const timeval& targetTime);
+        virtual void flushSendQueue();
     public:
         /**
          * Constructor.
@@ -60,6 +92,9 @@ class cSocketRTScheduler : public cScheduler
         static std::vector<int> headerLengths;
 #endif
         static timeval baseTime;
+        static int receiveBatchSize;
+        static unsigned long numReceivedPackets;
+        static unsigned long numReceiveBatches;  // wakeups that delivered at least one packet
 
         /**
          * Called at the beginning of a simulation run.
@@ -83,6 +118,14 @@ class cSocketRTScheduler : public cScheduler
          */
         void setInterfaceModule(cModule *mod, const char *dev, const char *filter);
 
+        /**
+         * Sends the queued packets, and records the statistics of the
+         * scheduler as scalars of the given module. To be called from the
+         * finish() function of an interface module; only the first call in
+         * a run records, as the statistics are shared by all interfaces.
+         */
+        void recordScalars(cComponent *module);
+
 #if OMNETPP_VERSION >= 0x0500
         /**
          * Returns the first event in the Future Event Set.
@@ -101,7 +144,8 @@ class cSocketRTScheduler : public cScheduler
 #endif
 
         /**
-         * Send on the currently open connection
+         * Send on the currently open connection. The bytes are copied, and
+         * the packet may be sent later, in a batch with other packets.
          */
         void sendBytes(unsigned char *buf, size_t numBytes, struct sockaddr *from, socklen_t addrlen);
 };
@@ -23,6 +23,7 @@
 #include "FWMath.h"
 #include "yans-error-rate-model.h"
 #include "nist-error-rate-model.h"
+#include "TabulatedErrorRateModel.h"
 #define NS3CALMODE
 
 
@@ -65,12 +66,15 @@ void Ieee80211RadioModel::initializeFrom(cModule *radioModule)
         errorModel = new NistErrorRateModel();
     else
         opp_error("Error %s model is not valid",radioModule->par("errorModel").stringValue());
+    if (radioModule->par("tabulateErrorModel").boolValue())
+        errorModel = new TabulatedErrorRateModel(errorModel, radioModule->par("errorModel").stringValue());
 
 
     btSize = radioModule->par("btSize").longValue();
     autoHeaderSize = radioModule->par("AutoHeaderSize");
 
     useTestFrame = radioModule->par("airtimeLinkComputation").boolValue();
+    perChunkErrorModel = radioModule->par("perChunkErrorModel").boolValue();
 
     parseTable = NULL;
     PHY_HEADER_LENGTH = 26e-6;
@@ -137,8 +141,9 @@ bool Ieee80211RadioModel::isReceivedCorrectly(AirFrame *airframe, const SnrList&
         if (iter->snr < snirMin)
             snirMin = iter->snr;
 
-    cPacket *frame = airframe->getEncapsulatedPacket();
-    EV << "packet (" << frame->getClassName() << ")" << frame->getName() << " (" << frame->info() << ") snrMin=" << snirMin << endl;
+    // the AirFrame has the name and the length of the packet; do not access
+    // the packet, that would copy it if it is shared (see AirFrame)
+    EV << "packet " << airframe->getName() << " (" << airframe->getBitLength() << " bits) snrMin=" << snirMin << endl;
 
     if (i%1000==0)
     {
@@ -147,13 +152,19 @@ bool Ieee80211RadioModel::isReceivedCorrectly(AirFrame *airframe, const SnrList&
     }
     i++;
 
+    // the frame ends now, and its MPDU is sent in its last lengthMPDU/bitrate seconds
+    double headerSnirMin = snirMin;
+    SnrList mpduSnrList;
+    if (perChunkErrorModel && !fileBer)
+        splitSnrList(receivedList, simTime() - airframe->getBitLength() / airframe->getBitrate(), headerSnirMin, mpduSnrList);
+
     if (snirMin <= snirThreshold)
     {
         // if snir is too low for the packet to be recognized
         EV << "COLLISION! Packet got lost. Noise only\n";
         return false;
     }
-    else if (isPacketOK(snirMin, frame->getBitLength(), airframe->getBitrate()))
+    else if (isPacketOK(headerSnirMin, airframe->getBitLength(), airframe->getBitrate(), mpduSnrList.empty() ? NULL : &mpduSnrList))
     {
         EV << "packet was received correctly, it is now handed to upper layer...\n";
         return true;
@@ -227,7 +238,31 @@ double Ieee80211RadioModel::getTestFrameError(double snirMin, double bitrate)
 }
 
 
-bool Ieee80211RadioModel::isPacketOK(double snirMin, int lengthMPDU, double bitrate)
+void Ieee80211RadioModel::splitSnrList(const SnrList& receivedList, simtime_t mpduStart, double& headerSnirMin, SnrList& mpduSnrList)
+{
+    headerSnirMin = receivedList.begin()->snr;
+    for (SnrList::const_iterator iter = receivedList.begin(); iter != receivedList.end(); iter++)
+    {
+        if (iter->time >= mpduStart)
+        {
+            mpduSnrList.push_back(*iter);
+            continue;
+        }
+        if (iter->snr < headerSnirMin)
+            headerSnirMin = iter->snr;
+        // the SNR at the start of the MPDU is that of the last entry before it
+        SnrList::const_iterator next = iter;
+        if (++next == receivedList.end() || next->time > mpduStart)
+        {
+            SnrListEntry entry;
+            entry.time = mpduStart;
+            entry.snr = iter->snr;
+            mpduSnrList.push_back(entry);
+        }
+    }
+}
+
+bool Ieee80211RadioModel::isPacketOK(double snirMin, int lengthMPDU, double bitrate, const SnrList *mpduSnrList)
 {
     double berHeader, berMPDU;
     ModulationType modeBody;
@@ -266,6 +301,8 @@ bool Ieee80211RadioModel::isPacketOK(double snirMin, int lengthMPDU, double bitr
     double MpduNoError;
     if (fileBer)
         MpduNoError = 1-parseTable->getPer(bitrate, snirMin, lengthMPDU/8);
+    else if (mpduSnrList)
+        MpduNoError = errorModel->GetSnrListSuccessRate(modeBody, *mpduSnrList, simTime(), bitrate);
     else
         MpduNoError = errorModel->GetChunkSuccessRate(modeBody, snirMin, lengthMPDU);
 
@@ -52,6 +52,7 @@ class INET_API Ieee80211RadioModel : public IRadioModel
 
     unsigned int btSize; //
     bool useTestFrame;
+    bool perChunkErrorModel;
 
   public:
     virtual void initializeFrom(cModule *radioModule);
@@ -72,7 +73,9 @@ class INET_API Ieee80211RadioModel : public IRadioModel
                 }
   protected:
     // utility
-    virtual bool isPacketOK(double snirMin, int lengthMPDU, double bitrate);
+    virtual bool isPacketOK(double snirMin, int lengthMPDU, double bitrate, const SnrList *mpduSnrList = NULL);
+    // utility: splits the SNR list of a frame at the start of its MPDU
+    virtual void splitSnrList(const SnrList& receivedList, simtime_t mpduStart, double& headerSnirMin, SnrList& mpduSnrList);
     // utility
     virtual double dB2fraction(double dB);
 
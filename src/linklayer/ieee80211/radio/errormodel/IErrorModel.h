@@ -16,12 +16,61 @@
 #ifndef IERRORMODEL_H_
 #define IERRORMODEL_H_
 
+#include <vector>
+#include "SnrList.h"
+
 class IErrorModel
 {
     public:
         IErrorModel() {};
         virtual ~IErrorModel() {};
         virtual double GetChunkSuccessRate(ModulationType mode, double snr, uint32_t nbits) const = 0;
+
+        /**
+         * Returns the probability that all of the n chunks are received without
+         * errors; chunk i has nbits[i] bits received with snr[i]. The default
+         * implementation multiplies the success rates of the chunks.
+         */
+        virtual double GetChunkSuccessRates(ModulationType mode, int n, const double *snr, const uint32_t *nbits) const
+        {
+            double successRate = 1;
+            for (int i = 0; i < n && successRate > 0; i++)
+                successRate *= GetChunkSuccessRate(mode, snr[i], nbits[i]);
+            return successRate;
+        }
+
+        /**
+         * Returns the probability that a frame sent with the given bitrate is
+         * received without errors until endTime, evaluating the whole SnrList
+         * in one GetChunkSuccessRates() call: every entry is a chunk that lasts
+         * until the next entry (the last one until endTime).
+         */
+        double GetSnrListSuccessRate(ModulationType mode, const SnrList& snrList, simtime_t endTime, double bitrate) const
+        {
+            if (snrList.empty())
+                return 1;
+            std::vector<double> snr;
+            std::vector<uint32_t> nbits;
+            snr.reserve(snrList.size());
+            nbits.reserve(snrList.size());
+            simtime_t startTime = snrList.begin()->time;
+            uint32_t bitsSoFar = 0;
+            for (SnrList::const_iterator it = snrList.begin(); it != snrList.end(); )
+            {
+                double snrValue = it->snr;
+                ++it;
+                // rounding the cumulated number of bits so that no bits are lost
+                simtime_t chunkEndTime = it == snrList.end() ? endTime : it->time;
+                uint32_t bits = (uint32_t)floor(SIMTIME_DBL(chunkEndTime - startTime) * bitrate + 0.5);
+                if (bits > bitsSoFar)
+                {
+                    snr.push_back(snrValue);
+                    nbits.push_back(bits - bitsSoFar);
+                    bitsSoFar = bits;
+                }
+            }
+            return snr.empty() ? 1 : GetChunkSuccessRates(mode, snr.size(), &snr[0], &nbits[0]);
+        }
 };
 
 #endif /* IERRORMODEL_H_ */
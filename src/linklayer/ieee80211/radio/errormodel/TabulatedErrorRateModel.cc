@@ -0,0 +1,159 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+
+#include <math.h>
+
+#include "TabulatedErrorRateModel.h"
+
+#define MIN_SNR_DB     -10.0
+#define MAX_SNR_DB     40.0
+#define SNR_STEP_DB    0.01
+#define NUM_SAMPLES    ((int)((MAX_SNR_DB - MIN_SNR_DB) / SNR_STEP_DB + 0.5) + 1)
+
+// the limits of the exponent stored in the table: below MIN_EXPONENT the success
+// rate of any chunk is 1 within 1e-20, an infinite exponent (the bit error rate
+// is 1) is clamped to MAX_EXPONENT
+#define MIN_EXPONENT   1e-30
+#define MAX_EXPONENT   1e300
+
+// the largest change of ln(exponent) between two samples that is interpolated;
+// the model is smooth where it matters (0.01 < success rate < 0.99 for any
+// packet length), larger changes indicate a discontinuity or an underflow
+#define MAX_LOG_EXPONENT_STEP  1.0
+
+TabulatedErrorRateModel::TableMap TabulatedErrorRateModel::tables;
+
+static bool isSameMode(const ModulationType& a, const ModulationType& b)
+{
+    return a.getModulationClass() == b.getModulationClass() && a.getConstellationSize() == b.getConstellationSize() &&
+           a.getCodeRate() == b.getCodeRate() && a.getBandwidth() == b.getBandwidth() &&
+           a.getPhyRate() == b.getPhyRate() && a.getDataRate() == b.getDataRate();
+}
+
+static double toSnr(double x)
+{
+    return pow(10.0, (MIN_SNR_DB + x * SNR_STEP_DB) / 10);
+}
+
+TabulatedErrorRateModel::TabulatedErrorRateModel(IErrorModel *model, const char *modelName)
+{
+    this->model = model;
+    this->modelName = modelName;
+}
+
+TabulatedErrorRateModel::~TabulatedErrorRateModel()
+{
+    delete model;
+}
+
+const TabulatedErrorRateModel::Table *TabulatedErrorRateModel::GetTable(const ModulationType& mode) const
+{
+    // the DSSS success rates are cheaper to calculate than to interpolate
+    if (mode.getModulationClass() == MOD_CLASS_DSSS)
+        return NULL;
+    for (ModeTableList::const_iterator it = modeTables.begin(); it != modeTables.end(); ++it)
+        if (isSameMode(it->first, mode))
+            return it->second;
+
+    std::string key = modelName + opp_stringf(" %d %d %d %u %u %u", (int)mode.getModulationClass(), (int)mode.getConstellationSize(),
+            (int)mode.getCodeRate(), mode.getBandwidth(), mode.getPhyRate(), mode.getDataRate());
+    TableMap::iterator it = tables.find(key);
+    if (it == tables.end())
+    {
+        it = tables.insert(std::make_pair(key, Table())).first;
+        BuildTable(it->second, mode);
+    }
+    modeTables.push_back(std::make_pair(mode, &it->second));
+    return &it->second;
+}
+
+void TabulatedErrorRateModel::BuildTable(Table& table, const ModulationType& mode) const
+{
+    // the models log every calculation, turn it off while building the table
+    bool tracingDisabled = ev.disable_tracing;
+    ev.disable_tracing = true;
+    table.logExponents.resize(NUM_SAMPLES);
+    for (int i = 0; i < NUM_SAMPLES; i++)
+    {
+        double successRate = model->GetChunkSuccessRate(mode, toSnr(i), 1);
+        double exponent = successRate > 0 ? -log(successRate) : MAX_EXPONENT;
+        table.logExponents[i] = log(std::min(MAX_EXPONENT, std::max(MIN_EXPONENT, exponent)));
+    }
+    ev.disable_tracing = tracingDisabled;
+
+    table.exact.resize(NUM_SAMPLES - 1);
+    for (int i = 0; i < NUM_SAMPLES - 1; i++)
+        table.exact[i] = fabs(table.logExponents[i + 1] - table.logExponents[i]) > MAX_LOG_EXPONENT_STEP;
+}
+
+double TabulatedErrorRateModel::GetBitExponent(const Table *table, double snr) const
+{
+    if (!table || !(snr > 0))
+        return -1;
+    double x = (10 * log10(snr) - MIN_SNR_DB) / SNR_STEP_DB;
+    if (!(x >= 0 && x < NUM_SAMPLES - 1))
+        return -1;
+    int i = (int)x;
+    if (table->exact[i])
+        return -1;
+    const double *y = &table->logExponents[i];
+    return exp(y[0] + (x - i) * (y[1] - y[0]));
+}
+
+double TabulatedErrorRateModel::GetChunkSuccessRate(ModulationType mode, double snr, uint32_t nbits) const
+{
+    double exponent = GetBitExponent(GetTable(mode), snr);
+    if (exponent < 0)
+        return model->GetChunkSuccessRate(mode, snr, nbits);
+    return exp(-(double)nbits * exponent);
+}
+
+double TabulatedErrorRateModel::GetChunkSuccessRates(ModulationType mode, int n, const double *snr, const uint32_t *nbits) const
+{
+    const Table *table = GetTable(mode);
+    double exponentSum = 0;
+    double successRate = 1;
+    for (int i = 0; i < n; i++)
+    {
+        double exponent = GetBitExponent(table, snr[i]);
+        if (exponent < 0)
+            successRate *= model->GetChunkSuccessRate(mode, snr[i], nbits[i]);
+        else
+            exponentSum += (double)nbits[i] * exponent;
+    }
+    return successRate * exp(-exponentSum);
+}
+
+double TabulatedErrorRateModel::GetMaxError(ModulationType mode, uint32_t nbits) const
+{
+    if (!GetTable(mode))
+        return 0;
+    bool tracingDisabled = ev.disable_tracing;
+    ev.disable_tracing = true;
+    double maxError = 0;
+    for (int i = 0; i < NUM_SAMPLES - 1; i++)
+    {
+        for (int j = 1; j < 4; j++)
+        {
+            double snr = toSnr(i + j / 4.0);
+            double error = fabs(GetChunkSuccessRate(mode, snr, nbits) - model->GetChunkSuccessRate(mode, snr, nbits));
+            maxError = std::max(maxError, error);
+        }
+    }
+    ev.disable_tracing = tracingDisabled;
+    return maxError;
+}
+
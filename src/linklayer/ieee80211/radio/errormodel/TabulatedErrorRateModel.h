@@ -0,0 +1,98 @@
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/.
+//
+
+
+#ifndef __INET_TABULATEDERRORRATEMODEL_H
+#define __INET_TABULATEDERRORRATEMODEL_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "INETDefs.h"
+#include "WifiMode.h"
+#include "IErrorModel.h"
+
+/**
+ * Decorator that replaces the analytic functions of an error model (e.g.
+ * YansErrorRateModel, NistErrorRateModel) with interpolated lookup tables.
+ *
+ * The success rate of every model has the form exp(-nbits * e(mode, snr)),
+ * where e is the negative logarithm of the success rate of one bit. The table
+ * of a mode stores ln(e) at every 0.01dB between -10dB and 40dB (that is a
+ * smooth function of the SNR in dB), and interpolates it linearly. The
+ * analytic model is called below and above the table, and within intervals
+ * that contain a discontinuity of the model (e.g. the thresholds of the CCK
+ * model) or the point where the bit error rate underflows to 0.
+ *
+ * Tables are built at the first use of a mode (in about 2ms), and they are
+ * shared by all instances that decorate the same model. DSSS modes are not
+ * tabulated, their closed form success rates are cheaper to calculate.
+ */
+class INET_API TabulatedErrorRateModel : public IErrorModel
+{
+  protected:
+    struct Table
+    {
+        std::vector<double> logExponents;  // ln(-ln(success rate of one bit)) at the samples
+        std::vector<bool> exact;           // whether the interval after the sample must be calculated by the model
+    };
+    typedef std::map<std::string, Table> TableMap;
+    typedef std::vector<std::pair<ModulationType, const Table *> > ModeTableList;
+
+    static TableMap tables;     // shared tables, the key is the model name and the mode
+    IErrorModel *model;
+    std::string modelName;
+    mutable ModeTableList modeTables;  // the tables used by this instance
+
+  public:
+    /**
+     * Takes the ownership of the model; modelName identifies the model (and its
+     * parameters, if any) among those that share the tables.
+     */
+    TabulatedErrorRateModel(IErrorModel *model, const char *modelName);
+    virtual ~TabulatedErrorRateModel();
+
+    virtual double GetChunkSuccessRate(ModulationType mode, double snr, uint32_t nbits) const;
+
+    /**
+     * Looks up the table of the mode once, and calculates one exponential for
+     * all the chunks.
+     */
+    virtual double GetChunkSuccessRates(ModulationType mode, int n, const double *snr, const uint32_t *nbits) const;
+
+    /**
+     * Returns the largest absolute difference between the interpolated and the
+     * analytic success rate of an nbits long chunk, checked between the samples
+     * of the table of the mode.
+     */
+    double GetMaxError(ModulationType mode, uint32_t nbits) const;
+
+    const IErrorModel *GetModel() const { return model; }
+
+  protected:
+    /** Returns NULL if the mode is not tabulated */
+    const Table *GetTable(const ModulationType& mode) const;
+    void BuildTable(Table& table, const ModulationType& mode) const;
+
+    /**
+     * Returns -ln(success rate of one bit) interpolated from the table, or -1
+     * if it must be calculated by the model.
+     */
+    double GetBitExponent(const Table *table, double snr) const;
+};
+
+#endif
+
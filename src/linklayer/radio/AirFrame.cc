@@ -0,0 +1,111 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "AirFrame.h"
+
+
+Register_Class(AirFrame);
+
+AirFrame::~AirFrame()
+{
+    if (transmission)
+        releaseTransmission(false);
+}
+
+AirFrame& AirFrame::operator=(const AirFrame& other)
+{
+    if (this == &other)
+        return *this;
+    if (transmission)
+        releaseTransmission(false);
+    AirFrame_Base::operator=(other);
+    copy(other);
+    return *this;
+}
+
+void AirFrame::copy(const AirFrame& other)
+{
+    transmission = other.transmission;
+    if (transmission)
+    {
+        transmission->numReferences++;
+        transmission->numReceptions++;
+    }
+}
+
+cPacket *AirFrame::releaseTransmission(bool keepPacket)
+{
+    SharedTransmission *released = transmission;
+    transmission = NULL;
+    cPacket *packet = NULL;
+    if (--released->numReferences == 0)
+    {
+        if (released->owner)
+            packet = released->owner->releaseTransmission(released, keepPacket);
+        delete released;
+    }
+    return packet;
+}
+
+AirFrame::SharedTransmission *AirFrame::sharePacket(ISharedTransmissionOwner *owner)
+{
+    if (transmission)
+        throw cRuntimeError(this, "sharePacket(): packet already shared");
+    int64 bitLength = getBitLength();
+    cPacket *packet = AirFrame_Base::decapsulate();
+    if (!packet)
+        return NULL;
+    setBitLength(bitLength);
+    transmission = new SharedTransmission(packet, owner);
+    return transmission;
+}
+
+void AirFrame::materializePacket()
+{
+    if (!transmission)
+        return;
+    if (!transmission->packet)
+        throw cRuntimeError(this, "materializePacket(): the shared packet has been deleted with its owner");
+
+    cPacket *packet;
+    if (transmission->numReferences == 1 && transmission->owner)
+        packet = releaseTransmission(true);
+    else
+    {
+        packet = transmission->packet->dup();
+        transmission->numPacketCopies++;
+        releaseTransmission(false);
+    }
+    setBitLength(getBitLength() - packet->getBitLength());
+    encapsulate(packet);
+}
+
+cPacket *AirFrame::decapsulate()
+{
+    materializePacket();
+    return AirFrame_Base::decapsulate();
+}
+
+cPacket *AirFrame::getEncapsulatedPacket() const
+{
+    const_cast<AirFrame *>(this)->materializePacket();
+    return AirFrame_Base::getEncapsulatedPacket();
+}
+
+void AirFrame::parsimPack(cCommBuffer *b)
+{
+    materializePacket();
+    AirFrame_Base::parsimPack(b);
+}
@@ -0,0 +1,110 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_AIRFRAME_H
+#define __INET_AIRFRAME_H
+
+#include "INETDefs.h"
+#include "AirFrame_m.h"
+
+
+/**
+ * Message sent to the channel, see AirFrame.msg.
+ *
+ * The encapsulated packet can be moved into a reference counted
+ * SharedTransmission (see sharePacket()): copies of the AirFrame made after
+ * that only refer to it, and copy the packet when decapsulate() or
+ * getEncapsulatedPacket() is first called on them. ChannelControl uses this
+ * to send the transmission to all radios in range: the AirFrame copies are
+ * only used for computing the noise level by most receivers, and only the
+ * ones that actually decode the frame need the packet.
+ */
+class INET_API AirFrame : public AirFrame_Base
+{
+  public:
+    class SharedTransmission;
+
+    /**
+     * Owns the packets of shared transmissions.
+     */
+    class INET_API ISharedTransmissionOwner
+    {
+      public:
+        virtual ~ISharedTransmissionOwner() {}
+
+        /**
+         * Called when no AirFrame refers to the transmission any more; the
+         * owner must delete the packet, or if keepPacket is true, hand it
+         * over to the current module and return it.
+         */
+        virtual cPacket *releaseTransmission(SharedTransmission *transmission, bool keepPacket) = 0;
+    };
+
+    /**
+     * The packet of a transmission, and the number of AirFrames referring to it.
+     */
+    class INET_API SharedTransmission
+    {
+      public:
+        cPacket *packet;                  // NULL if the owner has been deleted
+        ISharedTransmissionOwner *owner;  // NULL if the owner has been deleted
+        int numReferences;                // AirFrames currently referring to it
+        int numReceptions;                // copies of the AirFrame made since it was shared
+        int numPacketCopies;              // copies of the packet made by these
+
+        SharedTransmission(cPacket *packet, ISharedTransmissionOwner *owner) :
+            packet(packet), owner(owner), numReferences(1), numReceptions(0), numPacketCopies(0) {}
+    };
+
+  protected:
+    SharedTransmission *transmission;  // NULL if the AirFrame contains its packet
+
+  private:
+    void copy(const AirFrame& other);
+    cPacket *releaseTransmission(bool keepPacket);
+
+  public:
+    AirFrame(const char *name = NULL, int kind = 0) : AirFrame_Base(name, kind), transmission(NULL) {}
+    AirFrame(const AirFrame& other) : AirFrame_Base(other), transmission(NULL) { copy(other); }
+    virtual ~AirFrame();
+    AirFrame& operator=(const AirFrame& other);
+    virtual AirFrame *dup() const { return new AirFrame(*this); }
+
+    /**
+     * Moves the encapsulated packet into a new shared transmission of the
+     * given owner; the bit length of the AirFrame does not change. The packet
+     * is dropped into the current module, so this must be called in the
+     * context of the owner. Returns NULL if there is no encapsulated packet.
+     */
+    virtual SharedTransmission *sharePacket(ISharedTransmissionOwner *owner);
+
+    /** Returns the shared transmission this AirFrame refers to, or NULL */
+    SharedTransmission *getSharedTransmission() const { return transmission; }
+
+    /**
+     * Encapsulates a copy of the packet of the shared transmission, or the
+     * packet itself if this is the last AirFrame referring to it.
+     */
+    virtual void materializePacket();
+
+    /** @name Redefined cPacket methods; these materialize the packet first */
+    //@{
+    virtual cPacket *decapsulate();
+    virtual cPacket *getEncapsulatedPacket() const;
+    virtual void parsimPack(cCommBuffer *b);
+    //@}
+};
+
+#endif
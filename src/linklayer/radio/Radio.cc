@@ -45,6 +45,7 @@ Radio::Radio() : rs(this->getId())
     obstacles = NULL;
     radioModel = NULL;
     receptionModel = NULL;
+    receivedPowerTable = NULL;
     transceiverConnect = true;
     receiverConnect = true;
     updateString = NULL;
@@ -79,6 +80,7 @@ void Radio::initialize(int stage)
 
         // initialize noiseLevel
         noiseLevel = thermalNoise;
+        recalculateNoiseLevel = par("recalculateNoiseLevel");
         std::string noiseModel =  par("NoiseGenerator").stdstringValue();
         if (noiseModel!="")
         {
@@ -161,6 +163,18 @@ void Radio::initialize(int stage)
         // stage==2 or later, because base class initializes myRadioRef in that stage
         cc->setRadioChannel(myRadioRef, rs.getChannelNumber());
 
+        // tabulate the received power, so that ChannelControl can skip sending
+        // us transmissions that would be received far below the noise level
+        if (getChannelControlPar("cullReceptions").boolValue() && receptionModel->isDeterministic())
+        {
+            receivedPowerTable = new ReceivedPowerTable(receptionModel, carrierFrequency, MIN_DISTANCE, cc->getInterferenceRange(myRadioRef), 50);
+            double noiseFloor = std::min(thermalNoise, sensitivity);
+            for (SensitivityList::iterator it = sensitivityList.begin(); it != sensitivityList.end(); ++it)
+                noiseFloor = std::min(noiseFloor, it->second);
+            double minReceivePower = noiseFloor * pow(10.0, getChannelControlPar("cullingThreshold").doubleValue() / 10);
+            cc->setRadioReceivedPowerTable(myRadioRef, receivedPowerTable, minReceivePower);
+        }
+
         // statistics
         emit(bitrateSignal, rs.getBitrate());
         emit(radioStateSignal, rs.getState());
@@ -178,6 +192,7 @@ void Radio::finish()
 Radio::~Radio()
 {
     delete radioModel;
+    delete receivedPowerTable;
     delete receptionModel;
     if (noiseGenerator)
         delete noiseGenerator;
@@ -383,7 +398,7 @@ void Radio::handleUpperMsg(AirFrame *airframe)
         // clear the snr list
         snrInfo.sList.clear();
         // add the receive power to the noise level
-        noiseLevel += snrInfo.rcvdPower;
+        changeNoiseLevel(snrInfo.rcvdPower);
     }
 
     // now we are done with all the exception handling and can take care
@@ -578,10 +593,9 @@ void Radio::handleLowerMsgStart(AirFrame* airframe)
         EV << "receiving frame " << airframe->getName() << endl;
 
         // Put frame and related SnrList in receive buffer
-        SnrList snrList;
         snrInfo.ptr = airframe;
         snrInfo.rcvdPower = rcvdPower;
-        snrInfo.sList = snrList;
+        snrInfo.sList.clear();
 
         // add initial snr value
         addNewSnr();
@@ -598,7 +612,7 @@ void Radio::handleLowerMsgStart(AirFrame* airframe)
     {
         EV << "frame " << airframe->getName() << " is just noise\n";
         //add receive power to the noise level
-        noiseLevel += rcvdPower;
+        changeNoiseLevel(rcvdPower);
 
         // if a message is being received add a new snr value
         if (snrInfo.ptr != NULL)
@@ -635,16 +649,15 @@ void Radio::handleLowerMsgEnd(AirFrame * airframe)
     if (snrInfo.ptr == airframe)
     {
         EV << "reception of frame over, preparing to send packet to upper layer\n";
-        // get Packet and list out of the receive buffer:
+        // get Packet and list out of the receive buffer (swap leaves snrInfo.sList empty):
         SnrList list;
-        list = snrInfo.sList;
+        list.swap(snrInfo.sList);
 
         // delete the pointer to indicate that no message is currently
-        // being received and clear the list
+        // being received
         snrInfo.ptr = NULL;
-        snrInfo.sList.clear();
 
-        airframe->setSnr(10*log10(recvBuff[airframe]/ (BASE_NOISE_LEVEL))); //ahmed
+        airframe->setSnr(10*log10(snrInfo.rcvdPower / (BASE_NOISE_LEVEL))); //ahmed
         airframe->setLossRate(lossRate);
         // delete the frame from the recvBuff
         recvBuff.erase(airframe);
@@ -677,11 +690,12 @@ void Radio::handleLowerMsgEnd(AirFrame * airframe)
     else
     {
         EV << "reception of noise message over, removing recvdPower from noiseLevel....\n";
-        // get the rcvdPower and subtract it from the noiseLevel
-        noiseLevel -= recvBuff[airframe];
-
-        // delete message from the recvBuff
-        recvBuff.erase(airframe);
+        // delete message from the recvBuff, and subtract its rcvdPower from the noiseLevel
+        RecvBuff::iterator it = recvBuff.find(airframe);
+        ASSERT(it != recvBuff.end());
+        double rcvdPower = it->second;
+        recvBuff.erase(it);
+        changeNoiseLevel(-rcvdPower);
 
         // update snr info for message currently being received if any
         if (snrInfo.ptr != NULL)
@@ -714,6 +728,26 @@ void Radio::addNewSnr()
     snrInfo.sList.push_back(listEntry);
 }
 
+void Radio::changeNoiseLevel(double powerDelta)
+{
+    if (recalculateNoiseLevel)
+    {
+        // reference implementation: sum up all frames on the air
+        noiseLevel = thermalNoise;
+        for (RecvBuff::const_iterator it = recvBuff.begin(); it != recvBuff.end(); ++it)
+            if (it->first != snrInfo.ptr)
+                noiseLevel += it->second;
+    }
+    else if (recvBuff.empty())
+    {
+        // nothing on the air: reset, so that rounding errors of the
+        // running sum do not accumulate over the simulation
+        noiseLevel = thermalNoise;
+    }
+    else
+        noiseLevel += powerDelta;
+}
+
 void Radio::changeChannel(int channel)
 {
     if (channel == rs.getChannelNumber())
@@ -21,9 +21,10 @@
 
 #include "ChannelAccess.h"
 #include "RadioState.h"
-#include "AirFrame_m.h"
+#include "AirFrame.h"
 #include "IRadioModel.h"
 #include "IReceptionModel.h"
+#include "ReceivedPowerTable.h"
 #include "SnrList.h"
 #include "ObstacleControl.h"
 #include "IPowerControl.h"
@@ -114,6 +115,13 @@ class INET_API Radio : public ChannelAccess, public IPowerControl
     /** Updates the SNR information of the relevant AirFrame */
     virtual void addNewSnr();
 
+    /**
+     * Updates the noise level after the given received power has been added
+     * to (or, if negative, removed from) the noise. recvBuff and snrInfo
+     * must already reflect the change.
+     */
+    virtual void changeNoiseLevel(double powerDelta);
+
     /** Create a new AirFrame */
     virtual AirFrame *createAirFrame() {return new AirFrame();}
 
@@ -168,6 +176,7 @@ class INET_API Radio : public ChannelAccess, public IPowerControl
     ObstacleControl* obstacles;
     IRadioModel *radioModel;
     IReceptionModel *receptionModel;
+    ReceivedPowerTable *receivedPowerTable;  // for ChannelControl's transmission culling, or NULL
 
     /** @name Statistics */
     //@{
@@ -230,9 +239,19 @@ class INET_API Radio : public ChannelAccess, public IPowerControl
     /** State: if not -1, we have to switch to that bitrate once we finished transmitting */
     double newBitrate;
 
-    /** State: the current noise level of the channel.*/
+    /**
+     * State: the current noise level of the channel: thermal noise plus the
+     * receive power of all frames in recvBuff except the one being received.
+     * Maintained as a running sum (see changeNoiseLevel()).
+     */
     double noiseLevel;
 
+    /**
+     * Configuration: if true, the noise level is recalculated from recvBuff
+     * at every change instead of being maintained as a running sum.
+     */
+    bool recalculateNoiseLevel;
+
     /**
      * Configuration: The carrier frequency used. It is read from the ChannelControl module.
      */
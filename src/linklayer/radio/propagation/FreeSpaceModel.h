@@ -57,6 +57,8 @@ public:
      * To be redefined to calculate the received power of a transmission.
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance);
+
+    virtual bool isDeterministic() { return true; }  // also for TwoRayGroundModel
     ~FreeSpaceModel() { };
 
     protected:
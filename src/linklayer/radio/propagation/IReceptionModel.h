@@ -40,6 +40,13 @@ class INET_API IReceptionModel : public cObject
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance) = 0;
 
+    /**
+     * Should return true if calculateReceivedPower() uses no random numbers
+     * and its result is proportional to pSend, so that it can be tabulated
+     * (see ReceivedPowerTable).
+     */
+    virtual bool isDeterministic() { return false; }
+
     /**
      * Virtual destructor.
      */
@@ -37,6 +37,8 @@ class INET_API LogNormalShadowingModel : public FreeSpaceModel {
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance);
 
+    virtual bool isDeterministic() { return false; }  // uses random numbers
+
     private:
     double sigma;
 
@@ -37,6 +37,8 @@ class INET_API NakagamiModel : public FreeSpaceModel {
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance);
 
+    virtual bool isDeterministic() { return false; }  // uses random numbers
+
     protected:
     double m;
     private:
@@ -53,6 +53,8 @@ public:
      */
     virtual double calculateReceivedPower(double pSend, double carrierFrequency, double distance);
 
+    virtual bool isDeterministic() { return false; }  // uses random numbers
+
 };
 
 #endif /* __RAYLEIGH_H__ */
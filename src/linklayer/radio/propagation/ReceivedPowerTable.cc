@@ -0,0 +1,77 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <math.h>
+#include <algorithm>
+
+#include "ReceivedPowerTable.h"
+
+
+ReceivedPowerTable::ReceivedPowerTable(IReceptionModel *receptionModel, double carrierFrequency, double minDistance, double maxDistance, int samplesPerDecade)
+{
+    if (minDistance <= 0 || samplesPerDecade <= 0)
+        throw cRuntimeError("ReceivedPowerTable: invalid parameters");
+    this->receptionModel = receptionModel;
+    this->carrierFrequency = carrierFrequency;
+    this->minDistance = minDistance;
+    logMinDistance = log(minDistance);
+    samplesPerLogDistance = samplesPerDecade / log(10.0);
+
+    int numSamples = 2;
+    if (maxDistance > minDistance)
+        numSamples = std::max(2, (int)ceil((log(maxDistance) - logMinDistance) * samplesPerLogDistance) + 1);
+    powerRatios.resize(numSamples);
+    for (int i = 0; i < numSamples; i++)
+        powerRatios[i] = calculateReceivedPower(1.0, getSampleDistance(i));
+
+    maxPowerRatios.resize(numSamples);
+    maxPowerRatios[numSamples - 1] = powerRatios[numSamples - 1];
+    for (int i = numSamples - 2; i >= 0; i--)
+        maxPowerRatios[i] = std::max(powerRatios[i], maxPowerRatios[i + 1]);
+}
+
+double ReceivedPowerTable::getReceivedPower(double pSend, double distance) const
+{
+    int last = powerRatios.size() - 1;
+    double position = distance > 0 ? (log(distance) - logMinDistance) * samplesPerLogDistance : 0;
+    if (position <= 0)
+        return pSend * powerRatios[0];
+    if (position >= last)
+        return pSend * powerRatios[last];
+    int i = (int)position;
+    double fraction = position - i;
+    if (powerRatios[i] <= 0 || powerRatios[i + 1] <= 0)
+        return pSend * (powerRatios[i] + fraction * (powerRatios[i + 1] - powerRatios[i]));
+    return pSend * powerRatios[i] * pow(powerRatios[i + 1] / powerRatios[i], fraction);
+}
+
+double ReceivedPowerTable::getCullingDistance(double pSend, double minReceivePower) const
+{
+    double minRatio = minReceivePower / pSend;
+
+    // maxPowerRatios is non-increasing: find the first sample below minRatio
+    int lo = 0, hi = maxPowerRatios.size();
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (maxPowerRatios[mid] < minRatio)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    if (lo == (int)maxPowerRatios.size())
+        return INFINITY;
+    return lo == 0 ? 0 : getSampleDistance(lo);
+}
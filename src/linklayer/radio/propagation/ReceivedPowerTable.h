@@ -0,0 +1,82 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_RECEIVEDPOWERTABLE_H
+#define __INET_RECEIVEDPOWERTABLE_H
+
+#include <vector>
+
+#include "INETDefs.h"
+#include "IReceptionModel.h"
+
+
+/**
+ * Received power of a deterministic reception model (see
+ * IReceptionModel::isDeterministic()) as a function of the distance, at a
+ * given carrier frequency, sampled at logarithmically spaced distances.
+ * The received power is proportional to the transmitter power, so the
+ * table stores their ratio.
+ *
+ * ChannelControl uses it to skip sending transmissions to radios that
+ * would receive them far below their noise level (see getCullingDistance()).
+ * The samples are exact; between them the power is interpolated linearly on
+ * the log-log scale, which is exact for the free space model.
+ */
+class INET_API ReceivedPowerTable
+{
+  protected:
+    IReceptionModel *receptionModel;
+    double carrierFrequency;
+    double minDistance;
+    double logMinDistance;
+    double samplesPerLogDistance;  // samples per unit of ln(distance)
+    std::vector<double> powerRatios;     // received/transmitter power at the samples
+    std::vector<double> maxPowerRatios;  // the maximum of powerRatios from the sample on
+
+  protected:
+    double getSampleDistance(int i) const { return exp(logMinDistance + i / samplesPerLogDistance); }
+
+  public:
+    /**
+     * Samples the reception model between the given distances with the
+     * given number of samples per decade. The model is not owned and must
+     * outlive the table.
+     */
+    ReceivedPowerTable(IReceptionModel *receptionModel, double carrierFrequency, double minDistance, double maxDistance, int samplesPerDecade);
+
+    double getCarrierFrequency() const { return carrierFrequency; }
+    double getMinDistance() const { return minDistance; }
+    double getMaxDistance() const { return getSampleDistance(powerRatios.size() - 1); }
+
+    /**
+     * Returns the tabulated received power; distances outside the table are
+     * clamped to its ends.
+     */
+    double getReceivedPower(double pSend, double distance) const;
+
+    /** Returns the received power calculated by the reception model */
+    double calculateReceivedPower(double pSend, double distance) const {
+        return receptionModel->calculateReceivedPower(pSend, carrierFrequency, distance);
+    }
+
+    /**
+     * Returns the smallest sample distance from which on the received power
+     * of all samples is below minReceivePower, or infinity if there is none.
+     * Beyond the end of the table the power is assumed to keep decreasing.
+     */
+    double getCullingDistance(double pSend, double minReceivePower) const;
+};
+
+#endif
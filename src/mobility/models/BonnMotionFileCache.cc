@@ -16,22 +16,85 @@
 //
 
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <ctype.h>
 
 #include "BonnMotionFileCache.h"
 
 
-const BonnMotionFile::Line *BonnMotionFile::getLine(int nodeId) const
+#define BM_BINARY_MAGIC         "BMTRACE"
+#define BM_BYTE_ORDER_MAGIC     0x1A2B3C4D
+
+/* Header of the binary format; followed by the line starts and the values */
+struct bm_binary_header {
+    char magic[8];
+    uint32 byte_order_magic;
+    uint32 num_lines;
+};
+
+
+bool BonnMotionFile::LineReader::next(double& d)
 {
-    LineList::const_iterator it = lines.begin();
-    for (int i=0; i<nodeId && it!=lines.end(); i++) it++;
-    return (it==lines.end()) ? NULL : &(*it);
+    if (value)
+    {
+        if (value == valueEnd)
+            return false;
+        d = *value++;
+        return true;
+    }
+
+    while (pos < end && isspace((unsigned char)*pos))
+        pos++;
+    if (pos == end)
+        return false;
+
+    // the mapped file is not null-terminated, so the token is copied for strtod()
+    const char *tokenEnd = pos;
+    while (tokenEnd < end && !isspace((unsigned char)*tokenEnd))
+        tokenEnd++;
+    char buf[64];
+    size_t length = std::min((size_t)(tokenEnd - pos), sizeof(buf) - 1);
+    memcpy(buf, pos, length);
+    buf[length] = '\0';
+
+    char *numberEnd;
+    d = strtod(buf, &numberEnd);
+    if (numberEnd == buf)
+    {
+        pos = end;
+        return false;
+    }
+    pos += numberEnd - buf;
+    return true;
+}
+
+bool BonnMotionFile::getLine(int nodeId, LineReader& reader) const
+{
+    if (nodeId < 0 || nodeId >= numLines)
+        return false;
+    reader = LineReader();
+    if (binary)
+    {
+        reader.value = binaryValues + binaryLineStarts[nodeId];
+        reader.valueEnd = binaryValues + binaryLineStarts[nodeId + 1];
+    }
+    else
+    {
+        reader.pos = file.getData() + lineStarts[nodeId];
+        reader.end = file.getData() + lineStarts[nodeId + 1];
+    }
+    return true;
 }
 
 
 BonnMotionFileCache *BonnMotionFileCache::inst;
 
+BonnMotionFileCache::~BonnMotionFileCache()
+{
+    for (BMFileMap::iterator it = cache.begin(); it != cache.end(); ++it)
+        delete it->second;
+}
+
 BonnMotionFileCache *BonnMotionFileCache::getInstance()
 {
     if (!inst)
@@ -53,30 +116,60 @@ const BonnMotionFile *BonnMotionFileCache::getFile(const char *filename)
     // if found, return it from cache
     BMFileMap::iterator it = cache.find(std::string(filename));
     if (it!=cache.end())
-        return &(it->second);
+        return it->second;
 
     // load and store in cache
-    BonnMotionFile& bmFile = cache[filename];
-    parseFile(filename, bmFile);
-    return &bmFile;
+    BonnMotionFile *bmFile = new BonnMotionFile();
+    try
+    {
+        parseFile(filename, *bmFile);
+    }
+    catch (...)
+    {
+        delete bmFile;
+        throw;
+    }
+    cache[filename] = bmFile;
+    return bmFile;
 }
 
 void BonnMotionFileCache::parseFile(const char *filename, BonnMotionFile& bmFile)
 {
-    std::ifstream in(filename, std::ios::in);
-    if (in.fail())
-        throw cRuntimeError("Cannot open file '%s'", filename);
+    bmFile.file.open(filename);
+    const char *data = bmFile.file.getData();
+    size_t size = bmFile.file.getSize();
 
-    std::string line;
-    while (std::getline(in, line))
+    struct bm_binary_header header;
+    if (size >= sizeof(header) && memcmp(data, BM_BINARY_MAGIC, sizeof(header.magic)) == 0)
     {
-        bmFile.lines.push_back(BonnMotionFile::Line());
-        BonnMotionFile::Line& vec = bmFile.lines.back();
+        memcpy(&header, data, sizeof(header));
+        if (header.byte_order_magic != BM_BYTE_ORDER_MAGIC)
+            throw cRuntimeError("Cannot read file '%s': binary BonnMotion file has a different byte order", filename);
+        size_t valuesOffset = sizeof(header) + ((size_t)header.num_lines + 1) * sizeof(uint64);
+        if (valuesOffset > size)
+            throw cRuntimeError("Cannot read file '%s': truncated binary BonnMotion file", filename);
+        const uint64 *lineStarts = (const uint64 *)(data + sizeof(header));
+        for (uint32 i = 0; i < header.num_lines; i++)
+            if (lineStarts[i] > lineStarts[i + 1])
+                throw cRuntimeError("Cannot read file '%s': corrupt binary BonnMotion file", filename);
+        if (lineStarts[header.num_lines] > (size - valuesOffset) / sizeof(double))
+            throw cRuntimeError("Cannot read file '%s': truncated binary BonnMotion file", filename);
 
-        std::stringstream linestream(line);
-        double d;
-        while (linestream >> d)
-            vec.push_back(d);
+        bmFile.binary = true;
+        bmFile.binaryLineStarts = lineStarts;
+        bmFile.binaryValues = (const double *)(data + valuesOffset);
+        bmFile.numLines = header.num_lines;
+        return;
+    }
+
+    // text format: one line per node; only the line starts are stored
+    size_t start = 0;
+    while (start < size)
+    {
+        bmFile.lineStarts.push_back(start);
+        const char *newline = (const char *)memchr(data + start, '\n', size - start);
+        start = newline ? newline - data + 1 : size;
     }
-    in.close();
+    bmFile.numLines = bmFile.lineStarts.size();
+    bmFile.lineStarts.push_back(size);
 }
@@ -19,28 +19,79 @@
 #ifndef BONN_MOTION_FILE_CACHE_H
 #define BONN_MOTION_FILE_CACHE_H
 
-#include <list>
+#include <map>
 #include <vector>
 
 #include "INETDefs.h"
 
+#include "MappedFile.h"
+
 
 class BonnMotionFileCache;
 
 /**
  * Represents a BonnMotion file's contents.
+ *
+ * The file is memory-mapped, and only the position of each line is
+ * determined when it is loaded; the numbers of a line are decoded when
+ * they are read through a LineReader. Besides the BonnMotion text format,
+ * a pre-converted binary format is also accepted (see etc/bonnmotion2bin.py),
+ * which needs no decoding at all:
+ *
+ * <pre>
+ * char magic[8];           // "BMTRACE" and a zero byte
+ * uint32 byteOrderMagic;   // 0x1A2B3C4D, in the byte order of the file
+ * uint32 numLines;
+ * uint64 lineStart[numLines + 1];   // index of the first value of each line, and the number of values
+ * double values[];
+ * </pre>
+ *
  * @see BonnMotionFileCache, BonnMotionMobility
  */
 class INET_API BonnMotionFile
 {
   public:
-    typedef std::vector<double> Line;
+    /**
+     * Reads the numbers of a line one by one.
+     */
+    class INET_API LineReader
+    {
+      protected:
+        friend class BonnMotionFile;
+        const char *pos, *end;              // text format: the rest of the line
+        const double *value, *valueEnd;     // binary format: the rest of the values
+      public:
+        LineReader() : pos(NULL), end(NULL), value(NULL), valueEnd(NULL) {}
+
+        /**
+         * Stores the next number of the line into d, and returns true;
+         * returns false at the end of the line or at a token that is not a number.
+         */
+        bool next(double& d);
+    };
+
   protected:
     friend class BonnMotionFileCache;
-    typedef std::list<Line> LineList;
-    LineList lines;
+    MappedFile file;
+    bool binary;
+    std::vector<size_t> lineStarts;     // text format: file offset of each line, and the file size
+    const uint64 *binaryLineStarts;     // binary format: index of the first value of each line
+    const double *binaryValues;
+    int numLines;
+
   public:
-    const Line *getLine(int nodeId) const;
+    BonnMotionFile() : binary(false), binaryLineStarts(NULL), binaryValues(NULL), numLines(0) {}
+
+    /**
+     * Returns the number of lines, i.e. nodes.
+     */
+    int getNumLines() const {return numLines;}
+
+    /**
+     * Sets up the reader for the line of the given node, and returns true;
+     * returns false if there is no such line.
+     */
+    bool getLine(int nodeId, LineReader& reader) const;
 };
 
 
@@ -55,12 +106,12 @@ class INET_API BonnMotionFile
 class INET_API BonnMotionFileCache
 {
   protected:
-    typedef std::map<std::string,BonnMotionFile> BMFileMap;
+    typedef std::map<std::string,BonnMotionFile*> BMFileMap;
     BMFileMap cache;
     static BonnMotionFileCache *inst;
     void parseFile(const char *filename, BonnMotionFile& bmFile);
     BonnMotionFileCache() {}
-    virtual ~BonnMotionFileCache() {}
+    virtual ~BonnMotionFileCache();
 
   public:
     /**
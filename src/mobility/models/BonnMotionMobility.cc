@@ -27,8 +27,6 @@ Define_Module(BonnMotionMobility);
 BonnMotionMobility::BonnMotionMobility()
 {
     is3D = false;
-    lines = NULL;
-    currentLine = -1;
 }
 
 BonnMotionMobility::~BonnMotionMobility()
@@ -48,38 +46,37 @@ void BonnMotionMobility::initialize(int stage)
             nodeId = getParentModule()->getIndex();
         const char *fname = par("traceFile");
         const BonnMotionFile *bmFile = BonnMotionFileCache::getInstance()->getFile(fname);
-        lines = bmFile->getLine(nodeId);
-        if (!lines)
+        if (!bmFile->getLine(nodeId, line))
             throw cRuntimeError("Invalid nodeId %d -- no such line in file '%s'", nodeId, fname);
-        currentLine = 0;
     }
 }
 
 void BonnMotionMobility::initializePosition()
 {
-    const BonnMotionFile::Line& vec = *lines;
-    if (lines->size() >= 3)
+    // the first waypoint; it is read again as the first target
+    BonnMotionFile::LineReader firstWaypoint = line;
+    double t, x, y;
+    if (firstWaypoint.next(t) && firstWaypoint.next(x) && firstWaypoint.next(y))
     {
-        lastPosition.x = vec[1];
-        lastPosition.y = vec[2];
+        lastPosition.x = x;
+        lastPosition.y = y;
     }
 }
 
 void BonnMotionMobility::setTargetPosition()
 {
-    const BonnMotionFile::Line& vec = *lines;
-    if (currentLine + (is3D ? 3 : 2) >= (int)vec.size())
+    double t, x, y, z = 0;
+    if (!line.next(t) || !line.next(x) || !line.next(y) || (is3D && !line.next(z)))
     {
         nextChange = -1;
         stationary = true;
         targetPosition = lastPosition;
         return;
     }
-    nextChange = vec[currentLine];
-    targetPosition.x = vec[currentLine+1];
-    targetPosition.y = vec[currentLine+2];
-    targetPosition.z = is3D ? vec[currentLine+3] : 0;
-    currentLine += (is3D ? 4 : 3);
+    nextChange = t;
+    targetPosition.x = x;
+    targetPosition.y = y;
+    targetPosition.z = z;
     EV << "TARGET: t=" << nextChange << " (" << targetPosition.x << "," << targetPosition.y << ")\n";
 }
 
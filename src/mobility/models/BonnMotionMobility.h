@@ -35,8 +35,7 @@ class INET_API BonnMotionMobility : public LineSegmentsMobilityBase
   protected:
     // state
     bool is3D;
-    const BonnMotionFile::Line *lines;
-    int currentLine;
+    BonnMotionFile::LineReader line;   // the waypoints not yet reached
 
   protected:
     /** @brief Initializes mobility model parameters. */
@@ -0,0 +1,179 @@
+//
+// Copyright (C) 2005 Andras Varga
+// Copyright (C) 2008 Alfonso Ariza
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+#include "Ns2MotionFileCache.h"
+
+
+// returns the first occurrence of str in [begin, end), or end
+static const char *findString(const char *begin, const char *end, const char *str)
+{
+    return std::search(begin, end, str, str + strlen(str));
+}
+
+// like atof(), but the number may be followed by anything (the mapped file is not null-terminated)
+static double parseDouble(const char *begin, const char *end)
+{
+    char buf[64];
+    size_t length = std::min((size_t)(end - begin), sizeof(buf) - 1);
+    memcpy(buf, begin, length);
+    buf[length] = '\0';
+    return atof(buf);
+}
+
+
+const Ns2MotionFile::Node *Ns2MotionFile::getNode(int nodeId) const
+{
+    if (nodeId < 0 || nodeId >= (int)nodes.size())
+        return NULL;
+    const Node& node = nodes[nodeId];
+    if (node.initial[0] == -1 && node.initial[1] == -1 && node.initial[2] == -1 && node.setdestLines.empty())
+        return NULL;
+    return &node;
+}
+
+void Ns2MotionFile::getSetdest(const Node& node, unsigned int index, Line& line) const
+{
+    const char *data = file.getData();
+    const char *begin = data + node.setdestLines[index];
+    const char *end = (const char *)memchr(begin, '\n', data + file.getSize() - begin);
+    if (!end)
+        end = data + file.getSize();
+    end = std::find(begin, end, '#');
+    std::string command(begin, end);
+
+    line.clear();
+    // initial time
+    std::string::size_type found = command.find("at");
+    line.push_back(std::atof(command.c_str() + std::min(found + 3, command.size())));
+
+    const char *parameters = command.c_str() + command.find("setdest") + 7;
+    char *numberEnd;
+    double d = strtod(parameters, &numberEnd);
+    while (numberEnd != parameters)
+    {
+        line.push_back(d);
+        parameters = numberEnd;
+        d = strtod(parameters, &numberEnd);
+    }
+    if (line.size() < 4)
+        line.resize(4, 0);
+}
+
+
+Ns2MotionFileCache *Ns2MotionFileCache::inst;
+
+Ns2MotionFileCache::~Ns2MotionFileCache()
+{
+    for (Ns2FileMap::iterator it = cache.begin(); it != cache.end(); ++it)
+        delete it->second;
+}
+
+Ns2MotionFileCache *Ns2MotionFileCache::getInstance()
+{
+    if (!inst)
+        inst = new Ns2MotionFileCache;
+    return inst;
+}
+
+void Ns2MotionFileCache::deleteInstance()
+{
+    if (inst)
+    {
+        delete inst;
+        inst = NULL;
+    }
+}
+
+const Ns2MotionFile *Ns2MotionFileCache::getFile(const char *filename)
+{
+    // if found, return it from cache
+    Ns2FileMap::iterator it = cache.find(std::string(filename));
+    if (it!=cache.end())
+        return it->second;
+
+    // load and store in cache
+    Ns2MotionFile *ns2File = new Ns2MotionFile();
+    try
+    {
+        parseFile(filename, *ns2File);
+    }
+    catch (...)
+    {
+        delete ns2File;
+        throw;
+    }
+    cache[filename] = ns2File;
+    return ns2File;
+}
+
+void Ns2MotionFileCache::parseFile(const char *filename, Ns2MotionFile& ns2File)
+{
+    ns2File.file.open(filename);
+    const char *data = ns2File.file.getData();
+    const char *fileEnd = data + ns2File.file.getSize();
+
+    for (const char *lineBegin = data; lineBegin < fileEnd; )
+    {
+        const char *lineEnd = (const char *)memchr(lineBegin, '\n', fileEnd - lineBegin);
+        if (!lineEnd)
+            lineEnd = fileEnd;
+        const char *begin = lineBegin;
+        lineBegin = lineEnd + 1;
+
+        // '#' line
+        const char *end = std::find(begin, lineEnd, '#');
+        if (end == begin)
+            continue;
+        const char *found = findString(begin, end, "$node_(");
+        if (found == end)
+            continue;
+
+        // Node Id
+        int nodeId = (int)parseDouble(found + 7, end);
+        if (nodeId < 0)
+            continue;
+        if (nodeId >= (int)ns2File.nodes.size())
+        {
+            Ns2MotionFile::Node node;
+            node.initial[0] = node.initial[1] = node.initial[2] = -1;
+            ns2File.nodes.resize(nodeId + 1, node);
+        }
+        Ns2MotionFile::Node& node = ns2File.nodes[nodeId];
+
+        // Initial position
+        if (findString(begin, end, "set ") != end)
+        {
+            const char *coordNames[3] = {"X_", "Y_", "Z_"};
+            for (int i = 0; i < 3; i++)
+            {
+                found = findString(begin, end, coordNames[i]);
+                if (found != end)
+                    node.initial[i] = parseDouble(found + 2, end);
+            }
+        }
+        // the movements are only decoded when the node reaches them
+        if (findString(begin, end, "setdest") != end)
+            node.setdestLines.push_back(begin - data);
+    }
+}
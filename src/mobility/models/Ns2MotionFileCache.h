@@ -0,0 +1,109 @@
+//
+// Copyright (C) 2005 Andras Varga
+// Copyright (C) 2008 Alfonso Ariza
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+
+
+#ifndef NS2_MOTION_FILE_CACHE_H
+#define NS2_MOTION_FILE_CACHE_H
+
+#include <map>
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "MappedFile.h"
+
+
+class Ns2MotionFileCache;
+
+/**
+ * Represents a ns2 motion file's contents.
+ *
+ * The file is memory-mapped and indexed once when it is loaded: the initial
+ * position of each node is stored, together with the position of its
+ * setdest commands in the file. The commands are only decoded when the
+ * node reaches them.
+ *
+ * @see Ns2MotionFileCache, Ns2MotionMobility
+ */
+class INET_API Ns2MotionFile
+{
+  public:
+    typedef std::vector<double> Line;
+
+    struct Node
+    {
+        double initial[3];                  // initial position; -1 if not set in the file
+        std::vector<size_t> setdestLines;   // file offset of each setdest command of the node
+    };
+
+  protected:
+    friend class Ns2MotionFileCache;
+    MappedFile file;
+    std::vector<Node> nodes;    // indexed by node id
+
+  public:
+    /**
+     * Returns the data of the given node, or NULL if the file does not
+     * mention it.
+     */
+    const Node *getNode(int nodeId) const;
+
+    /**
+     * Decodes the index'th setdest command of the node into line: time,
+     * x, y, speed.
+     */
+    void getSetdest(const Node& node, unsigned int index, Line& line) const;
+};
+
+
+/**
+ * Singleton object to read and store ns2 motion files. Used within
+ * Ns2MotionMobility, so that the file is read and indexed once, not by
+ * every node.
+ *
+ * @ingroup mobility
+ */
+class INET_API Ns2MotionFileCache
+{
+  protected:
+    typedef std::map<std::string,Ns2MotionFile*> Ns2FileMap;
+    Ns2FileMap cache;
+    static Ns2MotionFileCache *inst;
+    void parseFile(const char *filename, Ns2MotionFile& ns2File);
+    Ns2MotionFileCache() {}
+    virtual ~Ns2MotionFileCache();
+
+  public:
+    /**
+     * Returns the singleton instance.
+     */
+    static Ns2MotionFileCache *getInstance();
+
+    /**
+     * Deletes the singleton instance.
+     */
+    static void deleteInstance();
+
+    /**
+     * Returns the given document.
+     */
+    virtual const Ns2MotionFile *getFile(const char *filename);
+};
+
+#endif
@@ -24,6 +24,7 @@
 #include "INETDefs.h"
 
 #include "LineSegmentsMobilityBase.h"
+#include "Ns2MotionFileCache.h"
 
 
 /**
@@ -32,36 +33,19 @@
  * @ingroup mobility
  * @author Alfonso Ariza
  */
-
-class Ns2MotionMobility;
-
-/**
- * Represents a ns2 motion file's contents.
- */
-class INET_API Ns2MotionFile
-{
-  public:
-    typedef std::vector<double> Line;
-    double initial[3];
-  protected:
-    friend class Ns2MotionMobility;
-    typedef std::vector<Line> LineList;
-    LineList lines;
-};
-
 class INET_API Ns2MotionMobility : public LineSegmentsMobilityBase
 {
   protected:
     // state
     unsigned int vecpos;
-    Ns2MotionFile *ns2File;
+    const Ns2MotionFile *ns2File;
+    const Ns2MotionFile::Node *node;
+    Ns2MotionFile::Line vec;    // the decoded setdest command
     int nodeId;
     double scrollX;
     double scrollY;
 
   protected:
-    void parseFile(const char *filename);
-
     /** @brief Initializes mobility model parameters.*/
     virtual void initialize(int stage);
 
@@ -50,6 +50,15 @@ static std::ostream& operator<<(std::ostream& out, const ARP::ARPCacheEntry& e)
     return out;
 }
 
+static std::ostream& operator<<(std::ostream& out, const ARP::ARPCacheTable& table)
+{
+    out << table.size() << " entries";
+    for (unsigned int i = 0; i < table.getNumSlots(); i++)
+        if (table.getSlotValue(i))
+            out << "; " << table.getSlotValue(i)->ipAddress << ": " << *table.getSlotValue(i);
+    return out;
+}
+
 ARP::ARPCache ARP::globalArpCache;
 int ARP::globalArpCacheRefCnt = 0;
 
@@ -65,6 +74,9 @@ ARP::ARP()
 
     ift = NULL;
     rt = NULL;
+    numCacheEntries = 0;
+    retryList.first = retryList.last = NULL;
+    timeoutTimer = NULL;
 }
 
 void ARP::initialize(int stage)
@@ -91,6 +103,7 @@ void ARP::initialize(int stage)
         globalARP = par("globalARP");
 
         pendingQueue.setName("pendingQueue");
+        timeoutTimer = new cMessage("ARP timeout");
 
         // init statistics
         numRequestsSent = numRepliesSent = 0;
@@ -100,7 +113,8 @@ void ARP::initialize(int stage)
         WATCH(numResolutions);
         WATCH(numFailedResolutions);
 
-        WATCH_PTRMAP(arpCache);
+        WATCH(numCacheEntries);
+        WATCH_VECTOR(arpCache);
         WATCH_PTRMAP(globalArpCache);
 
         // initialize global cache
@@ -111,13 +125,12 @@ void ARP::initialize(int stage)
                 continue;
             ARPCacheEntry *entry = new ARPCacheEntry();
             entry->ie = ie;
+            entry->ipAddress = ie->ipv4Data()->getIPAddress();
             entry->pending = false;
-            entry->timer = NULL;
             entry->numRetries = 0;
             entry->macAddress = ie->getMacAddress();
-            IPv4Address nextHopAddr = ie->ipv4Data()->getIPAddress();
-            ARPCache::iterator where = globalArpCache.insert(globalArpCache.begin(), std::make_pair(nextHopAddr, entry));
-            entry->myIter = where; // note: "inserting a new element into a map does not invalidate iterators that point to existing elements"
+            entry->prev = entry->next = NULL;
+            globalArpCache.insert(std::make_pair(entry->ipAddress, entry));
         }
     }
 }
@@ -128,12 +141,11 @@ void ARP::finish()
 
 ARP::~ARP()
 {
-    while (!arpCache.empty())
-    {
-        ARPCache::iterator i = arpCache.begin();
-        delete (*i).second;
-        arpCache.erase(i);
-    }
+    cancelAndDelete(timeoutTimer);
+
+    for (std::vector<ARPCacheTable>::iterator t = arpCache.begin(); t != arpCache.end(); ++t)
+        for (unsigned int i = 0; i < t->getNumSlots(); i++)
+            delete t->getSlotValue(i);  // NULL for empty slots
 
     if (--globalArpCacheRefCnt != 0)
         return;
@@ -148,9 +160,9 @@ ARP::~ARP()
 
 void ARP::handleMessage(cMessage *msg)
 {
-    if (msg->isSelfMessage())
+    if (msg == timeoutTimer)
     {
-        requestTimedOut(msg);
+        processTimeouts();
     }
     else if (dynamic_cast<ARPPacket *>(msg))
     {
@@ -169,7 +181,7 @@ void ARP::updateDisplayString()
 {
     std::stringstream os;
 
-    os << arpCache.size() << " cache entries\nsent req:" << numRequestsSent
+    os << numCacheEntries << " cache entries\nsent req:" << numRequestsSent
             << " repl:" << numRepliesSent << " fail:" << numFailedResolutions;
 
     getDisplayString().setTagArg("t", 0, os.str().c_str());
@@ -232,15 +244,11 @@ void ARP::processOutboundPacket(cMessage *msg)
     }
 
     // try look up
-    ARPCache::iterator it = arpCache.find(nextHopAddr);
-    //ASSERT(it==arpCache.end() || ie==(*it).second->ie); // verify: if arpCache gets keyed on InterfaceEntry* too, this becomes unnecessary
-    if (it==arpCache.end())
+    ARPCacheEntry *entry = getCacheTable(ie).find(nextHopAddr);
+    if (entry == NULL)
     {
         // no cache entry: launch ARP request
-        ARPCacheEntry *entry = new ARPCacheEntry();
-        ARPCache::iterator where = arpCache.insert(arpCache.begin(), std::make_pair(nextHopAddr, entry));
-        entry->myIter = where; // note: "inserting a new element into a map does not invalidate iterators that point to existing elements"
-        entry->ie = ie;
+        entry = createCacheEntry(ie, nextHopAddr);
 
         EV << "Starting ARP resolution for " << nextHopAddr << "\n";
         initiateARPResolution(entry);
@@ -249,20 +257,18 @@ void ARP::processOutboundPacket(cMessage *msg)
         entry->pendingPackets.push_back(msg);
         pendingQueue.insert(msg);
     }
-    else if ((*it).second->pending)
+    else if (entry->pending)
     {
         // an ARP request is already pending for this address -- just queue up packet
         EV << "ARP resolution for " << nextHopAddr << " is pending, queueing up packet\n";
-        (*it).second->pendingPackets.push_back(msg);
+        entry->pendingPackets.push_back(msg);
         pendingQueue.insert(msg);
     }
-    else if ((*it).second->lastUpdate+cacheTimeout<simTime())
+    else if (entry->lastUpdate+cacheTimeout<simTime())
     {
         EV << "ARP cache entry for " << nextHopAddr << " expired, starting new ARP resolution\n";
 
         // cache entry stale, send new ARP request
-        ARPCacheEntry *entry = (*it).second;
-        entry->ie = ie; // routing table may have changed
         initiateARPResolution(entry);
 
         // and queue up packet
@@ -272,8 +278,8 @@ void ARP::processOutboundPacket(cMessage *msg)
     else
     {
         // valid ARP cache entry found, flag msg with MAC address and send it out
-        EV << "ARP cache hit, MAC address for " << nextHopAddr << " is " << (*it).second->macAddress << ", sending packet down\n";
-        sendPacketToNIC(msg, ie, (*it).second->macAddress, ETHERTYPE_IPv4);
+        EV << "ARP cache hit, MAC address for " << nextHopAddr << " is " << entry->macAddress << ", sending packet down\n";
+        sendPacketToNIC(msg, ie, entry->macAddress, ETHERTYPE_IPv4);
     }
 }
 
@@ -292,18 +298,108 @@ MACAddress ARP::mapMulticastAddress(IPv4Address addr)
     return macAddr;
 }
 
+ARP::ARPCacheTable& ARP::getCacheTable(InterfaceEntry *ie)
+{
+    unsigned int index = ie->getNetworkLayerGateIndex();
+    if (index >= arpCache.size())
+        arpCache.resize(index + 1);
+    return arpCache[index];
+}
+
+ARP::ARPCacheEntry *ARP::createCacheEntry(InterfaceEntry *ie, const IPv4Address& ipAddress)
+{
+    ARPCacheEntry *entry = new ARPCacheEntry();
+    entry->ie = ie;
+    entry->ipAddress = ipAddress;
+    entry->pending = false;
+    entry->numRetries = 0;
+    entry->prev = entry->next = NULL;
+    getCacheTable(ie).insert(ipAddress, entry);
+    numCacheEntries++;
+    return entry;
+}
+
+void ARP::deleteCacheEntry(ARPCacheEntry *entry)
+{
+    removeFromTimeoutList(entry);
+    ASSERT(getCacheTable(entry->ie).find(entry->ipAddress) == entry);
+    getCacheTable(entry->ie).remove(entry->ipAddress);
+    numCacheEntries--;
+    delete entry;
+}
+
+void ARP::appendToTimeoutList(ARPCacheEntry *entry)
+{
+    ASSERT(entry->pending);
+    TimeoutList& list = retryList;
+    ASSERT(list.last == NULL || list.last->timeout <= entry->timeout);
+    entry->prev = list.last;
+    entry->next = NULL;
+    if (list.last)
+        list.last->next = entry;
+    else
+        list.first = entry;
+    list.last = entry;
+
+    if (list.first == entry)
+        rescheduleTimeoutTimer();
+}
+
+void ARP::removeFromTimeoutList(ARPCacheEntry *entry)
+{
+    TimeoutList& list = retryList;
+    if (entry->prev == NULL && list.first != entry)
+        return;  // not in the list
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        list.first = entry->next;
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    else
+        list.last = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+void ARP::rescheduleTimeoutTimer()
+{
+    // the timer is only brought forward here; if it fires early because
+    // the first entries have been removed meanwhile, processTimeouts()
+    // schedules it again
+    ARPCacheEntry *first = retryList.first;
+    if (first == NULL)
+        return;
+    if (timeoutTimer->isScheduled())
+    {
+        if (timeoutTimer->getArrivalTime() <= first->timeout)
+            return;
+        cancelEvent(timeoutTimer);
+    }
+    scheduleAt(first->timeout, timeoutTimer);
+}
+
+void ARP::processTimeouts()
+{
+    simtime_t now = simTime();
+    while (retryList.first && retryList.first->timeout <= now)
+    {
+        ARPCacheEntry *entry = retryList.first;
+        removeFromTimeoutList(entry);
+        requestTimedOut(entry);
+    }
+    rescheduleTimeoutTimer();
+}
+
 void ARP::initiateARPResolution(ARPCacheEntry *entry)
 {
-    IPv4Address nextHopAddr = entry->myIter->first;
     entry->pending = true;
     entry->numRetries = 0;
     entry->lastUpdate = 0;
-    sendARPRequest(entry->ie, nextHopAddr);
+    sendARPRequest(entry->ie, entry->ipAddress);
 
     // start timer
-    cMessage *msg = entry->timer = new cMessage("ARP timeout");
-    msg->setContextPointer(entry);
-    scheduleAt(simTime()+retryTimeout, msg);
+    entry->timeout = simTime() + retryTimeout;
+    appendToTimeoutList(entry);
 
     numResolutions++;
     emit(initiatedResolutionSignal, 1L);
@@ -345,17 +441,16 @@ void ARP::sendARPRequest(InterfaceEntry *ie, IPv4Address ipAddress)
     emit(sentReqSignal, 1L);
 }
 
-void ARP::requestTimedOut(cMessage *selfmsg)
+void ARP::requestTimedOut(ARPCacheEntry *entry)
 {
-    ARPCacheEntry *entry = (ARPCacheEntry *)selfmsg->getContextPointer();
     entry->numRetries++;
     if (entry->numRetries < retryCount)
     {
         // retry
-        IPv4Address nextHopAddr = entry->myIter->first;
-        EV << "ARP request for " << nextHopAddr << " timed out, resending\n";
-        sendARPRequest(entry->ie, nextHopAddr);
-        scheduleAt(simTime()+retryTimeout, selfmsg);
+        EV << "ARP request for " << entry->ipAddress << " timed out, resending\n";
+        sendARPRequest(entry->ie, entry->ipAddress);
+        entry->timeout = simTime() + retryTimeout;
+        appendToTimeoutList(entry);
         return;
     }
 
@@ -363,19 +458,12 @@ void ARP::requestTimedOut(cMessage *selfmsg)
     // throw out entry from cache, delete pending messages
     MsgPtrVector& pendingPackets = entry->pendingPackets;
     EV << "ARP timeout, max retry count " << retryCount << " for "
-       << entry->myIter->first << " reached. Dropping " << pendingPackets.size()
+       << entry->ipAddress << " reached. Dropping " << pendingPackets.size()
        << " waiting packets from the queue\n";
-    while (!pendingPackets.empty())
-    {
-        MsgPtrVector::iterator i = pendingPackets.begin();
-        cMessage *msg = (*i);
-        pendingPackets.erase(i);
-        pendingQueue.remove(msg);
-        delete msg;
-    }
-    delete selfmsg;
-    arpCache.erase(entry->myIter);
-    delete entry;
+    for (MsgPtrVector::iterator i = pendingPackets.begin(); i != pendingPackets.end(); ++i)
+        delete pendingQueue.remove(*i);
+    pendingPackets.clear();
+    deleteCacheEntry(entry);
     numFailedResolutions++;
     emit(failedResolutionSignal, 1L);
 }
@@ -450,11 +538,10 @@ void ARP::processARPPacket(ARPPacket *arp)
 
     bool mergeFlag = false;
     // "If ... sender protocol address is already in my translation table"
-    ARPCache::iterator it = arpCache.find(srcIPAddress);
-    if (it!=arpCache.end())
+    ARPCacheEntry *entry = getCacheTable(ie).find(srcIPAddress);
+    if (entry)
     {
         // "update the sender hardware address field"
-        ARPCacheEntry *entry = (*it).second;
         updateARPCache(entry, srcMACAddress);
         mergeFlag = true;
     }
@@ -467,22 +554,7 @@ void ARP::processARPPacket(ARPPacket *arp)
         // protocol address, sender hardware address to the translation table"
         if (!mergeFlag)
         {
-            ARPCacheEntry *entry;
-            if (it!=arpCache.end())
-            {
-                entry = (*it).second;
-            }
-            else
-            {
-                entry = new ARPCacheEntry();
-                ARPCache::iterator where = arpCache.insert(arpCache.begin(), std::make_pair(srcIPAddress, entry));
-                entry->myIter = where;
-                entry->ie = ie;
-
-                entry->pending = false;
-                entry->timer = NULL;
-                entry->numRetries = 0;
-            }
+            entry = createCacheEntry(ie, srcIPAddress);
             updateARPCache(entry, srcMACAddress);
         }
 
@@ -532,26 +604,24 @@ void ARP::processARPPacket(ARPPacket *arp)
 
 void ARP::updateARPCache(ARPCacheEntry *entry, const MACAddress& macAddress)
 {
-    EV << "Updating ARP cache entry: " << entry->myIter->first << " <--> " << macAddress << "\n";
+    EV << "Updating ARP cache entry: " << entry->ipAddress << " <--> " << macAddress << "\n";
 
     // update entry
     if (entry->pending)
     {
+        removeFromTimeoutList(entry);  // stop the retry timer
         entry->pending = false;
-        delete cancelEvent(entry->timer);
-        entry->timer = NULL;
         entry->numRetries = 0;
     }
     entry->macAddress = macAddress;
     entry->lastUpdate = simTime();
 
-    // process queued packets
-    MsgPtrVector& pendingPackets = entry->pendingPackets;
-    while (!pendingPackets.empty())
+    // process queued packets in one batch
+    MsgPtrVector pendingPackets;
+    pendingPackets.swap(entry->pendingPackets);
+    for (MsgPtrVector::iterator i = pendingPackets.begin(); i != pendingPackets.end(); ++i)
     {
-        MsgPtrVector::iterator i = pendingPackets.begin();
-        cMessage *msg = (*i);
-        pendingPackets.erase(i);
+        cMessage *msg = *i;
         pendingQueue.remove(msg);
         EV << "Sending out queued packet " << msg << "\n";
         sendPacketToNIC(msg, entry->ie, macAddress, ETHERTYPE_IPv4);
@@ -570,9 +640,12 @@ const MACAddress ARP::getDirectAddressResolution(const IPv4Address & add) const
     }
     else
     {
-        it = arpCache.find(add);
-        if (it!=arpCache.end())
-            address = (*it).second->macAddress;
+        for (std::vector<ARPCacheTable>::const_iterator t = arpCache.begin(); t != arpCache.end(); ++t)
+        {
+            ARPCacheEntry *entry = t->find(add);
+            if (entry)
+                return entry->macAddress;
+        }
     }
     return address;
 }
@@ -592,12 +665,15 @@ const IPv4Address ARP::getInverseAddressResolution(const MACAddress &add) const
     }
     else
     {
-        for (it = arpCache.begin(); it!=arpCache.end(); it++)
-            if ((*it).second->macAddress==add)
+        for (std::vector<ARPCacheTable>::const_iterator t = arpCache.begin(); t != arpCache.end(); ++t)
+        {
+            for (unsigned int i = 0; i < t->getNumSlots(); i++)
             {
-                address = (*it).first;
-                return address;
+                ARPCacheEntry *entry = t->getSlotValue(i);
+                if (entry && entry->macAddress==add)
+                    return entry->ipAddress;
             }
+        }
     }
     return address;
 }
@@ -614,11 +690,9 @@ void ARP::setChangeAddress(const IPv4Address &oldAddress)
             ARPCacheEntry *entry = (*it).second;
             globalArpCache.erase(it);
             entry->pending = false;
-            entry->timer = NULL;
             entry->numRetries = 0;
-            IPv4Address nextHopAddr = entry->ie->ipv4Data()->getIPAddress();
-            ARPCache::iterator where = globalArpCache.insert(globalArpCache.begin(), std::make_pair(nextHopAddr, entry));
-            entry->myIter = where; // note: "inserting a new element into a map does not invalidate iterators that point to existing elements"
+            entry->ipAddress = entry->ie->ipv4Data()->getIPAddress();
+            globalArpCache.insert(std::make_pair(entry->ipAddress, entry));
         }
     }
 }
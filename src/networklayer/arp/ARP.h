@@ -20,13 +20,14 @@
 
 //#include <stdio.h>
 //#include <string.h>
-//#include <vector>
+#include <vector>
 #include <map>
 
 #include "INETDefs.h"
 
 #include "MACAddress.h"
 #include "ModuleAccess.h"
+#include "OpenAddressingHashTable.h"
 #include "IPv4Address.h"
 
 // Forward declarations:
@@ -45,19 +46,44 @@ class INET_API ARP : public cSimpleModule
     typedef std::map<IPv4Address, ARPCacheEntry*> ARPCache;
     typedef std::vector<cMessage*> MsgPtrVector;
 
-    // IPv4Address -> MACAddress table
-    // TBD should we key it on (IPv4Address, InterfaceEntry*)?
+    // IPv4Address -> MACAddress table entry
     struct ARPCacheEntry
     {
         InterfaceEntry *ie; // NIC to send the packet to
+        IPv4Address ipAddress; // the address being resolved
         bool pending; // true if resolution is pending
         MACAddress macAddress;  // MAC address
         simtime_t lastUpdate;  // entries should time out after cacheTimeout
         int numRetries; // if pending==true: 0 after first ARP request, 1 after second, etc.
-        cMessage *timer;  // if pending==true: request timeout msg
+        simtime_t timeout; // if pending==true: time of the next retry
         MsgPtrVector pendingPackets;  // if pending==true: ptrs to packets waiting for resolution
                                       // (packets are owned by pendingQueue)
-        ARPCache::iterator myIter;  // iterator pointing to this entry
+        ARPCacheEntry *prev;  // previous entry in the retry list (if pending)
+        ARPCacheEntry *next;  // next entry in the retry list (if pending)
+    };
+
+    /** Hash function of IPv4 addresses, for ARPCacheTable. */
+    struct IPv4AddressHash
+    {
+        // hosts of a subnet differ in the low bits only
+        unsigned int operator()(const IPv4Address& addr) const {return fibonacciHash32(addr.getInt());}
+    };
+
+    /**
+     * ARP cache entries of one interface, keyed on the IPv4 address.
+     * The table does not own the entries.
+     */
+    class ARPCacheTable : public OpenAddressingHashTable<IPv4Address, ARPCacheEntry *, IPv4AddressHash>
+    {
+      public:
+        ARPCacheTable() : OpenAddressingHashTable<IPv4Address, ARPCacheEntry *, IPv4AddressHash>(NULL) {}
+    };
+
+    // list of entries ordered by timeout, see retryList
+    struct TimeoutList
+    {
+        ARPCacheEntry *first;
+        ARPCacheEntry *last;
     };
 
   protected:
@@ -77,10 +103,20 @@ class INET_API ARP : public cSimpleModule
     static simsignal_t failedResolutionSignal;
     static simsignal_t initiatedResolutionSignal;
 
-    ARPCache arpCache;
+    std::vector<ARPCacheTable> arpCache;  // indexed by the network layer gate index of the interface
+    int numCacheEntries;
     static ARPCache globalArpCache;
     static int globalArpCacheRefCnt;
 
+    // Retry timeouts of all pending entries are driven by a single
+    // self-message. Timeouts are always set to simTime() plus retryTimeout,
+    // so appending entries to the list keeps it ordered by timeout.
+    // Resolved entries are not timed out: they are kept in the cache
+    // (and refreshed by the ARP packets of their hosts), and checked for
+    // staleness when they are used.
+    TimeoutList retryList;  // pending entries, ordered by the time of the next retry
+    cMessage *timeoutTimer;
+
     cQueue pendingQueue; // outbound packets waiting for ARP resolution
     int nicOutBaseGateId;  // id of the nicOut[0] gate
 
@@ -106,9 +142,17 @@ class INET_API ARP : public cSimpleModule
     virtual void processOutboundPacket(cMessage *msg);
     virtual void sendPacketToNIC(cMessage *msg, InterfaceEntry *ie, const MACAddress& macAddress, int etherType);
 
+    virtual ARPCacheTable& getCacheTable(InterfaceEntry *ie);
+    virtual ARPCacheEntry *createCacheEntry(InterfaceEntry *ie, const IPv4Address& ipAddress);
+    virtual void deleteCacheEntry(ARPCacheEntry *entry);
+    virtual void appendToTimeoutList(ARPCacheEntry *entry);
+    virtual void removeFromTimeoutList(ARPCacheEntry *entry);
+    virtual void rescheduleTimeoutTimer();
+    virtual void processTimeouts();
+
     virtual void initiateARPResolution(ARPCacheEntry *entry);
     virtual void sendARPRequest(InterfaceEntry *ie, IPv4Address ipAddress);
-    virtual void requestTimedOut(cMessage *selfmsg);
+    virtual void requestTimedOut(ARPCacheEntry *entry);
     virtual bool addressRecognized(IPv4Address destAddr, InterfaceEntry *ie);
     virtual void processARPPacket(ARPPacket *arp);
     virtual void updateARPCache(ARPCacheEntry *entry, const MACAddress& macAddress);
@@ -44,15 +44,32 @@ void FlatNetworkConfigurator::initialize(int stage)
         // isIPNode, rt and ift members of nodeInfo[]
         extractTopology(topo, nodeInfo);
 
-        // assign addresses to IPv4 nodes, and also store result in nodeInfo[].address
-        assignAddresses(topo, nodeInfo);
+        // load addresses and routes from the snapshot cache if this configuration has been calculated before
+        const char *snapshotCacheDir = par("snapshotCacheDir");
+        ConfigurationSnapshot::Key key;
+        if (*snapshotCacheDir)
+            computeConfigurationKey(topo, nodeInfo, key);
+        ConfigurationSnapshot snapshot(snapshotCacheDir, "FlatNetworkConfigurator", key);
+        if (!restoreConfiguration(topo, nodeInfo, snapshot))
+        {
+            std::set<IPv4Route *> initialRoutes;
+            if (snapshot.isEnabled())
+                collectRoutes(nodeInfo, initialRoutes);
+
+            // assign addresses to IPv4 nodes, and also store result in nodeInfo[].address
+            assignAddresses(topo, nodeInfo);
 
-        // add default routes to hosts (nodes with a single attachment);
-        // also remember result in nodeInfo[].usesDefaultRoute
-        addDefaultRoutes(topo, nodeInfo);
+            // add default routes to hosts (nodes with a single attachment);
+            // also remember result in nodeInfo[].usesDefaultRoute
+            addDefaultRoutes(topo, nodeInfo);
 
-        // calculate shortest paths, and add corresponding static routes
-        fillRoutingTables(topo, nodeInfo);
+            // calculate shortest paths, and add corresponding static routes
+            fillRoutingTables(topo, nodeInfo);
+
+            // store the result in the snapshot cache
+            if (snapshot.isEnabled())
+                storeConfiguration(topo, nodeInfo, initialRoutes, snapshot);
+        }
 
         // update display string
         setDisplayString(topo, nodeInfo);
@@ -228,3 +245,139 @@ void FlatNetworkConfigurator::setDisplayString(cTopology& topo, NodeInfoVector&
     getDisplayString().setTagArg("t", 0, buf);
 }
 
+
+void FlatNetworkConfigurator::computeConfigurationKey(cTopology& topo, NodeInfoVector& nodeInfo, ConfigurationSnapshot::Key& key)
+{
+    key.addParameter(this, "networkAddress");
+    key.addParameter(this, "netmask");
+
+    // nodes with their interfaces and connections
+    key.add(topo.getNumNodes());
+    for (int i=0; i<topo.getNumNodes(); i++)
+    {
+        cTopology::Node *node = topo.getNode(i);
+        key.add(node->getModule()->getFullPath());
+        key.add(node->getModuleId());
+        key.add(node->getWeight());
+        key.add(nodeInfo[i].isIPNode);
+        if (nodeInfo[i].isIPNode)
+        {
+            IInterfaceTable *ift = nodeInfo[i].ift;
+            key.add(ift->getNumInterfaces());
+            for (int k=0; k<ift->getNumInterfaces(); k++)
+            {
+                InterfaceEntry *ie = ift->getInterface(k);
+                key.add(ie->getInterfaceId());
+                key.add(ie->getNodeOutputGateId());
+                key.add(ie->isLoopback());
+            }
+        }
+        key.add(node->getNumOutLinks());
+        for (int j=0; j<node->getNumOutLinks(); j++)
+        {
+            cTopology::LinkOut *link = node->getLinkOut(j);
+            key.add(link->getRemoteNode()->getModuleId());
+            key.add(link->getLocalGate()->getId());
+            key.add(link->getWeight());
+            key.add(link->isEnabled());
+        }
+    }
+}
+
+void FlatNetworkConfigurator::collectRoutes(NodeInfoVector& nodeInfo, std::set<IPv4Route *>& routes)
+{
+    for (int i=0; i<(int)nodeInfo.size(); i++)
+        if (nodeInfo[i].isIPNode)
+            for (int j=0; j<nodeInfo[i].rt->getNumRoutes(); j++)
+                routes.insert(nodeInfo[i].rt->getRoute(j));
+}
+
+void FlatNetworkConfigurator::storeConfiguration(cTopology& topo, NodeInfoVector& nodeInfo, const std::set<IPv4Route *>& initialRoutes, ConfigurationSnapshot& snapshot)
+{
+    snapshot.writeInt(topo.getNumNodes());
+    for (int i=0; i<topo.getNumNodes(); i++)
+    {
+        snapshot.writeString(topo.getNode(i)->getModule()->getFullPath());
+        snapshot.writeInt(nodeInfo[i].isIPNode);
+        if (!nodeInfo[i].isIPNode)
+            continue;
+        snapshot.writeUint32(nodeInfo[i].address.getInt());
+        snapshot.writeInt(nodeInfo[i].usesDefaultRoute);
+
+        // the routes added by the configurator, in routing table order
+        IRoutingTable *rt = nodeInfo[i].rt;
+        std::vector<IPv4Route *> routes;
+        for (int j=0; j<rt->getNumRoutes(); j++)
+        {
+            IPv4Route *e = rt->getRoute(j);
+            if (e->getSource()!=IPv4Route::IFACENETMASK && !initialRoutes.count(e))
+                routes.push_back(e);
+        }
+        snapshot.writeInt(routes.size());
+        for (int j=0; j<(int)routes.size(); j++)
+        {
+            snapshot.writeUint32(routes[j]->getDestination().getInt());
+            snapshot.writeUint32(routes[j]->getNetmask().getInt());
+            snapshot.writeInt(routes[j]->getInterface() ? routes[j]->getInterface()->getInterfaceId() : -1);
+        }
+    }
+
+    if (snapshot.save())
+        EV << "Configuration stored in " << snapshot.getFileName() << endl;
+    else
+        EV << "Cannot write configuration snapshot " << snapshot.getFileName() << ", continuing without it" << endl;
+}
+
+bool FlatNetworkConfigurator::restoreConfiguration(cTopology& topo, NodeInfoVector& nodeInfo, ConfigurationSnapshot& snapshot)
+{
+    if (!snapshot.load())
+        return false;
+
+    // the key guarantees that the snapshot belongs to this network, so errors mean a corrupt cache
+    if (snapshot.readInt()!=topo.getNumNodes())
+        error("Configuration snapshot %s does not match the network, delete it", snapshot.getFileName());
+    for (int i=0; i<topo.getNumNodes() && !snapshot.hasReadError(); i++)
+    {
+        if (snapshot.readString()!=topo.getNode(i)->getModule()->getFullPath() || snapshot.readInt()!=nodeInfo[i].isIPNode)
+            error("Configuration snapshot %s does not match the network, delete it", snapshot.getFileName());
+        if (!nodeInfo[i].isIPNode)
+            continue;
+
+        // same address on all (non-loopback) interfaces, as in assignAddresses()
+        nodeInfo[i].address.set(snapshot.readUint32());
+        nodeInfo[i].usesDefaultRoute = snapshot.readInt();
+        IInterfaceTable *ift = nodeInfo[i].ift;
+        for (int k=0; k<ift->getNumInterfaces(); k++)
+        {
+            InterfaceEntry *ie = ift->getInterface(k);
+            if (!ie->isLoopback())
+            {
+                ie->ipv4Data()->setIPAddress(nodeInfo[i].address);
+                ie->ipv4Data()->setNetmask(IPv4Address::ALLONES_ADDRESS); // full address must match for local delivery
+            }
+        }
+
+        int numRoutes = snapshot.readInt();
+        for (int j=0; j<numRoutes && !snapshot.hasReadError(); j++)
+        {
+            IPv4Route *e = new IPv4Route();
+            e->setDestination(IPv4Address(snapshot.readUint32()));
+            e->setNetmask(IPv4Address(snapshot.readUint32()));
+            int interfaceId = snapshot.readInt();
+            InterfaceEntry *ie = interfaceId==-1 ? NULL : ift->getInterfaceById(interfaceId);
+            if (interfaceId!=-1 && !ie)
+            {
+                delete e;
+                error("Configuration snapshot %s does not match the network, delete it", snapshot.getFileName());
+            }
+            e->setInterface(ie);
+            e->setSource(IPv4Route::MANUAL);
+            nodeInfo[i].rt->addRoute(e);
+        }
+    }
+    if (snapshot.hasReadError() || !snapshot.isAtEnd())
+        error("Configuration snapshot %s is corrupt, delete it", snapshot.getFileName());
+
+    EV << "Configuration restored from " << snapshot.getFileName() << endl;
+    return true;
+}
@@ -20,10 +20,14 @@
 
 #include "INETDefs.h"
 
+#include <set>
+
 #include "IPv4Address.h"
+#include "ConfigurationSnapshot.h"
 
 class IInterfaceTable;
 class IRoutingTable;
+class IPv4Route;
 
 
 /**
@@ -58,6 +62,12 @@ class INET_API FlatNetworkConfigurator : public cSimpleModule
     virtual void fillRoutingTables(cTopology& topo, NodeInfoVector& nodeInfo);
 
     virtual void setDisplayString(cTopology& topo, NodeInfoVector& nodeInfo);
+
+    // configuration snapshot cache
+    virtual void computeConfigurationKey(cTopology& topo, NodeInfoVector& nodeInfo, ConfigurationSnapshot::Key& key);
+    virtual void collectRoutes(NodeInfoVector& nodeInfo, std::set<IPv4Route *>& routes);
+    virtual void storeConfiguration(cTopology& topo, NodeInfoVector& nodeInfo, const std::set<IPv4Route *>& initialRoutes, ConfigurationSnapshot& snapshot);
+    virtual bool restoreConfiguration(cTopology& topo, NodeInfoVector& nodeInfo, ConfigurationSnapshot& snapshot);
 };
 
 #endif
@@ -19,6 +19,10 @@
 //
 
 #include <set>
+#include <map>
+#include <algorithm>
+#include <iterator>
+#include <platdep/timeutil.h>
 #include "stlutils.h"
 #include "IRoutingTable.h"
 #include "IInterfaceTable.h"
@@ -29,6 +33,12 @@
 #include "PatternMatcher.h"
 #include "ModuleAccess.h"
 
+#if !defined(_WIN32) && !defined(__WIN32__) && !defined(WIN32) && !defined(__CYGWIN__) && !defined(_WIN64)
+#define INET_IPV4NETWORKCONFIGURATOR_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 Define_Module(IPv4NetworkConfigurator);
 
 #define ADDRLEN_BITS 32
@@ -46,6 +56,19 @@ static void printElapsedTime(const char *name, long startTime)
     printTimeSpentUsingDuration(name, clock() - startTime);
 }
 
+// clock() measures the processor time of all threads, so worker threads are timed with this
+static double getWallClockTime()
+{
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void printWallClockTime(const char *name, double startTime)
+{
+    EV_INFO << "Wall clock time spent in IPv4NetworkConfigurator::" << name << ": " << (getWallClockTime() - startTime) << "s" << endl;
+}
+
 #define T(CODE)  {long startTime=clock(); CODE; printElapsedTime(#CODE, startTime);}
 
 void IPv4NetworkConfigurator::initialize(int stage)
@@ -61,6 +84,8 @@ void IPv4NetworkConfigurator::initialize(int stage)
         addDefaultRoutesParameter = par("addDefaultRoutes");
         optimizeRoutesParameter = par("optimizeRoutes");
         assignDisjunctSubnetAddressesParameter = par("assignDisjunctSubnetAddresses");
+        allPairsShortestPathsParameter = par("allPairsShortestPaths");
+        numThreadsParameter = par("numThreads");
 
         // extract topology into the IPv4Topology object, then fill in a LinkInfo[] vector
         T(extractTopology(topology));
@@ -69,29 +94,65 @@ void IPv4NetworkConfigurator::initialize(int stage)
         if (par("dumpTopology").boolValue())
             T(dumpTopology(topology));
 
-        // read the configuration from XML; it will serve as input for address assignment
-        T(readAddressConfiguration(par("config").xmlValue(), topology));
+        // load addresses and routes from the snapshot cache if this configuration has been calculated before
+        ConfigurationSnapshot::Key key;
+        if (!isEmpty(par("snapshotCacheDir")))
+            T(computeConfigurationKey(topology, key));
+        ConfigurationSnapshot snapshot(par("snapshotCacheDir"), "IPv4NetworkConfigurator", key);
+        ConfigurationBaseline baseline;
+        bool restored = false;
+        if (snapshot.isEnabled())
+        {
+            T(restored = restoreConfiguration(topology, snapshot));
+            if (!restored)
+                recordConfigurationBaseline(topology, baseline);
+        }
 
-        // assign addresses to IPv4 nodes
-        if (par("assignAddresses").boolValue())
-            T(assignAddresses(topology));
+        if (restored)
+        {
+            // print unicast and multicast addresses and other interface data to module output
+            if (par("dumpAddresses").boolValue())
+                T(dumpAddresses(topology));
+        }
+        else
+        {
+            // read the configuration from XML; it will serve as input for address assignment
+            T(readAddressConfiguration(par("config").xmlValue(), topology));
+
+            // assign addresses to IPv4 nodes
+            if (par("assignAddresses").boolValue())
+                T(assignAddresses(topology));
+
+            // read and configure multicast groups from the XML configuration
+            T(addMulticastGroups(par("config").xmlValue(), topology));
 
-        // read and configure multicast groups from the XML configuration
-        T(addMulticastGroups(par("config").xmlValue(), topology));
+            // print unicast and multicast addresses and other interface data to module output
+            if (par("dumpAddresses").boolValue())
+                T(dumpAddresses(topology));
 
-        // print unicast and multicast addresses and other interface data to module output
-        if (par("dumpAddresses").boolValue())
-            T(dumpAddresses(topology));
+            // read and configure manual routes from the XML configuration
+            T(addManualRoutes(par("config").xmlValue(), topology));
 
-        // read and configure manual routes from the XML configuration
-        T(addManualRoutes(par("config").xmlValue(), topology));
+            // read and configure manual multicast routes from the XML configuration
+            T(addManualMulticastRoutes(par("config").xmlValue(), topology));
 
-        // read and configure manual multicast routes from the XML configuration
-        T(addManualMulticastRoutes(par("config").xmlValue(), topology));
+            // calculate shortest paths, and add corresponding static routes
+            if (par("addStaticRoutes").boolValue())
+            {
+                if (allPairsShortestPathsParameter)
+                {
+                    T(addAllPairsStaticRoutes(topology));
+                }
+                else
+                {
+                    T(addStaticRoutes(topology));
+                }
+            }
 
-        // calculate shortest paths, and add corresponding static routes
-        if (par("addStaticRoutes").boolValue())
-            T(addStaticRoutes(topology));
+            // store the result in the snapshot cache
+            if (snapshot.isEnabled())
+                T(storeConfiguration(topology, baseline, snapshot));
+        }
 
         // dump routes to module output
         if (par("dumpRoutes").boolValue())
@@ -164,8 +225,7 @@ void IPv4NetworkConfigurator::extractWiredTopology(IPv4Topology& topology)
     for (int i = 0; i < topology.getNumNodes(); i++)
     {
         Node *node = (Node *)topology.getNode(i);
-        cModule *module = node->getModule();
-        IInterfaceTable *interfaceTable = IPvXAddressResolver().findInterfaceTableOf(module);
+        IInterfaceTable *interfaceTable = node->interfaceTable;
         if (interfaceTable)
         {
             for (int j = 0; j < interfaceTable->getNumInterfaces(); j++)
@@ -183,11 +243,11 @@ void IPv4NetworkConfigurator::extractWiredTopology(IPv4Topology& topology)
                     interfacesSeen.insert(ie);
 
                     // visit neighbor (and potentially the whole LAN, recursively)
-                    Topology::LinkOut *linkOut = findLinkOut((Node *)topology.getNode(i), ie->getNodeOutputGateId());
+                    Topology::LinkOut *linkOut = findLinkOut(node, ie->getNodeOutputGateId());
                     if (linkOut)
                     {
-                        std::vector<Node *> empty;
-                        extractWiredNeighbors(linkOut, linkInfo, interfacesSeen, empty);
+                        std::set<Node *> deviceNodesVisited;
+                        extractWiredNeighbors(linkOut, linkInfo, interfacesSeen, deviceNodesVisited);
                     }
                 }
             }
@@ -212,16 +272,15 @@ void IPv4NetworkConfigurator::extractWiredTopology(IPv4Topology& topology)
     }
 }
 
-void IPv4NetworkConfigurator::extractWiredNeighbors(Topology::LinkOut *linkOut, LinkInfo* linkInfo, std::set<InterfaceEntry *>& interfacesSeen, std::vector<Node *>& deviceNodesVisited)
+void IPv4NetworkConfigurator::extractWiredNeighbors(Topology::LinkOut *linkOut, LinkInfo* linkInfo, std::set<InterfaceEntry *>& interfacesSeen, std::set<Node *>& deviceNodesVisited)
 {
     cChannel *transmissionChannel = linkOut->getLocalGate()->getTransmissionChannel();
     if (transmissionChannel)
         linkOut->setWeight(getChannelWeight(transmissionChannel));
 
     Node *neighborNode = (Node *)linkOut->getRemoteNode();
-    cModule *neighborModule = neighborNode->getModule();
     int neighborInputGateId = linkOut->getRemoteGateId();
-    IInterfaceTable *neighborInterfaceTable = IPvXAddressResolver().findInterfaceTableOf(neighborModule);
+    IInterfaceTable *neighborInterfaceTable = neighborNode->interfaceTable;
     if (neighborInterfaceTable)
     {
         // neighbor is a host or router, just add the interface
@@ -237,9 +296,8 @@ void IPv4NetworkConfigurator::extractWiredNeighbors(Topology::LinkOut *linkOut,
     {
         // assume that neighbor is an L2 or L1 device (bus/hub/switch/bridge/access point/etc); visit all its output links
         Node *deviceNode = (Node *)linkOut->getRemoteNode();
-        if (!contains(deviceNodesVisited, deviceNode))
+        if (deviceNodesVisited.insert(deviceNode).second)
         {
-            deviceNodesVisited.push_back(deviceNode);
             for (int i = 0; i < deviceNode->getNumOutLinks(); i++)
             {
                 Topology::LinkOut *deviceLinkOut = deviceNode->getLinkOut(i);
@@ -269,8 +327,7 @@ void IPv4NetworkConfigurator::extractWirelessTopology(IPv4Topology& topology)
     for (int nodeIndex = 0; nodeIndex < topology.getNumNodes(); nodeIndex++)
     {
         Node *node = (Node *)topology.getNode(nodeIndex);
-        cModule *module = node->getModule();
-        IInterfaceTable *interfaceTable = IPvXAddressResolver().findInterfaceTableOf(module);
+        IInterfaceTable *interfaceTable = node->interfaceTable;
         if (interfaceTable)
         {
             for (int j = 0; j < interfaceTable->getNumInterfaces(); j++)
@@ -811,6 +868,15 @@ bool IPv4NetworkConfigurator::InterfaceMatcher::matches(InterfaceInfo *interface
     return false;
 }
 
+/**
+ * Returns true if the pattern matches only the given string, e.g. the full paths
+ * of hosts in configurations written by dumpConfig().
+ */
+inline bool isLiteralPattern(const char *pattern)
+{
+    return isNotEmpty(pattern) && !strpbrk(pattern, " \t\n*?{}[]\\");
+}
+
 inline bool strToBool(const char *str, bool defaultValue)
 {
     if (!str || !str[0])
@@ -827,6 +893,30 @@ void IPv4NetworkConfigurator::readAddressConfiguration(cXMLElement *root, IPv4To
     std::set<InterfaceInfo *> interfacesSeen;
     cXMLElementList interfaceElements = root->getChildrenByTagName("interface");
 
+    // determine the host paths only once, and index the interfaces by them for hosts attributes without wildcards
+    std::vector<InterfaceInfo *> interfaceInfos;
+    std::vector<std::string> hostFullPaths;
+    std::map<std::string, std::vector<int> > hostPathToInterfaceIndices;
+    for (int i = 0; i < (int)topology.linkInfos.size(); i++)
+    {
+        LinkInfo *linkInfo = topology.linkInfos[i];
+        for (int j = 0; j < (int)linkInfo->interfaceInfos.size(); j++)
+        {
+            InterfaceInfo *interfaceInfo = linkInfo->interfaceInfos[j];
+            std::string hostFullPath = interfaceInfo->interfaceEntry->getInterfaceTable()->getHostModule()->getFullPath();
+            std::string hostShortenedFullPath = hostFullPath.substr(hostFullPath.find('.') + 1);
+            hostPathToInterfaceIndices[hostFullPath].push_back(interfaceInfos.size());
+            if (hostShortenedFullPath != hostFullPath)
+                hostPathToInterfaceIndices[hostShortenedFullPath].push_back(interfaceInfos.size());
+            interfaceInfos.push_back(interfaceInfo);
+            hostFullPaths.push_back(hostFullPath);
+        }
+    }
+    std::vector<int> allInterfaceIndices(interfaceInfos.size());
+    for (int i = 0; i < (int)interfaceInfos.size(); i++)
+        allInterfaceIndices[i] = i;
+    std::vector<int> noInterfaceIndices;
+
     for (int i = 0; i < (int)interfaceElements.size(); i++)
     {
         cXMLElement *interfaceElement = interfaceElements[i];
@@ -866,62 +956,68 @@ void IPv4NetworkConfigurator::readAddressConfiguration(cXMLElement *root, IPv4To
             if (haveNetmaskConstraint)
                 parseAddressAndSpecifiedBits(netmaskAttr, netmask, netmaskSpecifiedBits);
 
+            // the candidate interfaces: only those of the given host if it is not a pattern
+            const std::vector<int> *interfaceIndices = &allInterfaceIndices;
+            if (isLiteralPattern(hostAttr))
+            {
+                std::map<std::string, std::vector<int> >::iterator it = hostPathToInterfaceIndices.find(hostAttr);
+                interfaceIndices = it != hostPathToInterfaceIndices.end() ? &it->second : &noInterfaceIndices;
+            }
+
             // configure address/netmask constraints on matching interfaces
-            for (int i = 0; i < (int)topology.linkInfos.size(); i++)
+            for (int k = 0; k < (int)interfaceIndices->size(); k++)
             {
-                LinkInfo *linkInfo = topology.linkInfos[i];
-                for (int j = 0; j < (int)linkInfo->interfaceInfos.size(); j++)
+                int interfaceIndex = (*interfaceIndices)[k];
+                InterfaceInfo *interfaceInfo = interfaceInfos[interfaceIndex];
+                LinkInfo *linkInfo = interfaceInfo->linkInfo;
+                if (interfacesSeen.count(interfaceInfo) == 0)
                 {
-                    InterfaceInfo *interfaceInfo = linkInfo->interfaceInfos[j];
-                    if (interfacesSeen.count(interfaceInfo) == 0)
+                    cModule *hostModule = interfaceInfo->interfaceEntry->getInterfaceTable()->getHostModule();
+                    const std::string& hostFullPath = hostFullPaths[interfaceIndex];
+                    std::string hostShortenedFullPath = hostFullPath.substr(hostFullPath.find('.') + 1);
+
+                    // Note: "hosts", "interfaces" and "towards" must ALL match on the interface for the rule to apply
+                    if ((hostMatcher.matchesAny() || hostMatcher.matches(hostShortenedFullPath.c_str()) || hostMatcher.matches(hostFullPath.c_str())) &&
+                        (interfaceMatcher.matchesAny() || interfaceMatcher.matches(interfaceInfo->interfaceEntry->getFullName())) &&
+                        (towardsMatcher.matchesAny() || linkContainsMatchingHostExcept(linkInfo, &towardsMatcher, hostModule)))
                     {
-                        cModule *hostModule = interfaceInfo->interfaceEntry->getInterfaceTable()->getHostModule();
-                        std::string hostFullPath = hostModule->getFullPath();
-                        std::string hostShortenedFullPath = hostFullPath.substr(hostFullPath.find('.') + 1);
-
-                        // Note: "hosts", "interfaces" and "towards" must ALL match on the interface for the rule to apply
-                        if ((hostMatcher.matchesAny() || hostMatcher.matches(hostShortenedFullPath.c_str()) || hostMatcher.matches(hostFullPath.c_str())) &&
-                            (interfaceMatcher.matchesAny() || interfaceMatcher.matches(interfaceInfo->interfaceEntry->getFullName())) &&
-                            (towardsMatcher.matchesAny() || linkContainsMatchingHostExcept(linkInfo, &towardsMatcher, hostModule)))
+                        // unicast address constraints
+                        interfaceInfo->configure = haveAddressConstraint;
+                        if (interfaceInfo->configure)
                         {
-                            // unicast address constraints
-                            interfaceInfo->configure = haveAddressConstraint;
-                            if (interfaceInfo->configure)
+                            interfaceInfo->address = address;
+                            interfaceInfo->addressSpecifiedBits = addressSpecifiedBits;
+                            if (haveNetmaskConstraint)
                             {
-                                interfaceInfo->address = address;
-                                interfaceInfo->addressSpecifiedBits = addressSpecifiedBits;
-                                if (haveNetmaskConstraint)
-                                {
-                                    interfaceInfo->netmask = netmask;
-                                    interfaceInfo->netmaskSpecifiedBits = netmaskSpecifiedBits;
-                                }
+                                interfaceInfo->netmask = netmask;
+                                interfaceInfo->netmaskSpecifiedBits = netmaskSpecifiedBits;
                             }
+                        }
 
-                            // mtu
-                            if (isNotEmpty(mtuAttr))
-                                interfaceInfo->interfaceEntry->setMtu(atoi(mtuAttr));
+                        // mtu
+                        if (isNotEmpty(mtuAttr))
+                            interfaceInfo->interfaceEntry->setMtu(atoi(mtuAttr));
 
-                            // metric
-                            if (isNotEmpty(metricAttr))
-                            {
-                                ASSERT(interfaceInfo->interfaceEntry->ipv4Data());
-                                interfaceInfo->interfaceEntry->ipv4Data()->setMetric(atoi(metricAttr));
-                            }
+                        // metric
+                        if (isNotEmpty(metricAttr))
+                        {
+                            ASSERT(interfaceInfo->interfaceEntry->ipv4Data());
+                            interfaceInfo->interfaceEntry->ipv4Data()->setMetric(atoi(metricAttr));
+                        }
 
-                            // groups
-                            if (isNotEmpty(groupsAttr))
-                            {
-                                ASSERT(interfaceInfo->interfaceEntry->ipv4Data());
-                                cStringTokenizer tokenizer(groupsAttr);
-                                while (tokenizer.hasMoreTokens()) {
-                                    IPv4Address address(tokenizer.nextToken());
-                                    interfaceInfo->interfaceEntry->ipv4Data()->joinMulticastGroup(address);
-                                }
+                        // groups
+                        if (isNotEmpty(groupsAttr))
+                        {
+                            ASSERT(interfaceInfo->interfaceEntry->ipv4Data());
+                            cStringTokenizer tokenizer(groupsAttr);
+                            while (tokenizer.hasMoreTokens()) {
+                                IPv4Address address(tokenizer.nextToken());
+                                interfaceInfo->interfaceEntry->ipv4Data()->joinMulticastGroup(address);
                             }
-
-                            interfacesSeen.insert(interfaceInfo);
-                            EV_DEBUG << hostModule->getFullPath() << ":" << interfaceInfo->interfaceEntry->getFullName() << endl;
                         }
+
+                        interfacesSeen.insert(interfaceInfo);
+                        EV_DEBUG << hostModule->getFullPath() << ":" << interfaceInfo->interfaceEntry->getFullName() << endl;
                     }
                 }
             }
@@ -971,6 +1067,288 @@ bool IPv4NetworkConfigurator::linkContainsMatchingHostExcept(LinkInfo *linkInfo,
     return false;
 }
 
+void IPv4NetworkConfigurator::computeConfigurationKey(IPv4Topology& topology, ConfigurationSnapshot::Key& key)
+{
+    // parameters that affect the result; numThreads and the dump parameters don't
+    const char *parameterNames[] = {"config", "assignAddresses", "assignDisjunctSubnetAddresses", "addStaticRoutes",
+            "addDefaultRoutes", "addSubnetRoutes", "optimizeRoutes", "allPairsShortestPaths", NULL};
+    for (int i = 0; parameterNames[i]; i++)
+        key.addParameter(this, parameterNames[i]);
+
+    // nodes with their interfaces and connections
+    key.add(topology.getNumNodes());
+    for (int i = 0; i < topology.getNumNodes(); i++)
+    {
+        Node *node = (Node *)topology.getNode(i);
+        key.add(node->module->getFullPath());
+        key.add(node->module->getId());
+        key.add(node->getWeight());
+        key.add(node->routingTable ? (node->routingTable->isIPForwardingEnabled() ? 2 : 1) : 0);
+        IInterfaceTable *interfaceTable = node->interfaceTable;
+        key.add(interfaceTable ? interfaceTable->getNumInterfaces() : -1);
+        for (int j = 0; interfaceTable && j < interfaceTable->getNumInterfaces(); j++)
+        {
+            InterfaceEntry *interfaceEntry = interfaceTable->getInterface(j);
+            IPv4InterfaceData *ipv4Data = interfaceEntry->ipv4Data();
+            key.add(interfaceEntry->getName());
+            key.add(interfaceEntry->getInterfaceId());
+            key.add(interfaceEntry->getNodeOutputGateId());
+            key.add(interfaceEntry->getMTU());
+            key.add(interfaceEntry->isLoopback());
+            key.add(ipv4Data != NULL);
+            if (ipv4Data)
+            {
+                key.add(ipv4Data->getIPAddress().getInt());
+                key.add(ipv4Data->getNetmask().getInt());
+                key.add(ipv4Data->getMetric());
+            }
+        }
+        key.add(node->getNumOutLinks());
+        for (int j = 0; j < node->getNumOutLinks(); j++)
+        {
+            Topology::LinkOut *linkOut = node->getLinkOut(j);
+            key.add(linkOut->getRemoteNode()->getModuleId());
+            key.add(linkOut->getLocalGateId());
+            key.add(linkOut->getRemoteGateId());
+            key.add(linkOut->getWeight());
+        }
+    }
+
+    // links (LANs and wireless networks) as determined by extractTopology()
+    key.add((int)topology.linkInfos.size());
+    for (int i = 0; i < (int)topology.linkInfos.size(); i++)
+    {
+        LinkInfo *linkInfo = topology.linkInfos[i];
+        key.add(linkInfo->isWireless);
+        key.add((int)linkInfo->interfaceInfos.size());
+        for (int j = 0; j < (int)linkInfo->interfaceInfos.size(); j++)
+        {
+            InterfaceInfo *interfaceInfo = linkInfo->interfaceInfos[j];
+            key.add(interfaceInfo->node->module->getId());
+            key.add(interfaceInfo->interfaceEntry->getInterfaceId());
+        }
+        key.add(linkInfo->gatewayInterfaceInfo ? linkInfo->gatewayInterfaceInfo->interfaceEntry->getInterfaceId() : -1);
+    }
+}
+
+void IPv4NetworkConfigurator::recordConfigurationBaseline(IPv4Topology& topology, ConfigurationBaseline& baseline)
+{
+    for (int i = 0; i < topology.getNumNodes(); i++)
+    {
+        Node *node = (Node *)topology.getNode(i);
+        IRoutingTable *routingTable = node->routingTable;
+        if (routingTable)
+        {
+            for (int j = 0; j < routingTable->getNumRoutes(); j++)
+                baseline.routes.insert(routingTable->getRoute(j));
+            for (int j = 0; j < routingTable->getNumMulticastRoutes(); j++)
+                baseline.routes.insert(routingTable->getMulticastRoute(j));
+        }
+        IInterfaceTable *interfaceTable = node->interfaceTable;
+        for (int j = 0; interfaceTable && j < interfaceTable->getNumInterfaces(); j++)
+        {
+            InterfaceEntry *interfaceEntry = interfaceTable->getInterface(j);
+            if (interfaceEntry->ipv4Data())
+                baseline.multicastGroups[interfaceEntry] = interfaceEntry->ipv4Data()->getJoinedMulticastGroups();
+        }
+    }
+}
+
+void IPv4NetworkConfigurator::storeConfiguration(IPv4Topology& topology, const ConfigurationBaseline& baseline, ConfigurationSnapshot& snapshot)
+{
+    snapshot.writeInt(topology.getNumNodes());
+    for (int i = 0; i < topology.getNumNodes(); i++)
+    {
+        Node *node = (Node *)topology.getNode(i);
+        snapshot.writeString(node->module->getFullPath());
+
+        // interface data, and the multicast groups joined by the configurator
+        IInterfaceTable *interfaceTable = node->interfaceTable;
+        snapshot.writeInt(interfaceTable ? interfaceTable->getNumInterfaces() : 0);
+        for (int j = 0; interfaceTable && j < interfaceTable->getNumInterfaces(); j++)
+        {
+            InterfaceEntry *interfaceEntry = interfaceTable->getInterface(j);
+            IPv4InterfaceData *ipv4Data = interfaceEntry->ipv4Data();
+            snapshot.writeInt(interfaceEntry->getMTU());
+            snapshot.writeInt(ipv4Data != NULL);
+            if (ipv4Data)
+            {
+                snapshot.writeUint32(ipv4Data->getIPAddress().getInt());
+                snapshot.writeUint32(ipv4Data->getNetmask().getInt());
+                snapshot.writeInt(ipv4Data->getMetric());
+                const std::vector<IPv4Address>& groups = ipv4Data->getJoinedMulticastGroups();
+                const std::vector<IPv4Address>& baselineGroups = baseline.multicastGroups.find(interfaceEntry)->second;
+                std::vector<IPv4Address> addedGroups;
+                for (int k = 0; k < (int)groups.size(); k++)
+                    if (std::find(baselineGroups.begin(), baselineGroups.end(), groups[k]) == baselineGroups.end())
+                        addedGroups.push_back(groups[k]);
+                snapshot.writeInt(addedGroups.size());
+                for (int k = 0; k < (int)addedGroups.size(); k++)
+                    snapshot.writeUint32(addedGroups[k].getInt());
+            }
+        }
+
+        // routes added by the configurator, in routing table order; netmask routes are
+        // added by the routing table itself
+        IRoutingTable *routingTable = node->routingTable;
+        std::vector<IPv4Route *> routes;
+        for (int j = 0; routingTable && j < routingTable->getNumRoutes(); j++)
+        {
+            IPv4Route *route = routingTable->getRoute(j);
+            if (route->getSource() != IPv4Route::IFACENETMASK && !baseline.routes.count(route))
+                routes.push_back(route);
+        }
+        snapshot.writeInt(routes.size());
+        for (int j = 0; j < (int)routes.size(); j++)
+        {
+            IPv4Route *route = routes[j];
+            snapshot.writeUint32(route->getDestination().getInt());
+            snapshot.writeUint32(route->getNetmask().getInt());
+            snapshot.writeUint32(route->getGateway().getInt());
+            snapshot.writeInt(route->getInterface() ? route->getInterface()->getInterfaceId() : -1);
+            snapshot.writeInt(route->getSource());
+            snapshot.writeInt(route->getMetric());
+        }
+        std::vector<IPv4MulticastRoute *> multicastRoutes;
+        for (int j = 0; routingTable && j < routingTable->getNumMulticastRoutes(); j++)
+        {
+            IPv4MulticastRoute *route = routingTable->getMulticastRoute(j);
+            if (!baseline.routes.count(route))
+                multicastRoutes.push_back(route);
+        }
+        snapshot.writeInt(multicastRoutes.size());
+        for (int j = 0; j < (int)multicastRoutes.size(); j++)
+        {
+            IPv4MulticastRoute *route = multicastRoutes[j];
+            snapshot.writeUint32(route->getOrigin().getInt());
+            snapshot.writeUint32(route->getOriginNetmask().getInt());
+            snapshot.writeUint32(route->getMulticastGroup().getInt());
+            snapshot.writeInt(route->getParent() ? route->getParent()->getInterfaceId() : -1);
+            snapshot.writeInt(route->getSource());
+            snapshot.writeInt(route->getMetric());
+            const IPv4MulticastRoute::ChildInterfaceVector& children = route->getChildren();
+            snapshot.writeInt(children.size());
+            for (int k = 0; k < (int)children.size(); k++)
+            {
+                snapshot.writeInt(children[k]->getInterface()->getInterfaceId());
+                snapshot.writeInt(children[k]->isLeaf());
+            }
+        }
+    }
+
+    if (snapshot.save())
+        EV_INFO << "Configuration stored in " << snapshot.getFileName() << endl;
+    else
+        EV_INFO << "Cannot write configuration snapshot " << snapshot.getFileName() << ", continuing without it" << endl;
+}
+
+bool IPv4NetworkConfigurator::restoreConfiguration(IPv4Topology& topology, ConfigurationSnapshot& snapshot)
+{
+    if (!snapshot.load())
+        return false;
+
+    // the key guarantees that the snapshot belongs to this network, so errors mean a corrupt cache
+    if (snapshot.readInt() != topology.getNumNodes())
+        throw cRuntimeError("Configuration snapshot %s does not match the network, delete it", snapshot.getFileName());
+    for (int i = 0; i < topology.getNumNodes(); i++)
+    {
+        Node *node = (Node *)topology.getNode(i);
+        IInterfaceTable *interfaceTable = node->interfaceTable;
+        IRoutingTable *routingTable = node->routingTable;
+        int numInterfaces = interfaceTable ? interfaceTable->getNumInterfaces() : 0;
+        if (snapshot.readString() != node->module->getFullPath() || snapshot.readInt() != numInterfaces)
+            throw cRuntimeError("Configuration snapshot %s does not match the network, delete it", snapshot.getFileName());
+
+        // interface data; only changed values are set, to avoid needless change notifications
+        for (int j = 0; j < numInterfaces; j++)
+        {
+            InterfaceEntry *interfaceEntry = interfaceTable->getInterface(j);
+            IPv4InterfaceData *ipv4Data = interfaceEntry->ipv4Data();
+            int mtu = snapshot.readInt();
+            if (interfaceEntry->getMTU() != mtu)
+                interfaceEntry->setMtu(mtu);
+            if (snapshot.readInt() != (ipv4Data != NULL))
+                throw cRuntimeError("Configuration snapshot %s does not match the network, delete it", snapshot.getFileName());
+            if (ipv4Data)
+            {
+                IPv4Address address(snapshot.readUint32());
+                IPv4Address netmask(snapshot.readUint32());
+                int metric = snapshot.readInt();
+                if (ipv4Data->getIPAddress() != address)
+                    ipv4Data->setIPAddress(address);
+                if (ipv4Data->getNetmask() != netmask)
+                    ipv4Data->setNetmask(netmask);
+                if (ipv4Data->getMetric() != metric)
+                    ipv4Data->setMetric(metric);
+                int numGroups = snapshot.readInt();
+                for (int k = 0; k < numGroups && !snapshot.hasReadError(); k++)
+                    ipv4Data->joinMulticastGroup(IPv4Address(snapshot.readUint32()));
+            }
+        }
+
+        // routes
+        int numRoutes = snapshot.readInt();
+        for (int j = 0; j < numRoutes && !snapshot.hasReadError(); j++)
+        {
+            IPv4Route *route = new IPv4Route();
+            route->setDestination(IPv4Address(snapshot.readUint32()));
+            route->setNetmask(IPv4Address(snapshot.readUint32()));
+            route->setGateway(IPv4Address(snapshot.readUint32()));
+            int interfaceId = snapshot.readInt();
+            route->setSource((IPv4Route::RouteSource)snapshot.readInt());
+            route->setMetric(snapshot.readInt());
+            InterfaceEntry *interfaceEntry = interfaceId == -1 || !interfaceTable ? NULL : interfaceTable->getInterfaceById(interfaceId);
+            if (!routingTable || (interfaceId != -1 && !interfaceEntry))
+            {
+                delete route;
+                throw cRuntimeError("Configuration snapshot %s does not match the network, delete it", snapshot.getFileName());
+            }
+            route->setInterface(interfaceEntry);
+            routingTable->addRoute(route);
+        }
+        int numMulticastRoutes = snapshot.readInt();
+        for (int j = 0; j < numMulticastRoutes && !snapshot.hasReadError(); j++)
+        {
+            IPv4MulticastRoute *route = new IPv4MulticastRoute();
+            route->setOrigin(IPv4Address(snapshot.readUint32()));
+            route->setOriginNetmask(IPv4Address(snapshot.readUint32()));
+            route->setMulticastGroup(IPv4Address(snapshot.readUint32()));
+            int parentId = snapshot.readInt();
+            route->setSource((IPv4MulticastRoute::RouteSource)snapshot.readInt());
+            route->setMetric(snapshot.readInt());
+            bool valid = routingTable && interfaceTable;
+            if (valid && parentId != -1)
+            {
+                route->setParent(interfaceTable->getInterfaceById(parentId));
+                valid = route->getParent() != NULL;
+            }
+            int numChildren = snapshot.readInt();
+            for (int k = 0; k < numChildren && !snapshot.hasReadError(); k++)
+            {
+                InterfaceEntry *child = interfaceTable ? interfaceTable->getInterfaceById(snapshot.readInt()) : NULL;
+                bool isLeaf = snapshot.readInt();
+                if (child)
+                    route->addChild(child, isLeaf);
+                else
+                    valid = false;
+            }
+            if (!valid)
+            {
+                delete route;
+                throw cRuntimeError("Configuration snapshot %s does not match the network, delete it", snapshot.getFileName());
+            }
+            routingTable->addMulticastRoute(route);
+        }
+        if (snapshot.hasReadError())
+            break;
+    }
+    if (snapshot.hasReadError() || !snapshot.isAtEnd())
+        throw cRuntimeError("Configuration snapshot %s is corrupt, delete it", snapshot.getFileName());
+
+    EV_INFO << "Configuration restored from " << snapshot.getFileName() << endl;
+    return true;
+}
+
 void IPv4NetworkConfigurator::dumpTopology(IPv4Topology& topology)
 {
     for (int i = 0; i < topology.getNumNodes(); i++)
@@ -1227,6 +1605,28 @@ const char *IPv4NetworkConfigurator::getMandatoryAttribute(cXMLElement *element,
 void IPv4NetworkConfigurator::addManualRoutes(cXMLElement *root, IPv4Topology& topology)
 {
     cXMLElementList routeElements = root->getChildrenByTagName("route");
+    if (routeElements.empty())
+        return;
+
+    // determine the host paths only once, and index the nodes by them for hosts attributes without wildcards
+    std::vector<std::string> hostFullPaths(topology.getNumNodes());
+    std::map<std::string, std::vector<int> > hostPathToNodeIndices;
+    std::vector<int> allNodeIndices;
+    for (int i = 0; i < topology.getNumNodes(); i++)
+    {
+        Node *node = (Node *)topology.getNode(i);
+        if (node->routingTable)
+        {
+            hostFullPaths[i] = node->module->getFullPath();
+            std::string hostShortenedFullPath = hostFullPaths[i].substr(hostFullPaths[i].find('.') + 1);
+            hostPathToNodeIndices[hostFullPaths[i]].push_back(i);
+            if (hostShortenedFullPath != hostFullPaths[i])
+                hostPathToNodeIndices[hostShortenedFullPath].push_back(i);
+            allNodeIndices.push_back(i);
+        }
+    }
+    std::vector<int> noNodeIndices;
+
     for (int i = 0; i < (int)routeElements.size(); i++)
     {
         cXMLElement *routeElement = routeElements[i];
@@ -1256,33 +1656,36 @@ void IPv4NetworkConfigurator::addManualRoutes(cXMLElement *root, IPv4Topology& t
             if (isEmpty(interfaceAttr) && isEmpty(gatewayAttr))
                 throw cRuntimeError("Incomplete route: either gateway or interface (or both) must be specified");
 
-            // find matching host(s), and add the route
+            // find matching host(s), and add the route; only the given host is a candidate if it is not a pattern
             Matcher atMatcher(hostAttr);
-            for (int i = 0; i < topology.getNumNodes(); i++)
+            const std::vector<int> *nodeIndices = &allNodeIndices;
+            if (isLiteralPattern(hostAttr))
+            {
+                std::map<std::string, std::vector<int> >::iterator it = hostPathToNodeIndices.find(hostAttr);
+                nodeIndices = it != hostPathToNodeIndices.end() ? &it->second : &noNodeIndices;
+            }
+            for (int k = 0; k < (int)nodeIndices->size(); k++)
             {
                 // extract source
-                Node *node = (Node *)topology.getNode(i);
-                if (node->routingTable)
+                Node *node = (Node *)topology.getNode((*nodeIndices)[k]);
+                const std::string& hostFullPath = hostFullPaths[(*nodeIndices)[k]];
+                std::string hostShortenedFullPath = hostFullPath.substr(hostFullPath.find('.') + 1);
+                if (atMatcher.matches(hostShortenedFullPath.c_str()) || atMatcher.matches(hostFullPath.c_str()))
                 {
-                    std::string hostFullPath = node->module->getFullPath();
-                    std::string hostShortenedFullPath = hostFullPath.substr(hostFullPath.find('.') + 1);
-                    if (atMatcher.matches(hostShortenedFullPath.c_str()) || atMatcher.matches(hostFullPath.c_str()))
-                    {
-                        // determine the gateway (its address towards this node!) and the output interface for the route (must be done per node)
-                        InterfaceEntry *ie;
-                        IPv4Address gateway;
-                        resolveInterfaceAndGateway(node, interfaceAttr, gatewayAttr, ie, gateway, topology);
-
-                        // create and add route
-                        IPv4Route *route = new IPv4Route();
-                        route->setDestination(destination);
-                        route->setNetmask(netmask);
-                        route->setGateway(gateway); // may be unspecified
-                        route->setInterface(ie);
-                        if (isNotEmpty(metricAttr))
-                            route->setMetric(atoi(metricAttr));
-                        node->routingTable->addRoute(route);
-                    }
+                    // determine the gateway (its address towards this node!) and the output interface for the route (must be done per node)
+                    InterfaceEntry *ie;
+                    IPv4Address gateway;
+                    resolveInterfaceAndGateway(node, interfaceAttr, gatewayAttr, ie, gateway, topology);
+
+                    // create and add route
+                    IPv4Route *route = new IPv4Route();
+                    route->setDestination(destination);
+                    route->setNetmask(netmask);
+                    route->setGateway(gateway); // may be unspecified
+                    route->setInterface(ie);
+                    if (isNotEmpty(metricAttr))
+                        route->setMetric(atoi(metricAttr));
+                    node->routingTable->addRoute(route);
                 }
             }
         }
@@ -1532,6 +1935,40 @@ bool IPv4NetworkConfigurator::containsRoute(const std::vector<IPv4Route *>& rout
     return false;
 }
 
+void IPv4NetworkConfigurator::addDefaultRoutesTowardsGateway(Node *sourceNode)
+{
+    IRoutingTable *sourceRoutingTable = sourceNode->routingTable;
+    InterfaceInfo *sourceInterfaceInfo = sourceNode->interfaceInfos[0];
+    InterfaceEntry *sourceInterfaceEntry = sourceInterfaceInfo->interfaceEntry;
+    InterfaceInfo *gatewayInterfaceInfo = sourceInterfaceInfo->linkInfo->gatewayInterfaceInfo;
+    InterfaceEntry *gatewayInterfaceEntry = gatewayInterfaceInfo->interfaceEntry;
+
+    // add a network route for the local network using ARP
+    IPv4Route *route = new IPv4Route();
+    IPv4InterfaceData *ipv4InterfaceData = sourceInterfaceEntry->ipv4Data();
+    IPv4Address address = ipv4InterfaceData->getIPAddress();
+    IPv4Address netmask = ipv4InterfaceData->getNetmask();
+    route->setDestination(IPv4Address(address.getInt() & netmask.getInt()));
+    route->setGateway(IPv4Address::UNSPECIFIED_ADDRESS);
+    route->setNetmask(netmask);
+    route->setInterface(sourceInterfaceEntry);
+    route->setSource(IPv4Route::MANUAL);
+    sourceRoutingTable->addRoute(route);
+
+    // add a default route towards the only one gateway
+    route = new IPv4Route();
+    IPv4Address gateway = gatewayInterfaceEntry->ipv4Data()->getIPAddress();
+    route->setDestination(IPv4Address::UNSPECIFIED_ADDRESS);
+    route->setNetmask(IPv4Address::UNSPECIFIED_ADDRESS);
+    route->setGateway(gateway);
+    route->setInterface(sourceInterfaceEntry);
+    route->setSource(IPv4Route::MANUAL);
+    sourceRoutingTable->addRoute(route);
+
+    // skip building and optimizing the whole routing table
+    EV_DEBUG << "Adding default routes to " << sourceNode->getModule()->getFullPath() << ", node has only one (non-loopback) interface\n";
+}
+
 void IPv4NetworkConfigurator::addStaticRoutes(IPv4Topology& topology)
 {
     long optimizeRoutesDuration = 0;
@@ -1561,35 +1998,7 @@ void IPv4NetworkConfigurator::addStaticRoutes(IPv4Topology& topology)
         if (addDefaultRoutesParameter && sourceNode->interfaceInfos.size() == 1 && sourceNode->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo)
         {
             begin = clock();
-            InterfaceInfo *sourceInterfaceInfo = sourceNode->interfaceInfos[0];
-            InterfaceEntry *sourceInterfaceEntry = sourceInterfaceInfo->interfaceEntry;
-            InterfaceInfo *gatewayInterfaceInfo = sourceInterfaceInfo->linkInfo->gatewayInterfaceInfo;
-            InterfaceEntry *gatewayInterfaceEntry = gatewayInterfaceInfo->interfaceEntry;
-
-            // add a network route for the local network using ARP
-            IPv4Route *route = new IPv4Route();
-            IPv4InterfaceData *ipv4InterfaceData = sourceInterfaceEntry->ipv4Data();
-            IPv4Address address = ipv4InterfaceData->getIPAddress();
-            IPv4Address netmask = ipv4InterfaceData->getNetmask();
-            route->setDestination(IPv4Address(address.getInt() & netmask.getInt()));
-            route->setGateway(IPv4Address::UNSPECIFIED_ADDRESS);
-            route->setNetmask(netmask);
-            route->setInterface(sourceInterfaceEntry);
-            route->setSource(IPv4Route::MANUAL);
-            sourceRoutingTable->addRoute(route);
-
-            // add a default route towards the only one gateway
-            route = new IPv4Route();
-            IPv4Address gateway = gatewayInterfaceEntry->ipv4Data()->getIPAddress();
-            route->setDestination(IPv4Address::UNSPECIFIED_ADDRESS);
-            route->setNetmask(IPv4Address::UNSPECIFIED_ADDRESS);
-            route->setGateway(gateway);
-            route->setInterface(sourceInterfaceEntry);
-            route->setSource(IPv4Route::MANUAL);
-            sourceRoutingTable->addRoute(route);
-
-            // skip building and optimizing the whole routing table
-            EV_DEBUG << "Adding default routes to " << sourceNode->getModule()->getFullPath() << ", node has only one (non-loopback) interface\n";
+            addDefaultRoutesTowardsGateway(sourceNode);
             addDefaultRoutesDuration += clock() - begin;
         }
         else
@@ -1683,6 +2092,312 @@ void IPv4NetworkConfigurator::addStaticRoutes(IPv4Topology& topology)
     printTimeSpentUsingDuration("optimizeRoutes", optimizeRoutesDuration);
 }
 
+namespace {
+
+/**
+ * A route calculated by the all-pairs shortest path workers.
+ */
+struct AllPairsRoute
+{
+    uint32 destination;
+    uint32 netmask;
+    uint32 gateway;
+    InterfaceEntry *interfaceEntry;
+
+    bool operator==(const AllPairsRoute& other) const {
+        return destination == other.destination && netmask == other.netmask && gateway == other.gateway && interfaceEntry == other.interfaceEntry;
+    }
+    unsigned int hash() const {
+        return (destination * 2654435761u) ^ (netmask * 40503u) ^ (gateway * 2246822519u) ^ (unsigned int)(size_t)interfaceEntry;
+    }
+};
+
+/**
+ * Compact, read-only copy of the topology for the all-pairs shortest path
+ * workers. Workers only compare the InterfaceEntry pointers, they never
+ * access simulation objects.
+ */
+struct AllPairsGraph
+{
+    int numNodes;
+    std::vector<char> nodeEnabled;
+    std::vector<char> nodeIsSource;               // needs a full routing table
+    std::vector<int> inLinkBegin;                 // the in-links of node i are [inLinkBegin[i], inLinkBegin[i+1])
+    std::vector<int> inLinkSource;                // the node at the other end of the link
+    std::vector<InterfaceEntry *> inLinkInterface; // the interface of the node at this end, NULL if none
+    std::vector<char> inLinkHasNextHop;           // the node at the other end has an interface table and an interface on the link
+    std::vector<char> inLinkNextHopValid;         // ... and that interface has IPv4 data
+    std::vector<uint32> inLinkNextHopAddress;
+    std::vector<int> destinationBegin;            // the destination addresses of node i are [destinationBegin[i], destinationBegin[i+1])
+    std::vector<uint32> destinationAddress;       // the address of the interface
+    std::vector<uint32> destinationRouteAddress;  // the destination and netmask of the route towards the interface
+    std::vector<uint32> destinationRouteNetmask;
+    bool optimizeRoutes;
+    int numThreads;
+    std::vector<std::vector<AllPairsRoute> > routes;   // the result for each source node
+};
+
+struct AllPairsWorker
+{
+    AllPairsGraph *graph;
+    int threadIndex;
+    long numRoutes;            // before aggregation
+    long numAggregatedRoutes;
+};
+
+/**
+ * Calculates the routing tables of the source nodes threadIndex, threadIndex + numThreads, ...
+ * A breadth-first search from the source yields the same shortest path tree as
+ * Topology::calculateUnweightedSingleShortestPathsTo(), and the first hop of
+ * each node is propagated down the tree instead of walking the paths back.
+ */
+void calculateAllPairsRoutes(AllPairsWorker *worker)
+{
+    AllPairsGraph& graph = *worker->graph;
+    int numNodes = graph.numNodes;
+    std::vector<char> visited(numNodes);
+    std::vector<int> queue(numNodes);
+    std::vector<InterfaceEntry *> firstHopInterface(numNodes);
+    std::vector<int> nextHopLink(numNodes);    // the in-link of the IP node closest to the source on the path, -1 if none
+    unsigned int numSlots = 16;                 // open addressing hash table of the routes of a source, at most half full
+    while (numSlots < 2 * graph.destinationAddress.size())
+        numSlots *= 2;
+    std::vector<int> routeSlots(numSlots);
+    std::map<std::pair<InterfaceEntry *, uint32>, int> colors;
+    std::vector<IPv4NetworkConfigurator::RouteAggregator::Route> coloredRoutes;
+    std::vector<AllPairsRoute> colorToRoute;
+    IPv4NetworkConfigurator::RouteAggregator aggregator;
+    worker->numRoutes = worker->numAggregatedRoutes = 0;
+
+    for (int source = worker->threadIndex; source < numNodes; source += graph.numThreads)
+    {
+        if (!graph.nodeIsSource[source])
+            continue;
+
+        // breadth-first search along the in-links
+        std::fill(visited.begin(), visited.end(), 0);
+        visited[source] = 1;
+        int queueBegin = 0, queueEnd = 0;
+        queue[queueEnd++] = source;
+        while (queueBegin < queueEnd)
+        {
+            int node = queue[queueBegin++];
+            for (int link = graph.inLinkBegin[node]; link < graph.inLinkBegin[node + 1]; link++)
+            {
+                int neighbor = graph.inLinkSource[link];
+                if (visited[neighbor] || !graph.nodeEnabled[neighbor])
+                    continue;
+                visited[neighbor] = 1;
+                if (node == source)
+                {
+                    firstHopInterface[neighbor] = graph.inLinkInterface[link];
+                    nextHopLink[neighbor] = graph.inLinkHasNextHop[link] ? link : -1;
+                }
+                else
+                {
+                    firstHopInterface[neighbor] = firstHopInterface[node];
+                    nextHopLink[neighbor] = nextHopLink[node] != -1 ? nextHopLink[node] : graph.inLinkHasNextHop[link] ? link : -1;
+                }
+                queue[queueEnd++] = neighbor;
+            }
+        }
+
+        // add a route to all destination interfaces, in the order of the nodes
+        std::vector<AllPairsRoute>& routes = graph.routes[source];
+        std::fill(routeSlots.begin(), routeSlots.end(), -1);
+        for (int destination = 0; destination < numNodes; destination++)
+        {
+            if (destination == source || !visited[destination] || graph.destinationBegin[destination] == graph.destinationBegin[destination + 1])
+                continue;
+            int link = nextHopLink[destination];
+            if (link == -1 || !graph.inLinkNextHopValid[link] || !firstHopInterface[destination])
+                continue;
+            uint32 gateway = graph.inLinkNextHopAddress[link];
+            for (int i = graph.destinationBegin[destination]; i < graph.destinationBegin[destination + 1]; i++)
+            {
+                AllPairsRoute route;
+                route.destination = graph.destinationRouteAddress[i];
+                route.netmask = graph.destinationRouteNetmask[i];
+                route.gateway = gateway != graph.destinationAddress[i] ? gateway : 0;
+                route.interfaceEntry = firstHopInterface[destination];
+                unsigned int slot = route.hash() & (numSlots - 1);
+                while (routeSlots[slot] != -1 && !(routes[routeSlots[slot]] == route))
+                    slot = (slot + 1) & (numSlots - 1);
+                if (routeSlots[slot] == -1)
+                {
+                    routeSlots[slot] = routes.size();
+                    routes.push_back(route);
+                }
+            }
+        }
+        worker->numRoutes += routes.size();
+
+        // aggregate the routes by color (output interface and gateway)
+        if (graph.optimizeRoutes)
+        {
+            colors.clear();
+            colorToRoute.clear();
+            coloredRoutes.resize(routes.size());
+            for (int i = 0; i < (int)routes.size(); i++)
+            {
+                std::pair<std::map<std::pair<InterfaceEntry *, uint32>, int>::iterator, bool> it =
+                        colors.insert(std::make_pair(std::make_pair(routes[i].interfaceEntry, routes[i].gateway), (int)colorToRoute.size()));
+                if (it.second)
+                    colorToRoute.push_back(routes[i]);
+                coloredRoutes[i] = IPv4NetworkConfigurator::RouteAggregator::Route(routes[i].destination, routes[i].netmask, it.first->second);
+            }
+            aggregator.aggregate(coloredRoutes, coloredRoutes);
+            routes.resize(coloredRoutes.size());
+            for (int i = 0; i < (int)coloredRoutes.size(); i++)
+            {
+                routes[i] = colorToRoute[coloredRoutes[i].color];
+                routes[i].destination = coloredRoutes[i].destination;
+                routes[i].netmask = coloredRoutes[i].netmask;
+            }
+        }
+        worker->numAggregatedRoutes += routes.size();
+    }
+}
+
+#ifdef INET_IPV4NETWORKCONFIGURATOR_THREADS
+void *allPairsThreadMain(void *arg)
+{
+    calculateAllPairsRoutes((AllPairsWorker *)arg);
+    return NULL;
+}
+#endif
+
+} // namespace
+
+void IPv4NetworkConfigurator::addAllPairsStaticRoutes(IPv4Topology& topology)
+{
+    double begin = getWallClockTime();
+
+    // build the compact copy of the topology, and add default routes where possible
+    AllPairsGraph graph;
+    int numNodes = topology.getNumNodes();
+    graph.numNodes = numNodes;
+    graph.optimizeRoutes = optimizeRoutesParameter;
+    graph.nodeEnabled.resize(numNodes);
+    graph.nodeIsSource.resize(numNodes);
+    graph.inLinkBegin.resize(numNodes + 1);
+    graph.destinationBegin.resize(numNodes + 1);
+    graph.routes.resize(numNodes);
+    std::map<Topology::Node *, int> nodeIndices;
+    for (int i = 0; i < numNodes; i++)
+        nodeIndices[topology.getNode(i)] = i;
+    for (int i = 0; i < numNodes; i++)
+    {
+        Node *node = (Node *)topology.getNode(i);
+        graph.nodeEnabled[i] = node->isEnabled();
+        if (node->interfaceTable && node->routingTable)
+        {
+            if (addDefaultRoutesParameter && node->interfaceInfos.size() == 1 && node->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo)
+                addDefaultRoutesTowardsGateway(node);
+            else
+                graph.nodeIsSource[i] = true;
+        }
+
+        graph.inLinkBegin[i] = graph.inLinkSource.size();
+        for (int j = 0; j < node->getNumInLinks(); j++)
+        {
+            Topology::LinkIn *linkIn = node->getLinkIn(j);
+            if (!linkIn->isEnabled())
+                continue;
+            Link *link = (Link *)linkIn;
+            Node *remoteNode = (Node *)linkIn->getRemoteNode();
+            InterfaceInfo *remoteInterfaceInfo = remoteNode->interfaceTable ? link->sourceInterfaceInfo : NULL;
+            IPv4InterfaceData *remoteInterfaceData = remoteInterfaceInfo ? remoteInterfaceInfo->interfaceEntry->ipv4Data() : NULL;
+            graph.inLinkSource.push_back(nodeIndices[remoteNode]);
+            graph.inLinkInterface.push_back(link->destinationInterfaceInfo ? link->destinationInterfaceInfo->interfaceEntry : NULL);
+            graph.inLinkHasNextHop.push_back(remoteInterfaceInfo != NULL);
+            graph.inLinkNextHopValid.push_back(remoteInterfaceData != NULL);
+            graph.inLinkNextHopAddress.push_back(remoteInterfaceData ? remoteInterfaceData->getIPAddress().getInt() : 0);
+        }
+
+        // the same routes are added for all interfaces (IP packets are accepted from any interface at the destination)
+        graph.destinationBegin[i] = graph.destinationAddress.size();
+        if (node->interfaceTable)
+        {
+            bool addSubnetRoutes = addSubnetRoutesParameter && node->interfaceInfos.size() == 1 && node->interfaceInfos[0]->linkInfo->gatewayInterfaceInfo;
+            for (int j = 0; j < node->interfaceTable->getNumInterfaces(); j++)
+            {
+                InterfaceEntry *interfaceEntry = node->interfaceTable->getInterface(j);
+                if (!interfaceEntry->ipv4Data() || interfaceEntry->isLoopback() || interfaceEntry->ipv4Data()->getIPAddress().isUnspecified())
+                    continue;
+                uint32 address = interfaceEntry->ipv4Data()->getIPAddress().getInt();
+                uint32 netmask = interfaceEntry->ipv4Data()->getNetmask().getInt();
+                graph.destinationAddress.push_back(address);
+                graph.destinationRouteAddress.push_back(addSubnetRoutes ? address & netmask : address);
+                graph.destinationRouteNetmask.push_back(addSubnetRoutes ? netmask : 0xFFFFFFFF);
+            }
+        }
+    }
+    graph.inLinkBegin[numNodes] = graph.inLinkSource.size();
+    graph.destinationBegin[numNodes] = graph.destinationAddress.size();
+    printWallClockTime("buildAllPairsGraph", begin);
+
+    // calculate the routing tables in worker threads; the main thread is one of them
+    begin = getWallClockTime();
+    int numThreads = numThreadsParameter;
+#ifdef INET_IPV4NETWORKCONFIGURATOR_THREADS
+    if (numThreads <= 0)
+        numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    numThreads = std::max(1, std::min(numThreads, numNodes));
+    graph.numThreads = numThreads;
+    std::vector<AllPairsWorker> workers(numThreads);
+    for (int i = 0; i < numThreads; i++)
+    {
+        workers[i].graph = &graph;
+        workers[i].threadIndex = i;
+    }
+#ifdef INET_IPV4NETWORKCONFIGURATOR_THREADS
+    std::vector<pthread_t> threads(numThreads);
+    std::vector<bool> threadStarted(numThreads, false);
+    for (int i = 1; i < numThreads; i++)
+        threadStarted[i] = pthread_create(&threads[i], NULL, allPairsThreadMain, &workers[i]) == 0;
+    for (int i = 0; i < numThreads; i++)
+        if (!threadStarted[i])
+            calculateAllPairsRoutes(&workers[i]);
+    for (int i = 1; i < numThreads; i++)
+        if (threadStarted[i])
+            pthread_join(threads[i], NULL);
+#else
+    for (int i = 0; i < numThreads; i++)
+        calculateAllPairsRoutes(&workers[i]);
+#endif
+    long numRoutes = 0, numAggregatedRoutes = 0;
+    for (int i = 0; i < numThreads; i++)
+    {
+        numRoutes += workers[i].numRoutes;
+        numAggregatedRoutes += workers[i].numAggregatedRoutes;
+    }
+    printWallClockTime("calculateAllPairsRoutes", begin);
+    EV_INFO << "Calculated " << numRoutes << " routes using " << numThreads << " threads, " << numAggregatedRoutes << " routes after aggregation" << endl;
+
+    // copy into the routing tables
+    begin = getWallClockTime();
+    for (int i = 0; i < numNodes; i++)
+    {
+        IRoutingTable *routingTable = ((Node *)topology.getNode(i))->routingTable;
+        std::vector<AllPairsRoute>& routes = graph.routes[i];
+        for (int j = 0; j < (int)routes.size(); j++)
+        {
+            IPv4Route *route = new IPv4Route();
+            route->setDestination(IPv4Address(routes[j].destination));
+            route->setNetmask(IPv4Address(routes[j].netmask));
+            route->setInterface(routes[j].interfaceEntry);
+            if (routes[j].gateway)
+                route->setGateway(IPv4Address(routes[j].gateway));
+            route->setSource(IPv4Route::MANUAL);
+            routingTable->addRoute(route);
+        }
+        std::vector<AllPairsRoute>().swap(routes);
+    }
+    printWallClockTime("addAllPairsRoutes", begin);
+}
+
 /**
  * Returns true if the two routes are the same except their address prefix and netmask.
  * If it returns true we say that the routes have the same color.
@@ -2006,3 +2721,162 @@ void IPv4NetworkConfigurator::optimizeRoutes(std::vector<IPv4Route *>& originalR
     // copy optimized routes to original routes and return
     originalRoutes = optimizedRoutes;
 }
+
+int IPv4NetworkConfigurator::RouteAggregator::addNode()
+{
+    TrieNode node;
+    node.children[0] = node.children[1] = -1;
+    node.color = -1;
+    node.setBegin = 0;
+    node.setLength = -1;
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+void IPv4NetworkConfigurator::RouteAggregator::insert(const Route& route)
+{
+    int nodeIndex = 0;
+    for (uint32 mask = 0x80000000; mask != 0 && (route.netmask & mask) != 0; mask >>= 1)
+    {
+        int bit = (route.destination & mask) != 0;
+        if (nodes[nodeIndex].children[bit] == -1)
+        {
+            int childIndex = addNode();
+            nodes[nodeIndex].children[bit] = childIndex;
+        }
+        nodeIndex = nodes[nodeIndex].children[bit];
+    }
+    // if the same prefix occurs more than once, the first route wins (as in the routing table)
+    if (nodes[nodeIndex].color == -1)
+        nodes[nodeIndex].color = route.color;
+}
+
+bool IPv4NetworkConfigurator::RouteAggregator::setContains(const TrieNode& node, int color) const
+{
+    if (node.setLength == -1)
+        return true;
+    return std::binary_search(colorSets.begin() + node.setBegin, colorSets.begin() + node.setBegin + node.setLength, color);
+}
+
+/**
+ * ORTC pass 1 and 2: calculates the set of colors for each node with which the
+ * fewest routes are needed in the subtree. A missing child of an inner node
+ * stands for the addresses that are routed by the closest original route above
+ * (the owner), or for addresses that are not routed at all (any color).
+ */
+void IPv4NetworkConfigurator::RouteAggregator::calculateColorSets(int nodeIndex, int ownerColor)
+{
+    if (nodes[nodeIndex].color != -1)
+        ownerColor = nodes[nodeIndex].color;
+    if (nodes[nodeIndex].children[0] == -1 && nodes[nodeIndex].children[1] == -1)
+    {
+        // leaves are only created for original routes
+        nodes[nodeIndex].setBegin = colorSets.size();
+        nodes[nodeIndex].setLength = 1;
+        colorSets.push_back(ownerColor);
+        return;
+    }
+
+    int begins[2], lengths[2];
+    for (int bit = 0; bit < 2; bit++)
+    {
+        int childIndex = nodes[nodeIndex].children[bit];
+        if (childIndex != -1)
+        {
+            calculateColorSets(childIndex, ownerColor);
+            begins[bit] = nodes[childIndex].setBegin;
+            lengths[bit] = nodes[childIndex].setLength;
+        }
+        else if (ownerColor != -1)
+        {
+            begins[bit] = colorSets.size();
+            lengths[bit] = 1;
+            colorSets.push_back(ownerColor);
+        }
+        else
+        {
+            begins[bit] = 0;
+            lengths[bit] = -1;
+        }
+    }
+
+    TrieNode& node = nodes[nodeIndex];
+    if (lengths[0] == -1 || lengths[1] == -1)
+    {
+        node.setBegin = lengths[0] == -1 ? begins[1] : begins[0];
+        node.setLength = lengths[0] == -1 ? lengths[1] : lengths[0];
+    }
+    else
+    {
+        // the intersection of the children's sets if it is not empty, their union otherwise
+        std::vector<int>::iterator first0 = colorSets.begin() + begins[0], last0 = first0 + lengths[0];
+        std::vector<int>::iterator first1 = colorSets.begin() + begins[1], last1 = first1 + lengths[1];
+        tempSet.clear();
+        std::set_intersection(first0, last0, first1, last1, std::back_inserter(tempSet));
+        if (tempSet.empty())
+            std::set_union(first0, last0, first1, last1, std::back_inserter(tempSet));
+        if ((int)tempSet.size() == lengths[0])
+            node.setBegin = begins[0];  // the same as the first set
+        else if ((int)tempSet.size() == lengths[1])
+            node.setBegin = begins[1];
+        else
+        {
+            node.setBegin = colorSets.size();
+            colorSets.insert(colorSets.end(), tempSet.begin(), tempSet.end());
+        }
+        node.setLength = tempSet.size();
+    }
+}
+
+/**
+ * ORTC pass 3: a route is only needed where the color inherited from above is
+ * not in the set of the node. Missing children get a route of their owner's
+ * color if it differs.
+ */
+void IPv4NetworkConfigurator::RouteAggregator::selectColors(int nodeIndex, uint32 prefix, int depth, int ownerColor, int inheritedColor, std::vector<Route>& result)
+{
+    const TrieNode& node = nodes[nodeIndex];
+    if (node.setLength == -1)
+        return;  // nothing is routed in this subtree
+    if (node.color != -1)
+        ownerColor = node.color;
+    int color = inheritedColor;
+    if (!setContains(node, color))
+    {
+        color = colorSets[node.setBegin];
+        result.push_back(Route(prefix, depth == 0 ? 0 : 0xFFFFFFFF << (32 - depth), color));
+    }
+    if (node.children[0] == -1 && node.children[1] == -1)
+        return;
+    for (int bit = 0; bit < 2; bit++)
+    {
+        uint32 childPrefix = prefix | ((uint32)bit << (31 - depth));
+        if (node.children[bit] != -1)
+            selectColors(node.children[bit], childPrefix, depth + 1, ownerColor, color, result);
+        else if (ownerColor != -1 && ownerColor != color)
+            result.push_back(Route(childPrefix, 0xFFFFFFFF << (31 - depth), ownerColor));
+    }
+}
+
+void IPv4NetworkConfigurator::RouteAggregator::aggregate(const std::vector<Route>& routes, std::vector<Route>& result)
+{
+    if (routes.empty())
+    {
+        result.clear();
+        return;
+    }
+    nodes.clear();
+    colorSets.clear();
+    addNode();
+    for (int i = 0; i < (int)routes.size(); i++)
+        insert(routes[i]);
+    calculateColorSets(0, -1);
+    std::vector<Route> aggregatedRoutes;
+    selectColors(0, 0, 0, -1, -1, aggregatedRoutes);
+
+    // the result is never worse than the original routes
+    if (aggregatedRoutes.size() < routes.size())
+        result.swap(aggregatedRoutes);
+    else if (&result != &routes)
+        result = routes;
+}
@@ -21,12 +21,15 @@
 #ifndef __INET_IPV4CONFIGURATOR_H
 #define __INET_IPV4CONFIGURATOR_H
 
+#include <set>
+#include <map>
 #include <omnetpp.h>
 #include "INETDefs.h"
 #include "Topology.h"
 #include "IInterfaceTable.h"
 #include "IRoutingTable.h"
 #include "IPv4Address.h"
+#include "ConfigurationSnapshot.h"
 
 namespace inet { class PatternMatcher; }
 
@@ -172,6 +175,64 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule
                 static bool routeInfoLessThan(const RouteInfo *a, const RouteInfo *b) { return a->netmask != b->netmask ? a->netmask > b->netmask : a->destination < b->destination; }
         };
 
+        /**
+         * Aggregates the routes of a routing table with a binary prefix trie,
+         * using the ORTC (optimal routing table constructor) algorithm. Routes
+         * are represented by their destination, netmask and color (action).
+         * Addresses that are not covered by any of the original routes are
+         * treated as "don't care", so the result might route packets that the
+         * original routes did not, but any packet routed by the original routes
+         * is routed the same way by the result. Does not use any simulation
+         * object, so it can be used from worker threads.
+         */
+        class RouteAggregator
+        {
+            public:
+                struct Route {
+                    uint32 destination;
+                    uint32 netmask;
+                    int color;
+                    Route() { destination = netmask = 0; color = -1; }
+                    Route(uint32 destination, uint32 netmask, int color) { this->destination = destination; this->netmask = netmask; this->color = color; }
+                };
+
+            protected:
+                struct TrieNode {
+                    int children[2];   // indices into nodes, -1 if none
+                    int color;         // color of the original route with this prefix, -1 if none
+                    int setBegin;      // the candidate colors of the subtree in colorSets; setLength -1 means any color
+                    int setLength;
+                };
+                std::vector<TrieNode> nodes;
+                std::vector<int> colorSets;
+                std::vector<int> tempSet;
+
+                int addNode();
+                void insert(const Route& route);
+                void calculateColorSets(int nodeIndex, int ownerColor);
+                void selectColors(int nodeIndex, uint32 prefix, int depth, int ownerColor, int inheritedColor, std::vector<Route>& result);
+                bool setContains(const TrieNode& node, int color) const;
+
+            public:
+                /**
+                 * Stores the aggregated form of routes into result, which might
+                 * be the same vector. Routes must have a non-negative color, and
+                 * there must be at most one route with the same destination and
+                 * netmask.
+                 */
+                void aggregate(const std::vector<Route>& routes, std::vector<Route>& result);
+        };
+
+        /**
+         * The routes and multicast groups present before the configuration, so that
+         * the configuration snapshot stores only those added by the configurator.
+         */
+        class ConfigurationBaseline {
+            public:
+                std::set<const cObject *> routes; // unicast and multicast routes
+                std::map<const InterfaceEntry *, std::vector<IPv4Address> > multicastGroups;
+        };
+
         class Matcher
         {
             private:
@@ -203,6 +264,8 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule
         bool addDefaultRoutesParameter;
         bool optimizeRoutesParameter;
         bool assignDisjunctSubnetAddressesParameter;
+        bool allPairsShortestPathsParameter;
+        int numThreadsParameter;
 
     protected:
         virtual int numInitStages() const  { return 3; }
@@ -235,6 +298,14 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule
          */
         virtual void addStaticRoutes(IPv4Topology& topology);
 
+        /**
+         * Adds the same static routes as addStaticRoutes(), but calculates
+         * the shortest path trees of all nodes at once from a compact copy of
+         * the topology, in parallel worker threads, and aggregates the routes
+         * with RouteAggregator instead of optimizeRoutes().
+         */
+        virtual void addAllPairsStaticRoutes(IPv4Topology& topology);
+
         /**
          * Destructively optimizes the given IPv4 routes by merging some of them.
          * The resulting routes might be different in that they will route packets
@@ -244,14 +315,31 @@ class INET_API IPv4NetworkConfigurator : public cSimpleModule
          */
         virtual void optimizeRoutes(std::vector<IPv4Route *> &routes);
 
+        /**
+         * Adds everything the configuration depends on to the key of the
+         * configuration snapshot: the parameters, the XML configuration and
+         * the extracted topology including the initial interface data.
+         */
+        virtual void computeConfigurationKey(IPv4Topology& topology, ConfigurationSnapshot::Key& key);
+
+        /**
+         * Loads interface data and routes from the snapshot, if it exists,
+         * and returns true; returns false if the configuration has to be
+         * calculated.
+         */
+        virtual bool restoreConfiguration(IPv4Topology& topology, ConfigurationSnapshot& snapshot);
+        virtual void recordConfigurationBaseline(IPv4Topology& topology, ConfigurationBaseline& baseline);
+        virtual void storeConfiguration(IPv4Topology& topology, const ConfigurationBaseline& baseline, ConfigurationSnapshot& snapshot);
+
         virtual void dumpTopology(IPv4Topology& topology);
         virtual void dumpAddresses(IPv4Topology& topology);
         virtual void dumpRoutes(IPv4Topology& topology);
         virtual void dumpConfig(IPv4Topology& topology);
 
         // helper functions
+        virtual void addDefaultRoutesTowardsGateway(Node *node);
         virtual void extractWiredTopology(IPv4Topology& topology);
-        virtual void extractWiredNeighbors(Topology::LinkOut *linkOut, LinkInfo* linkInfo, std::set<InterfaceEntry *>& interfacesSeen, std::vector<Node *>& nodesVisited);
+        virtual void extractWiredNeighbors(Topology::LinkOut *linkOut, LinkInfo* linkInfo, std::set<InterfaceEntry *>& interfacesSeen, std::set<Node *>& deviceNodesVisited);
         virtual void extractWirelessTopology(IPv4Topology& topology);
         virtual InterfaceInfo *determineGatewayForLink(LinkInfo *linkInfo);
         virtual double getChannelWeight(cChannel *transmissionChannel);
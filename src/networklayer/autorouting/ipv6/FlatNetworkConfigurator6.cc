@@ -47,7 +47,22 @@ void FlatNetworkConfigurator6::initialize(int stage)
     else if (stage==3)
     {
         addOwnAdvPrefixRoutes(topo);
-        addStaticRoutes(topo);
+
+        // load the static routes from the snapshot cache if they have been calculated before
+        const char *snapshotCacheDir = par("snapshotCacheDir");
+        ConfigurationSnapshot::Key key;
+        if (*snapshotCacheDir)
+            computeConfigurationKey(topo, key);
+        ConfigurationSnapshot snapshot(snapshotCacheDir, "FlatNetworkConfigurator6", key);
+        if (!restoreStaticRoutes(topo, snapshot))
+        {
+            std::set<IPv6Route *> initialRoutes;
+            if (snapshot.isEnabled())
+                collectRoutes(topo, initialRoutes);
+            addStaticRoutes(topo);
+            if (snapshot.isEnabled())
+                storeStaticRoutes(topo, initialRoutes, snapshot);
+        }
     }
 }
 
@@ -259,3 +274,136 @@ void FlatNetworkConfigurator6::addStaticRoutes(cTopology& topo)
     setDisplayString(numIPNodes, topo.getNumNodes()-numIPNodes);
 }
 
+
+void FlatNetworkConfigurator6::computeConfigurationKey(cTopology& topo, ConfigurationSnapshot::Key& key)
+{
+    // the routes depend on the topology and on the addresses and prefixes
+    // configured in stage 2
+    key.add(topo.getNumNodes());
+    for (int i = 0; i < topo.getNumNodes(); i++)
+    {
+        cTopology::Node *node = topo.getNode(i);
+        key.add(node->getModule()->getFullPath());
+        key.add(node->getModuleId());
+        key.add(isIPNode(node));
+        if (isIPNode(node))
+        {
+            RoutingTable6 *rt = IPvXAddressResolver().routingTable6Of(node->getModule());
+            IInterfaceTable *ift = IPvXAddressResolver().interfaceTableOf(node->getModule());
+            key.add(rt->par("isRouter").boolValue());
+            key.add(ift->getNumInterfaces());
+            for (int k = 0; k < ift->getNumInterfaces(); k++)
+            {
+                InterfaceEntry *ie = ift->getInterface(k);
+                key.add(ie->getInterfaceId());
+                key.add(ie->getNodeInputGateId());
+                key.add(ie->getNodeOutputGateId());
+                key.add(ie->isLoopback());
+                key.add(ie->ipv6Data() != NULL);
+                if (!ie->ipv6Data())
+                    continue;
+                key.add(ie->ipv6Data()->getLinkLocalAddress().words(), 4 * sizeof(uint32));
+                key.add(ie->ipv6Data()->getNumAdvPrefixes());
+                for (int y = 0; y < ie->ipv6Data()->getNumAdvPrefixes(); y++)
+                {
+                    key.add(ie->ipv6Data()->getAdvPrefix(y).prefix.words(), 4 * sizeof(uint32));
+                    key.add(ie->ipv6Data()->getAdvPrefix(y).prefixLength);
+                }
+            }
+        }
+        key.add(node->getNumOutLinks());
+        for (int j = 0; j < node->getNumOutLinks(); j++)
+        {
+            cTopology::LinkOut *link = node->getLinkOut(j);
+            key.add(link->getRemoteNode()->getModuleId());
+            key.add(link->getLocalGate()->getId());
+            key.add(link->getRemoteGate()->getId());
+            key.add(link->isEnabled());
+        }
+    }
+}
+
+void FlatNetworkConfigurator6::collectRoutes(cTopology& topo, std::set<IPv6Route *>& routes)
+{
+    for (int i = 0; i < topo.getNumNodes(); i++)
+    {
+        if (!isIPNode(topo.getNode(i)))
+            continue;
+        RoutingTable6 *rt = IPvXAddressResolver().routingTable6Of(topo.getNode(i)->getModule());
+        for (int j = 0; j < rt->getNumRoutes(); j++)
+            routes.insert(rt->getRoute(j));
+    }
+}
+
+void FlatNetworkConfigurator6::storeStaticRoutes(cTopology& topo, const std::set<IPv6Route *>& initialRoutes, ConfigurationSnapshot& snapshot)
+{
+    snapshot.writeInt(topo.getNumNodes());
+    for (int i = 0; i < topo.getNumNodes(); i++)
+    {
+        cTopology::Node *node = topo.getNode(i);
+        snapshot.writeString(node->getModule()->getFullPath());
+        snapshot.writeInt(isIPNode(node));
+        if (!isIPNode(node))
+            continue;
+
+        // the routes added by addStaticRoutes(), in routing table order
+        RoutingTable6 *rt = IPvXAddressResolver().routingTable6Of(node->getModule());
+        std::vector<IPv6Route *> routes;
+        for (int j = 0; j < rt->getNumRoutes(); j++)
+            if (rt->getRoute(j)->getSrc() == IPv6Route::STATIC && !initialRoutes.count(rt->getRoute(j)))
+                routes.push_back(rt->getRoute(j));
+        snapshot.writeInt(routes.size());
+        for (int j = 0; j < (int)routes.size(); j++)
+        {
+            snapshot.write(routes[j]->getDestPrefix().words(), 4 * sizeof(uint32));
+            snapshot.writeInt(routes[j]->getPrefixLength());
+            snapshot.writeInt(routes[j]->getInterfaceId());
+            snapshot.write(routes[j]->getNextHop().words(), 4 * sizeof(uint32));
+            snapshot.writeInt(routes[j]->getMetric());
+        }
+    }
+
+    if (snapshot.save())
+        EV << "Configuration stored in " << snapshot.getFileName() << endl;
+    else
+        EV << "Cannot write configuration snapshot " << snapshot.getFileName() << ", continuing without it" << endl;
+}
+
+bool FlatNetworkConfigurator6::restoreStaticRoutes(cTopology& topo, ConfigurationSnapshot& snapshot)
+{
+    if (!snapshot.load())
+        return false;
+
+    // the key guarantees that the snapshot belongs to this network, so errors mean a corrupt cache
+    int numIPNodes = 0;
+    if (snapshot.readInt() != topo.getNumNodes())
+        error("Configuration snapshot %s does not match the network, delete it", snapshot.getFileName());
+    for (int i = 0; i < topo.getNumNodes() && !snapshot.hasReadError(); i++)
+    {
+        cTopology::Node *node = topo.getNode(i);
+        if (snapshot.readString() != node->getModule()->getFullPath() || snapshot.readInt() != isIPNode(node))
+            error("Configuration snapshot %s does not match the network, delete it", snapshot.getFileName());
+        if (!isIPNode(node))
+            continue;
+
+        numIPNodes++;
+        RoutingTable6 *rt = IPvXAddressResolver().routingTable6Of(node->getModule());
+        int numRoutes = snapshot.readInt();
+        for (int j = 0; j < numRoutes && !snapshot.hasReadError(); j++)
+        {
+            IPv6Address destPrefix, nextHop;
+            snapshot.read(destPrefix.words(), 4 * sizeof(uint32));
+            int prefixLength = snapshot.readInt();
+            int interfaceId = snapshot.readInt();
+            snapshot.read(nextHop.words(), 4 * sizeof(uint32));
+            int metric = snapshot.readInt();
+            rt->addStaticRoute(destPrefix, prefixLength, interfaceId, nextHop, metric);
+        }
+    }
+    if (snapshot.hasReadError() || !snapshot.isAtEnd())
+        error("Configuration snapshot %s is corrupt, delete it", snapshot.getFileName());
+
+    EV << "Configuration restored from " << snapshot.getFileName() << endl;
+    setDisplayString(numIPNodes, topo.getNumNodes()-numIPNodes);
+    return true;
+}
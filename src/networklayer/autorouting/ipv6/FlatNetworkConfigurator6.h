@@ -20,8 +20,13 @@
 #define __INET_FLATNETWORKCONFIGURATOR6_H
 
 
+#include <set>
+
 #include "INETDefs.h"
 
+#include "ConfigurationSnapshot.h"
+
+class IPv6Route;
 
 /**
  * Configures IPv6 addresses and routing tables for a "flat" network,
@@ -43,6 +48,12 @@ class INET_API FlatNetworkConfigurator6 : public cSimpleModule
 
     virtual void setDisplayString(int numIPNodes, int numNonIPNodes);
     virtual bool isIPNode(cTopology::Node *node);
+
+    // configuration snapshot cache
+    virtual void computeConfigurationKey(cTopology& topo, ConfigurationSnapshot::Key& key);
+    virtual void collectRoutes(cTopology& topo, std::set<IPv6Route *>& routes);
+    virtual void storeStaticRoutes(cTopology& topo, const std::set<IPv6Route *>& initialRoutes, ConfigurationSnapshot& snapshot);
+    virtual bool restoreStaticRoutes(cTopology& topo, ConfigurationSnapshot& snapshot);
 };
 
 #endif
@@ -406,11 +406,12 @@ void Established::entry()
             std::string entryn = rtEntry->getNetmask().str();
             BGPEntry->addAS(session._info.ASValue);
             session.updateSendProcess(BGPEntry);
+            delete BGPEntry;
         }
     }
 
-    std::vector<BGP::RoutingTableEntry*> BGPRoutingTable = session.getBGPRoutingTable();
-    for (std::vector<BGP::RoutingTableEntry*>::iterator it = BGPRoutingTable.begin(); it != BGPRoutingTable.end(); it++)
+    const std::vector<BGP::RoutingTableEntry*>& BGPRoutingTable = session.getBGPRoutingTable();
+    for (std::vector<BGP::RoutingTableEntry*>::const_iterator it = BGPRoutingTable.begin(); it != BGPRoutingTable.end(); it++)
     {
         session.updateSendProcess((*it));
     }
@@ -29,7 +29,7 @@ public:
     virtual BGPUpdateMessage *dup() const {return new BGPUpdateMessage(*this);}
     void setWithdrawnRoutesArraySize(unsigned int size);
     void setPathAttributeList(const BGPUpdatePathAttributeList& pathAttributeList_var);
-    void setNLRI(const BGPUpdateNLRI& NLRI_var);
+    void setNLRIArraySize(unsigned int size);
 };
 
 #endif
@@ -0,0 +1,198 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <map>
+
+#include "BGPRib.h"
+
+namespace BGP {
+
+RIB::RIB()
+{
+    breakTies = false;
+}
+
+RIB::~RIB()
+{
+    for (unsigned int i = 0; i < destinations.size(); i++)
+    {
+        for (unsigned int j = 0; j < destinations[i]->adjRibIn.size(); j++)
+            delete destinations[i]->adjRibIn[j].route;
+        delete destinations[i];
+    }
+}
+
+RIB::Destination *RIB::findDestination(const IPv4Address& prefix, int length) const
+{
+    return static_cast<Destination *>(destinationTrie.findRoute(prefix, length));
+}
+
+RIB::Destination *RIB::findDestination(const IPv4Route *route) const
+{
+    return findDestination(route->getDestination(), route->getNetmask().getNetmaskLength());
+}
+
+RIB::Destination *RIB::getOrCreateDestination(const IPv4Address& prefix, int length)
+{
+    Destination *destination = findDestination(prefix, length);
+    if (!destination)
+    {
+        IPv4Address netmask = IPv4Address::makeNetmask(length);
+        destination = new Destination();
+        destination->setDestination(prefix.doAnd(netmask));
+        destination->setNetmask(netmask);
+        destination->best = -1;
+        destination->installedRoute = NULL;
+        destination->locRibIndex = -1;
+        destinationTrie.addRoute(destination);
+        destinations.push_back(destination);
+    }
+    return destination;
+}
+
+bool RIB::isBetterRoute(const ReceivedRoute& a, const ReceivedRoute& b) const
+{
+    if (a.route->getASCount() != b.route->getASCount())
+        return a.route->getASCount() < b.route->getASCount();
+    if (a.route->getPathType() != b.route->getPathType())
+        return a.route->getPathType() < b.route->getPathType();
+    if (!breakTies)
+        return false;
+    if (a.sessionType != b.sessionType)
+        return a.sessionType == EGP;
+    return a.peerAddr < b.peerAddr;
+}
+
+void RIB::selectBestRoute(Destination *destination)
+{
+    std::vector<ReceivedRoute>& routes = destination->adjRibIn;
+    int best = routes.empty() ? -1 : 0;
+    for (int i = 1; i < (int)routes.size(); i++)
+        if (isBetterRoute(routes[i], routes[best]))
+            best = i;
+    destination->best = best;
+}
+
+bool RIB::addReceivedRoute(Destination *destination, SessionID sessionID, type sessionType,
+        const IPv4Address& peerAddr, RoutingTableEntry *route)
+{
+    RoutingTableEntry *oldLocRibRoute = destination->getLocRibRoute();
+
+    ReceivedRoute receivedRoute;
+    receivedRoute.sessionID = sessionID;
+    receivedRoute.sessionType = sessionType;
+    receivedRoute.peerAddr = peerAddr;
+    receivedRoute.route = route;
+
+    std::vector<ReceivedRoute>& routes = destination->adjRibIn;
+    int pos = 0;
+    while (pos < (int)routes.size() && routes[pos].sessionID != sessionID)
+        pos++;
+
+    if (pos == (int)routes.size())
+    {
+        // new route: it only has to be compared to the current best one
+        routes.push_back(receivedRoute);
+        if (destination->best < 0 || isBetterRoute(receivedRoute, routes[destination->best]))
+            destination->best = pos;
+    }
+    else
+    {
+        // replacement: if it replaces the best route and is worse than that,
+        // another route may be the best now
+        bool wasBest = pos == destination->best;
+        bool isWorse = isBetterRoute(routes[pos], receivedRoute);
+        delete routes[pos].route;
+        routes[pos] = receivedRoute;
+        if (wasBest && isWorse)
+            selectBestRoute(destination);
+        else if (!wasBest && isBetterRoute(receivedRoute, routes[destination->best]))
+            destination->best = pos;
+    }
+
+    RoutingTableEntry *locRibRoute = destination->getLocRibRoute();
+    if (locRibRoute == oldLocRibRoute)
+        return false;
+
+    if (destination->locRibIndex < 0)
+    {
+        destination->locRibIndex = locRib.size();
+        locRib.push_back(locRibRoute);
+    }
+    else
+        locRib[destination->locRibIndex] = locRibRoute;
+    return true;
+}
+
+void AdjRibOut::addRoute(const BGPUpdatePathAttributeList& attributes, const BGPUpdateNLRI& NLRI)
+{
+    PendingUpdate update;
+    update.attributes = attributes;
+    update.NLRI = NLRI;
+
+    const BGPASPathSegment& ASPath = attributes.getAsPath(0).getValue(0);
+    update.attributesKey.reserve(2 + ASPath.getAsValueArraySize());
+    update.attributesKey.push_back(attributes.getOrigin().getValue());
+    update.attributesKey.push_back(attributes.getNextHop().getValue().getInt());
+    for (unsigned int i = 0; i < ASPath.getAsValueArraySize(); i++)
+        update.attributesKey.push_back(ASPath.getAsValue(i));
+    updates.push_back(update);
+}
+
+void AdjRibOut::createUpdateMessages(std::vector<BGPUpdateMessage *>& messages)
+{
+    // a later advertisement of the same prefix supersedes the earlier ones
+    std::map<std::pair<uint32, int>, unsigned int> lastUpdateOfPrefix;
+    for (unsigned int i = 0; i < updates.size(); i++)
+        lastUpdateOfPrefix[std::make_pair(updates[i].NLRI.prefix.getInt(), (int)updates[i].NLRI.length)] = i;
+
+    // group the prefixes by path attributes, in the order of their first appearance
+    std::map<std::vector<unsigned long>, unsigned int> groupOfAttributes;
+    std::vector<std::vector<unsigned int> > groups;
+    for (unsigned int i = 0; i < updates.size(); i++)
+    {
+        if (lastUpdateOfPrefix[std::make_pair(updates[i].NLRI.prefix.getInt(), (int)updates[i].NLRI.length)] != i)
+            continue;
+        std::map<std::vector<unsigned long>, unsigned int>::iterator groupIt = groupOfAttributes.find(updates[i].attributesKey);
+        if (groupIt == groupOfAttributes.end())
+        {
+            groupIt = groupOfAttributes.insert(std::make_pair(updates[i].attributesKey, groups.size())).first;
+            groups.push_back(std::vector<unsigned int>());
+        }
+        groups[groupIt->second].push_back(i);
+    }
+
+    // one UPDATE message per group, or more if the prefixes do not fit into one
+    for (unsigned int g = 0; g < groups.size(); g++)
+    {
+        const std::vector<unsigned int>& group = groups[g];
+        for (unsigned int first = 0; first < group.size(); )
+        {
+            BGPUpdateMessage *updateMsg = new BGPUpdateMessage("BGPUpdate");
+            updateMsg->setPathAttributeList(updates[group[first]].attributes);
+            unsigned int maxCount = std::max(1, (int)(BGP_MAX_MESSAGE_OCTETS - updateMsg->getByteLength()) / BGP_NLRI_OCTETS);
+            unsigned int count = std::min(maxCount, (unsigned int)group.size() - first);
+            updateMsg->setNLRIArraySize(count);
+            for (unsigned int k = 0; k < count; k++)
+                updateMsg->setNLRI(k, updates[group[first + k]].NLRI);
+            first += count;
+            messages.push_back(updateMsg);
+        }
+    }
+    updates.clear();
+}
+
+} // namespace BGP
@@ -0,0 +1,193 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_BGPRIB_H
+#define __INET_BGPRIB_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "BGPCommon.h"
+#include "BGPRoutingTableEntry.h"
+#include "BGPUpdate.h"
+#include "IPv4RouteTrie.h"
+
+namespace BGP {
+
+/**
+ * The Routing Information Bases of a BGP speaker (RFC 4271, 3.2), indexed by
+ * prefix in an IPv4RouteTrie, so that finding the routes of a prefix takes
+ * at most 33 steps regardless of the table size.
+ *
+ * For every prefix (Destination) the RIB stores the Adj-RIB-In, i.e. the
+ * last route received from each session, and the Loc-RIB route selected
+ * from them. The decision process runs incrementally: when a route is
+ * received, only the routes of its prefix are compared. The Loc-RIB routes
+ * of all prefixes are also kept in a vector, for iteration and inspection.
+ *
+ * The RIB owns the received routes. The copies of Loc-RIB routes installed
+ * into the IP routing table are owned by the routing table; the RIB only
+ * records them.
+ */
+class INET_API RIB
+{
+  public:
+    /**
+     * A route received from a session: an Adj-RIB-In entry.
+     */
+    struct ReceivedRoute
+    {
+        SessionID sessionID;
+        type sessionType;            // EGP or IGP
+        IPv4Address peerAddr;
+        RoutingTableEntry *route;    // owned by the RIB
+    };
+
+    /**
+     * The routes of a prefix. The prefix is stored as the destination and
+     * netmask of the IPv4Route base class, which is only there so that the
+     * destination can be indexed by IPv4RouteTrie.
+     */
+    struct Destination : public IPv4Route
+    {
+        std::vector<ReceivedRoute> adjRibIn;    // at most one route per session
+        int best;                               // index of the Loc-RIB route in adjRibIn, or -1
+        IPv4Route *installedRoute;              // copy of the Loc-RIB route in the IP routing table, or NULL
+        int locRibIndex;                        // position in the Loc-RIB vector, or -1
+
+        RoutingTableEntry *getLocRibRoute() const {return best < 0 ? NULL : adjRibIn[best].route;}
+        const ReceivedRoute *getBestRoute() const {return best < 0 ? NULL : &adjRibIn[best];}
+    };
+
+  protected:
+    IPv4RouteTrie destinationTrie;          // index of the destinations by prefix
+    std::vector<Destination *> destinations; // all destinations, owned by the RIB
+    std::vector<RoutingTableEntry *> locRib; // the Loc-RIB routes of all destinations, in no particular order
+    bool breakTies;                          // see setBreakTies()
+
+  protected:
+    void selectBestRoute(Destination *destination);
+
+  private:
+    // copying not supported: following are private and also left undefined
+    RIB(const RIB& other);
+    RIB& operator=(const RIB& other);
+
+  public:
+    RIB();
+    ~RIB();
+
+    /**
+     * Returns the destination with the given prefix, or NULL.
+     */
+    Destination *findDestination(const IPv4Address& prefix, int length) const;
+
+    /**
+     * Returns the destination for the destination and netmask of the route, or NULL.
+     */
+    Destination *findDestination(const IPv4Route *route) const;
+
+    /**
+     * Returns the destination with the given prefix, creating it (without
+     * routes) if it does not exist yet.
+     */
+    Destination *getOrCreateDestination(const IPv4Address& prefix, int length);
+
+    /**
+     * Stores the route in the Adj-RIB-In of the destination, replacing the
+     * route previously received from the same session, and runs the decision
+     * process for the destination. Returns true if the Loc-RIB route has
+     * changed, i.e. it is now another route object. Takes ownership of the route.
+     */
+    bool addReceivedRoute(Destination *destination, SessionID sessionID, type sessionType,
+            const IPv4Address& peerAddr, RoutingTableEntry *route);
+
+    /**
+     * If set, routes with the same AS_PATH length and ORIGIN are ordered by
+     * the further tie breaking rules of isBetterRoute(). By default they
+     * are not, so the Loc-RIB route is only replaced by a strictly better
+     * route, as in the original decision process of BGPRouting.
+     */
+    void setBreakTies(bool breakTies) {this->breakTies = breakTies;}
+    bool getBreakTies() const {return breakTies;}
+
+    /**
+     * The preference order of the decision process (RFC 4271, 9.1.2.2):
+     * shorter AS_PATH, then lower ORIGIN; then, if ties are broken, routes
+     * received from EGP sessions, then lower peer address. Returns true if
+     * a is preferred to b.
+     */
+    bool isBetterRoute(const ReceivedRoute& a, const ReceivedRoute& b) const;
+
+    /**
+     * Returns the Loc-RIB routes.
+     */
+    const std::vector<RoutingTableEntry *>& getLocRib() const {return locRib;}
+
+    /**
+     * Returns the Loc-RIB routes. The vector must not be modified; the
+     * non-const version is for WATCH_PTRVECTOR.
+     */
+    std::vector<RoutingTableEntry *>& getLocRib() {return locRib;}
+
+    /**
+     * Returns the number of destinations.
+     */
+    int getNumDestinations() const {return destinations.size();}
+};
+
+/**
+ * The Adj-RIB-Out of a peer (RFC 4271, 3.2): the routes queued for
+ * advertisement to the peer. createUpdateMessages() packs them into as few
+ * UPDATE messages as possible: routes with the same path attributes go
+ * into the same message, up to the maximum message size, and of several
+ * routes queued for the same prefix only the last one is advertised.
+ */
+class INET_API AdjRibOut
+{
+  protected:
+    struct PendingUpdate
+    {
+        std::vector<unsigned long> attributesKey;  // origin, next hop and AS path, to group the routes by path attributes
+        BGPUpdatePathAttributeList attributes;
+        BGPUpdateNLRI NLRI;
+    };
+
+    std::vector<PendingUpdate> updates;
+
+  public:
+    /**
+     * Queues the prefix for advertisement with the given path attributes.
+     */
+    void addRoute(const BGPUpdatePathAttributeList& attributes, const BGPUpdateNLRI& NLRI);
+
+    /**
+     * Returns true if no routes are queued.
+     */
+    bool isEmpty() const {return updates.empty();}
+
+    /**
+     * Appends the UPDATE messages for the queued routes to the vector, in
+     * the order of the first route of each set of path attributes, and
+     * empties the queue. The caller takes ownership of the messages.
+     */
+    void createUpdateMessages(std::vector<BGPUpdateMessage *>& messages);
+};
+
+} // namespace BGP
+
+#endif
+
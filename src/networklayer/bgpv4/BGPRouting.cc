@@ -29,7 +29,6 @@ BGPRouting::~BGPRouting(void)
     {
         (*sessionIterator).second->~BGPSession();
     }
-    _BGPRoutingTable.erase(_BGPRoutingTable.begin(), _BGPRoutingTable.end());
     _prefixListIN.erase(_prefixListIN.begin(), _prefixListIN.end());
     _prefixListOUT.erase(_prefixListOUT.begin(), _prefixListOUT.end());
 }
@@ -40,12 +39,15 @@ void BGPRouting::initialize(int stage)
     {
         _rt = RoutingTableAccess().get();
         _inft = InterfaceTableAccess().get();
+        _batchUpdates = par("batchUpdates");
+        _rib.setBreakTies(par("breakTies"));
 
         // read BGP configuration
         cXMLElement *bgpConfig = par("bgpConfig").xmlValue();
         loadConfigFromXML(bgpConfig);
         createWatch("myAutonomousSystem", _myAS);
-        WATCH_PTRVECTOR(_BGPRoutingTable);
+        std::vector<BGP::RoutingTableEntry*>& BGPRoutingTable = _rib.getLocRib();
+        WATCH_PTRVECTOR(BGPRoutingTable);
     }
 }
 
@@ -63,6 +65,9 @@ void BGPRouting::handleMessage(cMessage *msg)
     {
         delete msg;
     }
+
+    // send the routes queued while processing the message
+    flushUpdates();
 }
 
 void BGPRouting::handleTimer(cMessage *timer)
@@ -252,30 +257,43 @@ void BGPRouting::processMessage(const BGPUpdateMessage& msg)
     EV << "Processing BGP Update message" << std::endl;
     _BGPSessions[_currSessionId]->getFSM()->UpdateMsgEvent();
 
-    unsigned char               decisionProcessResult;
-    IPv4Address                 netMask(IPv4Address::ALLONES_ADDRESS);
-    BGP::RoutingTableEntry*     entry = new BGP::RoutingTableEntry();
-    const unsigned char         length = msg.getNLRI().length;
-    unsigned int                ASValueCount = msg.getPathAttributeList(0).getAsPath(0).getValue(0).getAsValueArraySize();
+    if (msg.getPathAttributeListArraySize() == 0)
+        return; // withdrawn routes only, which are not processed
+
+    // the path attributes apply to all prefixes of the message
+    const BGPASPathSegment&     ASPath = msg.getPathAttributeList(0).getAsPath(0).getValue(0);
+    unsigned int                ASValueCount = ASPath.getAsValueArraySize();
 
-    entry->setDestination(msg.getNLRI().prefix);
-    netMask = IPv4Address::makeNetmask(length);
-    entry->setNetmask(netMask);
-    for (unsigned int j=0; j < ASValueCount; j++)
+    for (unsigned int i = 0; i < msg.getNLRIArraySize(); i++)
     {
-        entry->addAS(msg.getPathAttributeList(0).getAsPath(0).getValue(0).getAsValue(j));
-    }
+        unsigned char               decisionProcessResult;
+        BGP::RoutingTableEntry*     entry = new BGP::RoutingTableEntry();
+        const BGPUpdateNLRI&        NLRI = msg.getNLRI(i);
 
-    decisionProcessResult = asLoopDetection(entry, _myAS);
+        entry->setDestination(NLRI.prefix);
+        entry->setNetmask(IPv4Address::makeNetmask(NLRI.length));
+        for (unsigned int j=0; j < ASValueCount; j++)
+        {
+            entry->addAS(ASPath.getAsValue(j));
+        }
 
-    if (decisionProcessResult == BGP::ASLOOP_NO_DETECTED)
-    {
-        // RFC 4271, 9.1.  Decision Process
-        decisionProcessResult = decisionProcess(msg, entry, _currSessionId);
-        //RFC 4271, 9.2.  Update-Send Process
-        if (decisionProcessResult != 0)
+        decisionProcessResult = asLoopDetection(entry, _myAS);
+
+        if (decisionProcessResult == BGP::ASLOOP_NO_DETECTED)
         {
-            updateSendProcess(decisionProcessResult, _currSessionId, entry);
+            // RFC 4271, 9.1.  Decision Process
+            decisionProcessResult = decisionProcess(msg, entry, _currSessionId);
+            //RFC 4271, 9.2.  Update-Send Process
+            if (decisionProcessResult != 0)
+            {
+                // advertise the selected route, which is not necessarily the received one
+                const BGP::RIB::ReceivedRoute *best = _rib.findDestination(NLRI.prefix, NLRI.length)->getBestRoute();
+                updateSendProcess(decisionProcessResult, best->sessionID, best->route);
+            }
+        }
+        else
+        {
+            delete entry;
         }
     }
 }
@@ -285,6 +303,7 @@ unsigned char BGPRouting::decisionProcess(const BGPUpdateMessage& msg, BGP::Rout
     //Don't add the route if it exists in PrefixListINTable or in ASListINTable
     if (isInTable(_prefixListIN, entry) != (unsigned long)-1 || isInASList(_ASListIN, entry))
     {
+        delete entry;
         return 0;
     }
 
@@ -292,54 +311,51 @@ unsigned char BGPRouting::decisionProcess(const BGPUpdateMessage& msg, BGP::Rout
     route should be excluded from the decision process. */
     entry->setPathType(msg.getPathAttributeList(0).getOrigin().getValue());
     entry->setGateway(msg.getPathAttributeList(0).getNextHop().getValue());
+    entry->setInterface(_BGPSessions[sessionIndex]->getLinkIntf());
+
+    BGPSession* session = _BGPSessions[sessionIndex];
 
-    //if the route already exist in BGP routing table, tieBreakingProcess();
-    //(RFC 4271: 9.1.2.2 Breaking Ties)
-    unsigned long BGPindex = isInTable(_BGPRoutingTable, entry);
-    if (BGPindex != (unsigned long)-1)
+    //if the route already exist in BGP routing table, add it to the routes received for the
+    //destination, and select the best one of them (RFC 4271: 9.1.2.2 Breaking Ties)
+    BGP::RIB::Destination* destination = _rib.findDestination(entry);
+    if (destination && destination->getLocRibRoute())
     {
-        if (tieBreakingProcess(_BGPRoutingTable[BGPindex], entry))
+        if (!_rib.addReceivedRoute(destination, sessionIndex, session->getType(), session->getPeerAddr(), entry))
         {
             return 0;
         }
-        else
-        {
-            entry->setInterface(_BGPSessions[sessionIndex]->getLinkIntf());
-            _BGPRoutingTable.push_back(entry);
-            _rt->addRoute(entry);
-            return BGP::ROUTE_DESTINATION_CHANGED;
-        }
+        installLocRibRoute(destination);
+        return BGP::ROUTE_DESTINATION_CHANGED;
     }
 
     //Don't add the route if it exists in IPv4 routing table except if the msg come from IGP session
-    int indexIP = isInRoutingTable(_rt, entry->getDestination());
-    if (indexIP != -1 && _rt->getRoute(indexIP)->getSource() != IPv4Route::BGP )
+    IPv4Route* ipRoute = _rt->findBestMatchingRoute(entry->getDestination());
+    if (ipRoute && ipRoute->getSource() != IPv4Route::BGP )
     {
-        if (_BGPSessions[sessionIndex]->getType() != BGP::IGP )
+        if (session->getType() != BGP::IGP )
         {
+            delete entry;
             return 0;
         }
         else
         {
             IPv4Route* newEntry = new IPv4Route;
-            newEntry->setDestination(_rt->getRoute(indexIP)->getDestination());
-            newEntry->setNetmask(_rt->getRoute(indexIP)->getNetmask());
-            newEntry->setGateway(_rt->getRoute(indexIP)->getGateway());
-            newEntry->setInterface(_rt->getRoute(indexIP)->getInterface());
+            newEntry->setDestination(ipRoute->getDestination());
+            newEntry->setNetmask(ipRoute->getNetmask());
+            newEntry->setGateway(ipRoute->getGateway());
+            newEntry->setInterface(ipRoute->getInterface());
             newEntry->setSource(IPv4Route::BGP);
-            _rt->deleteRoute(_rt->getRoute(indexIP));
+            _rt->deleteRoute(ipRoute);
             _rt->addRoute(newEntry);
         }
     }
 
-    entry->setInterface(_BGPSessions[sessionIndex]->getLinkIntf());
-    _BGPRoutingTable.push_back(entry);
+    destination = _rib.getOrCreateDestination(entry->getDestination(), entry->getNetmask().getNetmaskLength());
+    _rib.addReceivedRoute(destination, sessionIndex, session->getType(), session->getPeerAddr(), entry);
 
-    if (_BGPSessions[sessionIndex]->getType() == BGP::EGP)
+    if (session->getType() == BGP::EGP)
     {
-        std::string entryh = entry->getDestination().str();
-        std::string entryn = entry->getNetmask().str();
-        _rt->addRoute(entry);
+        installLocRibRoute(destination);
         //insertExternalRoute on OSPF ExternalRoutingTable if OSPF exist on this BGP router
         if (ospfExist(_rt))
         {
@@ -357,30 +373,33 @@ unsigned char BGPRouting::decisionProcess(const BGPUpdateMessage& msg, BGP::Rout
     return BGP::NEW_ROUTE_ADDED;
 }
 
-bool BGPRouting::tieBreakingProcess(BGP::RoutingTableEntry* oldEntry, BGP::RoutingTableEntry* entry)
+void BGPRouting::installLocRibRoute(BGP::RIB::Destination* destination)
 {
-    /*a) Remove from consideration all routes that are not tied for
-         having the smallest number of AS numbers present in their
-         AS_PATH attributes.*/
-    if (entry->getASCount() < oldEntry->getASCount())
+    if (destination->installedRoute)
     {
-        deleteBGPRoutingEntry(oldEntry);
-        return false;
+        _rt->deleteRoute(destination->installedRoute);
     }
 
-    /* b) Remove from consideration all routes that are not tied for
-         having the lowest Origin number in their Origin attribute.*/
-    if (entry->getPathType() < oldEntry->getPathType())
+    // the IP routing table owns its routes, so it gets a copy
+    const BGP::RoutingTableEntry* locRibRoute = destination->getLocRibRoute();
+    BGP::RoutingTableEntry* route = new BGP::RoutingTableEntry(locRibRoute);
+    route->setPathType(locRibRoute->getPathType());
+    for (unsigned int i = 0; i < locRibRoute->getASCount(); i++)
     {
-        deleteBGPRoutingEntry(oldEntry);
-        return false;
+        route->addAS(locRibRoute->getAS(i));
     }
-    return true;
+    _rt->addRoute(route);
+    destination->installedRoute = route;
 }
 
 void BGPRouting::updateSendProcess(const unsigned char type, BGP::SessionID sessionIndex, BGP::RoutingTableEntry* entry)
 {
     //Don't send the update Message if the route exists in listOUTTable
+    if (isInTable(_prefixListOUT, entry) != (unsigned long)-1 || isInASList(_ASListOUT, entry))
+    {
+        return;
+    }
+
     //SESSION = EGP : send an update message to all BGP Peer (EGP && IGP)
     //if it is not the currentSession and if the session is already established
     //SESSION = IGP : send an update message to External BGP Peer (EGP) only
@@ -388,8 +407,7 @@ void BGPRouting::updateSendProcess(const unsigned char type, BGP::SessionID sess
     for (std::map<BGP::SessionID, BGPSession*>::iterator sessionIt = _BGPSessions.begin();
         sessionIt != _BGPSessions.end(); sessionIt ++)
     {
-        if (isInTable(_prefixListOUT, entry) != (unsigned long)-1 || isInASList(_ASListOUT, entry) ||
-            ((*sessionIt).first == sessionIndex && type != BGP::NEW_SESSION_ESTABLISHED ) ||
+        if (((*sessionIt).first == sessionIndex && type != BGP::NEW_SESSION_ESTABLISHED ) ||
             (type == BGP::NEW_SESSION_ESTABLISHED && (*sessionIt).first != sessionIndex ) ||
             !(*sessionIt).second->isEstablished() )
         {
@@ -401,7 +419,7 @@ void BGPRouting::updateSendProcess(const unsigned char type, BGP::SessionID sess
             type == BGP::NEW_SESSION_ESTABLISHED )
         {
             BGPUpdateNLRI                   NLRI;
-            BGPUpdatePathAttributeList  content;
+            BGPUpdatePathAttributeList      content;
 
             unsigned int nbAS = entry->getASCount();
             content.setAsPathArraySize(1);
@@ -434,11 +452,16 @@ void BGPRouting::updateSendProcess(const unsigned char type, BGP::SessionID sess
             IPv4Address netMask = entry->getNetmask();
             NLRI.prefix = entry->getDestination().doAnd(netMask);
             NLRI.length = (unsigned char) netMask.getNetmaskLength();
+            if (_batchUpdates)
+            {
+                _adjRibsOut[(*sessionIt).first].addRoute(content, NLRI);
+            }
+            else
             {
                 BGPUpdateMessage* updateMsg = new BGPUpdateMessage("BGPUpdate");
-                updateMsg->setPathAttributeListArraySize(1);
                 updateMsg->setPathAttributeList(content);
-                updateMsg->setNLRI(NLRI);
+                updateMsg->setNLRIArraySize(1);
+                updateMsg->setNLRI(0, NLRI);
                 (*sessionIt).second->getSocket()->send(updateMsg);
                 (*sessionIt).second->addUpdateMsgSent();
             }
@@ -446,6 +469,25 @@ void BGPRouting::updateSendProcess(const unsigned char type, BGP::SessionID sess
     }
 }
 
+void BGPRouting::flushUpdates()
+{
+    for (std::map<BGP::SessionID, BGP::AdjRibOut>::iterator it = _adjRibsOut.begin(); it != _adjRibsOut.end(); it++)
+    {
+        if ((*it).second.isEmpty())
+        {
+            continue;
+        }
+        BGPSession* session = _BGPSessions[(*it).first];
+        std::vector<BGPUpdateMessage*> updateMsgs;
+        (*it).second.createUpdateMessages(updateMsgs);
+        for (unsigned int i = 0; i < updateMsgs.size(); i++)
+        {
+            session->getSocket()->send(updateMsgs[i]);
+            session->addUpdateMsgSent();
+        }
+    }
+}
+
 bool BGPRouting::checkExternalRoute(const IPv4Route* route)
 {
     IPv4Address OSPFRoute;
@@ -716,9 +758,9 @@ BGP::SessionID BGPRouting::createSession(BGP::type typeSession, const char* peer
 }
 
 
-BGP::SessionID BGPRouting::findIdFromPeerAddr(std::map<BGP::SessionID, BGPSession*> sessions, IPv4Address peerAddr)
+BGP::SessionID BGPRouting::findIdFromPeerAddr(const std::map<BGP::SessionID, BGPSession*>& sessions, IPv4Address peerAddr)
 {
-    for (std::map<BGP::SessionID, BGPSession*>::iterator sessionIterator = sessions.begin();
+    for (std::map<BGP::SessionID, BGPSession*>::const_iterator sessionIterator = sessions.begin();
         sessionIterator != sessions.end(); sessionIterator ++)
     {
         if ((*sessionIterator).second->getPeerAddr().equals(peerAddr))
@@ -729,36 +771,6 @@ BGP::SessionID BGPRouting::findIdFromPeerAddr(std::map<BGP::SessionID, BGPSessio
     return -1;
 }
 
-/*delete BGP Routing entry, if the route deleted correctly return true, false else*/
-bool BGPRouting::deleteBGPRoutingEntry(BGP::RoutingTableEntry* entry){
-    for (std::vector<BGP::RoutingTableEntry*>::iterator it = _BGPRoutingTable.begin();
-         it != _BGPRoutingTable.end(); it++)
-    {
-        if (((*it)->getDestination().getInt() & (*it)->getNetmask().getInt()) ==
-            (entry->getDestination().getInt() & entry->getNetmask().getInt()))
-        {
-            _BGPRoutingTable.erase(it);
-            _rt->deleteRoute(entry);
-            return true;
-        }
-    }
-    return false;
-}
-
-/*return index of the IPv4 table if the route is found, -1 else*/
-int BGPRouting::isInRoutingTable(IRoutingTable* rtTable, IPv4Address addr)
-{
-    for (int i = 0; i < rtTable->getNumRoutes(); i++)
-    {
-        const IPv4Route* entry = rtTable->getRoute(i);
-        if (IPv4Address::maskedAddrAreEqual(addr, entry->getDestination(), entry->getNetmask()))
-        {
-            return i;
-        }
-    }
-    return -1;
-}
-
 int BGPRouting::isInInterfaceTable(IInterfaceTable* ifTable, IPv4Address addr)
 {
     for (int i = 0; i < ifTable->getNumInterfaces(); i++)
@@ -771,9 +783,9 @@ int BGPRouting::isInInterfaceTable(IInterfaceTable* ifTable, IPv4Address addr)
     return -1;
 }
 
-BGP::SessionID BGPRouting::findIdFromSocketConnId(std::map<BGP::SessionID, BGPSession*> sessions, int connId)
+BGP::SessionID BGPRouting::findIdFromSocketConnId(const std::map<BGP::SessionID, BGPSession*>& sessions, int connId)
 {
-    for (std::map<BGP::SessionID, BGPSession*>::iterator sessionIterator = sessions.begin();
+    for (std::map<BGP::SessionID, BGPSession*>::const_iterator sessionIterator = sessions.begin();
         sessionIterator != sessions.end(); sessionIterator ++)
     {
         TCPSocket* socket = (*sessionIterator).second->getSocket();
@@ -786,7 +798,7 @@ BGP::SessionID BGPRouting::findIdFromSocketConnId(std::map<BGP::SessionID, BGPSe
 }
 
 /*return index of the table if the route is found, -1 else*/
-unsigned long BGPRouting::isInTable(std::vector<BGP::RoutingTableEntry*> rtTable, BGP::RoutingTableEntry* entry)
+unsigned long BGPRouting::isInTable(const std::vector<BGP::RoutingTableEntry*>& rtTable, BGP::RoutingTableEntry* entry)
 {
     for (unsigned long i = 0; i < rtTable.size(); i++)
     {
@@ -801,9 +813,9 @@ unsigned long BGPRouting::isInTable(std::vector<BGP::RoutingTableEntry*> rtTable
 }
 
 /*return true if the AS is found, false else*/
-bool BGPRouting::isInASList(std::vector<BGP::ASID> ASList, BGP::RoutingTableEntry* entry)
+bool BGPRouting::isInASList(const std::vector<BGP::ASID>& ASList, BGP::RoutingTableEntry* entry)
 {
-    for (std::vector<BGP::ASID>::iterator it = ASList.begin(); it != ASList.end(); it++)
+    for (std::vector<BGP::ASID>::const_iterator it = ASList.begin(); it != ASList.end(); it++)
     {
         for (unsigned int i = 0; i < entry->getASCount(); i++)
         {
@@ -819,10 +831,16 @@ bool BGPRouting::isInASList(std::vector<BGP::ASID> ASList, BGP::RoutingTableEntr
 /*return true if OSPF exists, false else*/
 bool BGPRouting::ospfExist(IRoutingTable* rtTable)
 {
+    // once found, OSPF is assumed to stay, so the table is not scanned for every route
+    if (_ospfExist)
+    {
+        return true;
+    }
     for (int i=0; i<rtTable->getNumRoutes(); i++)
     {
         if (rtTable->getRoute(i)->getSource() == IPv4Route::OSPF)
         {
+            _ospfExist = true;
             return true;
         }
     }
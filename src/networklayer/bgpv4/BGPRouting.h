@@ -26,6 +26,7 @@
 #include "InterfaceTableAccess.h"
 #include "OSPFRoutingAccess.h"
 #include "BGPRoutingTableEntry.h"
+#include "BGPRib.h"
 #include "BGPCommon.h"
 #include "IPv4InterfaceData.h"
 #include "IPv4Address.h"
@@ -40,7 +41,7 @@ class INET_API BGPRouting : public cSimpleModule, public TCPSocket::CallbackInte
 {
 public:
     BGPRouting()
-        : _myAS(0), _inft(0), _rt(0) {}
+        : _myAS(0), _inft(0), _rt(0), _ospfExist(false), _batchUpdates(false) {}
 
     virtual ~BGPRouting();
 
@@ -64,7 +65,7 @@ protected:
     cMessage*       getCancelEvent(cMessage* msg)               { return cancelEvent(msg);}
     cGate*          getGate(const char* gateName)               { return gate(gateName);}
     IRoutingTable*  getIPRoutingTable()                         { return _rt;}
-    std::vector<BGP::RoutingTableEntry*> getBGPRoutingTable()   { return _BGPRoutingTable;}
+    const std::vector<BGP::RoutingTableEntry*>& getBGPRoutingTable() { return _rib.getLocRib();}
     /**
      * \brief active listenSocket for a given session (used by BGPFSM)
      */
@@ -75,8 +76,14 @@ protected:
     void openTCPConnectionToPeer(BGP::SessionID sessionID);
     /**
      * \brief RFC 4271, 9.2 : Update-Send Process / Sent or not new UPDATE messages to its peers
+     *  If batchUpdates is set, the routes are queued per peer, and sent by flushUpdates()
+     *  in as few UPDATE messages as possible.
       */
     void updateSendProcess(const unsigned char decisionProcessResult, BGP::SessionID sessionIndex, BGP::RoutingTableEntry* entry);
+    /**
+     * \brief sends the routes queued by updateSendProcess() to the peers (see BGP::AdjRibOut)
+     */
+    void flushUpdates();
     /**
      * \brief find the next SessionID compared to his type and start this session if boolean is true
      */
@@ -96,24 +103,21 @@ private:
     void processMessage(const BGPKeepAliveMessage& msg);
     void processMessage(const BGPUpdateMessage& msg);
 
-    bool deleteBGPRoutingEntry(BGP::RoutingTableEntry* entry);
     /**
      * \brief RFC 4271: 9.1. : Decision Process used when an UPDATE message is received
      *  As matches, routes are sent or not to UpdateSentProcess
      *  The result can be ROUTE_DESTINATION_CHANGED, NEW_ROUTE_ADDED or 0 if no routingTable modification
+     *  Takes ownership of the entry.
      */
     unsigned char decisionProcess(const BGPUpdateMessage& msg, BGP::RoutingTableEntry* entry, BGP::SessionID sessionIndex);
     /**
-     * \brief RFC 4271: 9.1.2.2 Breaking Ties used when BGP speaker may have several routes
-     *  to the same destination that have the same degree of preference.
-     *
-     * \return bool, true if this process changed the route, false else
+     * \brief replaces the route of the destination in the IP routing table with a copy of its Loc-RIB route
      */
-    bool tieBreakingProcess(BGP::RoutingTableEntry* oldEntry, BGP::RoutingTableEntry* entry);
+    void installLocRibRoute(BGP::RIB::Destination* destination);
 
     BGP::SessionID createSession(BGP::type typeSession, const char* peerAddr);
-    bool isInASList(std::vector<BGP::ASID> ASList, BGP::RoutingTableEntry* entry);
-    unsigned long   isInTable(std::vector<BGP::RoutingTableEntry*> rtTable, BGP::RoutingTableEntry* entry);
+    bool isInASList(const std::vector<BGP::ASID>& ASList, BGP::RoutingTableEntry* entry);
+    unsigned long   isInTable(const std::vector<BGP::RoutingTableEntry*>& rtTable, BGP::RoutingTableEntry* entry);
 
     std::vector<const char *> loadASConfig(cXMLElementList& ASConfig);
     void loadSessionConfig(cXMLElementList& sessionList, simtime_t* delayTab);
@@ -122,10 +126,9 @@ private:
     bool ospfExist(IRoutingTable* rtTable);
     void loadTimerConfig(cXMLElementList& timerConfig, simtime_t* delayTab);
     unsigned char asLoopDetection(BGP::RoutingTableEntry* entry, BGP::ASID myAS);
-    BGP::SessionID findIdFromPeerAddr(std::map<BGP::SessionID, BGPSession*> sessions, IPv4Address peerAddr);
-    int isInRoutingTable(IRoutingTable* rtTable, IPv4Address addr);
+    BGP::SessionID findIdFromPeerAddr(const std::map<BGP::SessionID, BGPSession*>& sessions, IPv4Address peerAddr);
     int isInInterfaceTable(IInterfaceTable* rtTable, IPv4Address addr);
-    BGP::SessionID findIdFromSocketConnId(std::map<BGP::SessionID, BGPSession*> sessions, int connId);
+    BGP::SessionID findIdFromSocketConnId(const std::map<BGP::SessionID, BGPSession*>& sessions, int connId);
     unsigned int calculateStartDelay(int rtListSize, unsigned char rtPosition, unsigned char rtPeerPosition);
 
     TCPSocketMap                            _socketMap;
@@ -134,13 +137,17 @@ private:
 
     IInterfaceTable*                        _inft;
     IRoutingTable*                          _rt;                // The IP routing table
-    std::vector<BGP::RoutingTableEntry*>    _BGPRoutingTable;   // The BGP routing table
+    BGP::RIB                                _rib;               // The BGP routing table: Adj-RIBs-In and Loc-RIB
+    bool                                    _ospfExist;         // set when an OSPF route has been seen in the IP routing table
+    bool                                    _batchUpdates;      // queue the advertised routes until the end of the event
     std::vector<BGP::RoutingTableEntry*>    _prefixListIN;
     std::vector<BGP::RoutingTableEntry*>    _prefixListOUT;
     std::vector<BGP::ASID>                  _ASListIN;
     std::vector<BGP::ASID>                  _ASListOUT;
     std::map<BGP::SessionID, BGPSession*>   _BGPSessions;
 
+    std::map<BGP::SessionID, BGP::AdjRibOut> _adjRibsOut;       // routes to be advertised to each peer, if _batchUpdates is set
+
     static const int  BGP_TCP_CONNECT_VALID = 71;
     static const int  BGP_TCP_CONNECT_CONFIRM = 72;
     static const int  BGP_TCP_CONNECT_FAILED = 73;
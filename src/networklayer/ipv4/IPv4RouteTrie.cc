@@ -0,0 +1,210 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+
+#include "IPv4RouteTrie.h"
+
+#include "IPv4Route.h"
+
+
+IPv4RouteTrie::IPv4RouteTrie()
+{
+    root = new Node(0, 0);
+    numNodes = 1;
+    numRoutes = 0;
+}
+
+IPv4RouteTrie::~IPv4RouteTrie()
+{
+    deleteSubtree(root);
+}
+
+int IPv4RouteTrie::getCommonPrefixLength(uint32 a, uint32 b, int maxLength)
+{
+    uint32 diff = a ^ b;
+    int length = 0;
+    while (length < maxLength && !(diff & 0x80000000u))
+    {
+        diff <<= 1;
+        length++;
+    }
+    return length;
+}
+
+bool IPv4RouteTrie::routeLessThan(const IPv4Route *a, const IPv4Route *b)
+{
+    // routes in a node share the same prefix, so only the metric
+    // needs to be compared (see RoutingTable::routeLessThan())
+    return a->getMetric() < b->getMetric();
+}
+
+void IPv4RouteTrie::attachChild(Node *parent, Node *child)
+{
+    parent->child[getBit(child->prefix, parent->length)] = child;
+    child->parent = parent;
+}
+
+IPv4RouteTrie::Node *IPv4RouteTrie::findNode(uint32 prefix, int length) const
+{
+    Node *node = root;
+    while (node && node->length < length)
+    {
+        node = node->child[getBit(prefix, node->length)];
+        if (node && (node->length > length || (prefix & makeNetmask(node->length)) != node->prefix))
+            return NULL;
+    }
+    return node;
+}
+
+IPv4RouteTrie::Node *IPv4RouteTrie::findOrCreateNode(uint32 prefix, int length)
+{
+    Node *node = root;
+    while (node->length != length)
+    {
+        // invariant: node's prefix is a proper prefix of the one we look for
+        Node *child = node->child[getBit(prefix, node->length)];
+        if (!child)
+        {
+            Node *leaf = new Node(prefix, length);
+            attachChild(node, leaf);
+            numNodes++;
+            return leaf;
+        }
+
+        int commonLength = getCommonPrefixLength(prefix, child->prefix, std::min(length, child->length));
+        if (commonLength == child->length)
+        {
+            node = child;
+            continue;
+        }
+
+        // the child's prefix diverges from ours (or is longer than ours):
+        // insert a node for the common part between node and child
+        Node *split = new Node(prefix & makeNetmask(commonLength), commonLength);
+        attachChild(node, split);
+        attachChild(split, child);
+        numNodes++;
+        if (commonLength == length)
+            return split;
+
+        Node *leaf = new Node(prefix, length);
+        attachChild(split, leaf);
+        numNodes++;
+        return leaf;
+    }
+    return node;
+}
+
+void IPv4RouteTrie::compact(Node *node)
+{
+    // remove nodes that carry no routes and are not branching points
+    while (node != root && node->routes.empty() && !(node->child[0] && node->child[1]))
+    {
+        Node *parent = node->parent;
+        Node *child = node->child[0] ? node->child[0] : node->child[1];
+        if (child)
+            attachChild(parent, child);
+        else
+            parent->child[getBit(node->prefix, parent->length)] = NULL;
+        delete node;
+        numNodes--;
+        node = parent;
+    }
+}
+
+void IPv4RouteTrie::deleteSubtree(Node *node)
+{
+    if (node)
+    {
+        deleteSubtree(node->child[0]);
+        deleteSubtree(node->child[1]);
+        delete node;
+    }
+}
+
+void IPv4RouteTrie::addRoute(IPv4Route *entry)
+{
+    int length = entry->getNetmask().getNetmaskLength();
+    uint32 prefix = entry->getDestination().getInt() & makeNetmask(length);
+    Node *node = findOrCreateNode(prefix, length);
+
+    // same ordering as in RoutingTable's route vector: metric asc, then insertion order
+    std::vector<IPv4Route *>::iterator pos = std::upper_bound(node->routes.begin(), node->routes.end(), entry, routeLessThan);
+    node->routes.insert(pos, entry);
+    routeToNode[entry] = node;
+    numRoutes++;
+}
+
+bool IPv4RouteTrie::removeRoute(IPv4Route *entry)
+{
+    RouteToNodeMap::iterator it = routeToNode.find(entry);
+    if (it == routeToNode.end())
+        return false;
+
+    Node *node = it->second;
+    routeToNode.erase(it);
+    std::vector<IPv4Route *>::iterator pos = std::find(node->routes.begin(), node->routes.end(), entry);
+    ASSERT(pos != node->routes.end());
+    node->routes.erase(pos);
+    numRoutes--;
+    compact(node);
+    return true;
+}
+
+void IPv4RouteTrie::clear()
+{
+    deleteSubtree(root->child[0]);
+    deleteSubtree(root->child[1]);
+    root->child[0] = root->child[1] = NULL;
+    root->routes.clear();
+    routeToNode.clear();
+    numNodes = 1;
+    numRoutes = 0;
+}
+
+IPv4Route *IPv4RouteTrie::findBestMatchingRoute(const IPv4Address& dest) const
+{
+    uint32 addr = dest.getInt();
+    IPv4Route *bestRoute = NULL;
+
+    // walk down along the address; every node on the path whose prefix
+    // matches is a candidate, and deeper nodes have longer prefixes
+    const Node *node = root;
+    while (node && (addr & makeNetmask(node->length)) == node->prefix)
+    {
+        for (std::vector<IPv4Route *>::const_iterator i = node->routes.begin(); i != node->routes.end(); ++i)
+        {
+            if ((*i)->isValid())
+            {
+                bestRoute = *i;
+                break;
+            }
+        }
+        if (node->length == 32)
+            break;
+        node = node->child[getBit(addr, node->length)];
+    }
+    return bestRoute;
+}
+
+IPv4Route *IPv4RouteTrie::findRoute(const IPv4Address& prefix, int length) const
+{
+    const Node *node = findNode(prefix.getInt() & makeNetmask(length), length);
+    return node && !node->routes.empty() ? node->routes.front() : NULL;
+}
+
@@ -0,0 +1,133 @@
+//
+// Copyright (C) 2013 Opensim Ltd.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IPv4ROUTETRIE_H
+#define __INET_IPv4ROUTETRIE_H
+
+#include <map>
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "IPv4Address.h"
+
+class IPv4Route;
+
+
+/**
+ * Longest prefix match lookup structure for IPv4 unicast routes, used by
+ * RoutingTable as an alternative to scanning the sorted route vector.
+ *
+ * The structure is a path-compressed binary (Patricia) trie: every node
+ * stands for a prefix, and only prefixes that carry routes or where two
+ * branches diverge are represented. A lookup therefore visits at most 33
+ * nodes regardless of the number of routes. Routes with the same prefix
+ * are stored in the same node, ordered by metric (and insertion order
+ * among equal metrics), the same way as in the route vector of
+ * RoutingTable, so both lookup methods select the same route.
+ *
+ * Routes are added and removed one by one, so the trie can be kept
+ * up to date incrementally while routing protocols modify the table.
+ * The trie does not own the routes.
+ */
+class INET_API IPv4RouteTrie
+{
+  protected:
+    struct Node
+    {
+        uint32 prefix;        // prefix bits, all bits beyond 'length' are zero
+        int length;           // prefix length, 0..32
+        Node *parent;
+        Node *child[2];       // subtrees for the next bit being 0 or 1
+        std::vector<IPv4Route *> routes; // routes with exactly this prefix, by metric asc
+
+        Node(uint32 prefix, int length) : prefix(prefix), length(length), parent(NULL) {child[0] = child[1] = NULL;}
+    };
+
+    Node *root;               // the 0.0.0.0/0 node, always present
+    int numNodes;
+    int numRoutes;
+
+    typedef std::map<const IPv4Route *, Node *> RouteToNodeMap;
+    RouteToNodeMap routeToNode; // to be able to remove routes whose prefix has changed since insertion
+
+  protected:
+    static int getBit(uint32 addr, int pos) {return (addr >> (31 - pos)) & 1;}
+    static uint32 makeNetmask(int length) {return length >= 32 ? 0xffffffffu : ~(0xffffffffu >> length);}
+    static int getCommonPrefixLength(uint32 a, uint32 b, int maxLength);
+    static bool routeLessThan(const IPv4Route *a, const IPv4Route *b);
+
+    void attachChild(Node *parent, Node *child);
+    Node *findNode(uint32 prefix, int length) const;
+    Node *findOrCreateNode(uint32 prefix, int length);
+    void compact(Node *node);
+    void deleteSubtree(Node *node);
+
+  private:
+    // copying not supported: following are private and also left undefined
+    IPv4RouteTrie(const IPv4RouteTrie& other);
+    IPv4RouteTrie& operator=(const IPv4RouteTrie& other);
+
+  public:
+    IPv4RouteTrie();
+    ~IPv4RouteTrie();
+
+    /**
+     * Inserts the route under its current destination and netmask.
+     * The netmask must be a valid netmask.
+     */
+    void addRoute(IPv4Route *entry);
+
+    /**
+     * Removes the route. The route is found by identity, so it is OK
+     * if its destination or netmask has been modified since it was added.
+     * Returns false if the route was not in the trie.
+     */
+    bool removeRoute(IPv4Route *entry);
+
+    /**
+     * Removes all routes.
+     */
+    void clear();
+
+    /**
+     * Performs longest prefix match for the given destination address.
+     * Routes whose isValid() returns false are skipped. Returns NULL
+     * if there is no matching route.
+     */
+    IPv4Route *findBestMatchingRoute(const IPv4Address& dest) const;
+
+    /**
+     * Returns the first route (in lookup order) whose prefix is exactly
+     * the given one, or NULL if there is no such route. Unlike
+     * findBestMatchingRoute(), this does not check isValid().
+     */
+    IPv4Route *findRoute(const IPv4Address& prefix, int length) const;
+
+    /**
+     * Returns the number of routes in the trie.
+     */
+    int getNumRoutes() const {return numRoutes;}
+
+    /**
+     * Returns the number of trie nodes (including the root).
+     */
+    int getNumNodes() const {return numNodes;}
+};
+
+#endif
+
@@ -28,6 +28,7 @@
 #include "InterfaceTableAccess.h"
 #include "IPv4InterfaceData.h"
 #include "IPv4Route.h"
+#include "IPv4RouteTrie.h"
 #include "NotificationBoard.h"
 #include "NotifierConsts.h"
 #include "RoutingTableParser.h"
@@ -52,6 +53,7 @@ RoutingTable::RoutingTable()
 {
     ift = NULL;
     nb = NULL;
+    routeTrie = NULL;
 }
 
 RoutingTable::~RoutingTable()
@@ -60,6 +62,7 @@ RoutingTable::~RoutingTable()
         delete routes[i];
     for (unsigned int i=0; i<multicastRoutes.size(); i++)
         delete multicastRoutes[i];
+    delete routeTrie;
 }
 
 void RoutingTable::initialize(int stage)
@@ -73,6 +76,12 @@ void RoutingTable::initialize(int stage)
         IPForward = par("IPForward").boolValue();
         multicastForward = par("forwardMulticast");
 
+        const char *routeLookup = par("routeLookup").stringValue();
+        if (!strcmp(routeLookup, "trie"))
+            routeTrie = new IPv4RouteTrie();
+        else if (strcmp(routeLookup, "linear"))
+            error("Invalid routeLookup parameter value '%s', should be 'trie' or 'linear'", routeLookup);
+
         nb->subscribe(this, NF_INTERFACE_CREATED);
         nb->subscribe(this, NF_INTERFACE_DELETED);
         nb->subscribe(this, NF_INTERFACE_STATE_CHANGED);
@@ -220,6 +229,8 @@ void RoutingTable::deleteInterfaceRoutes(InterfaceEntry *entry)
         if (route->getInterface() == entry)
         {
             it = routes.erase(it);
+            if (routeTrie)
+                routeTrie->removeRoute(route);
             ASSERT(route->getRoutingTable() == this); // still filled in, for the listeners' benefit
             nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, route);
             delete route;
@@ -269,6 +280,15 @@ void RoutingTable::invalidateCache()
     localBroadcastAddresses.clear();
 }
 
+void RoutingTable::invalidateRoutingCache(const IPv4Route *entry)
+{
+    // adding or removing a route can only change the result for destinations
+    // within its prefix, and these form a contiguous range of the cache
+    IPv4Address first = entry->getDestination().doAnd(entry->getNetmask());
+    IPv4Address last(first.getInt() | ~entry->getNetmask().getInt());
+    routingCache.erase(routingCache.lower_bound(first), routingCache.upper_bound(last));
+}
+
 void RoutingTable::printRoutingTable() const
 {
     EV << "-- Routing table --\n";
@@ -454,6 +474,8 @@ void RoutingTable::purge()
         else
         {
             it = routes.erase(it);
+            if (routeTrie)
+                routeTrie->removeRoute(route);
             ASSERT(route->getRoutingTable() == this); // still filled in, for the listeners' benefit
             nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, route);
             delete route;
@@ -498,15 +520,20 @@ IPv4Route *RoutingTable::findBestMatchingRoute(const IPv4Address& dest) const
     // find best match (one with longest prefix)
     // default route has zero prefix length, so (if exists) it'll be selected as last resort
     IPv4Route *bestRoute = NULL;
-    for (RouteVector::const_iterator i=routes.begin(); i!=routes.end(); ++i)
+    if (routeTrie)
+        bestRoute = routeTrie->findBestMatchingRoute(dest);
+    else
     {
-        IPv4Route *e = *i;
-        if (e->isValid())
+        for (RouteVector::const_iterator i=routes.begin(); i!=routes.end(); ++i)
         {
-            if (IPv4Address::maskedAddrAreEqual(dest, e->getDestination(), e->getNetmask())) // match
+            IPv4Route *e = *i;
+            if (e->isValid())
             {
-                bestRoute = const_cast<IPv4Route *>(e);
-                break;
+                if (IPv4Address::maskedAddrAreEqual(dest, e->getDestination(), e->getNetmask())) // match
+                {
+                    bestRoute = const_cast<IPv4Route *>(e);
+                    break;
+                }
             }
         }
     }
@@ -613,6 +640,8 @@ void RoutingTable::internalAddRoute(IPv4Route *entry)
     // stop at the first match when doing the longest netmask matching
     RouteVector::iterator pos = upper_bound(routes.begin(), routes.end(), entry, routeLessThan);
     routes.insert(pos, entry);
+    if (routeTrie)
+        routeTrie->addRoute(entry);
 
     entry->setRoutingTable(this);
 }
@@ -623,7 +652,7 @@ void RoutingTable::addRoute(IPv4Route *entry)
 
     internalAddRoute(entry);
 
-    invalidateCache();
+    invalidateRoutingCache(entry);
     updateDisplayString();
 
     nb->fireChangeNotification(NF_IPv4_ROUTE_ADDED, entry);
@@ -635,6 +664,8 @@ IPv4Route *RoutingTable::internalRemoveRoute(IPv4Route *entry)
     if (i!=routes.end())
     {
         routes.erase(i);
+        if (routeTrie)
+            routeTrie->removeRoute(entry);
         return entry;
     }
     return NULL;
@@ -648,7 +679,7 @@ IPv4Route *RoutingTable::removeRoute(IPv4Route *entry)
 
     if (entry != NULL)
     {
-        invalidateCache();
+        invalidateRoutingCache(entry);
         updateDisplayString();
         ASSERT(entry->getRoutingTable() == this); // still filled in, for the listeners' benefit
         nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, entry);
@@ -665,7 +696,7 @@ bool RoutingTable::deleteRoute(IPv4Route *entry)
 
     if (entry != NULL)
     {
-        invalidateCache();
+        invalidateRoutingCache(entry);
         updateDisplayString();
         ASSERT(entry->getRoutingTable() == this); // still filled in, for the listeners' benefit
         nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, entry);
@@ -796,7 +827,16 @@ void RoutingTable::routeChanged(IPv4Route *entry, int fieldCode)
         ASSERT(entry != NULL);  // failure means inconsistency: route was not found in this routing table
         internalAddRoute(entry);
 
-        invalidateCache();
+        // the old prefix is no longer known, so drop the destinations that resolved to this
+        // route as well as those covered by its new prefix
+        for (RoutingCache::iterator it = routingCache.begin(); it != routingCache.end(); )
+        {
+            if (it->second == entry)
+                routingCache.erase(it++);
+            else
+                ++it;
+        }
+        invalidateRoutingCache(entry);
         updateDisplayString();
     }
     nb->fireChangeNotification(NF_IPv4_ROUTE_CHANGED, entry); // TODO include fieldCode in the notification
@@ -827,6 +867,8 @@ void RoutingTable::updateNetmaskRoutes()
             std::vector<IPv4Route *>::iterator it = routes.begin()+(k--);  // '--' is necessary because indices shift down
             IPv4Route *route = *it;
             routes.erase(it);
+            if (routeTrie)
+                routeTrie->removeRoute(route);
             ASSERT(route->getRoutingTable() == this); // still filled in, for the listeners' benefit
             nb->fireChangeNotification(NF_IPv4_ROUTE_DELETED, route);
             delete route;
@@ -851,6 +893,8 @@ void RoutingTable::updateNetmaskRoutes()
             route->setRoutingTable(this);
             RouteVector::iterator pos = upper_bound(routes.begin(), routes.end(), route, routeLessThan);
             routes.insert(pos, route);
+            if (routeTrie)
+                routeTrie->addRoute(route);
             nb->fireChangeNotification(NF_IPv4_ROUTE_ADDED, route);
         }
     }
@@ -37,6 +37,7 @@
 #include "IRoutingTable.h"
 
 class IInterfaceTable;
+class IPv4RouteTrie;
 class NotificationBoard;
 class RoutingTableParser;
 
@@ -86,6 +87,7 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
     //
     typedef std::vector<IPv4Route *> RouteVector;
     RouteVector routes;          // Unicast route array, sorted by netmask desc, dest asc, metric asc
+    IPv4RouteTrie *routeTrie;    // longest prefix match index over routes; NULL if lookups scan the route array
 
     typedef std::vector<IPv4MulticastRoute*> MulticastRouteVector;
     MulticastRouteVector multicastRoutes; // Multicast route array, sorted by netmask desc, origin asc, metric asc
@@ -123,6 +125,9 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
     // invalidates routing cache and local addresses cache
     virtual void invalidateCache();
 
+    // invalidates the routing cache entries of destinations covered by the given route
+    virtual void invalidateRoutingCache(const IPv4Route *entry);
+
     // helper for sorting routing table, used by addRoute()
     static bool routeLessThan(const IPv4Route *a, const IPv4Route *b);
 
@@ -55,6 +55,8 @@ int NS_CLASS timer_init(struct timer *t, timeout_func_t f, void *data)
 {
     if (!t)
         return -1;
+    /* The timer may be in malloc()'ed memory */
+    t->prev = t->next = NULL;
     t->handler = f;
     t->data = data;
     t->timeout = 0;
@@ -65,20 +67,18 @@ int NS_CLASS timer_init(struct timer *t, timeout_func_t f, void *data)
 /* Called when a timer should timeout */
 void NS_CLASS timer_timeout(const simtime_t &now)
 {
+    expireTimers(now);
+}
 
-    while (!aodvTimerMap.empty())
+/* Called by expireTimers() for each expired timer */
+void NS_CLASS handleTimer(ManetTimer *timer)
+{
+    struct timer *t = static_cast<struct timer *>(timer);
+    t->used = 0;
+    /* Execute handler function for expired timer... */
+    if (t->handler)
     {
-        if (aodvTimerMap.begin()->first > now)
-            return;
-        struct timer *t = aodvTimerMap.begin()->second;
-        aodvTimerMap.erase(aodvTimerMap.begin());
-        t->used = 0;
-        /* Execute handler function for expired timer... */
-        if (t->handler)
-        {
-            (*this.*t->handler) (t->data);
-        }
-
+        (*this.*t->handler) (t->data);
     }
 }
 
@@ -101,7 +101,7 @@ NS_STATIC void NS_CLASS timer_add(struct timer *t)
         timer_remove(t);
 
     t->used = 1;
-    aodvTimerMap.insert(std::make_pair(t->timeout,t));
+    scheduleTimer(t, t->timeout);
     return;
 }
 
@@ -111,15 +111,10 @@ int NS_CLASS timer_remove(struct timer *t)
         return -1;
 
     t->used = 0;
-    for (AodvTimerMap::iterator it = aodvTimerMap.begin();it != aodvTimerMap.end();it++)
-    {
-        if (it->second == t)
-        {
-            aodvTimerMap.erase(it);
-            return 1;
-        }
-    }
-    return 0;
+    if (!t->isScheduled())
+        return 0;
+    cancelTimer(t);
+    return 1;
 }
 
 
@@ -158,9 +153,10 @@ simtime_t NS_CLASS timer_age_queue()
     simtime_t remaining;
     now = simTime();
     timer_timeout(now);
-    if (aodvTimerMap.empty())
+    ManetTimer *t = getEarliestTimer();
+    if (!t)
         return remaining;
-    remaining =  aodvTimerMap.begin()->first - now;
+    remaining =  t->getExpiry() - now;
     return remaining;
 }
 #else
@@ -38,7 +38,8 @@ typedef void (*timeout_func_t) (void *);
 #endif
 
 #ifdef AODV_USE_STL
-struct timer
+/* The timers are kept in the ManetTimerScheduler of ManetRoutingBase */
+struct timer : public ManetTimer
 {
     int used;
     simtime_t timeout;
@@ -477,6 +477,10 @@ void NS_CLASS handleMessage (cMessage *msg)
 
     if (is_init==false)
         opp_error ("Aodv has not been initialized ");
+#ifdef AODV_USE_STL
+    if (handleTimerMessage(msg))
+        return;
+#endif
     if (msg==sendMessageEvent)
     {
         // timer event
@@ -716,12 +720,19 @@ IPv4Datagram *NS_CLASS pkt_decapsulate(IPv4Datagram *p)
 #ifdef AODV_USE_STL
 void NS_CLASS scheduleNextEvent()
 {
+    if (usesTimerWheel())
+    {
+        processTimers();
+        return;
+    }
+
     simtime_t timer;
-    simtime_t timeout = timer_age_queue();
+    timer_age_queue();
 
-    if (!aodvTimerMap.empty())
+    ManetTimer *t = getEarliestTimer();
+    if (t)
     {
-        timer = aodvTimerMap.begin()->first;
+        timer = t->getExpiry();
         if (sendMessageEvent->isScheduled())
         {
             if (timer < sendMessageEvent->getArrivalTime())
@@ -1050,6 +1061,7 @@ void NS_CLASS finish()
     recordScalar("rrep ack rec", totalRrepAckRec);
     recordScalar("rerr send", totalRerrSend);
     recordScalar("rerr rec", totalRerrRec);
+    ManetRoutingBase::finish();
 }
 
 
@@ -135,8 +135,6 @@ class AODVUU : public ManetRoutingBase
         return false;
     }
     // cMessage  messageEvent;
-    typedef std::multimap<simtime_t, struct timer*> AodvTimerMap;
-    AodvTimerMap aodvTimerMap;
     typedef std::map<ManetAddress, struct rt_table*> AodvRtTableMap;
     AodvRtTableMap aodvRtTableMap;
 
@@ -176,7 +174,9 @@ class AODVUU : public ManetRoutingBase
     int numInitStages() const  {return 5;}
     void initialize(int stage);
 
-
+#ifdef AODV_USE_STL
+    virtual void handleTimer(ManetTimer *timer);
+#endif
     cMessage * sendMessageEvent;
 
     void recvAODVUUPacket(cMessage * p);
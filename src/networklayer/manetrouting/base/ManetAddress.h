@@ -104,6 +104,16 @@ class ManetAddress
      */
     bool isUnspecified() const;
 
+    /**
+     * Returns a hash value of the address, for hash tables.
+     */
+    uint32_t hash() const
+    {
+        uint32_t h = (uint32_t)hi ^ (uint32_t)(hi >> 32) ^ ((uint32_t)lo * 31) ^ ((uint32_t)(lo >> 32) * 961) ^ addrType;
+        h *= 2654435761u;
+        return h ^ (h >> 16);
+    }
+
   protected:
     /// helper functions
     IPv4Address _getIPv4() const { return IPv4Address(hi); }
@@ -44,7 +44,7 @@ ManetRoutingBase::GlobalRouteMap *ManetRoutingBase::globalRouteMap = NULL;
 bool ManetRoutingBase::createInternalStore = false;
 
 
-ManetRoutingBase::ManetRoutingBase()
+ManetRoutingBase::ManetRoutingBase() : timerScheduler(this)
 {
 #ifdef WITH_80211MESH
     locator = NULL;
@@ -62,7 +62,6 @@ ManetRoutingBase::ManetRoutingBase()
     proxyAddress.clear();
     addressGroupVector.clear();
     inAddressGroup.clear();
-
 }
 
 
@@ -101,6 +100,7 @@ void ManetRoutingBase::registerRoutingModule()
     cProperties *props = getParentModule()->getProperties();
     mac_layer_ = props && props->getAsBool("macRouting");
     usetManetLabelRouting = par("usetManetLabelRouting");
+    timerScheduler.setUseWheel(par("useTimerWheel"));
 
     const char *interfaces = par("interfaces");
     cStringTokenizer tokenizerInterfaces(interfaces);
@@ -1040,6 +1040,26 @@ int ManetRoutingBase::gettimeofday(struct timeval *tv, struct timezone *tz)
     return 0;
 }
 
+void ManetRoutingBase::expireTimers(simtime_t limit)
+{
+    ManetTimer *timer;
+    while ((timer = timerScheduler.removeExpired(limit)) != NULL)
+        handleTimer(timer);
+}
+
+bool ManetRoutingBase::handleTimerMessage(cMessage *msg)
+{
+    if (!timerScheduler.isTimerMessage(msg))
+        return false;
+    processTimers();
+    return true;
+}
+
+void ManetRoutingBase::finish()
+{
+    timerScheduler.recordScalars();
+}
+
 //
 // Get the index of interface with the same address that add
 //
@@ -33,6 +33,7 @@
 #include "IInterfaceTable.h"
 #include "IPvXAddress.h"
 #include "ManetAddress.h"
+#include "ManetTimerScheduler.h"
 #include "NotifierConsts.h"
 #include "ICMP.h"
 
@@ -123,6 +124,8 @@ class INET_API ManetRoutingBase : public cSimpleModule, public INotifiable, prot
 
     std::vector<ManetProxyAddress> proxyAddress;
 
+    ManetTimerScheduler timerScheduler;
+
 #ifdef WITH_80211MESH
     ILocator *locator;
 #endif
@@ -233,6 +236,49 @@ class INET_API ManetRoutingBase : public cSimpleModule, public INotifiable, prot
      */
     virtual int gettimeofday(struct timeval *, struct timezone *);
 
+    /**
+     *  @name Protocol timers
+     *  The timers of the protocol are kept in a ManetTimerScheduler. By
+     *  default, the protocol drives them with its own self-message. If the
+     *  useTimerWheel parameter is set, they are kept in a timer wheel, and
+     *  they are driven by a single self-message, which is scheduled at the
+     *  earliest expiry by scheduleTimerMessage(). The protocol passes this
+     *  message to handleTimerMessage(), which calls handleTimer() for the
+     *  expired timers.
+     */
+    //@{
+    /// Schedules (or reschedules) the timer; the self-message is updated by scheduleTimerMessage()
+    void scheduleTimer(ManetTimer *timer, simtime_t expiry) {timerScheduler.schedule(timer, expiry);}
+    void cancelTimer(ManetTimer *timer) {timerScheduler.cancel(timer);}
+
+    /// Returns the timer that expires first, or NULL if no timer is scheduled
+    ManetTimer *getEarliestTimer() {return timerScheduler.getEarliest();}
+
+    /// Removes and returns the timer that expires first, or NULL if no timer is scheduled
+    ManetTimer *removeEarliestTimer() {return timerScheduler.removeEarliest();}
+
+    /// Returns true if the timers are driven by the self-message of the timer wheel
+    bool usesTimerWheel() const {return timerScheduler.getUseWheel();}
+
+    /// Calls handleTimer() for the timers expiring at or before limit, in order of expiry
+    virtual void expireTimers(simtime_t limit);
+
+    /// Schedules the self-message at the earliest expiry (or now, if it is in the past); only with the timer wheel
+    virtual void scheduleTimerMessage() {timerScheduler.scheduleTimerMessage();}
+
+    /// Expires the timers due now, and reschedules the self-message
+    virtual void processTimers() {expireTimers(simTime()); scheduleTimerMessage();}
+
+    /// Returns false if msg is not the self-message of the timers, otherwise calls processTimers()
+    virtual bool handleTimerMessage(cMessage *msg);
+
+    /// Called for each expired timer; the timer is not scheduled any more
+    virtual void handleTimer(ManetTimer *timer) {opp_error("handleTimer, method is not implemented");}
+    //@}
+
+    /// Records the statistics of the timer wheel
+    virtual void finish();
+
     /// Get the address of the first wlan interface
     virtual ManetAddress getAddress() const {return hostAddress;}
 
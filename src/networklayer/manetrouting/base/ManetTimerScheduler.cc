@@ -0,0 +1,174 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "ManetTimerScheduler.h"
+
+
+ManetTimerScheduler::ManetTimerScheduler(cSimpleModule *module)
+{
+    this->module = module;
+    useWheel = false;
+    timerMessage = NULL;
+    numScheduled = numCancelled = numExpired = 0;
+    maxPending = 0;
+    numSelfMessageEvents = 0;
+}
+
+ManetTimerScheduler::~ManetTimerScheduler()
+{
+    if (timerMessage)
+        module->cancelAndDelete(timerMessage);
+}
+
+void ManetTimerScheduler::setUseWheel(bool useWheel)
+{
+    ASSERT(isEmpty());
+    this->useWheel = useWheel;
+}
+
+void ManetTimerScheduler::schedule(ManetTimer *timer, simtime_t expiry)
+{
+    // a rescheduled timer is not counted as cancelled, as in the wheel
+    if (useWheel)
+        wheel.schedule(timer, expiry);
+    else
+    {
+        if (timer->isScheduled())
+            removeFromMap(timer);
+        timer->expiry = expiry;
+        // a timer in the multimap links to itself, so that isScheduled() is true
+        timer->prev = timer->next = timer;
+        timerMap.insert(std::make_pair(expiry, timer));
+    }
+    numScheduled++;
+    if (getNumPending() > maxPending)
+        maxPending = getNumPending();
+}
+
+void ManetTimerScheduler::cancel(ManetTimer *timer)
+{
+    if (!timer->isScheduled())
+        return;
+    numCancelled++;
+    if (useWheel)
+        wheel.cancel(timer);
+    else
+        removeFromMap(timer);
+}
+
+void ManetTimerScheduler::removeFromMap(ManetTimer *timer)
+{
+    std::pair<TimerMap::iterator, TimerMap::iterator> range = timerMap.equal_range(timer->expiry);
+    for (TimerMap::iterator it = range.first; it != range.second; ++it)
+    {
+        if (it->second == timer)
+        {
+            timerMap.erase(it);
+            break;
+        }
+    }
+    timer->prev = timer->next = NULL;
+}
+
+ManetTimer *ManetTimerScheduler::getEarliest()
+{
+    if (useWheel)
+        return wheel.getEarliest();
+    return timerMap.empty() ? NULL : timerMap.begin()->second;
+}
+
+ManetTimer *ManetTimerScheduler::removeEarliest()
+{
+    ManetTimer *timer;
+    if (useWheel)
+        timer = wheel.removeEarliest();
+    else
+    {
+        if (timerMap.empty())
+            return NULL;
+        timer = timerMap.begin()->second;
+        timerMap.erase(timerMap.begin());
+        timer->prev = timer->next = NULL;
+    }
+    // the protocols driving the multimap remove the expired timers with this
+    if (timer && timer->getExpiry() <= simulation.getSimTime())
+        numExpired++;
+    return timer;
+}
+
+ManetTimer *ManetTimerScheduler::removeExpired(simtime_t limit)
+{
+    ManetTimer *timer;
+    if (useWheel)
+        timer = wheel.removeExpired(limit);
+    else
+    {
+        if (timerMap.empty() || timerMap.begin()->first > limit)
+            return NULL;
+        timer = timerMap.begin()->second;
+        timerMap.erase(timerMap.begin());
+        timer->prev = timer->next = NULL;
+    }
+    if (timer)
+        numExpired++;
+    return timer;
+}
+
+void ManetTimerScheduler::scheduleTimerMessage()
+{
+    ASSERT(useWheel);
+    ManetTimer *timer = wheel.getEarliest();
+    if (!timer)
+    {
+        if (timerMessage && timerMessage->isScheduled())
+            module->cancelEvent(timerMessage);
+        return;
+    }
+    simtime_t now = simulation.getSimTime();
+    simtime_t expiry = timer->getExpiry() < now ? now : timer->getExpiry();
+    if (!timerMessage)
+        timerMessage = new cMessage("ManetTimers");
+    if (timerMessage->isScheduled())
+    {
+        if (timerMessage->getArrivalTime() == expiry)
+            return;
+        module->cancelEvent(timerMessage);
+    }
+    module->scheduleAt(expiry, timerMessage);
+}
+
+bool ManetTimerScheduler::isTimerMessage(cMessage *msg)
+{
+    // with the multimap, the self-messages of the protocol drive the timers
+    if (msg->isSelfMessage())
+        numSelfMessageEvents++;
+    return timerMessage && msg == timerMessage;
+}
+
+void ManetTimerScheduler::recordScalars()
+{
+    // nothing to record if the protocol does not use the timers
+    if (numScheduled == 0)
+        return;
+    module->recordScalar("timers scheduled", numScheduled);
+    module->recordScalar("timers cancelled", numCancelled);
+    module->recordScalar("timers expired", numExpired);
+    // the FES size the timers would need with a message for each of them
+    module->recordScalar("max pending timers", maxPending);
+    module->recordScalar("self-message events", numSelfMessageEvents);
+    simtime_t now = simulation.getSimTime();
+    if (now > 0)
+        module->recordScalar("self-message event rate", numSelfMessageEvents / SIMTIME_DBL(now));
+}
@@ -0,0 +1,113 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_MANETTIMERSCHEDULER_H
+#define __INET_MANETTIMERSCHEDULER_H
+
+#include <map>
+
+#include "INETDefs.h"
+
+#include "ManetTimerWheel.h"
+
+
+/**
+ * The timers of a MANET routing protocol module.
+ *
+ * By default the timers are kept in a multimap keyed by the expiry, and
+ * the module drives them with its own self-message(s), as the protocols
+ * always did. If the timer wheel is enabled (useTimerWheel parameter of
+ * the protocol), they are kept in a ManetTimerWheel instead, and they are
+ * driven by a single self-message, which scheduleTimerMessage() keeps at
+ * the earliest expiry. The statistics of the timers and the number of
+ * self-message events are kept with both, and recordScalars() records
+ * them as the same scalars, so that the two can be compared.
+ *
+ * The timers expire in the same order with both: in order of expiry, and
+ * the ones with equal expiries in the order they were scheduled.
+ */
+class INET_API ManetTimerScheduler
+{
+  protected:
+    typedef std::multimap<simtime_t, ManetTimer *> TimerMap;
+
+    cSimpleModule *module;
+    bool useWheel;
+    ManetTimerWheel wheel;
+    TimerMap timerMap;          // used if useWheel is false
+    cMessage *timerMessage;     // created on demand if useWheel is true
+
+    // statistics
+    long numScheduled;
+    long numCancelled;
+    long numExpired;
+    int maxPending;
+    long numSelfMessageEvents;
+
+  protected:
+    void removeFromMap(ManetTimer *timer);
+
+  private:
+    // not copyable: the timers point into the wheel
+    ManetTimerScheduler(const ManetTimerScheduler&);
+    ManetTimerScheduler& operator=(const ManetTimerScheduler&);
+
+  public:
+    ManetTimerScheduler(cSimpleModule *module);
+    ~ManetTimerScheduler();
+
+    /**
+     * Selects the timer wheel or the multimap; there must be no scheduled
+     * timers.
+     */
+    void setUseWheel(bool useWheel);
+    bool getUseWheel() const {return useWheel;}
+
+    /** @name Timers */
+    //@{
+    /// Schedules (or reschedules) the timer
+    void schedule(ManetTimer *timer, simtime_t expiry);
+
+    /// Cancels the timer; does nothing if it is not scheduled
+    void cancel(ManetTimer *timer);
+
+    /// Returns the timer that expires first, or NULL if no timer is scheduled
+    ManetTimer *getEarliest();
+
+    /// Removes and returns the timer that expires first, or NULL if no timer is scheduled
+    ManetTimer *removeEarliest();
+
+    /// Removes and returns the timer that expires first if it expires at or before limit, otherwise returns NULL
+    ManetTimer *removeExpired(simtime_t limit);
+
+    bool isEmpty() const {return useWheel ? wheel.isEmpty() : timerMap.empty();}
+
+    int getNumPending() const {return useWheel ? wheel.getNumPending() : timerMap.size();}
+    //@}
+
+    /** @name Self-message of the timer wheel */
+    //@{
+    /// Schedules the self-message at the earliest expiry (or now, if it is in the past), or cancels it if there are no timers
+    void scheduleTimerMessage();
+
+    /// Returns true if msg is the self-message; counts the self-message events of the module with both the wheel and the multimap
+    bool isTimerMessage(cMessage *msg);
+
+    /// Records the statistics of the timers; does nothing if no timer was scheduled
+    void recordScalars();
+    //@}
+};
+
+#endif
@@ -0,0 +1,243 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "ManetTimerWheel.h"
+
+
+static inline void detach(ManetTimerLink *link)
+{
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+}
+
+ManetTimerWheel::ManetTimerWheel(simtime_t resolution)
+{
+    this->resolution = resolution.raw() > 0 ? resolution.raw() : 1;
+    currentTick = 0;
+    initList(&due);
+    for (int level = 0; level < NUM_LEVELS; level++)
+    {
+        for (int i = 0; i < NUM_SLOTS; i++)
+            initList(&slots[level][i]);
+        levelSizes[level] = 0;
+    }
+    initList(&overflow);
+    numPending = 0;
+    nextSeq = 0;
+    earliest = NULL;
+    earliestValid = true;
+    numScheduled = numCancelled = numExpired = 0;
+    maxPending = 0;
+}
+
+void ManetTimerWheel::append(ManetTimerLink *list, ManetTimerLink *link)
+{
+    link->prev = list->prev;
+    link->next = list;
+    list->prev->next = link;
+    list->prev = link;
+}
+
+ManetTimer *ManetTimerWheel::findEarliest(const ManetTimerLink *list)
+{
+    ManetTimer *result = NULL;
+    for (ManetTimerLink *link = list->next; link != list; link = link->next)
+    {
+        ManetTimer *timer = static_cast<ManetTimer *>(link);
+        if (!result || isBefore(timer, result))
+            result = timer;
+    }
+    return result;
+}
+
+void ManetTimerWheel::unlink(ManetTimer *timer)
+{
+    detach(timer);
+    if (timer->level >= 0 && timer->level < NUM_LEVELS)
+        levelSizes[timer->level]--;
+    timer->prev = timer->next = NULL;
+    numPending--;
+    if (timer == earliest)
+        earliestValid = false;
+}
+
+void ManetTimerWheel::insertDue(ManetTimer *timer)
+{
+    // timers are mostly scheduled in increasing order of expiry, so search from the end
+    ManetTimerLink *pos = due.prev;
+    while (pos != &due && isBefore(timer, static_cast<ManetTimer *>(pos)))
+        pos = pos->prev;
+    timer->prev = pos;
+    timer->next = pos->next;
+    pos->next->prev = timer;
+    pos->next = timer;
+    timer->level = LEVEL_DUE;
+}
+
+void ManetTimerWheel::place(ManetTimer *timer)
+{
+    int64 tick = getTick(timer->expiry);
+    if (tick <= currentTick)
+    {
+        insertDue(timer);
+        return;
+    }
+    // the level is given by the highest digit in which the tick differs from the current one
+    uint64 diff = (uint64)(tick ^ currentTick);
+    int level = 0;
+    while (level < NUM_LEVELS && (diff >> (SLOT_BITS * (level + 1))) != 0)
+        level++;
+    if (level == NUM_LEVELS)
+    {
+        append(&overflow, timer);
+        timer->level = LEVEL_OVERFLOW;
+    }
+    else
+    {
+        append(&slots[level][(tick >> (SLOT_BITS * level)) & (NUM_SLOTS - 1)], timer);
+        timer->level = level;
+        levelSizes[level]++;
+    }
+}
+
+void ManetTimerWheel::moveToDue(ManetTimerLink *list)
+{
+    while (!isEmptyList(list))
+    {
+        ManetTimer *timer = static_cast<ManetTimer *>(list->next);
+        detach(timer);
+        if (timer->level >= 0 && timer->level < NUM_LEVELS)
+            levelSizes[timer->level]--;
+        insertDue(timer);
+    }
+}
+
+void ManetTimerWheel::advance(int64 tick)
+{
+    // all timers in the levels below the highest differing digit are before the new tick
+    uint64 diff = (uint64)(tick ^ currentTick);
+    int level = 0;
+    while (level < NUM_LEVELS && (diff >> (SLOT_BITS * (level + 1))) != 0)
+        level++;
+    for (int k = 0; k < level; k++)
+        if (levelSizes[k] > 0)
+            for (int i = 0; i < NUM_SLOTS; i++)
+                moveToDue(&slots[k][i]);
+
+    // in that level, the slots before the one of the new tick are before it too,
+    // and the slot of the new tick must be redistributed
+    ManetTimerLink *list;
+    if (level < NUM_LEVELS)
+    {
+        int shift = SLOT_BITS * level;
+        int from = (int)((currentTick >> shift) & (NUM_SLOTS - 1));
+        int to = (int)((tick >> shift) & (NUM_SLOTS - 1));
+        if (levelSizes[level] > 0)
+            for (int i = from + 1; i < to; i++)
+                moveToDue(&slots[level][i]);
+        list = &slots[level][to];
+    }
+    else
+        list = &overflow;
+
+    ManetTimerLink redistributed;
+    initList(&redistributed);
+    while (!isEmptyList(list))
+    {
+        ManetTimer *timer = static_cast<ManetTimer *>(list->next);
+        detach(timer);
+        if (timer->level >= 0 && timer->level < NUM_LEVELS)
+            levelSizes[timer->level]--;
+        append(&redistributed, timer);
+    }
+    currentTick = tick;
+    while (!isEmptyList(&redistributed))
+    {
+        ManetTimer *timer = static_cast<ManetTimer *>(redistributed.next);
+        detach(timer);
+        place(timer);
+    }
+}
+
+void ManetTimerWheel::schedule(ManetTimer *timer, simtime_t expiry)
+{
+    if (timer->isScheduled())
+        unlink(timer);
+    timer->expiry = expiry;
+    timer->seq = nextSeq++;
+    place(timer);
+    numPending++;
+    numScheduled++;
+    if (numPending > maxPending)
+        maxPending = numPending;
+    if (earliestValid && (!earliest || isBefore(timer, earliest)))
+        earliest = timer;
+}
+
+void ManetTimerWheel::cancel(ManetTimer *timer)
+{
+    if (!timer->isScheduled())
+        return;
+    unlink(timer);
+    numCancelled++;
+}
+
+ManetTimer *ManetTimerWheel::getEarliest()
+{
+    if (earliestValid)
+        return earliest;
+
+    // the due list is sorted; the timers of a level are after those of the
+    // lower levels, and its slots after the current one are in increasing order
+    earliest = NULL;
+    if (!isEmptyList(&due))
+        earliest = static_cast<ManetTimer *>(due.next);
+    for (int level = 0; level < NUM_LEVELS && !earliest; level++)
+    {
+        if (levelSizes[level] == 0)
+            continue;
+        int from = (int)((currentTick >> (SLOT_BITS * level)) & (NUM_SLOTS - 1));
+        for (int i = from + 1; i < NUM_SLOTS && !earliest; i++)
+            earliest = findEarliest(&slots[level][i]);
+    }
+    if (!earliest)
+        earliest = findEarliest(&overflow);
+    earliestValid = true;
+    return earliest;
+}
+
+ManetTimer *ManetTimerWheel::removeExpired(simtime_t limit)
+{
+    int64 tick = getTick(limit);
+    if (tick > currentTick)
+        advance(tick);
+    // the timers in the wheel are after the current tick, so after limit
+    if (isEmptyList(&due))
+        return NULL;
+    ManetTimer *timer = static_cast<ManetTimer *>(due.next);
+    if (timer->expiry > limit)
+        return NULL;
+    unlink(timer);
+    numExpired++;
+    return timer;
+}
+
+ManetTimer *ManetTimerWheel::removeEarliest()
+{
+    ManetTimer *timer = getEarliest();
+    if (timer)
+        unlink(timer);
+    return timer;
+}
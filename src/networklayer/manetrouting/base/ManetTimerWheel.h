@@ -0,0 +1,168 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_MANETTIMERWHEEL_H
+#define __INET_MANETTIMERWHEEL_H
+
+#include "INETDefs.h"
+
+
+/**
+ * Link of a timer in the (circular, doubly linked) lists of ManetTimerWheel.
+ */
+struct ManetTimerLink
+{
+    ManetTimerLink *prev;
+    ManetTimerLink *next;
+};
+
+/**
+ * A timer of a MANET routing protocol, stored in a ManetTimerWheel.
+ * It has no virtual functions, so that it can be embedded into the C
+ * structures of the ported protocols, which are allocated with malloc()
+ * and cleared with memset(): a zero-filled ManetTimer is not scheduled.
+ * The protocol recognizes its timers by their address, typically by
+ * deriving its own timer type from ManetTimer.
+ *
+ * A copy of a timer is not scheduled.
+ */
+struct INET_API ManetTimer : public ManetTimerLink
+{
+    simtime_t expiry;   ///< valid while the timer is scheduled
+    uint64 seq;         ///< insertion order, timers with the same expiry expire in this order
+    int level;          ///< the list of the wheel the timer is in
+
+    ManetTimer() { prev = next = NULL; seq = 0; level = 0; }
+    ManetTimer(const ManetTimer&) : ManetTimerLink() { prev = next = NULL; seq = 0; level = 0; }
+    ManetTimer& operator=(const ManetTimer&) { return *this; }
+
+    bool isScheduled() const { return next != NULL; }
+    const simtime_t& getExpiry() const { return expiry; }
+};
+
+/**
+ * Hierarchical timing wheel for the timers of a MANET routing protocol.
+ * Scheduling and cancelling a timer are O(1), which makes it possible to
+ * drive all timers of a protocol instance (that may be thousands of route
+ * lifetimes, blacklists, etc.) with a single self-message.
+ *
+ * Time is divided into ticks of the given resolution. Level k of the wheel
+ * has NUM_SLOTS slots, each covering NUM_SLOTS^k ticks, and holds the timers
+ * whose ticks differ from the current tick first in the k-th digit (in base
+ * NUM_SLOTS); the timers beyond the range of the top level are kept in an
+ * overflow list. When the current tick advances, the slot it enters is
+ * redistributed into the lower levels. The timers of the current (and past)
+ * ticks are kept in a list sorted by expiry, so the timers expire at
+ * their exact expiry times, and in the same order as if they were in a
+ * multimap keyed by the expiry: the ones with equal expiries in the order
+ * they were scheduled.
+ */
+class INET_API ManetTimerWheel
+{
+  public:
+    enum { SLOT_BITS = 6, NUM_SLOTS = 1 << SLOT_BITS, NUM_LEVELS = 5 };
+
+  protected:
+    enum { LEVEL_DUE = -1, LEVEL_OVERFLOW = NUM_LEVELS };
+
+    int64 resolution;           // length of a tick in raw simtime units
+    int64 currentTick;          // the timers of ticks up to this one are in the due list
+    ManetTimerLink due;         // sorted by (expiry, seq)
+    ManetTimerLink slots[NUM_LEVELS][NUM_SLOTS];
+    ManetTimerLink overflow;
+    int levelSizes[NUM_LEVELS];
+    int numPending;
+    uint64 nextSeq;
+    ManetTimer *earliest;       // cached result of getEarliest()
+    bool earliestValid;
+
+    // statistics
+    long numScheduled;
+    long numCancelled;
+    long numExpired;
+    int maxPending;
+
+  private:
+    // not copyable: the timers point into the lists
+    ManetTimerWheel(const ManetTimerWheel&);
+    ManetTimerWheel& operator=(const ManetTimerWheel&);
+
+  protected:
+    static bool isEmptyList(const ManetTimerLink *list) { return list->next == list; }
+    static void initList(ManetTimerLink *list) { list->prev = list->next = list; }
+    static void append(ManetTimerLink *list, ManetTimerLink *link);
+    static bool isBefore(const ManetTimer *a, const ManetTimer *b)
+    {
+        return a->expiry < b->expiry || (a->expiry == b->expiry && a->seq < b->seq);
+    }
+    static ManetTimer *findEarliest(const ManetTimerLink *list);
+
+    int64 getTick(const simtime_t& t) const { return t.raw() / resolution; }
+    void unlink(ManetTimer *timer);
+    void insertDue(ManetTimer *timer);
+    void place(ManetTimer *timer);
+    void moveToDue(ManetTimerLink *list);
+    void advance(int64 tick);
+
+  public:
+    /**
+     * The resolution only affects the efficiency, timers expire at their
+     * exact expiry times.
+     */
+    ManetTimerWheel(simtime_t resolution = 0.001);
+
+    /**
+     * Schedules the timer to expire at the given time; a scheduled timer
+     * is rescheduled.
+     */
+    void schedule(ManetTimer *timer, simtime_t expiry);
+
+    /**
+     * Cancels the timer; does nothing if it is not scheduled.
+     */
+    void cancel(ManetTimer *timer);
+
+    /**
+     * Returns the timer that expires first, or NULL if there are no
+     * scheduled timers.
+     */
+    ManetTimer *getEarliest();
+
+    /**
+     * Removes and returns the timer that expires first, if it expires at
+     * or before limit; returns NULL otherwise. Expired timers are returned
+     * in the order of their expiry.
+     */
+    ManetTimer *removeExpired(simtime_t limit);
+
+    /**
+     * Removes and returns the timer that expires first, or returns NULL
+     * if there are no scheduled timers.
+     */
+    ManetTimer *removeEarliest();
+
+    int getNumPending() const { return numPending; }
+    bool isEmpty() const { return numPending == 0; }
+
+    /** @name Statistics */
+    //@{
+    long getNumScheduled() const { return numScheduled; }
+    long getNumCancelled() const { return numCancelled; }
+    long getNumExpired() const { return numExpired; }
+    int getMaxPending() const { return maxPending; }
+    //@}
+};
+
+#endif
@@ -250,7 +250,13 @@ void Batman::initialize(int stage)
 
     simtime_t curr_time = simTime();
     simtime_t select_timeout = forw_list[0]->send_time > curr_time ? forw_list[0]->send_time : curr_time+10;
-    scheduleAt(select_timeout, timer);
+    if (usesTimerWheel())
+    {
+        scheduleTimer(&forwTimer, select_timeout);
+        scheduleTimerMessage();
+    }
+    else
+        scheduleAt(select_timeout, timer);
 }
 
 
@@ -262,6 +268,8 @@ void Batman::handleMessage(cMessage *msg)
 
     curr_time = getTime();
     check_active_inactive_interfaces();
+    if (handleTimerMessage(msg))
+        return;
     if (timer == msg)
     {
         sendPackets(curr_time);
@@ -342,6 +350,15 @@ void Batman::sendPackets(const simtime_t &curr_time)
 void Batman::scheduleNextEvent()
 {
      simtime_t select_timeout = forw_list[0]->send_time > 0 ? forw_list[0]->send_time : getTime()+10;
+     if (usesTimerWheel())
+     {
+         if (select_timeout < simTime())
+             select_timeout = simTime();
+         if (!forwTimer.isScheduled() || forwTimer.getExpiry() > select_timeout)
+             scheduleTimer(&forwTimer, select_timeout);
+         scheduleTimerMessage();
+         return;
+     }
      if (timer->isScheduled())
      {
          if (timer->getArrivalTime()>select_timeout)
@@ -362,6 +379,11 @@ void Batman::scheduleNextEvent()
      }
 }
 
+void Batman::handleTimer(ManetTimer *timer)
+{
+    sendPackets(getTime());
+}
+
 uint32_t Batman::getRoute(const ManetAddress &dest, std::vector<ManetAddress> &add)
 {
     OrigMap::iterator it = origMap.find(dest);
@@ -64,6 +64,7 @@ class Batman : public ManetRoutingBase
     bool aggregation_enabled;
     uint32_t MAX_AGGREGATION_BYTES;
     cMessage *timer;
+    ManetTimer forwTimer;   // sending of the packets of forw_list, with the timer wheel
 
     HnaLocalEntryList hna_list;
     HnaTaskList hna_chg_list;
@@ -147,6 +148,7 @@ class Batman : public ManetRoutingBase
     virtual void processLinkBreak(const cObject *details){};
     virtual void packetFailed(IPv4Datagram *dgram) {}
     virtual void scheduleNextEvent();
+    virtual void handleTimer(ManetTimer *timer);
 
   public:
     Batman();
@@ -185,8 +185,26 @@ void DSRUU::omnet_deliver(struct dsr_pkt *dp)
 }
 
 
+DSRUUTimer::~DSRUUTimer()
+{
+    cancel();
+}
+
+bool DSRUUTimer::pending()
+{
+    if (a_->timerScheduler.getUseWheel())
+        return isScheduled();
+    return msgtimer.isScheduled();
+}
+
 void  DSRUUTimer::resched(double delay)
 {
+    if (a_->timerScheduler.getUseWheel())
+    {
+        a_->timerScheduler.schedule(this, simTime()+delay);
+        a_->scheduleTimerMessage();
+        return;
+    }
     if (msgtimer.isScheduled())
         a_->cSimpleModule::cancelEvent(&msgtimer);
     a_->scheduleAt(simTime()+delay, &msgtimer);
@@ -194,6 +212,16 @@ void  DSRUUTimer::resched(double delay)
 
 void DSRUUTimer::cancel()
 {
+    if (a_->timerScheduler.getUseWheel())
+    {
+        // move the timer message to the new earliest expiry
+        if (isScheduled())
+        {
+            a_->timerScheduler.cancel(this);
+            a_->scheduleTimerMessage();
+        }
+        return;
+    }
     if (msgtimer.isScheduled())
         a_->cancelEvent(&msgtimer);
 }
@@ -203,6 +231,7 @@ void DSRUU::initialize(int stage)
     //current_time =simTime();
     if (!is_init)
     {
+        timerScheduler.setUseWheel(par("useTimerWheel"));
 
         for (int i = 0; i < CONFVAL_MAX; i++)
         {
@@ -411,12 +440,14 @@ void DSRUU::finish()
     send_buf_cleanup();
     maint_buf_cleanup();
 
+    timerScheduler.recordScalars();
 }
 
-DSRUU::DSRUU():cSimpleModule(), INotifiable()
+DSRUU::DSRUU():cSimpleModule(), INotifiable(), timerScheduler(this)
 {
     lifoDsrPkt = NULL;
     lifo_token = 0;
+    processingTimers = false;
     grat_rrep_tbl_timer_ptr = new DSRUUTimer(this);
     send_buf_timer_ptr = new DSRUUTimer(this);
     neigh_tbl_timer_ptr = new DSRUUTimer(this);
@@ -428,6 +459,8 @@ DSRUU::DSRUU():cSimpleModule(), INotifiable()
 
 DSRUU::~DSRUU()
 {
+    // the timers are cancelled below, don't move the timer message any more
+    processingTimers = true;
     lc_cleanup();
     neigh_tbl_cleanup();
     rreq_tbl_cleanup();
@@ -464,6 +497,18 @@ DSRUU::~DSRUU()
 }
 void DSRUU::handleTimer(cMessage* msg)
 {
+    if (timerScheduler.isTimerMessage(msg))
+    {
+        // the timers rescheduled by the handlers are put in the wheel only,
+        // the timer message is scheduled once they are all done
+        processingTimers = true;
+        ManetTimer *timer;
+        while ((timer = timerScheduler.removeExpired(simTime())) != NULL)
+            static_cast<DSRUUTimer *>(timer)->expire();
+        processingTimers = false;
+        scheduleTimerMessage();
+        return;
+    }
     if (ack_timer.testAndExcute(msg))
         return;
     else if (grat_rrep_tbl_timer.testAndExcute(msg))
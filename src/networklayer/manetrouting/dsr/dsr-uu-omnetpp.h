@@ -39,6 +39,8 @@
 
 #include <map>
 
+#include "ManetTimerScheduler.h"
+
 // generate ev prints
 #ifdef _WIN32
 #define DEBUG omnet_debug
@@ -212,6 +214,10 @@ class DSRUU:public cSimpleModule, public INotifiable
 
     unsigned int rreq_seqno;
 
+    // the DSRUUTimers, if they are kept in the timer wheel
+    ManetTimerScheduler timerScheduler;
+    bool processingTimers;
+
     DSRUUTimer *grat_rrep_tbl_timer_ptr;
     DSRUUTimer *send_buf_timer_ptr;
     DSRUUTimer *neigh_tbl_timer_ptr;
@@ -279,6 +285,7 @@ class DSRUU:public cSimpleModule, public INotifiable
     void omnet_deliver(struct dsr_pkt *dp);
     void packetFailed(IPv4Datagram *ipDgram);
     void handleTimer(cMessage*);
+    void scheduleTimerMessage() {if (!processingTimers) timerScheduler.scheduleTimerMessage();}
     void defaultProcess(cMessage*);
 
     struct dsr_srt *RouteFind(struct in_addr , struct in_addr);
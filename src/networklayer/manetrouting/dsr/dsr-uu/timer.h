@@ -127,7 +127,13 @@ tv->tv_usec = (now % HZ) * 1000000l / HZ;
 class DSRUU;
 
 typedef void (DSRUU::*fct_t) (unsigned long data);
-class DSRUUTimer:public cOwnedObject
+
+/*
+ * Each timer has its own self-message, or, if the timer wheel of the DSRUU
+ * module is used, the timers are kept in the wheel, which drives them with
+ * a single self-message.
+ */
+class DSRUUTimer:public cOwnedObject, public ManetTimer
 {
   protected:
     cMessage msgtimer;
@@ -152,7 +158,7 @@ class DSRUUTimer:public cOwnedObject
         expires = 0;
     }
 
-    ~DSRUUTimer() {cancel();}
+    ~DSRUUTimer();
 
     void setOwer(cOwnedObject *owner_)
     {
@@ -182,7 +188,7 @@ class DSRUUTimer:public cOwnedObject
     {
         return (&msgtimer);
     }
-    bool pending() {return msgtimer.isScheduled();}
+    bool pending();
     bool test(cMessage *msg )
     {
         return (msg==&msgtimer);
@@ -199,6 +205,10 @@ class DSRUUTimer:public cOwnedObject
         else
             return false;
     }
+    void expire()
+    {
+        (a_->*function)(data);
+    }
 
     void  resched(double delay);
 
@@ -243,9 +243,6 @@ DYMOUM::DYMOUM()
     INIT_DLIST_HEAD(&PENDING_RREQ);
     INIT_DLIST_HEAD(&BLACKLIST);
     INIT_DLIST_HEAD(&NBLIST);
-#endif
-#ifdef TIMERMAPLIST
-    dymoTimerList = new DymoTimerMap;
 #endif
     rtable_init();
     packet_queue_init();
@@ -325,11 +322,6 @@ DYMOUM::~ DYMOUM()
     if (ipNodeId)
         delete ipNodeId;
     free(progname);
-
-
-#ifdef TIMERMAPLIST
-    delete dymoTimerList;
-#endif
 }
 
 /*
@@ -350,6 +342,10 @@ void DYMOUM::handleMessage(cMessage *msg)
 
     if (is_init==false)
         opp_error("Dymo-UM has not been initialized ");
+#ifdef TIMERMAPLIST
+    if (handleTimerMessage(msg))
+        return;
+#endif
     if (msg==sendMessageEvent)
     {
         // timer event
@@ -578,6 +574,13 @@ void DYMOUM::scheduleNextEvent()
     struct timeval *timeout;
     double delay;
     simtime_t timer;
+#ifdef TIMERMAPLIST
+    if (usesTimerWheel())
+    {
+        processTimers();
+        return;
+    }
+#endif
     timeout = timer_age_queue();
     if (timeout)
     {
@@ -1409,6 +1412,7 @@ void DYMOUM::finish()
     */
     recordScalar("Dymo Rerr send", totalRerrSend);
     recordScalar("Dymo Rerr rec", totalRerrRec);
+    ManetRoutingBase::finish();
 }
 
 
@@ -159,7 +159,6 @@ class DYMOUM : public ManetRoutingBase
     // cMessage messageEvent;
 
     typedef std::map<MACAddress, unsigned int> MacToIpAddress;
-    typedef std::multimap<simtime_t, struct timer*> DymoTimerMap;
     typedef std::map<ManetAddress, rtable_entry_t *> DymoRoutingTable;
     typedef std::map<ManetAddress, pending_rreq_t * > DymoPendingRreq;
     typedef std::vector<nb_t *> DymoNbList;
@@ -169,7 +168,6 @@ class DYMOUM : public ManetRoutingBase
     static std::map<ManetAddress,u_int32_t *> mapSeqNum;
 
     MacToIpAddress *macToIpAdress;
-    DymoTimerMap *dymoTimerList;
     DymoRoutingTable *dymoRoutingTable;
     DymoPendingRreq *dymoPendingRreq;
     DymoNbList *dymoNbList;
@@ -277,6 +275,9 @@ class DYMOUM : public ManetRoutingBase
     cPacket * get_packet_queue(struct in_addr dest_addr);
 
     bool is_init;
+#ifdef TIMERMAPLIST
+    virtual void handleTimer(ManetTimer *timer);
+#endif
     cMessage * sendMessageEvent;
 
     int initialized;
@@ -40,11 +40,20 @@ static DLIST_HEAD(TQ);
 
 #if defined(OMNETPP) && defined(TIMERMAPLIST)
 
+static simtime_t timeval_to_simtime(const struct timeval *tv)
+{
+    simtime_t t = tv->tv_sec;
+    t += ((double)(tv->tv_usec)/1000000.0);
+    return t;
+}
+
 int NS_CLASS timer_init(struct timer *t, timeout_func_t f, void *data)
 {
     // Sanity check
     if (t)
     {
+        // The timer may be in malloc()'ed memory
+        t->prev = t->next = NULL;
         t->used     = 0;
         t->handler  = f;
         t->data     = data;
@@ -58,10 +67,7 @@ int NS_CLASS timer_init(struct timer *t, timeout_func_t f, void *data)
 int NS_CLASS timer_is_queued(struct timer *t)
 {
     if (t)
-        for (DymoTimerMap::iterator i = dymoTimerList->begin(); i != dymoTimerList->end(); i++)
-        {
-            if ((*i).second == t)return 1;
-        }
+        return t->isScheduled();
     return 0;
 }
 
@@ -76,10 +82,7 @@ int NS_CLASS timer_add(struct timer *t)
         timer_remove(t);
     t->used = 1;
 
-    simtime_t timeout = t->timeout.tv_sec;
-    timeout += ((double)(t->timeout.tv_usec)/1000000.0);
-
-    dymoTimerList->insert(std::make_pair(timeout,t));
+    scheduleTimer(t, timeval_to_simtime(&t->timeout));
     return DLIST_SUCCESS;
 }
 
@@ -90,15 +93,10 @@ int NS_CLASS timer_remove(struct timer *t)
         return -1;
 
     t->used = 0;
-    for (DymoTimerMap::iterator i = dymoTimerList->begin(); i != dymoTimerList->end(); i++)
-    {
-        if ((*i).second == t)
-        {
-            dymoTimerList->erase(i);
-            return DLIST_SUCCESS;
-        }
-    }
-    return DLIST_FAILURE;
+    if (!t->isScheduled())
+        return DLIST_FAILURE;
+    cancelTimer(t);
+    return DLIST_SUCCESS;
 }
 
 int NS_CLASS timer_set_timeout(struct timer *t, long msec)
@@ -118,21 +116,22 @@ int NS_CLASS timer_set_timeout(struct timer *t, long msec)
 
 void NS_CLASS timer_timeout(struct timeval *now)
 {
-
-    while (!dymoTimerList->empty() && (timeval_diff(&(dymoTimerList->begin()->second->timeout), now) <= 0))
+    struct timer *t;
+    while ((t = static_cast<struct timer *>(getEarliestTimer())) != NULL && timeval_diff(&t->timeout, now) <= 0)
     {
-        struct timer * t = dymoTimerList->begin()->second;
-        dymoTimerList->erase(dymoTimerList->begin());
-        if (t==NULL)
-            opp_error ("timer ower is bad");
-        else
-        {
-            if (t->handler)
-                (this->*t->handler)(t->data);
-        }
+        removeEarliestTimer();
+        handleTimer(t);
     }
 }
 
+/* Called for each expired timer, by expireTimers() with the timer wheel */
+void NS_CLASS handleTimer(ManetTimer *timer)
+{
+    struct timer *t = static_cast<struct timer *>(timer);
+    if (t->handler)
+        (this->*t->handler)(t->data);
+}
+
 struct timeval *NS_CLASS timer_age_queue()
 {
     struct timer *t;
@@ -140,23 +139,13 @@ struct timeval *NS_CLASS timer_age_queue()
     struct timeval now;
     gettimeofday(&now, NULL);
 
-    while (!dymoTimerList->empty())
-    {
-        t = dymoTimerList->begin()->second;
-        if (t==NULL)
-            opp_error ("timer ower is bad");
-        if (timeval_diff(&(t->timeout), &now)>0)
-            break;
-        dymoTimerList->erase(dymoTimerList->begin());
-        if (t->handler)
-            (this->*t->handler)(t->data);
-    }
+    timer_timeout(&now);
 
-    if (dymoTimerList->empty())
+    t = static_cast<struct timer *>(getEarliestTimer());
+    if (!t)
         return NULL;
 
-    t = dymoTimerList->begin()->second;
-    if (timeval_diff(&(dymoTimerList->begin()->second->timeout), &now)<=0)
+    if (timeval_diff(&t->timeout, &now) <= 0)
         opp_error("Dymo Time queue error");
     remaining.tv_usec   = (t->timeout.tv_usec - now.tv_usec);
     remaining.tv_sec    = (t->timeout.tv_sec - now.tv_sec);
@@ -35,7 +35,8 @@ typedef void (NS_CLASS*timeout_func_t) (void *);
 
 #if defined(OMNETPP) && defined(TIMERMAPLIST)
 
-struct timer
+/* The timers are kept in the ManetTimerScheduler of ManetRoutingBase */
+struct timer : public ManetTimer
 {
     int     used;
     struct timeval  timeout;
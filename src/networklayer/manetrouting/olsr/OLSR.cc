@@ -32,6 +32,7 @@
 
 #include <math.h>
 #include <limits.h>
+#include <algorithm>
 
 #include "UDPPacket.h"
 #include "IPv4Datagram.h"
@@ -94,21 +95,12 @@ OLSR_Timer::OLSR_Timer() : cOwnedObject("OLSR_Timer")
 
 void OLSR_Timer::removeQueueTimer()
 {
-    TimerQueue::iterator it;
-    for (it=agent_->timerQueuePtr->begin(); it != agent_->timerQueuePtr->end(); it++ )
-    {
-        if (it->second==this)
-        {
-            agent_->timerQueuePtr->erase(it);
-            return;
-        }
-    }
+    agent_->cancelTimer(this);
 }
 
 void OLSR_Timer::resched(double time)
 {
-    removeQueueTimer();
-    agent_->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+time, this));
+    agent_->scheduleTimer(this, simTime()+time);
     //if (this->isScheduled())
     //  agent_->cancelEvent(this);
     // agent_->scheduleAt (simTime()+time,this);
@@ -124,7 +116,7 @@ OLSR_HelloTimer::expire()
 {
     agent_->send_hello();
     // agent_->scheduleAt(simTime()+agent_->hello_ival_- JITTER,this);
-    agent_->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+agent_->hello_ival_- agent_->jitter(), this));
+    agent_->scheduleTimer(this, simTime()+agent_->hello_ival_- agent_->jitter());
 }
 
 ///
@@ -137,7 +129,7 @@ OLSR_TcTimer::expire()
     if (agent_->mprselset().size() > 0)
         agent_->send_tc();
     // agent_->scheduleAt(simTime()+agent_->tc_ival_- JITTER,this);
-    agent_->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+agent_->tc_ival_- agent_->jitter(), this));
+    agent_->scheduleTimer(this, simTime()+agent_->tc_ival_- agent_->jitter());
 
 }
 
@@ -154,7 +146,7 @@ OLSR_MidTimer::expire()
         return; // not multi-interface support
     agent_->send_mid();
 //  agent_->scheduleAt(simTime()+agent_->mid_ival_- JITTER,this);
-    agent_->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+agent_->mid_ival_- agent_->jitter(), this));
+    agent_->scheduleTimer(this, simTime()+agent_->mid_ival_- agent_->jitter());
 #endif
 }
 
@@ -180,7 +172,7 @@ OLSR_DupTupleTimer::expire()
     else
     {
         // agent_->scheduleAt (simTime()+DELAY_T(time),this);
-        agent_->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+DELAY_T(time), this));
+        agent_->scheduleTimer(this, simTime()+DELAY_T(time));
     }
 }
 
@@ -234,12 +226,12 @@ OLSR_LinkTupleTimer::expire()
         else
             agent_->nb_loss(tuple);
         // agent_->scheduleAt (simTime()+DELAY_T(tuple_->time()),this);
-        agent_->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+DELAY_T(tuple->time()), this));
+        agent_->scheduleTimer(this, simTime()+DELAY_T(tuple->time()));
     }
     else
     {
         // agent_->scheduleAt (simTime()+DELAY_T(MIN(tuple_->time(), tuple_->sym_time())),this);
-        agent_->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+DELAY_T(MIN(tuple->time(), tuple->sym_time())), this));
+        agent_->scheduleTimer(this, simTime()+DELAY_T(MIN(tuple->time(), tuple->sym_time())));
     }
 }
 
@@ -278,7 +270,7 @@ OLSR_Nb2hopTupleTimer::expire()
     else
     {
         // agent_->scheduleAt (simTime()+DELAY_T(time),this);
-        agent_->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+DELAY_T(time), this));
+        agent_->scheduleTimer(this, simTime()+DELAY_T(time));
     }
 }
 
@@ -319,7 +311,7 @@ OLSR_MprSelTupleTimer::expire()
     else
     {
 //      agent_->scheduleAt (simTime()+DELAY_T(time),this);
-        agent_->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+DELAY_T(time), this));
+        agent_->scheduleTimer(this, simTime()+DELAY_T(time));
     }
 }
 
@@ -359,7 +351,7 @@ OLSR_TopologyTupleTimer::expire()
     else
     {
 //      agent_->scheduleAt (simTime()+DELAY_T(time),this);
-        agent_->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+DELAY_T(time), this));
+        agent_->scheduleTimer(this, simTime()+DELAY_T(time));
     }
 }
 
@@ -396,7 +388,7 @@ void OLSR_IfaceAssocTupleTimer::expire()
     else
     {
         //  agent_->scheduleAt (simTime()+DELAY_T(time),this);
-        agent_->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+DELAY_T(time), this));
+        agent_->scheduleTimer(this, simTime()+DELAY_T(time));
     }
 }
 
@@ -482,10 +474,11 @@ OLSR::initialize(int stage)
 
 
         timerMessage = new cMessage();
-        timerQueuePtr = new TimerQueue;
-
 
         useIndex = par("UseIndex");
+        incrementalRouteUpdate_ = par("incrementalRouteUpdate");
+        incrementalSPF_ = par("incrementalSPF");
+        ipRoutesValid_ = false;
 
         optimizedMid = par("optimizedMid");
 
@@ -538,19 +531,16 @@ OLSR::initialize(int stage)
 
 void OLSR::handleMessage(cMessage *msg)
 {
+    if (handleTimerMessage(msg))
+        return;
+
     if (msg->isSelfMessage())
     {
-        //OLSR_Timer *timer=dynamic_cast<OLSR_Timer*>(msg);
-        while (timerQueuePtr->begin()->first<=simTime())
+        OLSR_Timer *timer;
+        while ((timer = static_cast<OLSR_Timer *>(getEarliestTimer())) != NULL && timer->getExpiry() <= simTime())
         {
-            OLSR_Timer *timer = timerQueuePtr->begin()->second;
-            if (timer==NULL)
-                opp_error("timer ower is bad");
-            else
-            {
-                timerQueuePtr->erase(timerQueuePtr->begin());
-                timer->expire();
-            }
+            removeEarliestTimer();
+            timer->expire();
         }
     }
     else
@@ -559,6 +549,11 @@ void OLSR::handleMessage(cMessage *msg)
     scheduleNextEvent();
 }
 
+void OLSR::handleTimer(ManetTimer *timer)
+{
+    static_cast<OLSR_Timer *>(timer)->expire();
+}
+
 ///
 /// \brief Check if packet is OLSR
 /// \param p received packet.
@@ -1260,63 +1255,60 @@ OLSR::mpr_computation()
 void
 OLSR::rtable_computation()
 {
+    if (incrementalSPF_)
+    {
+        rtable_spf_computation();
+        return;
+    }
+
     // 1. All the entries from the routing table are removed.
     rtable_.clear();
-    omnet_clean_rte(); // clean IP tables
+    addedIpRoutes_.clear();
+
+    // The destinations of the routing entries by R_dist, for step 4.1
+    std::vector<std::vector<nsaddr_t> > dests_by_dist(3);
+
+    // The link tuples of each neighbor, in Link Set order
+    std::map<nsaddr_t, std::vector<OLSR_link_tuple*> > nb_links;
+    for (linkset_t::iterator it = linkset().begin(); it != linkset().end(); it++)
+    {
+        OLSR_link_tuple* link_tuple = *it;
+        if (link_tuple->time() >= CURRENT_TIME)
+            nb_links[get_main_addr(link_tuple->nb_iface_addr())].push_back(link_tuple);
+    }
 
     // 2. The new routing entries are added starting with the
     // symmetric neighbors (h=1) as the destination nodes.
-    nsaddr_t netmask(IPv4Address::ALLONES_ADDRESS);
     for (nbset_t::iterator it = nbset().begin(); it != nbset().end(); it++)
     {
         OLSR_nb_tuple* nb_tuple = *it;
         if (nb_tuple->getStatus() == OLSR_STATUS_SYM)
         {
+            std::map<nsaddr_t, std::vector<OLSR_link_tuple*> >::iterator links = nb_links.find(nb_tuple->nb_main_addr());
+            if (links == nb_links.end())
+                continue;
             bool nb_main_addr = false;
             OLSR_link_tuple* lt = NULL;
-            for (linkset_t::iterator it2 = linkset().begin(); it2 != linkset().end(); it2++)
+            for (size_t i = 0; i < links->second.size(); i++)
             {
-                OLSR_link_tuple* link_tuple = *it2;
-                if (get_main_addr(link_tuple->nb_iface_addr()) == nb_tuple->nb_main_addr() && link_tuple->time() >= CURRENT_TIME)
-                {
-                    lt = link_tuple;
-                    rtable_.add_entry(link_tuple->nb_iface_addr(),
-                                      link_tuple->nb_iface_addr(),
-                                      link_tuple->local_iface_addr(),
-                                      1, link_tuple->local_iface_index());
-                    if (!useIndex)
-                        omnet_chg_rte(link_tuple->nb_iface_addr(),
-                                       link_tuple->nb_iface_addr(),
-                                       netmask,
-                                       1, false, link_tuple->local_iface_addr());
-                    else
-                        omnet_chg_rte(link_tuple->nb_iface_addr(),
-                                       link_tuple->nb_iface_addr(),
-                                       netmask,
-                                       1, false, link_tuple->local_iface_index());
-
-                    if (link_tuple->nb_iface_addr() == nb_tuple->nb_main_addr())
-                        nb_main_addr = true;
-                }
+                OLSR_link_tuple* link_tuple = links->second[i];
+                lt = link_tuple;
+                record_ip_route(rtable_.add_entry(link_tuple->nb_iface_addr(),
+                                  link_tuple->nb_iface_addr(),
+                                  link_tuple->local_iface_addr(),
+                                  1, link_tuple->local_iface_index()));
+                dests_by_dist[1].push_back(link_tuple->nb_iface_addr());
+
+                if (link_tuple->nb_iface_addr() == nb_tuple->nb_main_addr())
+                    nb_main_addr = true;
             }
             if (!nb_main_addr && lt != NULL)
             {
-                rtable_.add_entry(nb_tuple->nb_main_addr(),
+                record_ip_route(rtable_.add_entry(nb_tuple->nb_main_addr(),
                                   lt->nb_iface_addr(),
                                   lt->local_iface_addr(),
-                                  1, lt->local_iface_index());
-
-                if (!useIndex)
-                    omnet_chg_rte(nb_tuple->nb_main_addr(),
-                                   lt->nb_iface_addr(),
-                                   netmask,// Default mask
-                                   1, false, lt->local_iface_addr());
-
-                else
-                    omnet_chg_rte(nb_tuple->nb_main_addr(),
-                                   lt->nb_iface_addr(),
-                                   netmask,// Default mask
-                                   1, false, lt->local_iface_index());
+                                  1, lt->local_iface_index()));
+                dests_by_dist[1].push_back(nb_tuple->nb_main_addr());
             }
         }
     }
@@ -1351,28 +1343,28 @@ OLSR::rtable_computation()
         {
             OLSR_rt_entry* entry = rtable_.lookup(nb2hop_tuple->nb_main_addr());
             assert(entry != NULL);
-            rtable_.add_entry(nb2hop_tuple->nb2hop_addr(),
+            record_ip_route(rtable_.add_entry(nb2hop_tuple->nb2hop_addr(),
                               entry->next_addr(),
                               entry->iface_addr(),
-                              2, entry->local_iface_index());
-            if (!useIndex)
-                omnet_chg_rte(nb2hop_tuple->nb2hop_addr(),
-                               entry->next_addr(),
-                               netmask,
-                               2, false, entry->iface_addr());
-
-            else
-                omnet_chg_rte(nb2hop_tuple->nb2hop_addr(),
-                               entry->next_addr(),
-                               netmask,
-                               2, false, entry->local_iface_index());
-
+                              2, entry->local_iface_index()));
+            dests_by_dist[2].push_back(nb2hop_tuple->nb2hop_addr());
         }
     }
 
+    // The position of the topology tuples in the Topology Set: the tuples
+    // found through the routing entries are processed in this order, so
+    // the first tuple of the set wins if several lead to the same destination
+    std::vector<std::pair<OLSR_topology_tuple*, size_t> > topology_pos;
+    topology_pos.reserve(topologyset().size());
+    for (size_t i = 0; i < topologyset().size(); i++)
+        topology_pos.push_back(std::make_pair(topologyset()[i], i));
+    std::sort(topology_pos.begin(), topology_pos.end());
+
     for (uint32_t h = 2;; h++)
     {
         bool added = false;
+        if (dests_by_dist.size() < h + 2)
+            dests_by_dist.resize(h + 2);
 
         // 4.1. For each topology entry in the topology table, if its
         // T_dest_addr does not correspond to R_dest_addr of any
@@ -1380,32 +1372,41 @@ OLSR::rtable_computation()
         // corresponds to R_dest_addr of a route entry whose R_dist
         // is equal to h, then a new route entry MUST be recorded in
         // the routing table (if it does not already exist)
-        for (topologyset_t::iterator it = topologyset().begin();
-                it != topologyset().end();
-                it++)
+        std::vector<nsaddr_t>& last_addrs = dests_by_dist[h];
+        std::sort(last_addrs.begin(), last_addrs.end());
+        last_addrs.erase(std::unique(last_addrs.begin(), last_addrs.end()), last_addrs.end());
+        std::vector<std::pair<size_t, OLSR_topology_tuple*> > candidates;
+        for (size_t i = 0; i < last_addrs.size(); i++)
+        {
+            OLSR_rt_entry* entry = rtable_.lookup(last_addrs[i]);
+            if (entry == NULL || entry->dist() != h)
+                continue;
+            const OLSR_index<OLSR_topology_tuple>::Bucket& bucket = state_.topology_tuples_by_last(last_addrs[i]);
+            for (size_t j = 0; j < bucket.size(); j++)
+            {
+                OLSR_topology_tuple* topology_tuple = bucket[j].second;
+                if (topology_tuple->last_addr() == last_addrs[i])
+                {
+                    std::vector<std::pair<OLSR_topology_tuple*, size_t> >::iterator pos =
+                        std::lower_bound(topology_pos.begin(), topology_pos.end(), std::make_pair(topology_tuple, (size_t)0));
+                    candidates.push_back(std::make_pair(pos->second, topology_tuple));
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        for (size_t i = 0; i < candidates.size(); i++)
         {
-            OLSR_topology_tuple* topology_tuple = *it;
+            OLSR_topology_tuple* topology_tuple = candidates[i].second;
             OLSR_rt_entry* entry1 = rtable_.lookup(topology_tuple->dest_addr());
             OLSR_rt_entry* entry2 = rtable_.lookup(topology_tuple->last_addr());
             if (entry1 == NULL && entry2 != NULL && entry2->dist() == h)
             {
-                rtable_.add_entry(topology_tuple->dest_addr(),
+                record_ip_route(rtable_.add_entry(topology_tuple->dest_addr(),
                                   entry2->next_addr(),
                                   entry2->iface_addr(),
-                                  h+1, entry2->local_iface_index(), entry2);
-
-                if (!useIndex)
-                    omnet_chg_rte(topology_tuple->dest_addr(),
-                                   entry2->next_addr(),
-                                   netmask,
-                                   h+1, false, entry2->iface_addr());
-
-                else
-                    omnet_chg_rte(topology_tuple->dest_addr(),
-                                   entry2->next_addr(),
-                                   netmask,
-                                   h+1, false, entry2->local_iface_index());
-
+                                  h+1, entry2->local_iface_index(), entry2));
+                dests_by_dist[h+1].push_back(topology_tuple->dest_addr());
                 added = true;
             }
         }
@@ -1425,22 +1426,12 @@ OLSR::rtable_computation()
             OLSR_rt_entry* entry2 = rtable_.lookup(tuple->iface_addr());
             if (entry1 != NULL && entry2 == NULL)
             {
-                rtable_.add_entry(tuple->iface_addr(),
+                record_ip_route(rtable_.add_entry(tuple->iface_addr(),
                                   entry1->next_addr(),
                                   entry1->iface_addr(),
-                                  entry1->dist(), entry1->local_iface_index(), entry1);
-
-                if (!useIndex)
-                    omnet_chg_rte(tuple->iface_addr(),
-                                   entry1->next_addr(),
-                                   netmask,
-                                   entry1->dist(), false, entry1->iface_addr());
-
-                else
-                    omnet_chg_rte(tuple->iface_addr(),
-                                   entry1->next_addr(),
-                                   netmask,
-                                   entry1->dist(), false, entry1->local_iface_index());
+                                  entry1->dist(), entry1->local_iface_index(), entry1));
+                if (entry1->dist() < dests_by_dist.size())
+                    dests_by_dist[entry1->dist()].push_back(tuple->iface_addr());
                 added = true;
             }
         }
@@ -1448,9 +1439,242 @@ OLSR::rtable_computation()
         if (!added)
             break;
     }
+    update_ip_routes(useIndex);
+    setTopologyChanged(false);
+}
+
+///
+/// \brief Creates the routing table of the node from the shortest path tree.
+///
+/// Used instead of rtable_computation() if incrementalSPF is set. The symmetric
+/// neighbors, the 2-hop neighbors and the Topology Set make up the graph, every
+/// link costs one hop, and spf_ repairs the tree of the previous computation.
+/// The routes have the same lengths as the ones of RFC 3626 section 10, but
+/// another one of several routes of equal length may be selected.
+///
+void
+OLSR::rtable_spf_computation()
+{
+    rtable_.clear();
+    addedIpRoutes_.clear();
+
+    spf_.set_metric(false, OLSR_ETX_BEHAVIOR_ETX);
+    spf_.begin();
+
+    // The link tuples of each symmetric neighbor, in Link Set order
+    std::map<nsaddr_t, std::vector<OLSR_link_tuple*> > nb_links;
+    for (linkset_t::iterator it = linkset().begin(); it != linkset().end(); it++)
+    {
+        OLSR_link_tuple* link_tuple = *it;
+        if (link_tuple->time() >= CURRENT_TIME)
+            nb_links[get_main_addr(link_tuple->nb_iface_addr())].push_back(link_tuple);
+    }
+    // The addresses of the symmetric neighbors, i.e. of the routes with R_dist 1
+    std::set<nsaddr_t> nb_addrs;
+    for (nbset_t::iterator it = nbset().begin(); it != nbset().end(); it++)
+    {
+        OLSR_nb_tuple* nb_tuple = *it;
+        if (nb_tuple->getStatus() != OLSR_STATUS_SYM)
+            continue;
+        std::map<nsaddr_t, std::vector<OLSR_link_tuple*> >::iterator links = nb_links.find(nb_tuple->nb_main_addr());
+        if (links == nb_links.end())
+            continue;
+        spf_.add_edge(nb_tuple->nb_main_addr(), links->second.front()->local_iface_addr(), 0, 1, true);
+        nb_addrs.insert(nb_tuple->nb_main_addr());
+        for (size_t i = 0; i < links->second.size(); i++)
+            nb_addrs.insert(links->second[i]->nb_iface_addr());
+    }
+
+    // The 2-hop neighbors, except the ones only reachable by neighbors with
+    // willingness WILL_NEVER and the node performing the computation
+    for (nb2hopset_t::iterator it = nb2hopset().begin(); it != nb2hopset().end(); it++)
+    {
+        OLSR_nb2hop_tuple* nb2hop_tuple = *it;
+        if (nb2hop_tuple->nb2hop_addr() == ra_addr() ||
+                state_.find_sym_nb_tuple(nb2hop_tuple->nb_main_addr()) == NULL ||
+                state_.find_nb_tuple(nb2hop_tuple->nb_main_addr(), OLSR_WILL_NEVER) != NULL)
+            continue;
+        spf_.add_edge(nb2hop_tuple->nb2hop_addr(), nb2hop_tuple->nb_main_addr(), 0, 1, false);
+    }
+
+    // As in step 4.1, the Topology Set only adds routes of R_dist 3 or more,
+    // the ones of the neighbors of the symmetric neighbors come from step 3
+    for (topologyset_t::iterator it = topologyset().begin(); it != topologyset().end(); it++)
+    {
+        OLSR_topology_tuple* topology_tuple = *it;
+        if (topology_tuple->dest_addr() != ra_addr() && nb_addrs.find(topology_tuple->last_addr()) == nb_addrs.end())
+            spf_.add_edge(topology_tuple->dest_addr(), topology_tuple->last_addr(), 0, 1, false);
+    }
+
+    spf_.run(incrementalSPF_);
+
+    // Add the routes by hop count, so that the route to the previous node
+    // exists when a node is added
+    std::vector<std::pair<std::pair<int, nsaddr_t>, int> > nodes;
+    for (int i = 0; i < spf_.get_num_nodes(); i++)
+        if (spf_.is_present(i) && spf_.get_label(i).hop_count > 0)
+            nodes.push_back(std::make_pair(std::make_pair(spf_.get_label(i).hop_count, spf_.get_address(i)), i));
+    std::sort(nodes.begin(), nodes.end());
+
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        uint32_t hop_count = nodes[i].first.first;
+        const nsaddr_t& addr = nodes[i].first.second;
+        if (hop_count == 1)
+        {
+            // a route to each interface of the neighbor, and to its main address
+            const std::vector<OLSR_link_tuple*>& links = nb_links[addr];
+            bool nb_main_addr = false;
+            for (size_t j = 0; j < links.size(); j++)
+            {
+                record_ip_route(rtable_.add_entry(links[j]->nb_iface_addr(),
+                                  links[j]->nb_iface_addr(),
+                                  links[j]->local_iface_addr(),
+                                  1, links[j]->local_iface_index()));
+                if (links[j]->nb_iface_addr() == addr)
+                    nb_main_addr = true;
+            }
+            if (!nb_main_addr)
+                record_ip_route(rtable_.add_entry(addr,
+                                  links.back()->nb_iface_addr(),
+                                  links.back()->local_iface_addr(),
+                                  1, links.back()->local_iface_index()));
+            continue;
+        }
+
+        // an interface of a neighbor keeps its one hop route
+        if (rtable_.lookup(addr) != NULL)
+            continue;
+        OLSR_rt_entry* entry = rtable_.lookup(spf_.get_label(nodes[i].second).last_node);
+        assert(entry != NULL);
+        if (hop_count == 2)
+            record_ip_route(rtable_.add_entry(addr, entry->next_addr(), entry->iface_addr(),
+                              2, entry->local_iface_index()));
+        else
+            record_ip_route(rtable_.add_entry(addr, entry->next_addr(), entry->iface_addr(),
+                              hop_count, entry->local_iface_index(), entry));
+    }
+
+    // 5. For each entry in the multiple interface association base
+    // where there exists a routing entry such that:
+    //  R_dest_addr  == I_main_addr  (of the multiple interface association entry)
+    // AND there is no routing entry such that:
+    //  R_dest_addr  == I_iface_addr
+    // then a route entry is created in the routing table
+    for (ifaceassocset_t::iterator it = ifaceassocset().begin(); it != ifaceassocset().end(); it++)
+    {
+        OLSR_iface_assoc_tuple* tuple = *it;
+        OLSR_rt_entry* entry1 = rtable_.lookup(tuple->main_addr());
+        OLSR_rt_entry* entry2 = rtable_.lookup(tuple->iface_addr());
+        if (entry1 != NULL && entry2 == NULL)
+        {
+            record_ip_route(rtable_.add_entry(tuple->iface_addr(),
+                              entry1->next_addr(),
+                              entry1->iface_addr(),
+                              entry1->dist(), entry1->local_iface_index(), entry1));
+        }
+    }
+    update_ip_routes(useIndex);
     setTopologyChanged(false);
 }
 
+///
+/// \brief Brings the IPv4 routing table in line with the routing table.
+///
+/// By default, the routes of the wlan interfaces are removed, and the routes
+/// are written again in the order they were added to the routing table. If
+/// incrementalRouteUpdate is set, only the routes that were added, removed
+/// or changed since the previous call are written to the IPv4 routing table.
+///
+/// \param useIndex identify the interface of the routes by index instead of address.
+///
+void
+OLSR::update_ip_routes(bool useIndex)
+{
+    nsaddr_t netmask(IPv4Address::ALLONES_ADDRESS);
+    if (!incrementalRouteUpdate_)
+    {
+        omnet_clean_rte(); // clean IP tables
+        for (size_t i = 0; i < addedIpRoutes_.size(); i++)
+        {
+            const IpRoute& route = addedIpRoutes_[i].second;
+            if (!useIndex)
+                omnet_chg_rte(addedIpRoutes_[i].first, route.next, netmask, route.dist, false, route.iface);
+            else
+                omnet_chg_rte(addedIpRoutes_[i].first, route.next, netmask, route.dist, false, route.index);
+        }
+        addedIpRoutes_.clear();
+        return;
+    }
+
+    if (!ipRoutesValid_)
+    {
+        omnet_clean_rte(); // clean IP tables
+        ipRoutes_.clear();
+        ipRoutesValid_ = true;
+    }
+
+    const rtable_t& entries = rtable_.entries();
+    rtable_t::const_iterator it = entries.begin();
+    IpRouteMap::iterator old = ipRoutes_.begin();
+    // both maps are ordered by destination
+    while (it != entries.end() || old != ipRoutes_.end())
+    {
+        if (it == entries.end() || (old != ipRoutes_.end() && old->first < it->first))
+        {
+            deleteIpEntry(old->first);
+            ipRoutes_.erase(old++);
+            continue;
+        }
+
+        OLSR_rt_entry* entry = it->second;
+        IpRoute route;
+        route.next = entry->next_addr();
+        route.iface = entry->iface_addr();
+        route.index = entry->local_iface_index();
+        route.dist = entry->dist();
+        if (old != ipRoutes_.end() && old->first == it->first)
+        {
+            IpRoute& installed = old->second;
+            bool unchanged = installed.next == route.next && installed.dist == route.dist &&
+                (useIndex ? installed.index == route.index : installed.iface == route.iface);
+            old++;
+            if (unchanged)
+            {
+                it++;
+                continue;
+            }
+        }
+        ipRoutes_[it->first] = route;
+        if (!useIndex)
+            omnet_chg_rte(it->first, route.next, netmask, route.dist, false, route.iface);
+        else
+            omnet_chg_rte(it->first, route.next, netmask, route.dist, false, route.index);
+        it++;
+    }
+}
+
+///
+/// \brief Records a route just added to the routing table, to be written to
+/// the IPv4 routing table by update_ip_routes().
+///
+/// Nothing is recorded if incrementalRouteUpdate is set.
+///
+/// \param entry the added routing table entry.
+///
+void
+OLSR::record_ip_route(OLSR_rt_entry* entry)
+{
+    if (incrementalRouteUpdate_)
+        return;
+    IpRoute route;
+    route.next = entry->next_addr();
+    route.iface = entry->iface_addr();
+    route.index = entry->local_iface_index();
+    route.dist = entry->dist();
+    addedIpRoutes_.push_back(std::make_pair(entry->dest_addr(), route));
+}
+
 ///
 /// \brief Processes a HELLO message following RFC 3626 specification.
 ///
@@ -2235,6 +2459,7 @@ OLSR::mac_failed(IPv4Datagram* p)
         }
     }
     deleteIpEntry(dest_addr);
+    ipRoutes_.erase(dest_addr);
 }
 
 ///
@@ -2771,6 +2996,7 @@ void OLSR::finish()
     tcTimer= NULL;  ///< Timer for sending TC messages.
     midTimer = NULL;    ///< Timer for sending MID messages.
     */
+    ManetRoutingBase::finish();
 }
 
 OLSR::~OLSR()
@@ -2806,10 +3032,9 @@ OLSR::~OLSR()
         timerMessage = NULL;
     }
 
-    while (timerQueuePtr && timerQueuePtr->size()>0)
+    OLSR_Timer *timer;
+    while ((timer = static_cast<OLSR_Timer *>(removeEarliestTimer())) != NULL)
     {
-        OLSR_Timer * timer = timerQueuePtr->begin()->second;
-        timerQueuePtr->erase(timerQueuePtr->begin());
         timer->setTuple(NULL);
         if (helloTimer==timer)
             helloTimer = NULL;
@@ -2835,12 +3060,6 @@ OLSR::~OLSR()
         delete midTimer;
         midTimer = NULL;
     }
-
-    if (timerQueuePtr)
-    {
-        delete timerQueuePtr;
-        timerQueuePtr = NULL;
-    }
 }
 
 
@@ -2940,20 +3159,28 @@ bool OLSR::getDestAddress(cPacket *msg, ManetAddress &dest)
 
 void OLSR::scheduleNextEvent()
 {
-    TimerQueue::iterator e = timerQueuePtr->begin();
+    if (usesTimerWheel())
+    {
+        scheduleTimerMessage();
+        return;
+    }
+
+    ManetTimer *e = getEarliestTimer();
+    if (e == NULL)
+        return;
     if (timerMessage->isScheduled())
     {
-        if (e->first < timerMessage->getArrivalTime())
+        if (e->getExpiry() < timerMessage->getArrivalTime())
         {
             cancelEvent(timerMessage);
-            scheduleAt(e->first, timerMessage);
+            scheduleAt(e->getExpiry(), timerMessage);
         }
-        else if (e->first>timerMessage->getArrivalTime())
+        else if (e->getExpiry()>timerMessage->getArrivalTime())
             error("OLSR timer Queue problem");
     }
     else
     {
-        scheduleAt(e->first, timerMessage);
+        scheduleAt(e->getExpiry(), timerMessage);
     }
 }
 
@@ -37,6 +37,7 @@
 #include "OLSR_state.h"
 #include "OLSR_rtable.h"
 #include "OLSR_repositories.h"
+#include "OLSR_spf.h"
 
 #include <map>
 #include <vector>
@@ -160,7 +161,7 @@ class OLSR;         // forward declaration
 
 /// Basic timer class
 
-class OLSR_Timer :  public cOwnedObject /*cMessage*/
+class OLSR_Timer :  public cOwnedObject /*cMessage*/, public ManetTimer
 {
   protected:
     OLSR*       agent_; ///< OLSR agent which created the timer.
@@ -336,7 +337,6 @@ class OLSR_IfaceAssocTupleTimer : public OLSR_Timer
 ///
 
 typedef std::set<OLSR_Timer *> TimerPendingList;
-typedef std::multimap <simtime_t, OLSR_Timer *> TimerQueue;
 
 
 class OLSR : public ManetRoutingBase
@@ -380,8 +380,8 @@ class OLSR : public ManetRoutingBase
     bool topologyChange;
     virtual void setTopologyChanged(bool p) {topologyChange = p;}
     virtual bool getTopologyChanged() {return topologyChange;}
-    TimerQueue *timerQueuePtr;
 
+    /// Self-message of the timers, if the timer wheel is not used.
     cMessage *timerMessage;
 
 // must be protected and used for dereved class OLSR_ETX
@@ -389,6 +389,29 @@ class OLSR : public ManetRoutingBase
     std::vector<OLSR_msg>   msgs_;
     /// Routing table.
     OLSR_rtable     rtable_;
+
+    /// A route installed in the IPv4 routing table.
+    struct IpRoute
+    {
+        nsaddr_t    next;
+        nsaddr_t    iface;
+        int     index;
+        uint32_t    dist;
+    };
+    typedef std::map<nsaddr_t, IpRoute> IpRouteMap;
+    /// Routes installed in the IPv4 routing table by update_ip_routes().
+    IpRouteMap  ipRoutes_;
+    /// False until update_ip_routes() has cleaned the IPv4 routing table.
+    bool    ipRoutesValid_;
+    /// Routes in the order they were added to the routing table, written by
+    /// update_ip_routes() if incrementalRouteUpdate_ is false.
+    std::vector<std::pair<nsaddr_t, IpRoute> > addedIpRoutes_;
+    /// Only write the changed routes to the IPv4 routing table.
+    bool    incrementalRouteUpdate_;
+    /// Shortest path tree, kept between route computations.
+    OLSR_spf    spf_;
+    /// Repair spf_ after topology changes instead of recomputing it.
+    bool    incrementalSPF_;
     /// Internal state with all needed data structs.
 
     OLSR_state      *state_ptr;
@@ -470,6 +493,9 @@ class OLSR : public ManetRoutingBase
 
     virtual void        mpr_computation();
     virtual void        rtable_computation();
+    virtual void        rtable_spf_computation();
+    virtual void        update_ip_routes(bool useIndex);
+    virtual void        record_ip_route(OLSR_rt_entry* entry);
 
     virtual bool        process_hello(OLSR_msg&, const nsaddr_t &, const nsaddr_t &, const int &);
     virtual bool        process_tc(OLSR_msg&, const nsaddr_t &, const int &);
@@ -521,6 +547,7 @@ class OLSR : public ManetRoutingBase
     virtual void    recv(cMessage *p) {}
 
     virtual void handleMessage(cMessage *msg);
+    virtual void handleTimer(ManetTimer *timer);
     virtual void finish();
     //virtual void processPromiscuous(const cObject *details){};
     virtual void processLinkBreak(const cObject *details);
@@ -531,7 +558,7 @@ class OLSR : public ManetRoutingBase
     const char * getNodeId(const nsaddr_t &addr);
 
   public:
-    OLSR() {}
+    OLSR() {timerMessage = NULL;}
     virtual ~OLSR();
 
 
@@ -34,6 +34,7 @@
 
 #include <math.h>
 #include <limits.h>
+#include <algorithm>
 
 #include <omnetpp.h>
 #include "IPv4Datagram.h"
@@ -48,7 +49,6 @@
 
 #include "OLSRpkt_m.h"
 #include "OLSR_ETX.h"
-#include "OLSR_ETX_dijkstra.h"
 
 
 /// Length (in bytes) of UDP header.
@@ -77,7 +77,7 @@ void OLSR_ETX_LinkQualityTimer::expire()
     OLSR_ETX *agentaux = check_and_cast<OLSR_ETX *>(agent_);
     agentaux->OLSR_ETX::link_quality();
     // agentaux->scheduleAt(simTime()+agentaux->hello_ival_,this);
-    agentaux->timerQueuePtr->insert(std::pair<simtime_t, OLSR_Timer *>(simTime()+agentaux->hello_ival_, this));
+    agentaux->scheduleTimer(this, simTime()+agentaux->hello_ival_);
 }
 
 
@@ -159,7 +159,6 @@ OLSR_ETX::initialize(int stage)
         ra_addr_ = getAddress();
 
         timerMessage = new cMessage();
-        timerQueuePtr = new TimerQueue;
 
         // Starts all timers
 
@@ -191,6 +190,9 @@ OLSR_ETX::initialize(int stage)
         link_quality_timer_.resched(0.0);
 
         useIndex = false;
+        incrementalRouteUpdate_ = par("incrementalRouteUpdate");
+        incrementalSPF_ = par("incrementalSPF");
+        ipRoutesValid_ = false;
 
         if (use_mac())
         {
@@ -1206,13 +1208,13 @@ OLSR_ETX::rtable_default_computation()
 void
 OLSR_ETX::rtable_dijkstra_computation()
 {
-    // Declare a class that will run the dijkstra algorithm
-    Dijkstra *dijkstra = new Dijkstra();
-
     // All the entries from the routing table are removed.
     rtable_.clear();
-    omnet_clean_rte();
-    nsaddr_t netmask(IPv4Address::ALLONES_ADDRESS);
+    addedIpRoutes_.clear();
+
+    // Describe the graph to the shortest path tree computation
+    spf_.set_metric(parameter_.link_delay(), parameter_.link_quality());
+    spf_.begin();
 
     debug("Current node %s:\n", getNodeId(ra_addr()));
     // Iterate through all out 1 hop neighbors
@@ -1228,8 +1230,8 @@ OLSR_ETX::rtable_dijkstra_computation()
         {
             debug("nb_tuple: %s (local) ==> %s , delay %lf, quality %lf\n", getNodeId(best_link->local_iface_addr()),
                     getNodeId(nb_tuple->nb_main_addr()), best_link->nb_link_delay(), best_link->etx());
-            dijkstra->add_edge(nb_tuple->nb_main_addr(), best_link->local_iface_addr(),
-                                best_link->nb_link_delay(), best_link->etx(), true);
+            spf_.add_edge(nb_tuple->nb_main_addr(), best_link->local_iface_addr(),
+                           best_link->nb_link_delay(), best_link->etx(), true);
         }
     }
 
@@ -1299,8 +1301,8 @@ OLSR_ETX::rtable_dijkstra_computation()
             // nb2hop_addr is not directly connected to this node
             debug("nb2hop_tuple: %s (local) ==> %s , delay %lf, quality %lf\n", getNodeId(nb_main_addr),
                     getNodeId(nb2hop_tuple->nb2hop_addr()), nb2hop_tuple->nb_link_delay(), nb2hop_tuple->etx());
-            dijkstra->add_edge(nb2hop_tuple->nb2hop_addr(), nb_main_addr,
-                                nb2hop_tuple->nb_link_delay(), nb2hop_tuple->etx(), false);
+            spf_.add_edge(nb2hop_tuple->nb2hop_addr(), nb_main_addr,
+                           nb2hop_tuple->nb_link_delay(), nb2hop_tuple->etx(), false);
         }
     }
 
@@ -1321,97 +1323,41 @@ OLSR_ETX::rtable_dijkstra_computation()
         // is not directly connected to this node
         debug("topology_tuple: %s (local) ==> %sd , delay %lf, quality %lf\n", getNodeId(topology_tuple->last_addr()),
                 getNodeId(topology_tuple->dest_addr()), topology_tuple->nb_link_delay(), topology_tuple->etx());
-        dijkstra->add_edge(topology_tuple->dest_addr(), topology_tuple->last_addr(),
-                            topology_tuple->nb_link_delay(), topology_tuple->etx(), false);
+        spf_.add_edge(topology_tuple->dest_addr(), topology_tuple->last_addr(),
+                       topology_tuple->nb_link_delay(), topology_tuple->etx(), false);
     }
 
     // Run the dijkstra algorithm
-    dijkstra->run();
+    spf_.run(incrementalSPF_);
 
     // Now all we have to do is inserting routes according to hop count
-#if 1
-    std::multimap<int,nsaddr_t> processed_nodes;
-    for (Dijkstra::DijkstraMap::iterator it = dijkstra->dijkstraMap.begin(); it != dijkstra->dijkstraMap.end(); it++)
+    std::vector<std::pair<std::pair<int, nsaddr_t>, int> > processed_nodes;
+    for (int i = 0; i < spf_.get_num_nodes(); i++)
     {
-        // store the nodes in hop order, the multimap order the values in function of number of hops
-        processed_nodes.insert(std::pair<int,nsaddr_t>(it->second.hop_count(), it->first));
+        // store the nodes in hop order, then in address order
+        if (spf_.is_present(i) && spf_.get_label(i).hop_count > 0)
+            processed_nodes.push_back(std::make_pair(std::make_pair(spf_.get_label(i).hop_count, spf_.get_address(i)), i));
     }
-    while (!processed_nodes.empty())
+    std::sort(processed_nodes.begin(), processed_nodes.end());
+    for (size_t i = 0; i < processed_nodes.size(); i++)
     {
-
-        std::multimap<int,nsaddr_t>::iterator it = processed_nodes.begin();
-        Dijkstra::DijkstraMap::iterator itDij = dijkstra->dijkstraMap.find(it->second);
-        if (itDij==dijkstra->dijkstraMap.end())
-            opp_error("node not found in DijkstraMap");
-        int hopCount = it->first;
+        int hopCount = processed_nodes[i].first.first;
+        const nsaddr_t& addr = processed_nodes[i].first.second;
+        const OLSR_spf::Label& label = spf_.get_label(processed_nodes[i].second);
         if (hopCount == 1)
         {
             // add route...
-            rtable_.add_entry(it->second, it->second, itDij->second.link().last_node(), 1, -1,itDij->second.link().quality(),itDij->second.link().getDelay());
-            omnet_chg_rte(it->second, it->second, netmask, hopCount, false, itDij->second.link().last_node());
+            record_ip_route(rtable_.add_entry(addr, addr, label.last_node, 1, -1, label.quality, label.delay));
         }
-        else if (it->first > 1)
+        else
         {
             // add route...
-            OLSR_ETX_rt_entry* entry = rtable_.lookup(itDij->second.link().last_node());
+            OLSR_ETX_rt_entry* entry = rtable_.lookup(label.last_node);
             if (entry==NULL)
                 opp_error("entry not found");
-            rtable_.add_entry(it->second, entry->next_addr(), entry->iface_addr(), hopCount, entry->local_iface_index(),itDij->second.link().quality(),itDij->second.link().getDelay());
-            omnet_chg_rte (it->second, entry->next_addr(), netmask, hopCount, false, entry->iface_addr());
+            record_ip_route(rtable_.add_entry(addr, entry->next_addr(), entry->iface_addr(), hopCount, entry->local_iface_index(), label.quality, label.delay));
         }
-        processed_nodes.erase(processed_nodes.begin());
-        dijkstra->dijkstraMap.erase(itDij);
     }
-    dijkstra->dijkstraMap.clear();
-#else
-    std::set<nsaddr_t> processed_nodes;
-    for (std::set<nsaddr_t>::iterator it = dijkstra->all_nodes()->begin(); it != dijkstra->all_nodes()->end(); it++)
-    {
-        if (dijkstra->D(*it).hop_count() == 1)
-        {
-            // add route...
-            rtable_.add_entry(*it, *it, dijkstra->D(*it).link().last_node(), 1, -1);
-            omnet_chg_rte(*it, *it, netmask, 1, false, dijkstra->D(*it).link().last_node());
-            processed_nodes.insert(*it);
-        }
-    }
-    for (std::set<nsaddr_t>::iterator it = processed_nodes.begin(); it != processed_nodes.end(); it++)
-        dijkstra->all_nodes()->erase(*it);
-    processed_nodes.clear();
-    for (std::set<nsaddr_t>::iterator it = dijkstra->all_nodes()->begin(); it != dijkstra->all_nodes()->end(); it++)
-    {
-        if (dijkstra->D(*it).hop_count() == 2)
-        {
-            // add route...
-            OLSR_ETX_rt_entry* entry = rtable_.lookup(dijkstra->D(*it).link().last_node());
-            assert(entry != NULL);
-            rtable_.add_entry(*it, dijkstra->D(*it).link().last_node(), entry->iface_addr(), 2, entry->local_iface_index());
-            omnet_chg_rte(*it, dijkstra->D(*it).link().last_node(), netmask, 2, false, entry->iface_addr());
-            processed_nodes.insert(*it);
-        }
-    }
-    for (std::set<nsaddr_t>::iterator it = processed_nodes.begin(); it != processed_nodes.end(); it++)
-        dijkstra->all_nodes()->erase(*it);
-    processed_nodes.clear();
-    for (int i = 3; i <= dijkstra->highest_hop(); i++)
-    {
-        for (std::set<nsaddr_t>::iterator it = dijkstra->all_nodes()->begin(); it != dijkstra->all_nodes()->end(); it++)
-        {
-            if (dijkstra->D(*it).hop_count() == i)
-            {
-                // add route...
-                OLSR_ETX_rt_entry* entry = rtable_.lookup(dijkstra->D(*it).link().last_node());
-                assert(entry != NULL);
-                rtable_.add_entry(*it, entry->next_addr(), entry->iface_addr(), i, entry->local_iface_index());
-                omnet_chg_rte(*it, entry->next_addr(), netmask, i, false, entry->iface_addr());
-                processed_nodes.insert(*it);
-            }
-        }
-        for (std::set<nsaddr_t>::iterator it = processed_nodes.begin(); it != processed_nodes.end(); it++)
-            dijkstra->all_nodes()->erase(*it);
-        processed_nodes.clear();
-    }
-#endif
     // 5. For each entry in the multiple interface association base
     // where there exists a routing entry such that:
     //  R_dest_addr  == I_main_addr  (of the multiple interface association entry)
@@ -1425,16 +1371,12 @@ OLSR_ETX::rtable_dijkstra_computation()
         OLSR_ETX_rt_entry* entry2 = rtable_.lookup(tuple->iface_addr());
         if (entry1 != NULL && entry2 == NULL)
         {
-            rtable_.add_entry(tuple->iface_addr(),
-                              entry1->next_addr(), entry1->iface_addr(), entry1->dist(), entry1->local_iface_index(),entry1->quality,entry1->delay);
-            omnet_chg_rte(tuple->iface_addr(), entry1->next_addr(), netmask, entry1->dist(), false, entry1->iface_addr());
-
+            record_ip_route(rtable_.add_entry(tuple->iface_addr(),
+                              entry1->next_addr(), entry1->iface_addr(), entry1->dist(), entry1->local_iface_index(),entry1->quality,entry1->delay));
         }
     }
+    update_ip_routes(false);
     // rtable_.print_debug(this);
-    // destroy the dijkstra class we've created
-    // dijkstra->clear ();
-    delete dijkstra;
 }
 
 ///
@@ -2621,6 +2563,7 @@ void OLSR_ETX::finish()
     tcTimer = NULL;  ///< Timer for sending TC messages.
     midTimer = NULL;    ///< Timer for sending MID messages.
     linkQualityTimer = NULL;
+    ManetRoutingBase::finish();
 }
 
 OLSR_ETX::~OLSR_ETX()
@@ -2660,10 +2603,9 @@ OLSR_ETX::~OLSR_ETX()
         timerMessage = NULL;
     }
 
-    while (timerQueuePtr && timerQueuePtr->size()>0)
+    OLSR_Timer *timer;
+    while ((timer = static_cast<OLSR_Timer *>(removeEarliestTimer())) != NULL)
     {
-        OLSR_Timer * timer = timerQueuePtr->begin()->second;
-        timerQueuePtr->erase(timerQueuePtr->begin());
         timer->setTuple(NULL);
         if (helloTimer==timer)
             helloTimer = NULL;
@@ -2696,11 +2638,6 @@ OLSR_ETX::~OLSR_ETX()
         delete linkQualityTimer;
         linkQualityTimer = NULL;
     }
-    if (timerQueuePtr)
-    {
-        delete timerQueuePtr;
-        timerQueuePtr = NULL;
-    }
 }
 
 
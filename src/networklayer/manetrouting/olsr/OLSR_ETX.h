@@ -160,7 +160,6 @@ class OLSR_ETX : public OLSR
         friend class OLSR_IfaceAssocTupleTimer;
         friend class OLSR_MsgTimer;
         friend class OLSR_ETX_state;
-        friend class Dijkstra;
 
         OLSR_ETX_parameter parameter_;
 
@@ -0,0 +1,109 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+///
+/// \file   OLSR_index.h
+/// \brief  Hash index of the tuples of the OLSR repositories.
+///
+
+#ifndef __OLSR_index_h__
+#define __OLSR_index_h__
+
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "ManetAddress.h"
+
+inline uint32_t OLSR_hash(const ManetAddress &a) { return a.hash(); }
+inline uint32_t OLSR_hash(const ManetAddress &a, const ManetAddress &b) { return a.hash() * 31 + b.hash(); }
+inline uint32_t OLSR_hash(const ManetAddress &a, uint16_t n) { return a.hash() * 31 + n; }
+
+///
+/// \brief Hash index of the tuples of a repository.
+///
+/// The key of a tuple (one or two addresses) is given by its hash value;
+/// the find functions of OLSR_state scan the bucket of the hash value, and
+/// compare the key fields of the tuples. Tuples with the same hash value are
+/// kept in insertion order, which is also their order in the repository
+/// (the repositories are vectors that are only appended to), so the first
+/// matching tuple in the bucket is the same as the one a linear scan of the
+/// repository would find.
+///
+template <class Tuple>
+class OLSR_index
+{
+  public:
+    typedef std::pair<uint32_t, Tuple*> Entry;
+    typedef std::vector<Entry> Bucket;
+
+  protected:
+    std::vector<Bucket> buckets_;
+    uint32_t mask_;
+    size_t size_;
+
+    void rehash(size_t numBuckets)
+    {
+        std::vector<Bucket> old;
+        old.swap(buckets_);
+        buckets_.resize(numBuckets);
+        mask_ = (uint32_t)(numBuckets - 1);
+        // old buckets in order: entries with the same hash stay in order
+        for (size_t i = 0; i < old.size(); i++)
+            for (size_t j = 0; j < old[i].size(); j++)
+                buckets_[old[i][j].first & mask_].push_back(old[i][j]);
+    }
+
+  public:
+    OLSR_index() : mask_(0), size_(0) { buckets_.resize(1); }
+
+    /// Returns the bucket that contains the tuples with the given hash value (and others).
+    const Bucket& bucket(uint32_t hash) const { return buckets_[hash & mask_]; }
+
+    void insert(uint32_t hash, Tuple *tuple)
+    {
+        if (++size_ > 2 * buckets_.size())
+            rehash(4 * buckets_.size());
+        buckets_[hash & mask_].push_back(Entry(hash, tuple));
+    }
+
+    void erase(uint32_t hash, Tuple *tuple)
+    {
+        Bucket& b = buckets_[hash & mask_];
+        for (typename Bucket::iterator it = b.begin(); it != b.end(); ++it)
+        {
+            if (it->second == tuple)
+            {
+                b.erase(it);
+                size_--;
+                return;
+            }
+        }
+    }
+
+    void clear()
+    {
+        buckets_.clear();
+        buckets_.resize(1);
+        mask_ = 0;
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+};
+
+#endif
@@ -0,0 +1,386 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <queue>
+
+#include "OLSR_spf.h"
+
+namespace {
+
+enum NodeState
+{
+    UNAFFECTED,  // keeps its path, unless a shorter one is found
+    OPEN,        // its path is being computed
+    SETTLED      // its path is final
+};
+
+// Nodes to select, by cost and address; a node whose cost changed may have
+// outdated entries, these are skipped
+struct HeapEntry
+{
+    double cost;
+    nsaddr_t addr;
+    int node;
+
+    HeapEntry(double cost, const nsaddr_t &addr, int node) : cost(cost), addr(addr), node(node) {}
+    bool operator>(const HeapEntry &other) const
+    {
+        if (cost != other.cost)
+            return cost > other.cost;
+        return other.addr < addr;
+    }
+};
+
+struct HeapEntryGreater
+{
+    bool operator()(const HeapEntry &a, const HeapEntry &b) const { return a > b; }
+};
+
+bool same_path(const OLSR_spf::Label &a, const OLSR_spf::Label &b)
+{
+    return a.last_node == b.last_node && a.quality == b.quality && a.delay == b.delay;
+}
+
+OLSR_spf::Label unreachable()
+{
+    OLSR_spf::Label label;
+    label.last_node = nsaddr_t();
+    label.quality = 0;
+    label.delay = 0;
+    label.hop_count = -1;
+    return label;
+}
+
+} // namespace
+
+OLSR_spf::OLSR_spf() : index_(-1)
+{
+    link_delay_ = false;
+    link_quality_ = OLSR_ETX_BEHAVIOR_ETX;
+    valid_ = false;
+    num_recomputed_ = 0;
+}
+
+void OLSR_spf::set_metric(bool link_delay, int link_quality)
+{
+    if (link_delay != link_delay_ || link_quality != link_quality_)
+        valid_ = false;
+    link_delay_ = link_delay;
+    link_quality_ = link_quality;
+}
+
+int OLSR_spf::get_node(const nsaddr_t &addr)
+{
+    int i = index_.find(addr);
+    if (i != -1)
+        return i;
+
+    Node node;
+    node.addr = addr;
+    node.present = node.prev_present = false;
+    node.direct = node.prev_direct = false;
+    node.direct_label = node.prev_direct_label = unreachable();
+    node.label = unreachable();
+    node.parent = -1;
+    i = nodes_.size();
+    nodes_.push_back(node);
+    index_.insert(addr, i);
+    return i;
+}
+
+void OLSR_spf::begin()
+{
+    added_.clear();
+    for (size_t i = 0; i < nodes_.size(); i++)
+    {
+        nodes_[i].present = false;
+        nodes_[i].direct = false;
+    }
+}
+
+void OLSR_spf::add_edge(const nsaddr_t &dest_node, const nsaddr_t &last_node, double delay,
+                        double quality, bool direct_connected)
+{
+    int to = get_node(dest_node);
+    Node &node = nodes_[to];
+    node.present = true;
+    if (direct_connected)
+    {
+        // Since dest_node is directly connected to the node running the
+        // algorithm, this link has hop count 1; the last one added is used
+        node.direct = true;
+        node.direct_label.last_node = last_node;
+        node.direct_label.quality = quality;
+        node.direct_label.delay = delay;
+        node.direct_label.hop_count = 1;
+    }
+
+    AddedEdge edge;
+    edge.to = to;
+    edge.last_node = last_node;
+    edge.quality = quality;
+    edge.delay = delay;
+    added_.push_back(edge);
+}
+
+void OLSR_spf::build_graph()
+{
+    int n = nodes_.size();
+    for (int i = 0; i < n; i++)
+    {
+        nodes_[i].in.clear();
+        nodes_[i].out.clear();
+        nodes_[i].out_edge.clear();
+    }
+
+    // Group the links by destination, keeping their order
+    std::vector<int> first(n + 1, 0);
+    for (size_t k = 0; k < added_.size(); k++)
+        first[added_[k].to + 1]++;
+    for (int i = 0; i < n; i++)
+        first[i + 1] += first[i];
+    std::vector<int> order(added_.size());
+    std::vector<int> next(first.begin(), first.end() - 1);
+    for (size_t k = 0; k < added_.size(); k++)
+        order[next[added_[k].to]++] = k;
+
+    // Only the links from nodes of the graph are used, and only the first
+    // one between the same two nodes
+    std::vector<int> lastDest(n, -1);
+    for (int to = 0; to < n; to++)
+    {
+        for (int k = first[to]; k < first[to + 1]; k++)
+        {
+            const AddedEdge &added = added_[order[k]];
+            int from = index_.find(added.last_node);
+            if (from == -1 || !nodes_[from].present || lastDest[from] == to)
+                continue;
+            lastDest[from] = to;
+            Edge edge;
+            edge.from = from;
+            edge.quality = added.quality;
+            edge.delay = added.delay;
+            nodes_[from].out.push_back(to);
+            nodes_[from].out_edge.push_back(nodes_[to].in.size());
+            nodes_[to].in.push_back(edge);
+        }
+    }
+}
+
+double OLSR_spf::cost(const Label &label) const
+{
+    // the cost by which the best node is selected
+    if (link_delay_)
+        return label.delay;
+    switch (link_quality_)
+    {
+    case OLSR_ETX_BEHAVIOR_ETX:
+        return label.quality;
+
+    case OLSR_ETX_BEHAVIOR_ML:
+        return -label.quality;
+
+    case OLSR_ETX_BEHAVIOR_NONE:
+    default:
+        return 0;
+    }
+}
+
+bool OLSR_spf::relax(Label &dest, const Label &current, const Edge &current_edge, const nsaddr_t &last_node)
+{
+    // D(node) = min (D(node), D(current_node) + edge(current_node, node).cost())
+    if (dest.hop_count == -1)   // there is not a link to dest_node yet...
+    {
+        switch (link_quality_)
+        {
+        case OLSR_ETX_BEHAVIOR_ETX:
+            dest.last_node = last_node;
+            dest.quality = current.quality + current_edge.quality;
+            dest.delay = current.delay + current_edge.delay;
+            dest.hop_count = current.hop_count + 1;
+            return true;
+
+        case OLSR_ETX_BEHAVIOR_ML:
+            dest.last_node = last_node;
+            dest.quality = current.quality * current_edge.quality;
+            dest.delay = current.delay + current_edge.delay;
+            dest.hop_count = current.hop_count + 1;
+            return true;
+
+        case OLSR_ETX_BEHAVIOR_NONE:
+        default:
+            return false;
+        }
+    }
+    else if (link_delay_)
+    {
+        if (link_quality_ != OLSR_ETX_BEHAVIOR_ETX && link_quality_ != OLSR_ETX_BEHAVIOR_ML)
+            return false;
+        if (current.delay + current_edge.delay >= dest.delay)
+            return false;
+        dest.last_node = last_node;
+        if (link_quality_ == OLSR_ETX_BEHAVIOR_ETX)
+            dest.quality = current.quality + current_edge.quality;
+        else
+            dest.quality = current.quality * current_edge.quality;
+        dest.delay = current.delay + current_edge.delay;
+        dest.hop_count = current.hop_count + 1;
+        return true;
+    }
+    else
+    {
+        switch (link_quality_)
+        {
+        case OLSR_ETX_BEHAVIOR_ETX:
+            if (current.quality + current_edge.quality >= dest.quality)
+                return false;
+            dest.quality = current.quality + current_edge.quality;
+            break;
+
+        case OLSR_ETX_BEHAVIOR_ML:
+            if (current.quality * current_edge.quality <= dest.quality)
+                return false;
+            dest.quality = current.quality * current_edge.quality;
+            break;
+
+        case OLSR_ETX_BEHAVIOR_NONE:
+        default:
+            return false;
+        }
+        // the delay is left as it is
+        dest.last_node = last_node;
+        dest.hop_count = current.hop_count + 1;
+        return true;
+    }
+}
+
+void OLSR_spf::run(bool incremental)
+{
+    build_graph();
+    int n = nodes_.size();
+    bool repair = incremental && valid_;
+
+    // The nodes to compute: all of them, or the ones whose incoming links
+    // changed, and their descendants on the previous tree
+    std::vector<NodeState> state(n, repair ? UNAFFECTED : OPEN);
+    if (repair)
+    {
+        std::vector<std::vector<int> > children(n);
+        for (int i = 0; i < n; i++)
+            if (nodes_[i].parent != -1)
+                children[nodes_[i].parent].push_back(i);
+        std::vector<int> stack;
+        for (int i = 0; i < n; i++)
+        {
+            const Node &node = nodes_[i];
+            bool changed = node.present != node.prev_present ||
+                (node.present && (node.direct != node.prev_direct || node.in != node.prev_in ||
+                                  (node.direct && !same_path(node.direct_label, node.prev_direct_label))));
+            if (!changed || state[i] == OPEN)
+                continue;
+            state[i] = OPEN;
+            stack.push_back(i);
+            while (!stack.empty())
+            {
+                int j = stack.back();
+                stack.pop_back();
+                for (size_t k = 0; k < children[j].size(); k++)
+                {
+                    if (state[children[j][k]] != OPEN)
+                    {
+                        state[children[j][k]] = OPEN;
+                        stack.push_back(children[j][k]);
+                    }
+                }
+            }
+        }
+    }
+
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, HeapEntryGreater> heap;
+    for (int i = 0; i < n; i++)
+    {
+        if (state[i] != OPEN)
+            continue;
+        Node &node = nodes_[i];
+        node.label = node.present && node.direct ? node.direct_label : unreachable();
+        node.parent = -1;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        if (state[i] != OPEN)
+            continue;
+        Node &node = nodes_[i];
+        if (!node.present)
+            continue;
+        // start from the paths of the unaffected nodes
+        if (repair)
+        {
+            for (size_t k = 0; k < node.in.size(); k++)
+            {
+                const Node &from = nodes_[node.in[k].from];
+                if (state[node.in[k].from] == UNAFFECTED && from.label.hop_count != -1 &&
+                        relax(node.label, from.label, node.in[k], from.addr))
+                    node.parent = node.in[k].from;
+            }
+        }
+        if (node.label.hop_count != -1)
+            heap.push(HeapEntry(cost(node.label), node.addr, i));
+    }
+
+    // If all the open nodes have cost equals to infinite, there is nothing
+    // left to do (this might be the case of a not fully connected graph)
+    num_recomputed_ = 0;
+    while (!heap.empty())
+    {
+        // Get the open node having best cost...
+        HeapEntry top = heap.top();
+        heap.pop();
+        int current = top.node;
+        if (state[current] == SETTLED || top.cost != cost(nodes_[current].label))
+            continue;
+        state[current] = SETTLED;
+        num_recomputed_++;
+
+        // for each node adjacent to 'current' that is not settled...
+        const Node &node = nodes_[current];
+        for (size_t k = 0; k < node.out.size(); k++)
+        {
+            int dest = node.out[k];
+            if (state[dest] == SETTLED)
+                continue;
+            Node &destNode = nodes_[dest];
+            if (relax(destNode.label, node.label, destNode.in[node.out_edge[k]], node.addr))
+            {
+                // an unaffected node has a shorter path now: reopen it
+                state[dest] = OPEN;
+                destNode.parent = current;
+                heap.push(HeapEntry(cost(destNode.label), destNode.addr, dest));
+            }
+        }
+    }
+
+    // Keep the graph for the next comparison
+    for (int i = 0; i < n; i++)
+    {
+        Node &node = nodes_[i];
+        node.prev_present = node.present;
+        node.prev_direct = node.direct;
+        node.prev_direct_label = node.direct_label;
+        node.prev_in.swap(node.in);
+    }
+    valid_ = true;
+}
@@ -0,0 +1,164 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+///
+/// \file   OLSR_spf.h
+/// \brief  Shortest path tree computation shared by OLSR and OLSR_ETX.
+///
+
+#ifndef __OLSR_spf_h__
+#define __OLSR_spf_h__
+
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "OpenAddressingHashTable.h"
+#include "OLSR_ETX_parameter.h"
+#include "OLSR_repositories.h"
+
+///
+/// \brief Shortest path tree of the node running OLSR, kept between route computations.
+///
+/// The graph is described anew before each computation: begin(), then add_edge()
+/// for every link, then run(). The one hop neighbors are added as directly
+/// connected nodes. The metric is the one of OLSR_ETX (see set_metric()); OLSR
+/// uses the ETX metric with a quality of 1 on every link, i.e. the hop count.
+///
+/// The nodes keep their numbers between computations, and run() compares the
+/// graph with the one of the previous computation. With incremental set, only
+/// the nodes whose incoming links changed and their descendants on the previous
+/// tree are recomputed, and the nodes whose paths get shorter through them; the
+/// others keep their paths. Otherwise the whole tree is computed exactly like
+/// the Dijkstra algorithm of OLSR_ETX did: nodes of equal cost are selected in
+/// address order, and the first path found wins among paths of equal cost.
+/// The repaired tree has the same costs as a computed one, but it may select
+/// another one of several paths of equal cost.
+///
+class OLSR_spf
+{
+  public:
+    ///
+    /// \brief The best path found to a node.
+    ///
+    struct Label
+    {
+        nsaddr_t last_node;  ///< Previous node on the path (the local interface for a directly connected node).
+        double quality;      ///< Link quality of the path.
+        double delay;        ///< Link delay of the path.
+        int hop_count;       ///< Number of hops, -1 if the node is not reachable.
+    };
+
+  protected:
+    struct AddressHash
+    {
+        unsigned int operator()(const nsaddr_t &addr) const { return addr.hash(); }
+    };
+
+    struct Edge
+    {
+        int from;            ///< The last node, i.e. the node at the start of the link.
+        double quality;
+        double delay;
+
+        bool operator==(const Edge &other) const { return from == other.from && quality == other.quality && delay == other.delay; }
+    };
+
+    struct AddedEdge
+    {
+        int to;
+        nsaddr_t last_node;
+        double quality;
+        double delay;
+    };
+
+    struct Node
+    {
+        nsaddr_t addr;
+        bool present;               ///< Whether the node is a destination of the current graph.
+        bool direct;                ///< Whether the node is directly connected.
+        Label direct_label;         ///< The path of the last direct link added.
+        std::vector<Edge> in;       ///< Incoming links, the first of each last node only.
+        std::vector<int> out;       ///< Indices of the nodes of the outgoing links.
+        std::vector<int> out_edge;  ///< Index of the outgoing links in the in vector of those nodes.
+        Label label;
+        int parent;                 ///< The previous node on the path, -1 if none or not a node.
+
+        // the graph of the previous computation
+        bool prev_present;
+        bool prev_direct;
+        Label prev_direct_label;
+        std::vector<Edge> prev_in;
+    };
+
+    std::vector<Node> nodes_;
+    OpenAddressingHashTable<nsaddr_t, int, AddressHash> index_;  ///< address -> index into nodes_
+    std::vector<AddedEdge> added_;  ///< Links added since begin(), in the order of add_edge() calls.
+    bool link_delay_;
+    int link_quality_;
+    bool valid_;                    ///< Whether the nodes hold the tree of the previous graph.
+    int num_recomputed_;
+
+    int get_node(const nsaddr_t &addr);
+    void build_graph();
+    double cost(const Label &label) const;
+    bool relax(Label &dest, const Label &current, const Edge &current_edge, const nsaddr_t &last_node);
+
+  public:
+    OLSR_spf();
+
+    ///
+    /// \brief Sets the metric, see OLSR_ETX_parameter.
+    ///
+    /// \param link_delay select paths by link delay rather than by link quality.
+    /// \param link_quality one of OLSR_ETX_BEHAVIOR_NONE, OLSR_ETX_BEHAVIOR_ETX and OLSR_ETX_BEHAVIOR_ML.
+    ///
+    void set_metric(bool link_delay, int link_quality);
+
+    /// Starts the description of a new graph.
+    void begin();
+
+    ///
+    /// \brief Adds a link to the graph.
+    ///
+    /// \param dest_node the node at the end of the link.
+    /// \param last_node the node at the start of the link, or the local interface of a direct link.
+    /// \param delay the link delay.
+    /// \param quality the link quality.
+    /// \param direct_connected whether dest_node is a one hop neighbor.
+    ///
+    void add_edge(const nsaddr_t &dest_node, const nsaddr_t &last_node, double delay, double quality, bool direct_connected);
+
+    /// Computes the shortest path tree of the graph, repairing the previous one if incremental is set.
+    void run(bool incremental);
+
+    /// Forgets the previous tree, so that the next run() computes the whole tree.
+    void invalidate() { valid_ = false; }
+
+    /// Returns the number of nodes, including the ones that are not in the current graph.
+    int get_num_nodes() const { return nodes_.size(); }
+    /// Returns the address of a node.
+    const nsaddr_t& get_address(int node) const { return nodes_[node].addr; }
+    /// Returns whether the node is a destination of a link of the current graph.
+    bool is_present(int node) const { return nodes_[node].present; }
+    /// Returns the path to a node.
+    const Label& get_label(int node) const { return nodes_[node].label; }
+    /// Returns the number of nodes the last run() computed a path to.
+    int get_num_recomputed() const { return num_recomputed_; }
+};
+
+#endif
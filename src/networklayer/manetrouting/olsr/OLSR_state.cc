@@ -29,14 +29,42 @@
 #include "OLSR_state.h"
 #include "OLSR.h"
 
+#include <algorithm>
+
+// Removes the given tuples from the set, keeping the order of the others
+template <class Tuple>
+static void erase_tuples(std::vector<Tuple*> &set, std::vector<Tuple*> &tuples)
+{
+    if (tuples.empty())
+        return;
+    std::sort(tuples.begin(), tuples.end());
+    typename std::vector<Tuple*>::iterator dest = set.begin();
+    for (typename std::vector<Tuple*>::iterator it = set.begin(); it != set.end(); it++)
+        if (!std::binary_search(tuples.begin(), tuples.end(), *it))
+            *dest++ = *it;
+    set.erase(dest, set.end());
+}
+
+// Removes the tuple from the set; returns false if it is not in the set
+template <class Tuple>
+static bool erase_tuple(std::vector<Tuple*> &set, Tuple *tuple)
+{
+    typename std::vector<Tuple*>::iterator it = std::find(set.begin(), set.end(), tuple);
+    if (it == set.end())
+        return false;
+    set.erase(it);
+    return true;
+}
+
 /********** MPR Selector Set Manipulation **********/
 
 OLSR_mprsel_tuple*
 OLSR_state::find_mprsel_tuple(const nsaddr_t &main_addr)
 {
-    for (mprselset_t::iterator it = mprselset_.begin(); it != mprselset_.end(); it++)
+    const OLSR_index<OLSR_mprsel_tuple>::Bucket& bucket = mprsel_index_.bucket(OLSR_hash(main_addr));
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_mprsel_tuple* tuple = *it;
+        OLSR_mprsel_tuple* tuple = bucket[i].second;
         if (tuple->main_addr() == main_addr)
             return tuple;
     }
@@ -46,34 +74,23 @@ OLSR_state::find_mprsel_tuple(const nsaddr_t &main_addr)
 void
 OLSR_state::erase_mprsel_tuple(OLSR_mprsel_tuple* tuple)
 {
-    for (mprselset_t::iterator it = mprselset_.begin(); it != mprselset_.end(); it++)
-    {
-        if (*it == tuple)
-        {
-            mprselset_.erase(it);
-            break;
-        }
-    }
+    if (erase_tuple(mprselset_, tuple))
+        mprsel_index_.erase(OLSR_hash(tuple->main_addr()), tuple);
 }
 
 bool
 OLSR_state::erase_mprsel_tuples(const nsaddr_t & main_addr)
 {
-    bool topologyChanged = false;
-    for (mprselset_t::iterator it = mprselset_.begin(); it != mprselset_.end();)
-    {
-        OLSR_mprsel_tuple* tuple = *it;
-        if (tuple->main_addr() == main_addr)
-        {
-            it = mprselset_.erase(it);
-            topologyChanged = true;
-            if (mprselset_.empty())
-                break;
-        }
-        else
-            it++;
-
-    }
+    uint32_t hash = OLSR_hash(main_addr);
+    std::vector<OLSR_mprsel_tuple*> tuples;
+    const OLSR_index<OLSR_mprsel_tuple>::Bucket& bucket = mprsel_index_.bucket(hash);
+    for (size_t i = 0; i < bucket.size(); i++)
+        if (bucket[i].second->main_addr() == main_addr)
+            tuples.push_back(bucket[i].second);
+    for (size_t i = 0; i < tuples.size(); i++)
+        mprsel_index_.erase(hash, tuples[i]);
+    bool topologyChanged = !tuples.empty();
+    erase_tuples(mprselset_, tuples);
     return topologyChanged;
 }
 
@@ -81,6 +98,7 @@ void
 OLSR_state::insert_mprsel_tuple(OLSR_mprsel_tuple* tuple)
 {
     mprselset_.push_back(tuple);
+    mprsel_index_.insert(OLSR_hash(tuple->main_addr()), tuple);
 }
 
 /********** Neighbor Set Manipulation **********/
@@ -88,9 +106,10 @@ OLSR_state::insert_mprsel_tuple(OLSR_mprsel_tuple* tuple)
 OLSR_nb_tuple*
 OLSR_state::find_nb_tuple(const nsaddr_t & main_addr)
 {
-    for (nbset_t::iterator it = nbset_.begin(); it != nbset_.end(); it++)
+    const OLSR_index<OLSR_nb_tuple>::Bucket& bucket = nb_index_.bucket(OLSR_hash(main_addr));
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_nb_tuple* tuple = *it;
+        OLSR_nb_tuple* tuple = bucket[i].second;
         if (tuple->nb_main_addr() == main_addr)
             return tuple;
     }
@@ -100,9 +119,10 @@ OLSR_state::find_nb_tuple(const nsaddr_t & main_addr)
 OLSR_nb_tuple*
 OLSR_state::find_sym_nb_tuple(const nsaddr_t & main_addr)
 {
-    for (nbset_t::iterator it = nbset_.begin(); it != nbset_.end(); it++)
+    const OLSR_index<OLSR_nb_tuple>::Bucket& bucket = nb_index_.bucket(OLSR_hash(main_addr));
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_nb_tuple* tuple = *it;
+        OLSR_nb_tuple* tuple = bucket[i].second;
         if (tuple->nb_main_addr() == main_addr && tuple->getStatus() == OLSR_STATUS_SYM)
             return tuple;
     }
@@ -112,9 +132,10 @@ OLSR_state::find_sym_nb_tuple(const nsaddr_t & main_addr)
 OLSR_nb_tuple*
 OLSR_state::find_nb_tuple(const nsaddr_t & main_addr, uint8_t willingness)
 {
-    for (nbset_t::iterator it = nbset_.begin(); it != nbset_.end(); it++)
+    const OLSR_index<OLSR_nb_tuple>::Bucket& bucket = nb_index_.bucket(OLSR_hash(main_addr));
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_nb_tuple* tuple = *it;
+        OLSR_nb_tuple* tuple = bucket[i].second;
         if (tuple->nb_main_addr() == main_addr && tuple->willingness() == willingness)
             return tuple;
     }
@@ -124,34 +145,23 @@ OLSR_state::find_nb_tuple(const nsaddr_t & main_addr, uint8_t willingness)
 void
 OLSR_state::erase_nb_tuple(OLSR_nb_tuple* tuple)
 {
-    for (nbset_t::iterator it = nbset_.begin(); it != nbset_.end(); it++)
-    {
-        if (*it == tuple)
-        {
-            nbset_.erase(it);
-            break;
-        }
-    }
+    if (erase_tuple(nbset_, tuple))
+        nb_index_.erase(OLSR_hash(tuple->nb_main_addr()), tuple);
 }
 
 void
 OLSR_state::erase_nb_tuple(const nsaddr_t & main_addr)
 {
-    for (nbset_t::iterator it = nbset_.begin(); it != nbset_.end(); it++)
-    {
-        OLSR_nb_tuple* tuple = *it;
-        if (tuple->nb_main_addr() == main_addr)
-        {
-            it = nbset_.erase(it);
-            break;
-        }
-    }
+    OLSR_nb_tuple* tuple = find_nb_tuple(main_addr);
+    if (tuple != NULL)
+        erase_nb_tuple(tuple);
 }
 
 void
 OLSR_state::insert_nb_tuple(OLSR_nb_tuple* tuple)
 {
     nbset_.push_back(tuple);
+    nb_index_.insert(OLSR_hash(tuple->nb_main_addr()), tuple);
 }
 
 /********** Neighbor 2 Hop Set Manipulation **********/
@@ -159,9 +169,10 @@ OLSR_state::insert_nb_tuple(OLSR_nb_tuple* tuple)
 OLSR_nb2hop_tuple*
 OLSR_state::find_nb2hop_tuple(const nsaddr_t & nb_main_addr, const nsaddr_t & nb2hop_addr)
 {
-    for (nb2hopset_t::iterator it = nb2hopset_.begin(); it != nb2hopset_.end(); it++)
+    const OLSR_index<OLSR_nb2hop_tuple>::Bucket& bucket = nb2hop_index_.bucket(OLSR_hash(nb_main_addr, nb2hop_addr));
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_nb2hop_tuple* tuple = *it;
+        OLSR_nb2hop_tuple* tuple = bucket[i].second;
         if (tuple->nb_main_addr() == nb_main_addr && tuple->nb2hop_addr() == nb2hop_addr)
             return tuple;
     }
@@ -171,55 +182,44 @@ OLSR_state::find_nb2hop_tuple(const nsaddr_t & nb_main_addr, const nsaddr_t & nb
 void
 OLSR_state::erase_nb2hop_tuple(OLSR_nb2hop_tuple* tuple)
 {
-    for (nb2hopset_t::iterator it = nb2hopset_.begin(); it != nb2hopset_.end(); it++)
-    {
-        if (*it == tuple)
-        {
-            nb2hopset_.erase(it);
-            break;
-        }
-    }
+    if (erase_tuple(nb2hopset_, tuple))
+        nb2hop_index_.erase(OLSR_hash(tuple->nb_main_addr(), tuple->nb2hop_addr()), tuple);
 }
 
 bool
 OLSR_state::erase_nb2hop_tuples(const nsaddr_t & nb_main_addr, const nsaddr_t & nb2hop_addr)
 {
-    bool returnValue = false;
-    for (nb2hopset_t::iterator it = nb2hopset_.begin(); it != nb2hopset_.end();)
+    uint32_t hash = OLSR_hash(nb_main_addr, nb2hop_addr);
+    std::vector<OLSR_nb2hop_tuple*> tuples;
+    const OLSR_index<OLSR_nb2hop_tuple>::Bucket& bucket = nb2hop_index_.bucket(hash);
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_nb2hop_tuple* tuple = *it;
+        OLSR_nb2hop_tuple* tuple = bucket[i].second;
         if (tuple->nb_main_addr() == nb_main_addr && tuple->nb2hop_addr() == nb2hop_addr)
-        {
-            it = nb2hopset_.erase(it);
-            returnValue = true;
-            if (nb2hopset_.empty())
-                break;
-        }
-        else
-            it++;
-
+            tuples.push_back(tuple);
     }
+    for (size_t i = 0; i < tuples.size(); i++)
+        nb2hop_index_.erase(hash, tuples[i]);
+    bool returnValue = !tuples.empty();
+    erase_tuples(nb2hopset_, tuples);
     return returnValue;
 }
 
 bool
 OLSR_state::erase_nb2hop_tuples(const nsaddr_t & nb_main_addr)
 {
-    bool topologyChanged = false;
-    for (nb2hopset_t::iterator it = nb2hopset_.begin(); it != nb2hopset_.end();)
+    std::vector<OLSR_nb2hop_tuple*> tuples;
+    for (nb2hopset_t::iterator it = nb2hopset_.begin(); it != nb2hopset_.end(); it++)
     {
         OLSR_nb2hop_tuple* tuple = *it;
         if (tuple->nb_main_addr() == nb_main_addr)
         {
-            it = nb2hopset_.erase(it);
-            topologyChanged = true;
-            if (nb2hopset_.empty())
-                break;
+            nb2hop_index_.erase(OLSR_hash(tuple->nb_main_addr(), tuple->nb2hop_addr()), tuple);
+            tuples.push_back(tuple);
         }
-        else
-            it++;
-
     }
+    bool topologyChanged = !tuples.empty();
+    erase_tuples(nb2hopset_, tuples);
     return topologyChanged;
 }
 
@@ -227,6 +227,7 @@ void
 OLSR_state::insert_nb2hop_tuple(OLSR_nb2hop_tuple* tuple)
 {
     nb2hopset_.push_back(tuple);
+    nb2hop_index_.insert(OLSR_hash(tuple->nb_main_addr(), tuple->nb2hop_addr()), tuple);
 }
 
 /********** MPR Set Manipulation **********/
@@ -255,9 +256,10 @@ OLSR_state::clear_mprset()
 OLSR_dup_tuple*
 OLSR_state::find_dup_tuple(const nsaddr_t & addr, uint16_t seq_num)
 {
-    for (dupset_t::iterator it = dupset_.begin(); it != dupset_.end(); it++)
+    const OLSR_index<OLSR_dup_tuple>::Bucket& bucket = dup_index_.bucket(OLSR_hash(addr, seq_num));
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_dup_tuple* tuple = *it;
+        OLSR_dup_tuple* tuple = bucket[i].second;
         if (tuple->getAddr() == addr && tuple->seq_num() == seq_num)
             return tuple;
     }
@@ -267,20 +269,15 @@ OLSR_state::find_dup_tuple(const nsaddr_t & addr, uint16_t seq_num)
 void
 OLSR_state::erase_dup_tuple(OLSR_dup_tuple* tuple)
 {
-    for (dupset_t::iterator it = dupset_.begin(); it != dupset_.end(); it++)
-    {
-        if (*it == tuple)
-        {
-            dupset_.erase(it);
-            break;
-        }
-    }
+    if (erase_tuple(dupset_, tuple))
+        dup_index_.erase(OLSR_hash(tuple->getAddr(), tuple->seq_num()), tuple);
 }
 
 void
 OLSR_state::insert_dup_tuple(OLSR_dup_tuple* tuple)
 {
     dupset_.push_back(tuple);
+    dup_index_.insert(OLSR_hash(tuple->getAddr(), tuple->seq_num()), tuple);
 }
 
 /********** Link Set Manipulation **********/
@@ -288,9 +285,10 @@ OLSR_state::insert_dup_tuple(OLSR_dup_tuple* tuple)
 OLSR_link_tuple*
 OLSR_state::find_link_tuple(const nsaddr_t & iface_addr)
 {
-    for (linkset_t::iterator it = linkset_.begin(); it != linkset_.end(); it++)
+    const OLSR_index<OLSR_link_tuple>::Bucket& bucket = link_index_.bucket(OLSR_hash(iface_addr));
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_link_tuple* tuple = *it;
+        OLSR_link_tuple* tuple = bucket[i].second;
         if (tuple->nb_iface_addr() == iface_addr)
             return tuple;
     }
@@ -300,37 +298,24 @@ OLSR_state::find_link_tuple(const nsaddr_t & iface_addr)
 OLSR_link_tuple*
 OLSR_state::find_sym_link_tuple(const nsaddr_t & iface_addr, double now)
 {
-    for (linkset_t::iterator it = linkset_.begin(); it != linkset_.end(); it++)
-    {
-        OLSR_link_tuple* tuple = *it;
-        if (tuple->nb_iface_addr() == iface_addr)
-        {
-            if (tuple->sym_time() > now)
-                return tuple;
-            else
-                break;
-        }
-    }
+    OLSR_link_tuple* tuple = find_link_tuple(iface_addr);
+    if (tuple != NULL && tuple->sym_time() > now)
+        return tuple;
     return NULL;
 }
 
 void
 OLSR_state::erase_link_tuple(OLSR_link_tuple* tuple)
 {
-    for (linkset_t::iterator it = linkset_.begin(); it != linkset_.end(); it++)
-    {
-        if (*it == tuple)
-        {
-            linkset_.erase(it);
-            break;
-        }
-    }
+    if (erase_tuple(linkset_, tuple))
+        link_index_.erase(OLSR_hash(tuple->nb_iface_addr()), tuple);
 }
 
 void
 OLSR_state::insert_link_tuple(OLSR_link_tuple* tuple)
 {
     linkset_.push_back(tuple);
+    link_index_.insert(OLSR_hash(tuple->nb_iface_addr()), tuple);
 }
 
 /********** Topology Set Manipulation **********/
@@ -338,9 +323,10 @@ OLSR_state::insert_link_tuple(OLSR_link_tuple* tuple)
 OLSR_topology_tuple*
 OLSR_state::find_topology_tuple(const nsaddr_t & dest_addr, const nsaddr_t & last_addr)
 {
-    for (topologyset_t::iterator it = topologyset_.begin(); it != topologyset_.end(); it++)
+    const OLSR_index<OLSR_topology_tuple>::Bucket& bucket = topology_index_.bucket(OLSR_hash(dest_addr, last_addr));
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_topology_tuple* tuple = *it;
+        OLSR_topology_tuple* tuple = bucket[i].second;
         if (tuple->dest_addr() == dest_addr && tuple->last_addr() == last_addr)
             return tuple;
     }
@@ -350,9 +336,10 @@ OLSR_state::find_topology_tuple(const nsaddr_t & dest_addr, const nsaddr_t & las
 OLSR_topology_tuple*
 OLSR_state::find_newer_topology_tuple(const nsaddr_t &last_addr, uint16_t ansn)
 {
-    for (topologyset_t::iterator it = topologyset_.begin(); it != topologyset_.end(); it++)
+    const OLSR_index<OLSR_topology_tuple>::Bucket& bucket = topology_tuples_by_last(last_addr);
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_topology_tuple* tuple = *it;
+        OLSR_topology_tuple* tuple = bucket[i].second;
         if (tuple->last_addr() == last_addr && tuple->seq() > ansn)
             return tuple;
     }
@@ -362,15 +349,22 @@ OLSR_state::find_newer_topology_tuple(const nsaddr_t &last_addr, uint16_t ansn)
 void
 OLSR_state::erase_topology_tuple(OLSR_topology_tuple* tuple)
 {
-    for (topologyset_t::iterator it = topologyset_.begin(); it != topologyset_.end(); it++)
+    if (erase_tuple(topologyset_, tuple))
     {
-        if (*it == tuple)
-        {
-            topologyset_.erase(it);
-            break;
-        }
+        topology_index_.erase(OLSR_hash(tuple->dest_addr(), tuple->last_addr()), tuple);
+        topology_last_index_.erase(OLSR_hash(tuple->last_addr()), tuple);
     }
 }
+
+topologyset_t::iterator
+OLSR_state::erase_topology_tuple(topologyset_t::iterator it)
+{
+    OLSR_topology_tuple* tuple = *it;
+    topology_index_.erase(OLSR_hash(tuple->dest_addr(), tuple->last_addr()), tuple);
+    topology_last_index_.erase(OLSR_hash(tuple->last_addr()), tuple);
+    return topologyset_.erase(it);
+}
+
 std::ostream& operator<<(std::ostream& out, const OLSR_topology_tuple& tuple)
 {
     out << "Tuple index: " << tuple.index;
@@ -406,25 +400,29 @@ OLSR_state::print_topology_tuples_across(const nsaddr_t & last_addr)
 void
 OLSR_state::erase_older_topology_tuples(const nsaddr_t & last_addr, uint16_t ansn)
 {
-    for (topologyset_t::iterator it = topologyset_.begin(); it != topologyset_.end();)
+    std::vector<OLSR_topology_tuple*> tuples;
+    const OLSR_index<OLSR_topology_tuple>::Bucket& bucket = topology_tuples_by_last(last_addr);
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_topology_tuple* tuple = *it;
+        OLSR_topology_tuple* tuple = bucket[i].second;
         if (tuple->last_addr() == last_addr && tuple->seq() < ansn)
-        {
-            it = topologyset_.erase(it);
-            if (topologyset_.empty())
-                break;
-        }
-        else
-            it++;
-
+            tuples.push_back(tuple);
+    }
+    for (size_t i = 0; i < tuples.size(); i++)
+    {
+        OLSR_topology_tuple* tuple = tuples[i];
+        topology_index_.erase(OLSR_hash(tuple->dest_addr(), tuple->last_addr()), tuple);
+        topology_last_index_.erase(OLSR_hash(tuple->last_addr()), tuple);
     }
+    erase_tuples(topologyset_, tuples);
 }
 
 void
 OLSR_state::insert_topology_tuple(OLSR_topology_tuple* tuple)
 {
     topologyset_.push_back(tuple);
+    topology_index_.insert(OLSR_hash(tuple->dest_addr(), tuple->last_addr()), tuple);
+    topology_last_index_.insert(OLSR_hash(tuple->last_addr()), tuple);
 }
 
 /********** Interface Association Set Manipulation **********/
@@ -432,11 +430,10 @@ OLSR_state::insert_topology_tuple(OLSR_topology_tuple* tuple)
 OLSR_iface_assoc_tuple*
 OLSR_state::find_ifaceassoc_tuple(const nsaddr_t & iface_addr)
 {
-    for (ifaceassocset_t::iterator it = ifaceassocset_.begin();
-            it != ifaceassocset_.end();
-            it++)
+    const OLSR_index<OLSR_iface_assoc_tuple>::Bucket& bucket = ifaceassoc_index_.bucket(OLSR_hash(iface_addr));
+    for (size_t i = 0; i < bucket.size(); i++)
     {
-        OLSR_iface_assoc_tuple* tuple = *it;
+        OLSR_iface_assoc_tuple* tuple = bucket[i].second;
         if (tuple->iface_addr() == iface_addr)
             return tuple;
     }
@@ -446,22 +443,15 @@ OLSR_state::find_ifaceassoc_tuple(const nsaddr_t & iface_addr)
 void
 OLSR_state::erase_ifaceassoc_tuple(OLSR_iface_assoc_tuple* tuple)
 {
-    for (ifaceassocset_t::iterator it = ifaceassocset_.begin();
-            it != ifaceassocset_.end();
-            it++)
-    {
-        if (*it == tuple)
-        {
-            ifaceassocset_.erase(it);
-            break;
-        }
-    }
+    if (erase_tuple(ifaceassocset_, tuple))
+        ifaceassoc_index_.erase(OLSR_hash(tuple->iface_addr()), tuple);
 }
 
 void
 OLSR_state::insert_ifaceassoc_tuple(OLSR_iface_assoc_tuple* tuple)
 {
     ifaceassocset_.push_back(tuple);
+    ifaceassoc_index_.insert(OLSR_hash(tuple->iface_addr()), tuple);
 }
 
 void OLSR_state::clear_all()
@@ -493,6 +483,14 @@ void OLSR_state::clear_all()
     ifaceassocset_.clear();
     mprset_.clear();
 
+    link_index_.clear();
+    nb_index_.clear();
+    nb2hop_index_.clear();
+    topology_index_.clear();
+    topology_last_index_.clear();
+    mprsel_index_.clear();
+    dup_index_.clear();
+    ifaceassoc_index_.clear();
 }
 
 OLSR_state::OLSR_state(OLSR_state * st)
@@ -500,25 +498,25 @@ OLSR_state::OLSR_state(OLSR_state * st)
     for (linkset_t::iterator it = st->linkset_.begin(); it != st->linkset_.end(); it++)
     {
         OLSR_link_tuple* tuple = *it;
-        linkset_.push_back(tuple->dup());
+        insert_link_tuple(tuple->dup());
     }
 
     for (nbset_t::iterator it = st->nbset_.begin(); it != st->nbset_.end(); it++)
     {
         OLSR_nb_tuple* tuple = *it;
-        nbset_.push_back(tuple->dup());
+        insert_nb_tuple(tuple->dup());
     }
 
     for (nb2hopset_t::iterator it = st->nb2hopset_.begin(); it != st->nb2hopset_.end(); it++)
     {
         OLSR_nb2hop_tuple* tuple = *it;
-        nb2hopset_.push_back(tuple->dup());
+        insert_nb2hop_tuple(tuple->dup());
     }
 
     for (topologyset_t::iterator it = st->topologyset_.begin(); it != st->topologyset_.end(); it++)
     {
         OLSR_topology_tuple* tuple = *it;
-        topologyset_.push_back(tuple->dup());
+        insert_topology_tuple(tuple->dup());
     }
 
     for (mprset_t::iterator it = st->mprset_.begin(); it != st->mprset_.end(); it++)
@@ -529,19 +527,19 @@ OLSR_state::OLSR_state(OLSR_state * st)
     for (mprselset_t::iterator it = st->mprselset_.begin(); it != st->mprselset_.end(); it++)
     {
         OLSR_mprsel_tuple* tuple = *it;
-        mprselset_.push_back(tuple->dup());
+        insert_mprsel_tuple(tuple->dup());
     }
 
     for (dupset_t::iterator it = st->dupset_.begin(); it != st->dupset_.end(); it++)
     {
         OLSR_dup_tuple* tuple = *it;
-        dupset_.push_back(tuple->dup());
+        insert_dup_tuple(tuple->dup());
     }
 
     for (ifaceassocset_t::iterator it = st->ifaceassocset_.begin(); it != st->ifaceassocset_.end(); it++)
     {
         OLSR_iface_assoc_tuple* tuple = *it;
-        ifaceassocset_.push_back(tuple->dup());
+        insert_ifaceassoc_tuple(tuple->dup());
     }
 }
 
@@ -550,4 +548,3 @@ OLSR_state::~OLSR_state()
 {
     clear_all();
 }
-
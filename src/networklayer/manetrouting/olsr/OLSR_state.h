@@ -29,6 +29,7 @@
 #include "INETDefs.h"
 
 #include "OLSR_repositories.h"
+#include "OLSR_index.h"
 
 /// This class encapsulates all data structures needed for maintaining internal state of an OLSR node.
 class OLSR_state : public cObject
@@ -45,6 +46,17 @@ class OLSR_state : public cObject
     dupset_t    dupset_;    ///< Duplicate Set (RFC 3626, section 3.4).
     ifaceassocset_t ifaceassocset_; ///< Interface Association Set (RFC 3626, section 4.1).
 
+    // Hash indices of the sets, maintained by the insert and erase functions
+    // (the sets must not be modified directly)
+    OLSR_index<OLSR_link_tuple>     link_index_;        ///< Link Set by neighbor interface address.
+    OLSR_index<OLSR_nb_tuple>       nb_index_;          ///< Neighbor Set by neighbor main address.
+    OLSR_index<OLSR_nb2hop_tuple>   nb2hop_index_;      ///< 2-hop Neighbor Set by neighbor and 2-hop neighbor address.
+    OLSR_index<OLSR_topology_tuple> topology_index_;    ///< Topology Set by destination and last address.
+    OLSR_index<OLSR_topology_tuple> topology_last_index_;   ///< Topology Set by last address.
+    OLSR_index<OLSR_mprsel_tuple>   mprsel_index_;      ///< MPR Selector Set by main address.
+    OLSR_index<OLSR_dup_tuple>      dup_index_;         ///< Duplicate Set by address and sequence number.
+    OLSR_index<OLSR_iface_assoc_tuple>  ifaceassoc_index_;  ///< Interface Association Set by interface address.
+
     inline  linkset_t&      linkset()   { return linkset_; }
     inline  mprset_t&       mprset()    { return mprset_; }
     inline  mprselset_t&        mprselset() { return mprselset_; }
@@ -88,6 +100,8 @@ class OLSR_state : public cObject
     OLSR_topology_tuple*    find_topology_tuple(const nsaddr_t &, const  nsaddr_t &);
     OLSR_topology_tuple*    find_newer_topology_tuple(const nsaddr_t &, uint16_t);
     void            erase_topology_tuple(OLSR_topology_tuple*);
+    topologyset_t::iterator erase_topology_tuple(topologyset_t::iterator);
+    const OLSR_index<OLSR_topology_tuple>::Bucket&  topology_tuples_by_last(const nsaddr_t &last_addr) const { return topology_last_index_.bucket(OLSR_hash(last_addr)); }
     void            erase_older_topology_tuples(const nsaddr_t &, uint16_t);
     void             print_topology_tuples_to(const nsaddr_t & dest_addr);
     void             print_topology_tuples_across(const nsaddr_t & last_addr);
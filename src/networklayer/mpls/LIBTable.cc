@@ -17,9 +17,22 @@
 #include "LIBTable.h"
 #include "XMLUtils.h"
 #include "RoutingTableAccess.h"
+#include "InterfaceTableAccess.h"
 
 Define_Module(LIBTable);
 
+LIBTable::LIBTable() : entryTable(NULL)
+{
+    ift = NULL;
+    maxLabel = 0;
+}
+
+LIBTable::~LIBTable()
+{
+    for (unsigned int i = 0; i < lib.size(); i++)
+        delete lib[i];
+}
+
 void LIBTable::initialize(int stage)
 {
     if (stage==0)
@@ -31,12 +44,13 @@ void LIBTable::initialize(int stage)
         RoutingTableAccess routingTableAccess;
         IRoutingTable *rt = routingTableAccess.get();
         routerId = rt->getRouterId();
+        ift = InterfaceTableAccess().get();
 
         // read configuration
 
         readTableFromXML(par("config").xmlValue());
 
-        WATCH_VECTOR(lib);
+        WATCH_PTRVECTOR(lib);
     }
 }
 
@@ -45,26 +59,103 @@ void LIBTable::handleMessage(cMessage *)
     ASSERT(false);
 }
 
+int LIBTable::getInterfaceId(const std::string& interfaceName)
+{
+    InterfaceEntry *ie = ift ? ift->getInterfaceByName(interfaceName.c_str()) : NULL;
+    return ie ? ie->getInterfaceId() : -1;
+}
+
+void LIBTable::addEntry(LIBEntry *entry)
+{
+    entry->inInterfaceId = getInterfaceId(entry->inInterface);
+    entry->outInterfaceId = getInterfaceId(entry->outInterface);
+    entry->nextWithSameLabel = NULL;
+
+    if (entry->inInterfaceId != -1)
+    {
+        if (lookup(makeKey(entry->inInterfaceId, entry->inLabel)))
+            throw cRuntimeError(this, "Duplicate LIB entry for label %d on interface %s", entry->inLabel, entry->inInterface.c_str());
+        entryTable.insert(makeKey(entry->inInterfaceId, entry->inLabel), entry);
+    }
+
+    // append to the list of entries with this label
+    LIBEntry *last = lookup(makeKey(-1, entry->inLabel));
+    if (!last)
+        entryTable.insert(makeKey(-1, entry->inLabel), entry);
+    else
+    {
+        while (last->nextWithSameLabel)
+            last = last->nextWithSameLabel;
+        last->nextWithSameLabel = entry;
+    }
+
+    entry->index = lib.size();
+    lib.push_back(entry);
+}
+
+void LIBTable::deleteEntry(LIBEntry *entry)
+{
+    if (entry->inInterfaceId != -1)
+        entryTable.remove(makeKey(entry->inInterfaceId, entry->inLabel));
+
+    // unlink from the list of entries with this label
+    LIBEntry *first = lookup(makeKey(-1, entry->inLabel));
+    ASSERT(first);
+    if (first == entry)
+    {
+        entryTable.remove(makeKey(-1, entry->inLabel));
+        if (entry->nextWithSameLabel)
+            entryTable.insert(makeKey(-1, entry->inLabel), entry->nextWithSameLabel);
+    }
+    else
+    {
+        LIBEntry *prev = first;
+        while (prev->nextWithSameLabel != entry)
+            prev = prev->nextWithSameLabel;
+        prev->nextWithSameLabel = entry->nextWithSameLabel;
+    }
+
+    // move the last entry into its place
+    lib[entry->index] = lib.back();
+    lib[entry->index]->index = entry->index;
+    lib.pop_back();
+    delete entry;
+}
+
+const LIBTable::LIBEntry *LIBTable::findEntry(int inInterfaceId, int inLabel) const
+{
+    return lookup(makeKey(inInterfaceId, inLabel));
+}
+
 bool LIBTable::resolveLabel(std::string inInterface, int inLabel,
         LabelOpVector& outLabel, std::string& outInterface, int& color)
 {
     bool any = (inInterface.length() == 0);
 
-    for (unsigned int i = 0; i < lib.size(); i++)
+    const LIBEntry *entry = NULL;
+    if (any)
+        entry = lookup(makeKey(-1, inLabel));
+    else
     {
-        if (!any && lib[i].inInterface != inInterface)
-            continue;
-
-        if (lib[i].inLabel != inLabel)
-            continue;
+        int inInterfaceId = getInterfaceId(inInterface);
+        if (inInterfaceId != -1)
+            entry = lookup(makeKey(inInterfaceId, inLabel));
+        else
+        {
+            // not an interface of this router, search by name
+            for (entry = lookup(makeKey(-1, inLabel)); entry; entry = entry->nextWithSameLabel)
+                if (entry->inInterface == inInterface)
+                    break;
+        }
+    }
 
-        outLabel = lib[i].outLabel;
-        outInterface = lib[i].outInterface;
-        color = lib[i].color;
+    if (!entry)
+        return false;
 
-        return true;
-    }
-    return false;
+    outLabel = entry->outLabel;
+    outInterface = entry->outInterface;
+    color = entry->color;
+    return true;
 }
 
 int LIBTable::installLibEntry(int inLabel, std::string inInterface, const LabelOpVector& outLabel,
@@ -72,44 +163,53 @@ int LIBTable::installLibEntry(int inLabel, std::string inInterface, const LabelO
 {
     if (inLabel == -1)
     {
-        LIBEntry newItem;
-        newItem.inLabel = ++maxLabel;
-        newItem.inInterface = inInterface;
-        newItem.outLabel = outLabel;
-        newItem.outInterface = outInterface;
-        newItem.color = color;
-        lib.push_back(newItem);
-        return newItem.inLabel;
+        LIBEntry *newItem = new LIBEntry();
+        newItem->inLabel = ++maxLabel;
+        newItem->inInterface = inInterface;
+        newItem->outLabel = outLabel;
+        newItem->outInterface = outInterface;
+        newItem->color = color;
+        addEntry(newItem);
+        return newItem->inLabel;
     }
     else
     {
-        for (unsigned int i = 0; i < lib.size(); i++)
+        // update the first entry with this label
+        LIBEntry *entry = lookup(makeKey(-1, inLabel));
+        ASSERT(entry);
+
+        if (entry->inInterface != inInterface)
         {
-            if (lib[i].inLabel != inLabel)
-                continue;
-
-            lib[i].inInterface = inInterface;
-            lib[i].outLabel = outLabel;
-            lib[i].outInterface = outInterface;
-            lib[i].color = color;
-            return inLabel;
+            int inInterfaceId = getInterfaceId(inInterface);
+            if (inInterfaceId != entry->inInterfaceId)
+            {
+                if (inInterfaceId != -1 && lookup(makeKey(inInterfaceId, inLabel)))
+                    throw cRuntimeError(this, "Duplicate LIB entry for label %d on interface %s", inLabel, inInterface.c_str());
+                if (entry->inInterfaceId != -1)
+                    entryTable.remove(makeKey(entry->inInterfaceId, inLabel));
+                if (inInterfaceId != -1)
+                    entryTable.insert(makeKey(inInterfaceId, inLabel), entry);
+                entry->inInterfaceId = inInterfaceId;
+            }
+            entry->inInterface = inInterface;
         }
-        ASSERT(false);
-        return 0; // prevent warning
+        if (entry->outInterface != outInterface)
+        {
+            entry->outInterface = outInterface;
+            entry->outInterfaceId = getInterfaceId(outInterface);
+        }
+        entry->outLabel = outLabel;
+        entry->color = color;
+        return inLabel;
     }
 }
 
 void LIBTable::removeLibEntry(int inLabel)
 {
-    for (unsigned int i = 0; i < lib.size(); i++)
-    {
-        if (lib[i].inLabel != inLabel)
-            continue;
-
-        lib.erase(lib.begin() + i);
-        return;
-    }
-    ASSERT(false);
+    // remove the first entry with this label
+    LIBEntry *entry = lookup(makeKey(-1, inLabel));
+    ASSERT(entry);
+    deleteEntry(entry);
 }
 
 void LIBTable::readTableFromXML(const cXMLElement* libtable)
@@ -124,11 +224,11 @@ void LIBTable::readTableFromXML(const cXMLElement* libtable)
 
         checkTags(&entry, "inLabel inInterface outLabel outInterface color");
 
-        LIBEntry newItem;
-        newItem.inLabel = getParameterIntValue(&entry, "inLabel");
-        newItem.inInterface = getParameterStrValue(&entry, "inInterface");
-        newItem.outInterface = getParameterStrValue(&entry, "outInterface");
-        newItem.color = getParameterIntValue(&entry, "color", 0);
+        LIBEntry *newItem = new LIBEntry();
+        newItem->inLabel = getParameterIntValue(&entry, "inLabel");
+        newItem->inInterface = getParameterStrValue(&entry, "inInterface");
+        newItem->outInterface = getParameterStrValue(&entry, "outInterface");
+        newItem->color = getParameterIntValue(&entry, "color", 0);
 
         cXMLElementList ops = getUniqueChild(&entry, "outLabel")->getChildrenByTagName("op");
         for (cXMLElementList::iterator oit=ops.begin(); oit != ops.end(); oit++)
@@ -161,15 +261,15 @@ void LIBTable::readTableFromXML(const cXMLElement* libtable)
             else
                 ASSERT(false);
 
-            newItem.outLabel.push_back(l);
+            newItem->outLabel.push_back(l);
         }
 
-        lib.push_back(newItem);
+        ASSERT(newItem->inLabel > 0);
 
-        ASSERT(newItem.inLabel > 0);
+        if (newItem->inLabel > maxLabel)
+            maxLabel = newItem->inLabel;
 
-        if (newItem.inLabel > maxLabel)
-            maxLabel = newItem.inLabel;
+        addEntry(newItem);
     }
 }
 
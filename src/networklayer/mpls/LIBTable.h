@@ -22,9 +22,12 @@
 #include "INETDefs.h"
 
 #include "ConstType.h"
+#include "OpenAddressingHashTable.h"
 #include "IPv4Address.h"
 #include "IPv4Datagram.h"
 
+class IInterfaceTable;
+
 // label operations
 #define PUSH_OPER              0
 #define SWAP_OPER              1
@@ -42,7 +45,19 @@ struct LabelOp
 typedef std::vector<LabelOp> LabelOpVector;
 
 /**
- * TODO documentation
+ * The Label Information Base of an LSR.
+ *
+ * Entries are indexed in an OpenAddressingHashTable keyed on (incoming
+ * interface id, incoming label), so that resolving the
+ * label of a packet takes constant time. The same table also maps each
+ * label to the list of entries with that label, in the order they were
+ * installed; it is used for lookups without an incoming interface and by
+ * installLibEntry() and removeLibEntry(), which identify entries by their
+ * label only.
+ *
+ * Interface names that are not names of interfaces of this router (e.g.
+ * "any") are kept as strings, and their entries can only be found by name
+ * or by label.
  */
 class INET_API LIBTable: public cSimpleModule
 {
@@ -57,12 +72,24 @@ class INET_API LIBTable: public cSimpleModule
 
             // FIXME colors in nam, temporary solution
             int color;
+
+            // ids of inInterface and outInterface, or -1 if they are not interfaces of this router
+            int inInterfaceId;
+            int outInterfaceId;
+
+            // maintained by LIBTable
+            int index;                      // position in the lib vector
+            LIBEntry *nextWithSameLabel;    // next entry with the same inLabel, in order of installation
         };
 
     protected:
         IPv4Address routerId;
+        IInterfaceTable *ift;
         int maxLabel;
-        std::vector<LIBEntry> lib;
+        std::vector<LIBEntry *> lib;    // all entries, in no particular order
+        // the key is made of the interface id and the label, with interface id -1
+        // for the first entry of the list of entries with the label
+        OpenAddressingHashTable<uint64, LIBEntry *> entryTable;
 
     protected:
         virtual void initialize(int stage);
@@ -72,11 +99,30 @@ class INET_API LIBTable: public cSimpleModule
         // static configuration
         virtual void readTableFromXML(const cXMLElement* libtable);
 
+        // entry management; addEntry() takes ownership of the entry
+        virtual void addEntry(LIBEntry *entry);
+        virtual void deleteEntry(LIBEntry *entry);
+        virtual int getInterfaceId(const std::string& interfaceName);
+
+        // hash table
+        static uint64 makeKey(int interfaceId, int label) {return ((uint64)(uint32)interfaceId << 32) | (uint32)label;}
+        LIBEntry *lookup(uint64 key) const {return entryTable.find(key);}
+
     public:
+        LIBTable();
+        virtual ~LIBTable();
+
         // label management
         virtual bool resolveLabel(std::string inInterface, int inLabel,
                           LabelOpVector& outLabel, std::string& outInterface, int& color);
 
+        /**
+         * Returns the entry for the given label received on the interface with
+         * the given id, or NULL if there is no such entry. The entry must not
+         * be modified, and it is only valid until the LIB changes.
+         */
+        virtual const LIBEntry *findEntry(int inInterfaceId, int inLabel) const;
+
         virtual int installLibEntry(int inLabel, std::string inInterface, const LabelOpVector& outLabel,
                             std::string outInterface, int color);
 
@@ -225,11 +225,10 @@ void MPLS::processMPLSPacketFromL2(MPLSPacket *mplsPacket)
 {
     int gateIndex = mplsPacket->getArrivalGate()->getIndex();
     InterfaceEntry *ie = ift->getInterfaceByNetworkLayerGateIndex(gateIndex);
-    std::string senderInterface = ie->getName();
     ASSERT(mplsPacket->hasLabel());
     int oldLabel = mplsPacket->getTopLabel();
 
-    EV << "Received " << mplsPacket << " from L2, label=" << oldLabel << " inInterface=" << senderInterface << endl;
+    EV << "Received " << mplsPacket << " from L2, label=" << oldLabel << " inInterface=" << ie->getName() << endl;
 
     if (oldLabel==-1)
     {
@@ -243,12 +242,9 @@ void MPLS::processMPLSPacketFromL2(MPLSPacket *mplsPacket)
         return;
     }
 
-    LabelOpVector outLabel;
-    std::string outInterface;
-    int color;
-
-    bool found = lt->resolveLabel(senderInterface, oldLabel, outLabel, outInterface, color);
-    if (!found)
+    // the entry stays valid while the packet is processed, as the LIB is not modified meanwhile
+    const LIBTable::LIBEntry *entry = lt->findEntry(ie->getInterfaceId(), oldLabel);
+    if (!entry)
     {
         EV << "discarding packet, incoming label not resolved" << endl;
 
@@ -256,7 +252,12 @@ void MPLS::processMPLSPacketFromL2(MPLSPacket *mplsPacket)
         return;
     }
 
-    int outgoingPort = ift->getInterfaceByName(outInterface.c_str())->getNetworkLayerGateIndex();
+    const LabelOpVector& outLabel = entry->outLabel;
+    const std::string& outInterface = entry->outInterface;
+    int color = entry->color;
+
+    InterfaceEntry *outInterfaceEntry = entry->outInterfaceId != -1 ? ift->getInterfaceById(entry->outInterfaceId) : ift->getInterfaceByName(outInterface.c_str());
+    int outgoingPort = outInterfaceEntry->getNetworkLayerGateIndex();
 
     doStackOps(mplsPacket, outLabel);
 
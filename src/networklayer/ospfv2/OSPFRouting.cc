@@ -62,6 +62,8 @@ void OSPFRouting::initialize(int stage)
 
         // Get routerId
         ospfRouter = new OSPF::Router(rt->getRouterId(), this);
+        ospfRouter->setIncrementalSPF(par("incrementalSPF").boolValue());
+        ospfRouter->setRecordSPFDuration(par("recordSPFDuration").boolValue());
 
         // read the OSPF AS configuration
         cXMLElement *ospfConfig = par("ospfConfig").xmlValue();
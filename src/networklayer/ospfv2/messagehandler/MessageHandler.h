@@ -43,6 +43,8 @@ private:
 public:
     MessageHandler(Router* containingRouter, cSimpleModule* containingModule);
 
+    cSimpleModule* getOSPFModule()  { return ospfModule; }
+
     void    messageReceived(cMessage* message);
     void    handleTimer(OSPFTimer* timer);
 
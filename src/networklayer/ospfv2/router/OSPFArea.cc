@@ -17,7 +17,11 @@
 
 #include "OSPFArea.h"
 #include "OSPFRouter.h"
+#include <algorithm>
+#include <iterator>
 #include <memory.h>
+#include <set>
+#include <time.h>
 
 OSPF::Area::Area(OSPF::AreaID id) :
     areaID(id),
@@ -27,6 +31,8 @@ OSPF::Area::Area(OSPF::AreaID id) :
     spfTreeRoot(NULL),
     parentRouter(NULL)
 {
+    spfDurationSignal = cComponent::registerSignal("spfDuration");
+    spfVerticesSignal = cComponent::registerSignal("spfVertices");
 }
 
 OSPF::Area::~Area()
@@ -1346,15 +1352,326 @@ OSPF::SummaryLSA* OSPF::Area::originateSummaryLSA(const OSPF::SummaryLSA* summar
     return NULL;
 }
 
+namespace OSPF {
+
+/**
+ * Index of the network destinations of a routing table under construction,
+ * replacing the linear scans of the shortest path tree calculation. It finds
+ * the same entry as those scans: the one with the longest match, compared as
+ * (destination & entry netmask) and never the all-zero match, and the first
+ * one in the table among equal matches.
+ */
+class RoutingTableIndex
+{
+  private:
+    typedef std::map<uint32, std::set<unsigned int> > AddressMap;   // masked address -> positions in the table
+
+    const std::vector<RoutingTableEntry*>& table;
+    std::map<uint32, AddressMap> entriesByNetmask;
+
+  public:
+    RoutingTableIndex(const std::vector<RoutingTableEntry*>& routingTable) : table(routingTable) {
+        for (unsigned int i = 0; i < table.size(); i++) {
+            addEntry(i);
+        }
+    }
+
+    /**
+     * To be called after the entry at the given position was added to the table.
+     */
+    void addEntry(unsigned int position) {
+        const RoutingTableEntry* entry = table[position];
+        if (entry->getDestinationType() == RoutingTableEntry::NETWORK_DESTINATION) {
+            uint32 netmask = entry->getNetmask().getInt();
+            entriesByNetmask[netmask][entry->getDestination().getInt() & netmask].insert(position);
+        }
+    }
+
+    /**
+     * To be called before the destination or the netmask of the entry at the given position changes.
+     */
+    void removeEntry(unsigned int position) {
+        const RoutingTableEntry* entry = table[position];
+        if (entry->getDestinationType() == RoutingTableEntry::NETWORK_DESTINATION) {
+            uint32 netmask = entry->getNetmask().getInt();
+            AddressMap& addresses = entriesByNetmask[netmask];
+            AddressMap::iterator it = addresses.find(entry->getDestination().getInt() & netmask);
+            ASSERT(it != addresses.end());
+            it->second.erase(position);
+            if (it->second.empty()) {
+                addresses.erase(it);
+            }
+            if (addresses.empty()) {
+                entriesByNetmask.erase(netmask);
+            }
+        }
+    }
+
+    /**
+     * Returns the position of the longest matching network entry, or -1.
+     */
+    int findLongestMatch(uint32 destination) const {
+        uint32 longestMatch = 0;
+        int position = -1;
+        for (std::map<uint32, AddressMap>::const_iterator it = entriesByNetmask.begin(); it != entriesByNetmask.end(); it++) {
+            uint32 match = destination & it->first;
+            if ((match == 0) || (match < longestMatch)) {
+                continue;
+            }
+            AddressMap::const_iterator entryIt = it->second.find(match);
+            if (entryIt != it->second.end()) {
+                int firstPosition = *entryIt->second.begin();
+                if ((match > longestMatch) || (firstPosition < position)) {
+                    longestMatch = match;
+                    position = firstPosition;
+                }
+            }
+        }
+        return position;
+    }
+};
+
+} // namespace OSPF
+
+namespace {
+
+/**
+ * The candidate list of Dijkstra's algorithm (RFC2328 16.1 (2) and (3)), kept in a
+ * balanced tree. Vertices come out in the same order the linear search of the
+ * candidate vector used to select them: the closest one first, networks before
+ * routers at equal distance, and then in the order they became candidates.
+ */
+class SPFCandidateList
+{
+  private:
+    struct Key {
+        unsigned long   distance;
+        int             rank;       // 0 for networks, 1 for routers
+        unsigned long   order;
+        OSPFLSA*        vertex;
+
+        bool operator<(const Key& other) const {
+            if (distance != other.distance)
+                return distance < other.distance;
+            if (rank != other.rank)
+                return rank < other.rank;
+            return order < other.order;
+        }
+    };
+
+    std::set<Key>               queue;
+    std::map<OSPFLSA*, Key>     keys;
+    unsigned long               nextOrder;
+
+  public:
+    SPFCandidateList() : nextOrder(0) {}
+
+    bool isEmpty() const  { return queue.empty(); }
+    bool contains(OSPFLSA* vertex) const  { return keys.find(vertex) != keys.end(); }
+
+    void add(OSPFLSA* vertex, unsigned long distance) {
+        Key key;
+        key.distance = distance;
+        key.rank = (vertex->getHeader().getLsType() == NETWORKLSA_TYPE) ? 0 : 1;
+        key.order = nextOrder++;
+        key.vertex = vertex;
+        keys[vertex] = key;
+        queue.insert(key);
+    }
+
+    /**
+     * Lowers the distance of a candidate; it keeps its place among the candidates of equal distance.
+     */
+    void decreaseDistance(OSPFLSA* vertex, unsigned long distance) {
+        Key& key = keys[vertex];
+        queue.erase(key);
+        key.distance = distance;
+        queue.insert(key);
+    }
+
+    unsigned long getDistance(OSPFLSA* vertex) const  { return keys.find(vertex)->second.distance; }
+    unsigned long getClosestDistance() const  { return queue.begin()->distance; }
+
+    OSPFLSA* removeClosest() {
+        OSPFLSA* vertex = queue.begin()->vertex;
+        queue.erase(queue.begin());
+        keys.erase(vertex);
+        return vertex;
+    }
+};
+
+/**
+ * The graph the incremental SPF works on: the vertices of the previous shortest
+ * path tree (with the same indices as in Area::spfVertices), followed by the ones
+ * that became reachable since, and their current links.
+ */
+struct SPFGraph
+{
+    std::vector<OSPFLSA*>                                       vertices;       // NULL if the LSA has been flushed
+    std::map<OSPFLSA*, int>                                     indices;
+    std::vector<std::vector<std::pair<int, unsigned long> > >   links;          // (joining vertex, cost)
+    std::vector<std::vector<std::pair<int, int> > >             incomingLinks;  // (vertex, index in its links)
+    std::vector<unsigned long>                                  distances;
+    std::vector<bool>                                           affected;       // whether it is recalculated
+    std::vector<bool>                                           done;           // whether it has been recalculated
+
+    int addVertex(OSPFLSA* lsa, unsigned long distance, bool isAffected) {
+        int index = vertices.size();
+        vertices.push_back(lsa);
+        if (lsa != NULL) {
+            indices[lsa] = index;
+        }
+        links.push_back(std::vector<std::pair<int, unsigned long> >());
+        incomingLinks.push_back(std::vector<std::pair<int, int> >());
+        distances.push_back(distance);
+        affected.push_back(isAffected);
+        done.push_back(false);
+        return index;
+    }
+
+    void addLink(int from, OSPFLSA* to, unsigned long cost) {
+        std::map<OSPFLSA*, int>::iterator it = indices.find(to);
+        int index = (it != indices.end()) ? it->second : addVertex(to, 0, true);
+        incomingLinks[index].push_back(std::make_pair(from, (int)links[from].size()));
+        links[from].push_back(std::make_pair(index, cost));
+    }
+
+    /**
+     * Marks a vertex and its descendants on the old shortest path DAG affected,
+     * and appends the newly marked ones to newlyAffected.
+     */
+    void setAffected(int index, const std::vector<std::vector<int> >& dagChildren, std::vector<int>& newlyAffected) {
+        std::vector<int> stack(1, index);
+        affected[index] = true;
+        while (!stack.empty()) {
+            int vertex = stack.back();
+            stack.pop_back();
+            newlyAffected.push_back(vertex);
+            if (vertex < (int)dagChildren.size()) {
+                for (unsigned int i = 0; i < dagChildren[vertex].size(); i++) {
+                    int child = dagChildren[vertex][i];
+                    if (!affected[child]) {
+                        affected[child] = true;
+                        stack.push_back(child);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * Makes an affected vertex a candidate via its links from vertices with a final distance.
+     */
+    void addCandidate(int index, SPFCandidateList& candidates) {
+        if (vertices[index] == NULL) {
+            return;
+        }
+        unsigned long distance = LS_INFINITY;
+        bool reachable = false;
+        for (unsigned int i = 0; i < incomingLinks[index].size(); i++) {
+            int from = incomingLinks[index][i].first;
+            if (!affected[from] || done[from]) {
+                unsigned long linkStateCost = distances[from] + links[from][incomingLinks[index][i].second].second;
+                if (!reachable || (linkStateCost < distance)) {
+                    distance = linkStateCost;
+                    reachable = true;
+                }
+            }
+        }
+        if (reachable) {
+            relax(index, distance, candidates);
+        }
+    }
+
+    void relax(int index, unsigned long distance, SPFCandidateList& candidates) {
+        OSPFLSA* vertex = vertices[index];
+        if (!candidates.contains(vertex)) {
+            candidates.add(vertex, distance);
+        } else if (distance < candidates.getDistance(vertex)) {
+            candidates.decreaseDistance(vertex, distance);
+        }
+    }
+};
+
+struct DAGParentLess
+{
+    // (position on the tree, index of the link in the parent's links, parent)
+    bool operator()(const std::pair<std::pair<int, int>, int>& a, const std::pair<std::pair<int, int>, int>& b) const {
+        return a.first < b.first;
+    }
+};
+
+} // namespace
+
+simsignal_t OSPF::Area::spfDurationSignal = SIMSIGNAL_NULL;
+simsignal_t OSPF::Area::spfVerticesSignal = SIMSIGNAL_NULL;
+
+OSPFLSA* OSPF::Area::findVertexLSA(LSAType type, LinkStateID linkStateID)
+{
+    if (type == ROUTERLSA_TYPE) {
+        return findRouterLSA(linkStateID);
+    } else {
+        return findNetworkLSA(linkStateID);
+    }
+}
+
+void OSPF::Area::getVertexLinks(OSPFLSA* vertex, std::vector<VertexLink>& links)
+{
+    links.clear();
+
+    if (vertex->getHeader().getLsType() == ROUTERLSA_TYPE) {
+        OSPF::RouterLSA* routerVertex = check_and_cast<OSPF::RouterLSA*> (vertex);
+        unsigned int linkCount = routerVertex->getLinksArraySize();
+        for (unsigned int i = 0; i < linkCount; i++) {
+            Link& link = routerVertex->getLinks(i);
+            LinkType linkType = static_cast<LinkType> (link.getType());
+            OSPFLSA* joiningVertex;
+
+            if (linkType == STUB_LINK) {     // (2) (a)
+                continue;
+            }
+
+            if (linkType == TRANSIT_LINK) {
+                joiningVertex = findNetworkLSA(link.getLinkID());
+            } else {
+                joiningVertex = findRouterLSA(link.getLinkID());
+            }
+
+            if ((joiningVertex == NULL) ||
+                (joiningVertex->getHeader().getLsAge() == MAX_AGE) ||
+                (!hasLink(joiningVertex, vertex)))  // (from, to)     (2) (b)
+            {
+                continue;
+            }
+
+            VertexLink vertexLink;
+            vertexLink.vertex = joiningVertex;
+            vertexLink.cost = link.getLinkCost();
+            links.push_back(vertexLink);
+        }
+    } else {
+        OSPF::NetworkLSA* networkVertex = check_and_cast<OSPF::NetworkLSA*> (vertex);
+        unsigned int routerCount = networkVertex->getAttachedRoutersArraySize();
+        for (unsigned int i = 0; i < routerCount; i++) {     // (2)
+            OSPF::RouterLSA* joiningVertex = findRouterLSA(networkVertex->getAttachedRouters(i));
+            if ((joiningVertex == NULL) ||
+                (joiningVertex->getHeader().getLsAge() == MAX_AGE) ||
+                (!hasLink(joiningVertex, vertex)))  // (from, to)     (2) (b)
+            {
+                continue;
+            }
+
+            VertexLink vertexLink;
+            vertexLink.vertex = joiningVertex;
+            vertexLink.cost = 0;    // link cost from network to router is always 0
+            links.push_back(vertexLink);
+        }
+    }
+}
+
 void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>& newRoutingTable)
 {
     OSPF::RouterID routerID = parentRouter->getRouterID();
-    bool finished = false;
-    std::vector<OSPFLSA*> treeVertices;
-    OSPFLSA* justAddedVertex;
-    std::vector<OSPFLSA*> candidateVertices;
-    unsigned long            i, j, k;
-    unsigned long lsaCount;
 
     if (spfTreeRoot == NULL) {
         OSPF::RouterLSA* newLSA = originateRouterLSA();
@@ -1371,6 +1688,53 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
         return;
     }
 
+    // Bringing up a virtual link may rebuild the routing table in the middle of the
+    // calculation, so the tree is not repaired incrementally if this is a transit area.
+    OSPF::Area* backbone = (areaID != OSPF::BACKBONE_AREAID) ? parentRouter->getAreaByID(OSPF::BACKBONE_AREAID) : this;
+    bool incremental = parentRouter->getIncrementalSPF() && ((backbone == NULL) || !backbone->hasVirtualLink(areaID));
+
+    bool recordDuration = parentRouter->getRecordSPFDuration();
+    clock_t startTime = recordDuration ? clock() : 0;
+    std::vector<OSPFLSA*> treeVertices;
+    unsigned long recalculatedCount;
+    OSPF::RoutingTableIndex routeIndex(newRoutingTable);
+
+    if (incremental && repairShortestPathTree(treeVertices, recalculatedCount)) {
+        unsigned long treeSize = treeVertices.size();
+        for (unsigned long i = 1; i < treeSize; i++) {
+            addIntraAreaRoute(treeVertices[i], treeVertices[i - 1], newRoutingTable, routeIndex);
+        }
+    } else {
+        calculateFullShortestPathTree(newRoutingTable, routeIndex, treeVertices, incremental);
+        recalculatedCount = treeVertices.size();
+    }
+    addStubRoutes(treeVertices, newRoutingTable, routeIndex);
+
+    EV << "Shortest path tree of area " << areaID.str(false) << ": " << treeVertices.size() << " vertices, "
+       << recalculatedCount << " recalculated\n";
+
+    cSimpleModule* ospfModule = parentRouter->getMessageHandler()->getOSPFModule();
+    if (recordDuration) {
+        // CPU time, so it is only recorded on request: it would make the results machine dependent
+        ospfModule->emit(spfDurationSignal, (double)(clock() - startTime) / CLOCKS_PER_SEC);
+    }
+    ospfModule->emit(spfVerticesSignal, (long)recalculatedCount);
+}
+
+void OSPF::Area::calculateFullShortestPathTree(std::vector<OSPF::RoutingTableEntry*>& newRoutingTable,
+                                               OSPF::RoutingTableIndex& routeIndex,
+                                               std::vector<OSPFLSA*>& treeVertices,
+                                               bool keepState)
+{
+    std::set<OSPFLSA*> onTree;
+    SPFCandidateList candidateVertices;
+    std::map<OSPFLSA*, std::vector<OSPFLSA*> > dagParents;
+    std::map<OSPFLSA*, std::vector<VertexLink> > treeLinks;
+    std::vector<VertexLink> links;
+    OSPFLSA* justAddedVertex;
+    unsigned long i, k;
+    unsigned long lsaCount;
+
     lsaCount = routerLSAs.size();
     for (i = 0; i < lsaCount; i++) {
         routerLSAs[i]->clearNextHops();
@@ -1381,290 +1745,529 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
     }
     spfTreeRoot->setDistance(0);
     treeVertices.push_back(spfTreeRoot);
+    onTree.insert(spfTreeRoot);
     justAddedVertex = spfTreeRoot;          // (1)
 
-    do {
-        LSAType vertexType = static_cast<LSAType> (justAddedVertex->getHeader().getLsType());
-
-        if ((vertexType == ROUTERLSA_TYPE)) {
+    while (true) {
+        if (justAddedVertex->getHeader().getLsType() == ROUTERLSA_TYPE) {
             OSPF::RouterLSA* routerVertex = check_and_cast<OSPF::RouterLSA*> (justAddedVertex);
             if (routerVertex->getV_VirtualLinkEndpoint()) {    // (2)
                 transitCapability = true;
             }
+        }
 
-            unsigned int linkCount = routerVertex->getLinksArraySize();
-            for (i = 0; i < linkCount; i++) {
-                Link& link = routerVertex->getLinks(i);
-                LinkType linkType = static_cast<LinkType> (link.getType());
-                OSPFLSA* joiningVertex;
-                LSAType joiningVertexType;
+        unsigned long justAddedDistance = check_and_cast<OSPF::RoutingInfo*> (justAddedVertex)->getDistance();
+        getVertexLinks(justAddedVertex, links);
 
-                if (linkType == STUB_LINK) {     // (2) (a)
-                    continue;
-                }
+        unsigned int linkCount = links.size();
+        for (i = 0; i < linkCount; i++) {
+            OSPFLSA* joiningVertex = links[i].vertex;
 
-                if (linkType == TRANSIT_LINK) {
-                    joiningVertex = findNetworkLSA(link.getLinkID());
-                    joiningVertexType = NETWORKLSA_TYPE;
-                } else {
-                    joiningVertex = findRouterLSA(link.getLinkID());
-                    joiningVertexType = ROUTERLSA_TYPE;
-                }
+            if (onTree.find(joiningVertex) != onTree.end()) {    // (2) (c)
+                continue;
+            }
 
-                if ((joiningVertex == NULL) ||
-                    (joiningVertex->getHeader().getLsAge() == MAX_AGE) ||
-                    (!hasLink(joiningVertex, justAddedVertex)))  // (from, to)     (2) (b)
-                {
-                    continue;
-                }
+            unsigned long linkStateCost = justAddedDistance + links[i].cost;
+            OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningVertex);
 
-                unsigned int treeSize = treeVertices.size();
-                bool alreadyOnTree = false;
+            if (candidateVertices.contains(joiningVertex)) {    // (2) (d)
+                unsigned long candidateDistance = routingInfo->getDistance();
 
-                for (j = 0; j < treeSize; j++) {
-                    if (treeVertices[j] == joiningVertex) {
-                        alreadyOnTree = true;
-                        break;
-                    }
-                }
-                if (alreadyOnTree) {    // (2) (c)
+                if (linkStateCost > candidateDistance) {
                     continue;
                 }
-
-                unsigned long linkStateCost = routerVertex->getDistance() + link.getLinkCost();
-                unsigned int candidateCount = candidateVertices.size();
-                OSPFLSA* candidate = NULL;
-
-                for (j = 0; j < candidateCount; j++) {
-                    if (candidateVertices[j] == joiningVertex) {
-                        candidate = candidateVertices[j];
+                if (linkStateCost < candidateDistance) {
+                    routingInfo->setDistance(linkStateCost);
+                    routingInfo->clearNextHops();
+                    candidateVertices.decreaseDistance(joiningVertex, linkStateCost);
+                    if (keepState) {
+                        dagParents[joiningVertex].clear();
                     }
                 }
-                if (candidate != NULL) {    // (2) (d)
-                    OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (candidate);
-                    unsigned long candidateDistance = routingInfo->getDistance();
+            } else {
+                routingInfo->setDistance(linkStateCost);
+                routingInfo->setParent(justAddedVertex);
+                candidateVertices.add(joiningVertex, linkStateCost);
+            }
 
-                    if (linkStateCost > candidateDistance) {
-                        continue;
-                    }
-                    if (linkStateCost < candidateDistance) {
-                        routingInfo->setDistance(linkStateCost);
-                        routingInfo->clearNextHops();
-                    }
-                    std::vector<OSPF::NextHop>* newNextHops = calculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
-                    unsigned int nextHopCount = newNextHops->size();
-                    for (k = 0; k < nextHopCount; k++) {
-                        routingInfo->addNextHop((*newNextHops)[k]);
-                    }
-                    delete newNextHops;
-                } else {
-                    if (joiningVertexType == ROUTERLSA_TYPE) {
-                        OSPF::RouterLSA* joiningRouterVertex = check_and_cast<OSPF::RouterLSA*> (joiningVertex);
-                        joiningRouterVertex->setDistance(linkStateCost);
-                        std::vector<OSPF::NextHop>* newNextHops = calculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
-                        unsigned int nextHopCount = newNextHops->size();
-                        for (k = 0; k < nextHopCount; k++) {
-                            joiningRouterVertex->addNextHop((*newNextHops)[k]);
-                        }
-                        delete newNextHops;
-                        OSPF::RoutingInfo* vertexRoutingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningRouterVertex);
-                        vertexRoutingInfo->setParent(justAddedVertex);
+            std::vector<OSPF::NextHop>* newNextHops = calculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
+            unsigned int nextHopCount = newNextHops->size();
+            for (k = 0; k < nextHopCount; k++) {
+                routingInfo->addNextHop((*newNextHops)[k]);
+            }
+            delete newNextHops;
 
-                        candidateVertices.push_back(joiningRouterVertex);
-                    } else {
-                        OSPF::NetworkLSA* joiningNetworkVertex = check_and_cast<OSPF::NetworkLSA*> (joiningVertex);
-                        joiningNetworkVertex->setDistance(linkStateCost);
-                        std::vector<OSPF::NextHop>* newNextHops = calculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
-                        unsigned int nextHopCount = newNextHops->size();
-                        for (k = 0; k < nextHopCount; k++) {
-                            joiningNetworkVertex->addNextHop((*newNextHops)[k]);
-                        }
-                        delete newNextHops;
-                        OSPF::RoutingInfo* vertexRoutingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningNetworkVertex);
-                        vertexRoutingInfo->setParent(justAddedVertex);
+            if (keepState) {
+                dagParents[joiningVertex].push_back(justAddedVertex);
+            }
+        }
+        if (keepState) {
+            treeLinks[justAddedVertex] = links;
+        }
 
-                        candidateVertices.push_back(joiningNetworkVertex);
-                    }
-                }
+        if (candidateVertices.isEmpty()) {  // (3)
+            break;
+        }
+
+        OSPFLSA* closestVertex = candidateVertices.removeClosest();
+        treeVertices.push_back(closestVertex);
+        onTree.insert(closestVertex);
+
+        addIntraAreaRoute(closestVertex, justAddedVertex, newRoutingTable, routeIndex);
+
+        justAddedVertex = closestVertex;
+    }
+
+    spfVertices.clear();
+    if (keepState) {
+        std::map<OSPFLSA*, int> positions;
+        unsigned int treeSize = treeVertices.size();
+        for (i = 0; i < treeSize; i++) {
+            positions[treeVertices[i]] = i;
+        }
+
+        spfVertices.resize(treeSize);
+        for (i = 0; i < treeSize; i++) {
+            OSPFLSA* vertex = treeVertices[i];
+            OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (vertex);
+            SPFVertex& vertexState = spfVertices[i];
+
+            vertexState.type = static_cast<LSAType> (vertex->getHeader().getLsType());
+            vertexState.linkStateID = vertex->getHeader().getLinkStateID();
+            vertexState.distance = routingInfo->getDistance();
+            const std::vector<VertexLink>& vertexLinks = treeLinks[vertex];
+            for (k = 0; k < vertexLinks.size(); k++) {
+                vertexState.links.push_back(std::make_pair(positions[vertexLinks[k].vertex], vertexLinks[k].cost));
+            }
+            const std::vector<OSPFLSA*>& vertexParents = dagParents[vertex];
+            for (k = 0; k < vertexParents.size(); k++) {
+                vertexState.dagParents.push_back(positions[vertexParents[k]]);
+            }
+            unsigned int nextHopCount = routingInfo->getNextHopCount();
+            for (k = 0; k < nextHopCount; k++) {
+                vertexState.nextHops.push_back(routingInfo->getNextHop(k));
+            }
+        }
+    }
+}
+
+/**
+ * Updates the shortest path tree of the previous calculation (spfVertices) to the
+ * current link state database, and returns the vertices of the new tree in the order
+ * they are to be added to the routing table. Distances and next hops are recalculated
+ * only for the vertices behind a changed link on the old shortest path DAG, and for
+ * the ones that get closer or get new equal cost paths; the result is the same as
+ * that of a full calculation. Returns false if the tree must be calculated from scratch.
+ */
+bool OSPF::Area::repairShortestPathTree(std::vector<OSPFLSA*>& treeVertices, unsigned long& recalculatedCount)
+{
+    unsigned int oldCount = spfVertices.size();
+    std::vector<VertexLink> vertexLinks;
+    SPFGraph graph;
+    unsigned int i, j, k;
+
+    if ((oldCount == 0) || (findRouterLSA(spfVertices[0].linkStateID) != spfTreeRoot)) {
+        return false;
+    }
+
+    for (i = 0; i < oldCount; i++) {
+        OSPFLSA* vertex = findVertexLSA(spfVertices[i].type, spfVertices[i].linkStateID);
+        if ((vertex != NULL) && (vertex->getHeader().getLsAge() == MAX_AGE)) {
+            vertex = NULL;
+        }
+        graph.addVertex(vertex, spfVertices[i].distance, vertex == NULL);
+    }
+    for (i = 0; i < oldCount; i++) {
+        if (graph.vertices[i] == NULL) {
+            continue;
+        }
+        getVertexLinks(graph.vertices[i], vertexLinks);
+        for (j = 0; j < vertexLinks.size(); j++) {
+            // the tree would not be ordered by (distance, vertex type) with zero cost links between routers
+            if ((vertexLinks[j].cost == 0) && (spfVertices[i].type == ROUTERLSA_TYPE)) {
+                return false;
             }
+            graph.addLink(i, vertexLinks[j].vertex, vertexLinks[j].cost);
         }
+    }
 
-        if ((vertexType == NETWORKLSA_TYPE)) {
-            OSPF::NetworkLSA* networkVertex = check_and_cast<OSPF::NetworkLSA*> (justAddedVertex);
-            unsigned int routerCount = networkVertex->getAttachedRoutersArraySize();
+    // restore the routing info of the vertices from the previous calculation, as LSA updates clear it
+    for (i = 0; i < oldCount; i++) {
+        if (graph.vertices[i] != NULL) {
+            OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (graph.vertices[i]);
+            routingInfo->setDistance(spfVertices[i].distance);
+            routingInfo->clearNextHops();
+            for (k = 0; k < spfVertices[i].nextHops.size(); k++) {
+                routingInfo->addNextHop(spfVertices[i].nextHops[k]);
+            }
+        }
+    }
+    std::vector<bool> linkedToRoot(graph.vertices.size(), false);
+    for (j = 0; j < graph.links[0].size(); j++) {
+        int joiningVertex = graph.links[0][j].first;
+        linkedToRoot[joiningVertex] = true;
+        check_and_cast<OSPF::RoutingInfo*> (graph.vertices[joiningVertex])->setParent(spfTreeRoot);
+    }
 
-            for (i = 0; i < routerCount; i++) {     // (2)
-                OSPF::RouterLSA* joiningVertex = findRouterLSA(networkVertex->getAttachedRouters(i));
-                if ((joiningVertex == NULL) ||
-                    (joiningVertex->getHeader().getLsAge() == MAX_AGE) ||
-                    (!hasLink(joiningVertex, justAddedVertex)))  // (from, to)     (2) (b)
-                {
-                    continue;
-                }
+    // the vertices whose distance, next hops or parent may have changed
+    std::vector<int> changedVertices;
+    for (i = 0; i < oldCount; i++) {
+        if (graph.vertices[i] == NULL) {
+            changedVertices.push_back(i);
+            continue;
+        }
 
-                unsigned int treeSize = treeVertices.size();
-                bool alreadyOnTree = false;
+        std::vector<std::pair<int, unsigned long> > oldLinks = spfVertices[i].links;
+        std::vector<std::pair<int, unsigned long> > newLinks = graph.links[i];
+        std::sort(oldLinks.begin(), oldLinks.end());
+        std::sort(newLinks.begin(), newLinks.end());
+        if (oldLinks == newLinks) {
+            continue;
+        }
 
-                for (j = 0; j < treeSize; j++) {
-                    if (treeVertices[j] == joiningVertex) {
-                        alreadyOnTree = true;
-                        break;
-                    }
-                }
-                if (alreadyOnTree) {    // (2) (c)
-                    continue;
-                }
+        std::vector<std::pair<int, unsigned long> > removedLinks, addedLinks;
+        std::set_difference(oldLinks.begin(), oldLinks.end(), newLinks.begin(), newLinks.end(), std::back_inserter(removedLinks));
+        std::set_difference(newLinks.begin(), newLinks.end(), oldLinks.begin(), oldLinks.end(), std::back_inserter(addedLinks));
+        for (j = 0; j < removedLinks.size(); j++) {
+            int joiningVertex = removedLinks[j].first;
+            const std::vector<int>& parents = spfVertices[joiningVertex].dagParents;
+            if ((i == 0) || (std::find(parents.begin(), parents.end(), (int)i) != parents.end())) {
+                changedVertices.push_back(joiningVertex);
+            }
+        }
+        for (j = 0; j < addedLinks.size(); j++) {
+            int joiningVertex = addedLinks[j].first;
+            if ((i == 0) || (joiningVertex >= (int)oldCount) ||
+                (spfVertices[i].distance + addedLinks[j].second <= spfVertices[joiningVertex].distance))
+            {
+                changedVertices.push_back(joiningVertex);
+            }
+        }
+    }
+
+    // the next hops via the root and the networks it is attached to also depend on the interfaces
+    for (i = 1; i < oldCount; i++) {
+        const std::vector<int>& parents = spfVertices[i].dagParents;
+        bool directlyAttached = false;
+        bool parentsExist = true;
+        for (j = 0; j < parents.size(); j++) {
+            if (graph.vertices[parents[j]] == NULL) {
+                parentsExist = false;   // already changed
+            } else if ((parents[j] == 0) || linkedToRoot[parents[j]]) {
+                directlyAttached = true;
+            }
+        }
+        if ((graph.vertices[i] == NULL) || !directlyAttached || !parentsExist) {
+            continue;
+        }
 
-                unsigned long linkStateCost = networkVertex->getDistance();   // link cost from network to router is always 0
-                unsigned int candidateCount = candidateVertices.size();
-                OSPFLSA* candidate = NULL;
+        std::vector<OSPF::NextHop> nextHops;
+        for (j = 0; j < parents.size(); j++) {
+            std::vector<OSPF::NextHop>* newNextHops = calculateNextHops(graph.vertices[i], graph.vertices[parents[j]]); // (destination, parent)
+            nextHops.insert(nextHops.end(), newNextHops->begin(), newNextHops->end());
+            delete newNextHops;
+        }
+        if ((nextHops.size() != spfVertices[i].nextHops.size()) ||
+            !std::equal(nextHops.begin(), nextHops.end(), spfVertices[i].nextHops.begin()))
+        {
+            changedVertices.push_back(i);
+        }
+    }
 
-                for (j = 0; j < candidateCount; j++) {
-                    if (candidateVertices[j] == joiningVertex) {
-                        candidate = candidateVertices[j];
-                    }
+    // the changed vertices and their descendants on the old shortest path DAG are recalculated
+    std::vector<std::vector<int> > dagChildren(oldCount);
+    for (i = 0; i < oldCount; i++) {
+        const std::vector<int>& parents = spfVertices[i].dagParents;
+        for (j = 0; j < parents.size(); j++) {
+            if (dagChildren[parents[j]].empty() || (dagChildren[parents[j]].back() != (int)i)) {
+                dagChildren[parents[j]].push_back(i);
+            }
+        }
+    }
+    std::vector<int> affectedVertices;
+    for (i = 0; i < changedVertices.size(); i++) {
+        int vertex = changedVertices[i];
+        if (vertex >= (int)oldCount) {
+            affectedVertices.push_back(vertex);
+        } else if (!graph.affected[vertex] || (graph.vertices[vertex] == NULL)) {
+            graph.setAffected(vertex, dagChildren, affectedVertices);
+        }
+    }
+    std::sort(affectedVertices.begin(), affectedVertices.end());
+    affectedVertices.erase(std::unique(affectedVertices.begin(), affectedVertices.end()), affectedVertices.end());
+
+    // Dijkstra's algorithm over the affected vertices, the others keep their distance
+    SPFCandidateList candidateVertices;
+    std::vector<int> recalculatedVertices;
+    for (i = 0; i < affectedVertices.size(); i++) {
+        graph.addCandidate(affectedVertices[i], candidateVertices);
+    }
+    while (!candidateVertices.isEmpty()) {
+        unsigned long distance = candidateVertices.getClosestDistance();
+        OSPFLSA* closestVertex = candidateVertices.removeClosest();
+        int vertex = graph.indices[closestVertex];
+        graph.distances[vertex] = distance;
+        graph.done[vertex] = true;
+        recalculatedVertices.push_back(vertex);
+
+        if (vertex >= (int)oldCount) {
+            getVertexLinks(closestVertex, vertexLinks);
+            for (j = 0; j < vertexLinks.size(); j++) {
+                if ((vertexLinks[j].cost == 0) && (closestVertex->getHeader().getLsType() == ROUTERLSA_TYPE)) {
+                    return false;
                 }
-                if (candidate != NULL) {    // (2) (d)
-                    OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (candidate);
-                    unsigned long candidateDistance = routingInfo->getDistance();
+                graph.addLink(vertex, vertexLinks[j].vertex, vertexLinks[j].cost);
+            }
+        }
 
-                    if (linkStateCost > candidateDistance) {
-                        continue;
-                    }
-                    if (linkStateCost < candidateDistance) {
-                        routingInfo->setDistance(linkStateCost);
-                        routingInfo->clearNextHops();
+        for (j = 0; j < graph.links[vertex].size(); j++) {
+            int joiningVertex = graph.links[vertex][j].first;
+            unsigned long linkStateCost = graph.distances[vertex] + graph.links[vertex][j].second;
+
+            if (!graph.affected[joiningVertex]) {
+                // a vertex of the old tree gets closer or gets more next hops
+                if (linkStateCost <= graph.distances[joiningVertex]) {
+                    std::vector<int> newlyAffected;
+                    graph.setAffected(joiningVertex, dagChildren, newlyAffected);
+                    for (k = 0; k < newlyAffected.size(); k++) {
+                        graph.addCandidate(newlyAffected[k], candidateVertices);
                     }
-                    std::vector<OSPF::NextHop>* newNextHops = calculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
-                    unsigned int nextHopCount = newNextHops->size();
-                    for (k = 0; k < nextHopCount; k++) {
-                        routingInfo->addNextHop((*newNextHops)[k]);
-                    }
-                    delete newNextHops;
-                } else {
-                    joiningVertex->setDistance(linkStateCost);
-                    std::vector<OSPF::NextHop>* newNextHops = calculateNextHops(joiningVertex, justAddedVertex); // (destination, parent)
-                    unsigned int nextHopCount = newNextHops->size();
-                    for (k = 0; k < nextHopCount; k++) {
-                        joiningVertex->addNextHop((*newNextHops)[k]);
-                    }
-                    delete newNextHops;
-                    OSPF::RoutingInfo* vertexRoutingInfo = check_and_cast<OSPF::RoutingInfo*> (joiningVertex);
-                    vertexRoutingInfo->setParent(justAddedVertex);
-
-                    candidateVertices.push_back(joiningVertex);
                 }
+            } else if (!graph.done[joiningVertex]) {
+                graph.relax(joiningVertex, linkStateCost, candidateVertices);
             }
         }
 
-        if (candidateVertices.empty()) {  // (3)
-            finished = true;
-        } else {
-            unsigned int candidateCount = candidateVertices.size();
-            unsigned long minDistance = LS_INFINITY;
-            OSPFLSA* closestVertex = candidateVertices[0];
+    }
 
-            for (i = 0; i < candidateCount; i++) {
-                OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (candidateVertices[i]);
-                unsigned long currentDistance = routingInfo->getDistance();
+    // The new tree: the unaffected vertices in their old order merged with the recalculated
+    // ones, ordered by (distance, vertex type). Within such a group, the vertices are added
+    // in the order they became candidates, i.e. by the position of their parent on the tree
+    // (the first vertex that has a link to them) and the index of that link; this yields
+    // the same tree as a full calculation.
+    std::vector<int> sortedVertices;
+    unsigned int reachedCount = recalculatedVertices.size();
+    unsigned int next = 0;
+    for (i = 0; i < oldCount; i++) {
+        if (graph.affected[i]) {
+            continue;
+        }
+        while (next < reachedCount) {
+            int vertex = recalculatedVertices[next];
+            unsigned long distance = graph.distances[vertex];
+            bool isNetwork = (graph.vertices[vertex]->getHeader().getLsType() == NETWORKLSA_TYPE);
+            if ((distance > graph.distances[i]) ||
+                ((distance == graph.distances[i]) && (!isNetwork || (spfVertices[i].type == NETWORKLSA_TYPE))))
+            {
+                break;
+            }
+            sortedVertices.push_back(vertex);
+            next++;
+        }
+        sortedVertices.push_back(i);
+    }
+    for ( ; next < reachedCount; next++) {
+        sortedVertices.push_back(recalculatedVertices[next]);
+    }
 
-                if (currentDistance < minDistance) {
-                    closestVertex = candidateVertices[i];
-                    minDistance = currentDistance;
-                } else {
-                    if (currentDistance == minDistance) {
-                        if ((closestVertex->getHeader().getLsType() == ROUTERLSA_TYPE) &&
-                            (candidateVertices[i]->getHeader().getLsType() == NETWORKLSA_TYPE))
-                        {
-                            closestVertex = candidateVertices[i];
-                        }
-                    }
+    std::vector<int> order(1, 0);
+    std::vector<int> positions(graph.vertices.size(), -1);
+    positions[0] = 0;
+    unsigned int treeSize = sortedVertices.size();
+    for (i = 1; i < treeSize; ) {
+        int groupType = graph.vertices[sortedVertices[i]]->getHeader().getLsType();
+        unsigned long groupDistance = graph.distances[sortedVertices[i]];
+        std::vector<std::pair<std::pair<int, int>, int> > group;   // ((parent position, link index), vertex)
+
+        for ( ; i < treeSize; i++) {
+            int vertex = sortedVertices[i];
+            if ((graph.distances[vertex] != groupDistance) || (graph.vertices[vertex]->getHeader().getLsType() != groupType)) {
+                break;
+            }
+            const std::vector<std::pair<int, int> >& incomingLinks = graph.incomingLinks[vertex];
+            std::pair<int, int> parentKey(-1, -1);
+            for (j = 0; j < incomingLinks.size(); j++) {
+                int from = incomingLinks[j].first;
+                std::pair<int, int> key(positions[from], incomingLinks[j].second);
+                if ((positions[from] != -1) && ((parentKey.first == -1) || (key < parentKey))) {
+                    parentKey = key;
                 }
             }
+            ASSERT(parentKey.first != -1);
+            group.push_back(std::make_pair(parentKey, vertex));
+        }
 
-            treeVertices.push_back(closestVertex);
+        std::sort(group.begin(), group.end());
+        for (j = 0; j < group.size(); j++) {
+            int vertex = group[j].second;
+            positions[vertex] = order.size();
+            order.push_back(vertex);
+            check_and_cast<OSPF::RoutingInfo*> (graph.vertices[vertex])->setParent(graph.vertices[order[group[j].first.first]]);
+        }
+    }
 
-            for (std::vector<OSPFLSA*>::iterator it = candidateVertices.begin(); it != candidateVertices.end(); it++) {
-                if ((*it) == closestVertex) {
-                    candidateVertices.erase(it);
-                    break;
-                }
+    // the next hops of the recalculated vertices come from their parents on the shortest path DAG, in tree order
+    std::vector<std::vector<int> > newDAGParents(graph.vertices.size());
+    for (i = 1; i < treeSize; i++) {
+        int vertex = order[i];
+        if (!graph.affected[vertex]) {
+            newDAGParents[vertex] = spfVertices[vertex].dagParents;
+            continue;
+        }
+
+        const std::vector<std::pair<int, int> >& incomingLinks = graph.incomingLinks[vertex];
+        std::vector<std::pair<std::pair<int, int>, int> > parents;
+        for (j = 0; j < incomingLinks.size(); j++) {
+            int from = incomingLinks[j].first;
+            if ((positions[from] != -1) && (positions[from] < (int)i) &&
+                (graph.distances[from] + graph.links[from][incomingLinks[j].second].second == graph.distances[vertex]))
+            {
+                parents.push_back(std::make_pair(std::make_pair(positions[from], incomingLinks[j].second), from));
             }
+        }
+        std::sort(parents.begin(), parents.end(), DAGParentLess());
+
+        OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (graph.vertices[vertex]);
+        routingInfo->setDistance(graph.distances[vertex]);
+        routingInfo->clearNextHops();
+        for (j = 0; j < parents.size(); j++) {
+            std::vector<OSPF::NextHop>* newNextHops = calculateNextHops(graph.vertices[vertex], graph.vertices[parents[j].second]); // (destination, parent)
+            unsigned int nextHopCount = newNextHops->size();
+            for (k = 0; k < nextHopCount; k++) {
+                routingInfo->addNextHop((*newNextHops)[k]);
+            }
+            delete newNextHops;
+            newDAGParents[vertex].push_back(parents[j].second);
+        }
+    }
 
-            if (closestVertex->getHeader().getLsType() == ROUTERLSA_TYPE) {
-                OSPF::RouterLSA* routerLSA = check_and_cast<OSPF::RouterLSA*> (closestVertex);
-                if (routerLSA->getB_AreaBorderRouter() || routerLSA->getE_ASBoundaryRouter()) {
-                    OSPF::RoutingTableEntry* entry = new OSPF::RoutingTableEntry;
-                    OSPF::RouterID destinationID = routerLSA->getHeader().getLinkStateID();
-                    unsigned int nextHopCount = routerLSA->getNextHopCount();
-                    OSPF::RoutingTableEntry::RoutingDestinationType destinationType = OSPF::RoutingTableEntry::NETWORK_DESTINATION;
-
-                    entry->setDestination(destinationID);
-                    entry->setLinkStateOrigin(routerLSA);
-                    entry->setArea(areaID);
-                    entry->setPathType(OSPF::RoutingTableEntry::INTRAAREA);
-                    entry->setCost(routerLSA->getDistance());
-                    if (routerLSA->getB_AreaBorderRouter()) {
-                        destinationType |= OSPF::RoutingTableEntry::AREA_BORDER_ROUTER_DESTINATION;
-                    }
-                    if (routerLSA->getE_ASBoundaryRouter()) {
-                        destinationType |= OSPF::RoutingTableEntry::AS_BOUNDARY_ROUTER_DESTINATION;
-                    }
-                    entry->setDestinationType(destinationType);
-                    entry->setOptionalCapabilities(routerLSA->getHeader().getLsOptions());
-                    for (i = 0; i < nextHopCount; i++) {
-                        entry->addNextHop(routerLSA->getNextHop(i));
-                    }
+    // vertices that are no longer reachable
+    for (i = 0; i < graph.vertices.size(); i++) {
+        if ((positions[i] == -1) && (graph.vertices[i] != NULL)) {
+            check_and_cast<OSPF::RoutingInfo*> (graph.vertices[i])->clearNextHops();
+        }
+    }
 
-                    newRoutingTable.push_back(entry);
+    std::vector<SPFVertex> newSPFVertices(treeSize);
+    treeVertices.resize(treeSize);
+    for (i = 0; i < treeSize; i++) {
+        int vertex = order[i];
+        OSPFLSA* lsa = graph.vertices[vertex];
+        OSPF::RoutingInfo* routingInfo = check_and_cast<OSPF::RoutingInfo*> (lsa);
+        SPFVertex& vertexState = newSPFVertices[i];
+
+        if (lsa->getHeader().getLsType() == ROUTERLSA_TYPE) {
+            OSPF::RouterLSA* routerVertex = check_and_cast<OSPF::RouterLSA*> (lsa);
+            if (routerVertex->getV_VirtualLinkEndpoint()) {
+                transitCapability = true;
+            }
+        }
 
-                    OSPF::Area* backbone;
-                    if (areaID != OSPF::BACKBONE_AREAID) {
-                        backbone = parentRouter->getAreaByID(OSPF::BACKBONE_AREAID);
-                    } else {
-                        backbone = this;
-                    }
-                    if (backbone != NULL) {
-                        OSPF::Interface* virtualIntf = backbone->findVirtualLink(destinationID);
-                        if ((virtualIntf != NULL) && (virtualIntf->getTransitAreaID() == areaID)) {
-                            OSPF::IPv4AddressRange range;
-                            range.address = getInterface(routerLSA->getNextHop(0).ifIndex)->getAddressRange().address;
-                            range.mask = IPv4Address::ALLONES_ADDRESS;
-                            virtualIntf->setAddressRange(range);
-                            virtualIntf->setIfIndex(routerLSA->getNextHop(0).ifIndex);
-                            virtualIntf->setOutputCost(routerLSA->getDistance());
-                            OSPF::Neighbor* virtualNeighbor = virtualIntf->getNeighbor(0);
-                            if (virtualNeighbor != NULL) {
-                                unsigned int linkCount = routerLSA->getLinksArraySize();
-                                OSPF::RouterLSA* toRouterLSA = dynamic_cast<OSPF::RouterLSA*> (justAddedVertex);
-                                if (toRouterLSA != NULL) {
-                                    for (i = 0; i < linkCount; i++) {
-                                        Link& link = routerLSA->getLinks(i);
-
-                                        if ((link.getType() == POINTTOPOINT_LINK) &&
-                                            (link.getLinkID() == toRouterLSA->getHeader().getLinkStateID()) &&
-                                            (virtualIntf->getState() < OSPF::Interface::WAITING_STATE))
-                                        {
-                                            virtualNeighbor->setAddress(IPv4Address(link.getLinkData()));
-                                            virtualIntf->processEvent(OSPF::Interface::INTERFACE_UP);
-                                            break;
-                                        }
-                                    }
-                                } else {
-                                    OSPF::NetworkLSA* toNetworkLSA = dynamic_cast<OSPF::NetworkLSA*> (justAddedVertex);
-                                    if (toNetworkLSA != NULL) {
-                                        for (i = 0; i < linkCount; i++) {
-                                            Link& link = routerLSA->getLinks(i);
-
-                                            if ((link.getType() == TRANSIT_LINK) &&
-                                                (link.getLinkID() == toNetworkLSA->getHeader().getLinkStateID()) &&
-                                                (virtualIntf->getState() < OSPF::Interface::WAITING_STATE))
-                                            {
-                                                virtualNeighbor->setAddress(IPv4Address(link.getLinkData()));
-                                                virtualIntf->processEvent(OSPF::Interface::INTERFACE_UP);
-                                                break;
-                                            }
-                                        }
+        vertexState.type = static_cast<LSAType> (lsa->getHeader().getLsType());
+        vertexState.linkStateID = lsa->getHeader().getLinkStateID();
+        vertexState.distance = graph.distances[vertex];
+        for (j = 0; j < graph.links[vertex].size(); j++) {
+            vertexState.links.push_back(std::make_pair(positions[graph.links[vertex][j].first], graph.links[vertex][j].second));
+        }
+        for (j = 0; j < newDAGParents[vertex].size(); j++) {
+            vertexState.dagParents.push_back(positions[newDAGParents[vertex][j]]);
+        }
+        unsigned int nextHopCount = routingInfo->getNextHopCount();
+        for (k = 0; k < nextHopCount; k++) {
+            vertexState.nextHops.push_back(routingInfo->getNextHop(k));
+        }
+        treeVertices[i] = lsa;
+    }
+    spfVertices.swap(newSPFVertices);
+
+    recalculatedCount = 0;
+    for (i = 0; i < graph.vertices.size(); i++) {
+        if (graph.affected[i]) {
+            recalculatedCount++;
+        }
+    }
+    return true;
+}
+
+void OSPF::Area::addIntraAreaRoute(OSPFLSA* vertex, OSPFLSA* previousVertex,
+                                   std::vector<OSPF::RoutingTableEntry*>& newRoutingTable,
+                                   OSPF::RoutingTableIndex& routeIndex)
+{
+    unsigned long i;
+
+    if (vertex->getHeader().getLsType() == ROUTERLSA_TYPE) {
+        OSPF::RouterLSA* routerLSA = check_and_cast<OSPF::RouterLSA*> (vertex);
+        if (routerLSA->getB_AreaBorderRouter() || routerLSA->getE_ASBoundaryRouter()) {
+            OSPF::RoutingTableEntry* entry = new OSPF::RoutingTableEntry;
+            OSPF::RouterID destinationID = routerLSA->getHeader().getLinkStateID();
+            unsigned int nextHopCount = routerLSA->getNextHopCount();
+            OSPF::RoutingTableEntry::RoutingDestinationType destinationType = OSPF::RoutingTableEntry::NETWORK_DESTINATION;
+
+            entry->setDestination(destinationID);
+            entry->setLinkStateOrigin(routerLSA);
+            entry->setArea(areaID);
+            entry->setPathType(OSPF::RoutingTableEntry::INTRAAREA);
+            entry->setCost(routerLSA->getDistance());
+            if (routerLSA->getB_AreaBorderRouter()) {
+                destinationType |= OSPF::RoutingTableEntry::AREA_BORDER_ROUTER_DESTINATION;
+            }
+            if (routerLSA->getE_ASBoundaryRouter()) {
+                destinationType |= OSPF::RoutingTableEntry::AS_BOUNDARY_ROUTER_DESTINATION;
+            }
+            entry->setDestinationType(destinationType);
+            entry->setOptionalCapabilities(routerLSA->getHeader().getLsOptions());
+            for (i = 0; i < nextHopCount; i++) {
+                entry->addNextHop(routerLSA->getNextHop(i));
+            }
+
+            newRoutingTable.push_back(entry);
+            routeIndex.addEntry(newRoutingTable.size() - 1);
+
+            OSPF::Area* backbone;
+            if (areaID != OSPF::BACKBONE_AREAID) {
+                backbone = parentRouter->getAreaByID(OSPF::BACKBONE_AREAID);
+            } else {
+                backbone = this;
+            }
+            if (backbone != NULL) {
+                OSPF::Interface* virtualIntf = backbone->findVirtualLink(destinationID);
+                if ((virtualIntf != NULL) && (virtualIntf->getTransitAreaID() == areaID)) {
+                    OSPF::IPv4AddressRange range;
+                    range.address = getInterface(routerLSA->getNextHop(0).ifIndex)->getAddressRange().address;
+                    range.mask = IPv4Address::ALLONES_ADDRESS;
+                    virtualIntf->setAddressRange(range);
+                    virtualIntf->setIfIndex(routerLSA->getNextHop(0).ifIndex);
+                    virtualIntf->setOutputCost(routerLSA->getDistance());
+                    OSPF::Neighbor* virtualNeighbor = virtualIntf->getNeighbor(0);
+                    if (virtualNeighbor != NULL) {
+                        unsigned int linkCount = routerLSA->getLinksArraySize();
+                        OSPF::RouterLSA* toRouterLSA = dynamic_cast<OSPF::RouterLSA*> (previousVertex);
+                        if (toRouterLSA != NULL) {
+                            for (i = 0; i < linkCount; i++) {
+                                Link& link = routerLSA->getLinks(i);
+
+                                if ((link.getType() == POINTTOPOINT_LINK) &&
+                                    (link.getLinkID() == toRouterLSA->getHeader().getLinkStateID()) &&
+                                    (virtualIntf->getState() < OSPF::Interface::WAITING_STATE))
+                                {
+                                    virtualNeighbor->setAddress(IPv4Address(link.getLinkData()));
+                                    virtualIntf->processEvent(OSPF::Interface::INTERFACE_UP);
+                                    break;
+                                }
+                            }
+                        } else {
+                            OSPF::NetworkLSA* toNetworkLSA = dynamic_cast<OSPF::NetworkLSA*> (previousVertex);
+                            if (toNetworkLSA != NULL) {
+                                for (i = 0; i < linkCount; i++) {
+                                    Link& link = routerLSA->getLinks(i);
+
+                                    if ((link.getType() == TRANSIT_LINK) &&
+                                        (link.getLinkID() == toNetworkLSA->getHeader().getLinkStateID()) &&
+                                        (virtualIntf->getState() < OSPF::Interface::WAITING_STATE))
+                                    {
+                                        virtualNeighbor->setAddress(IPv4Address(link.getLinkData()));
+                                        virtualIntf->processEvent(OSPF::Interface::INTERFACE_UP);
+                                        break;
                                     }
                                 }
                             }
@@ -1672,65 +2275,60 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
                     }
                 }
             }
+        }
+    }
 
-            if (closestVertex->getHeader().getLsType() == NETWORKLSA_TYPE) {
-                OSPF::NetworkLSA* networkLSA = check_and_cast<OSPF::NetworkLSA*> (closestVertex);
-                IPv4Address destinationID = (networkLSA->getHeader().getLinkStateID() & networkLSA->getNetworkMask());
-                unsigned int nextHopCount = networkLSA->getNextHopCount();
-                bool overWrite = false;
-                OSPF::RoutingTableEntry* entry = NULL;
-                unsigned long routeCount = newRoutingTable.size();
-                IPv4Address longestMatch(0u);
-
-                for (i = 0; i < routeCount; i++) {
-                    if (newRoutingTable[i]->getDestinationType() == OSPF::RoutingTableEntry::NETWORK_DESTINATION) {
-                        OSPF::RoutingTableEntry* routingEntry = newRoutingTable[i];
-                        IPv4Address entryAddress = routingEntry->getDestination();
-                        IPv4Address entryMask = routingEntry->getNetmask();
-
-                        if ((entryAddress & entryMask) == (destinationID & entryMask)) {
-                            if ((destinationID & entryMask) > longestMatch) {
-                                longestMatch = (destinationID & entryMask);
-                                entry = routingEntry;
-                            }
-                        }
-                    }
-                }
-                if (entry != NULL) {
-                    const OSPFLSA* entryOrigin = entry->getLinkStateOrigin();
-                    if ((entry->getCost() != networkLSA->getDistance()) ||
-                        (entryOrigin->getHeader().getLinkStateID() >= networkLSA->getHeader().getLinkStateID()))
-                    {
-                        overWrite = true;
-                    }
-                }
+    if (vertex->getHeader().getLsType() == NETWORKLSA_TYPE) {
+        OSPF::NetworkLSA* networkLSA = check_and_cast<OSPF::NetworkLSA*> (vertex);
+        IPv4Address destinationID = (networkLSA->getHeader().getLinkStateID() & networkLSA->getNetworkMask());
+        unsigned int nextHopCount = networkLSA->getNextHopCount();
+        bool overWrite = false;
+        int position = routeIndex.findLongestMatch(destinationID.getInt());
+        OSPF::RoutingTableEntry* entry = (position != -1) ? newRoutingTable[position] : NULL;
 
-                if ((entry == NULL) || (overWrite)) {
-                    if (entry == NULL) {
-                        entry = new OSPF::RoutingTableEntry;
-                    }
+        if (entry != NULL) {
+            const OSPFLSA* entryOrigin = entry->getLinkStateOrigin();
+            if ((entry->getCost() != networkLSA->getDistance()) ||
+                (entryOrigin->getHeader().getLinkStateID() >= networkLSA->getHeader().getLinkStateID()))
+            {
+                overWrite = true;
+            }
+        }
 
-                    entry->setDestination(IPv4Address(destinationID));
-                    entry->setNetmask(networkLSA->getNetworkMask());
-                    entry->setLinkStateOrigin(networkLSA);
-                    entry->setArea(areaID);
-                    entry->setPathType(OSPF::RoutingTableEntry::INTRAAREA);
-                    entry->setCost(networkLSA->getDistance());
-                    entry->setDestinationType(OSPF::RoutingTableEntry::NETWORK_DESTINATION);
-                    entry->setOptionalCapabilities(networkLSA->getHeader().getLsOptions());
-                    for (i = 0; i < nextHopCount; i++) {
-                        entry->addNextHop(networkLSA->getNextHop(i));
-                    }
+        if ((entry == NULL) || (overWrite)) {
+            if (entry == NULL) {
+                entry = new OSPF::RoutingTableEntry;
+            } else {
+                routeIndex.removeEntry(position);
+            }
 
-                    if (!overWrite) {
-                        newRoutingTable.push_back(entry);
-                    }
-                }
+            entry->setDestination(IPv4Address(destinationID));
+            entry->setNetmask(networkLSA->getNetworkMask());
+            entry->setLinkStateOrigin(networkLSA);
+            entry->setArea(areaID);
+            entry->setPathType(OSPF::RoutingTableEntry::INTRAAREA);
+            entry->setCost(networkLSA->getDistance());
+            entry->setDestinationType(OSPF::RoutingTableEntry::NETWORK_DESTINATION);
+            entry->setOptionalCapabilities(networkLSA->getHeader().getLsOptions());
+            for (i = 0; i < nextHopCount; i++) {
+                entry->addNextHop(networkLSA->getNextHop(i));
             }
 
-            justAddedVertex = closestVertex;
+            if (!overWrite) {
+                newRoutingTable.push_back(entry);
+                routeIndex.addEntry(newRoutingTable.size() - 1);
+            } else {
+                routeIndex.addEntry(position);
+            }
         }
-    } while (!finished);
+    }
+}
+
+void OSPF::Area::addStubRoutes(const std::vector<OSPFLSA*>& treeVertices,
+                               std::vector<OSPF::RoutingTableEntry*>& newRoutingTable,
+                               OSPF::RoutingTableIndex& routeIndex)
+{
+    unsigned long i, j, k;
 
     unsigned int treeSize = treeVertices.size();
     for (i = 0; i < treeSize; i++) {
@@ -1748,24 +2346,8 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
 
             unsigned long distance = routerVertex->getDistance() + link.getLinkCost();
             unsigned long destinationID = (link.getLinkID().getInt() & link.getLinkData());
-            OSPF::RoutingTableEntry* entry = NULL;
-            unsigned long routeCount = newRoutingTable.size();
-            unsigned long longestMatch = 0;
-
-            for (k = 0; k < routeCount; k++) {
-                if (newRoutingTable[k]->getDestinationType() == OSPF::RoutingTableEntry::NETWORK_DESTINATION) {
-                    OSPF::RoutingTableEntry* routingEntry = newRoutingTable[k];
-                    unsigned long entryAddress = routingEntry->getDestination().getInt();
-                    unsigned long entryMask = routingEntry->getNetmask().getInt();
-
-                    if ((entryAddress & entryMask) == (destinationID & entryMask)) {
-                        if ((destinationID & entryMask) > longestMatch) {
-                            longestMatch = (destinationID & entryMask);
-                            entry = routingEntry;
-                        }
-                    }
-                }
-            }
+            int position = routeIndex.findLongestMatch(destinationID);
+            OSPF::RoutingTableEntry* entry = (position != -1) ? newRoutingTable[position] : NULL;
 
             if (entry != NULL) {
                 Metric entryCost = entry->getCost();
@@ -1822,6 +2404,7 @@ void OSPF::Area::calculateShortestPathTree(std::vector<OSPF::RoutingTableEntry*>
                 delete newNextHops;
 
                 newRoutingTable.push_back(entry);
+                routeIndex.addEntry(newRoutingTable.size() - 1);
             }
         }
     }
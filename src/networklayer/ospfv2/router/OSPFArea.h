@@ -30,9 +30,36 @@
 namespace OSPF {
 
 class Router;
+class RoutingTableIndex;
 
 class Area : public cObject {
 private:
+    /**
+     * A link of a vertex of the shortest path tree, as examined by Dijkstra's
+     * algorithm (RFC2328 16.1 (2)): the joining vertex and the cost of the link.
+     */
+    struct VertexLink {
+        OSPFLSA*            vertex;
+        unsigned long       cost;
+    };
+
+    /**
+     * A vertex of the last calculated shortest path tree, kept for the incremental SPF.
+     * Vertices are referred to by their index in spfVertices; the LSA objects themselves
+     * may be replaced or deleted between two calculations.
+     */
+    struct SPFVertex {
+        LSAType             type;
+        LinkStateID         linkStateID;
+        unsigned long       distance;
+        std::vector<std::pair<int, unsigned long> > links;  // (joining vertex, cost) in the order the links were examined
+        std::vector<int>    dagParents;     // the vertices the next hops come from (once per link), in tree order
+        std::vector<NextHop> nextHops;
+    };
+
+    static simsignal_t spfDurationSignal;
+    static simsignal_t spfVerticesSignal;
+
     AreaID                                                  areaID;
     std::map<IPv4AddressRange, bool>                        advertiseAddressRanges;
     std::vector<IPv4AddressRange>                           areaAddressRanges;
@@ -48,6 +75,7 @@ private:
     bool                                                    externalRoutingCapability;
     Metric                                                  stubDefaultCost;
     RouterLSA*                                              spfTreeRoot;
+    std::vector<SPFVertex>                                  spfVertices;    ///< The last shortest path tree in the order the vertices were added; empty if not valid.
 
     Router*                                                 parentRouter;
 public:
@@ -126,6 +154,20 @@ private:
     std::vector<NextHop>* calculateNextHops(OSPFLSA* destination, OSPFLSA* parent) const;
     std::vector<NextHop>* calculateNextHops(Link& destination, OSPFLSA* parent) const;
 
+    OSPFLSA*              findVertexLSA(LSAType type, LinkStateID linkStateID);
+    void                  getVertexLinks(OSPFLSA* vertex, std::vector<VertexLink>& links);
+    void                  calculateFullShortestPathTree(std::vector<RoutingTableEntry*>& newRoutingTable,
+                                                        RoutingTableIndex& routeIndex,
+                                                        std::vector<OSPFLSA*>& treeVertices,
+                                                        bool keepState);
+    bool                  repairShortestPathTree(std::vector<OSPFLSA*>& treeVertices, unsigned long& recalculatedCount);
+    void                  addIntraAreaRoute(OSPFLSA* vertex, OSPFLSA* previousVertex,
+                                            std::vector<RoutingTableEntry*>& newRoutingTable,
+                                            RoutingTableIndex& routeIndex);
+    void                  addStubRoutes(const std::vector<OSPFLSA*>& treeVertices,
+                                        std::vector<RoutingTableEntry*>& newRoutingTable,
+                                        RoutingTableIndex& routeIndex);
+
     LinkStateID           getUniqueLinkStateID(IPv4AddressRange destination,
                                                Metric destinationCost,
                                                SummaryLSA*& lsaToReoriginate) const;
@@ -23,7 +23,9 @@
 
 OSPF::Router::Router(OSPF::RouterID id, cSimpleModule* containingModule) :
     routerID(id),
-    rfc1583Compatibility(false)
+    rfc1583Compatibility(false),
+    incrementalSPF(false),
+    recordSPFDuration(false)
 {
     messageHandler = new OSPF::MessageHandler(this, containingModule);
     ageTimer = new OSPFTimer();
@@ -50,6 +50,8 @@ private:
     std::vector<RoutingTableEntry*>                                    routingTable;            ///< The OSPF routing table - contains more information than the one in the IP layer.
     MessageHandler*                                                    messageHandler;          ///< The message dispatcher class.
     bool                                                               rfc1583Compatibility;    ///< Decides whether to handle the preferred routing table entry to an AS boundary router as defined in RFC1583 or not.
+    bool                                                               incrementalSPF;          ///< Whether the Areas repair their shortest path trees instead of recalculating them from scratch.
+    bool                                                               recordSPFDuration;       ///< Whether the Areas emit the CPU time of each shortest path calculation.
 
 public:
     /**
@@ -68,6 +70,10 @@ public:
     RouterID                 getRouterID() const  { return routerID; }
     void                     setRFC1583Compatibility(bool compatibility)  { rfc1583Compatibility = compatibility; }
     bool                     getRFC1583Compatibility() const  { return rfc1583Compatibility; }
+    void                     setIncrementalSPF(bool incremental)  { incrementalSPF = incremental; }
+    bool                     getIncrementalSPF() const  { return incrementalSPF; }
+    void                     setRecordSPFDuration(bool record)  { recordSPFDuration = record; }
+    bool                     getRecordSPFDuration() const  { return recordSPFDuration; }
     unsigned long            getAreaCount() const  { return areas.size(); }
 
     MessageHandler*          getMessageHandler()  { return messageHandler; }
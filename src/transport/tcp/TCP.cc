@@ -48,6 +48,8 @@ bool TCP::logverbose;
 
 #define EPHEMERAL_PORTRANGE_START 1024
 #define EPHEMERAL_PORTRANGE_END   5000
+#define EPHEMERAL_PORTRANGE_SIZE  (EPHEMERAL_PORTRANGE_END - EPHEMERAL_PORTRANGE_START)
+
 
 static std::ostream& operator<<(std::ostream& os, const TCP::SockPair& sp)
 {
@@ -69,6 +71,28 @@ static std::ostream& operator<<(std::ostream& os, const TCPConnection& conn)
     return os;
 }
 
+static std::ostream& operator<<(std::ostream& os, const TCP::SockPairTable& table)
+{
+    os << table.size() << " connections";
+    return os;
+}
+
+static inline uint32 hashAddress(const IPvXAddress& addr)
+{
+    const uint32 *w = addr.words();
+    return addr.isIPv6() ? (w[0] ^ w[1] ^ w[2] ^ w[3]) : w[0];
+}
+
+
+unsigned int TCP::SockPairHash::operator()(const SockPair& key) const
+{
+    uint32 h = hashAddress(key.remoteAddr);
+    h = h * 31 + hashAddress(key.localAddr);
+    h = h * 31 + (uint32)key.remotePort;
+    h = h * 31 + (uint32)key.localPort;
+    return fibonacciHash32(h);
+}
+
 
 void TCP::initialize()
 {
@@ -82,9 +106,14 @@ void TCP::initialize()
         error("Don't use obsolete receiveQueueClass = \"%s\" parameter", q);
 
     lastEphemeralPort = EPHEMERAL_PORTRANGE_START;
+    ephemeralPortUsage.assign(EPHEMERAL_PORTRANGE_SIZE, 0);
+    ephemeralPortBitmap.assign((EPHEMERAL_PORTRANGE_SIZE + 31) / 32, 0);
+    numUsedEphemeralPorts = 0;
     WATCH(lastEphemeralPort);
+    WATCH(numUsedEphemeralPorts);
 
-    WATCH_PTRMAP(tcpConnMap);
+    WATCH(tcpConnTable);
+    WATCH_PTRMAP(tcpListenMap);
     WATCH_PTRMAP(tcpAppConnMap);
 
     recordStatistics = par("recordStats");
@@ -279,39 +308,62 @@ TCPConnection *TCP::findConnForSegment(TCPSegment *tcpseg, IPvXAddress srcAddr,
     SockPair save = key;
 
     // try with fully qualified SockPair
-    TcpConnMap::iterator i;
-    i = tcpConnMap.find(key);
-
-    if (i != tcpConnMap.end())
-        return i->second;
+    TCPConnection *conn = tcpConnTable.find(key);
+    if (conn)
+        return conn;
 
     // try with localAddr missing (only localPort specified in passive/active open)
     key.localAddr = IPvXAddress();
-    i = tcpConnMap.find(key);
+    conn = tcpConnTable.find(key);
+    if (conn)
+        return conn;
 
-    if (i != tcpConnMap.end())
-        return i->second;
+    // the remaining candidates are listening connections
+    if (tcpListenMap.empty())
+        return NULL;
 
     // try fully qualified local socket + blank remote socket (for incoming SYN)
     key = save;
     key.remoteAddr = IPvXAddress();
     key.remotePort = -1;
-    i = tcpConnMap.find(key);
+    TcpConnMap::iterator i = tcpListenMap.find(key);
 
-    if (i != tcpConnMap.end())
+    if (i != tcpListenMap.end())
         return i->second;
 
     // try with blank remote socket, and localAddr missing (for incoming SYN)
     key.localAddr = IPvXAddress();
-    i = tcpConnMap.find(key);
+    i = tcpListenMap.find(key);
 
-    if (i != tcpConnMap.end())
+    if (i != tcpListenMap.end())
         return i->second;
 
     // given up
     return NULL;
 }
 
+TCPConnection *TCP::lookupSockPair(const SockPair& key)
+{
+    if (!isListeningSockPair(key))
+        return tcpConnTable.find(key);
+    TcpConnMap::iterator it = tcpListenMap.find(key);
+    return it == tcpListenMap.end() ? NULL : it->second;
+}
+
+bool TCP::insertSockPair(const SockPair& key, TCPConnection *conn)
+{
+    if (!isListeningSockPair(key))
+        return tcpConnTable.insert(key, conn);
+    return tcpListenMap.insert(std::make_pair(key, conn)).second;
+}
+
+bool TCP::eraseSockPair(const SockPair& key)
+{
+    if (!isListeningSockPair(key))
+        return tcpConnTable.remove(key);
+    return tcpListenMap.erase(key) > 0;
+}
+
 TCPConnection *TCP::findConnForApp(int appGateIndex, int connId)
 {
     AppConnKey key;
@@ -324,24 +376,67 @@ TCPConnection *TCP::findConnForApp(int appGateIndex, int connId)
 
 ushort TCP::getEphemeralPort()
 {
+    if (numUsedEphemeralPorts == EPHEMERAL_PORTRANGE_SIZE)
+        error("Ephemeral port range %d..%d exhausted, all ports occupied", EPHEMERAL_PORTRANGE_START, EPHEMERAL_PORTRANGE_END);
+
     // start at the last allocated port number + 1, and search for an unused one
-    ushort searchUntil = lastEphemeralPort++;
-    if (lastEphemeralPort == EPHEMERAL_PORTRANGE_END) // wrap
-        lastEphemeralPort = EPHEMERAL_PORTRANGE_START;
+    int start = lastEphemeralPort + 1 - EPHEMERAL_PORTRANGE_START;
+    if (start == EPHEMERAL_PORTRANGE_SIZE) // wrap
+        start = 0;
 
-    while (usedEphemeralPorts.find(lastEphemeralPort) != usedEphemeralPorts.end())
-    {
-        if (lastEphemeralPort == searchUntil) // got back to starting point?
-            error("Ephemeral port range %d..%d exhausted, all ports occupied", EPHEMERAL_PORTRANGE_START, EPHEMERAL_PORTRANGE_END);
+    int index = findUnusedEphemeralPort(start, EPHEMERAL_PORTRANGE_SIZE);
+    if (index == -1)
+        index = findUnusedEphemeralPort(0, start);
+    ASSERT(index != -1);
 
-        lastEphemeralPort++;
+    // found a free one, return it
+    lastEphemeralPort = EPHEMERAL_PORTRANGE_START + index;
+    return lastEphemeralPort;
+}
 
-        if (lastEphemeralPort == EPHEMERAL_PORTRANGE_END) // wrap
-            lastEphemeralPort = EPHEMERAL_PORTRANGE_START;
+int TCP::findUnusedEphemeralPort(int from, int to)
+{
+    // returns the index of the first clear bit in [from, to) of the bitmap,
+    // or -1; skips fully used 32-port blocks with a single comparison
+    int i = from;
+    while (i < to)
+    {
+        uint32 word = ephemeralPortBitmap[i / 32] | ((1u << (i % 32)) - 1); // ignore bits below i
+        if (word != 0xffffffffu)
+        {
+            int bit = 0;
+            while (word & (1u << bit))
+                bit++;
+            int index = (i / 32) * 32 + bit;
+            return index < to ? index : -1;
+        }
+        i = (i / 32 + 1) * 32;
     }
+    return -1;
+}
 
-    // found a free one, return it
-    return lastEphemeralPort;
+void TCP::markEphemeralPortUsed(int port)
+{
+    if (port < EPHEMERAL_PORTRANGE_START || port >= EPHEMERAL_PORTRANGE_END)
+        return;
+    int index = port - EPHEMERAL_PORTRANGE_START;
+    if (ephemeralPortUsage[index]++ == 0)
+    {
+        ephemeralPortBitmap[index / 32] |= 1u << (index % 32);
+        numUsedEphemeralPorts++;
+    }
+}
+
+void TCP::releaseEphemeralPort(int port)
+{
+    if (port < EPHEMERAL_PORTRANGE_START || port >= EPHEMERAL_PORTRANGE_END)
+        return;
+    int index = port - EPHEMERAL_PORTRANGE_START;
+    if (ephemeralPortUsage[index] > 0 && --ephemeralPortUsage[index] == 0)
+    {
+        ephemeralPortBitmap[index / 32] &= ~(1u << (index % 32));
+        numUsedEphemeralPorts--;
+    }
 }
 
 void TCP::addSockPair(TCPConnection *conn, IPvXAddress localAddr, IPvXAddress remoteAddr, int localPort, int remotePort)
@@ -353,9 +448,8 @@ void TCP::addSockPair(TCPConnection *conn, IPvXAddress localAddr, IPvXAddress re
     key.localPort = conn->localPort = localPort;
     key.remotePort = conn->remotePort = remotePort;
 
-    // make sure connection is unique
-    TcpConnMap::iterator it = tcpConnMap.find(key);
-    if (it != tcpConnMap.end())
+    // make sure connection is unique, then insert it into the lookup tables
+    if (!insertSockPair(key, conn))
     {
         // throw "address already in use" error
         if (remoteAddr.isUnspecified() && remotePort == -1)
@@ -366,12 +460,8 @@ void TCP::addSockPair(TCPConnection *conn, IPvXAddress localAddr, IPvXAddress re
                   localAddr.str().c_str(), localPort, remoteAddr.str().c_str(), remotePort);
     }
 
-    // then insert it into tcpConnMap
-    tcpConnMap[key] = conn;
-
     // mark port as used
-    if (localPort >= EPHEMERAL_PORTRANGE_START && localPort < EPHEMERAL_PORTRANGE_END)
-        usedEphemeralPorts.insert(localPort);
+    markEphemeralPortUsed(localPort);
 }
 
 void TCP::updateSockPair(TCPConnection *conn, IPvXAddress localAddr, IPvXAddress remoteAddr, int localPort, int remotePort)
@@ -382,21 +472,21 @@ void TCP::updateSockPair(TCPConnection *conn, IPvXAddress localAddr, IPvXAddress
     key.remoteAddr = conn->remoteAddr;
     key.localPort = conn->localPort;
     key.remotePort = conn->remotePort;
-    TcpConnMap::iterator it = tcpConnMap.find(key);
 
-    ASSERT(it != tcpConnMap.end() && it->second == conn);
+    ASSERT(lookupSockPair(key) == conn);
 
-    // ...and remove from the old place in tcpConnMap
-    tcpConnMap.erase(it);
+    // ...and remove from the old place
+    eraseSockPair(key);
 
-    // then update addresses/ports, and re-insert it with new key into tcpConnMap
+    // then update addresses/ports, and re-insert it with new key
     key.localAddr = conn->localAddr = localAddr;
     key.remoteAddr = conn->remoteAddr = remoteAddr;
     ASSERT(conn->localPort == localPort);
     key.remotePort = conn->remotePort = remotePort;
-    tcpConnMap[key] = conn;
+    eraseSockPair(key); // replace any existing entry with the same key
+    insertSockPair(key, conn);
 
-    // localPort doesn't change (see ASSERT above), so there's no need to update usedEphemeralPorts[].
+    // localPort doesn't change (see ASSERT above), so there's no need to update the ephemeral port usage.
 }
 
 void TCP::addForkedConnection(TCPConnection *conn, TCPConnection *newConn, IPvXAddress localAddr, IPvXAddress remoteAddr, int localPort, int remotePort)
@@ -433,21 +523,18 @@ void TCP::removeConnection(TCPConnection *conn)
     key2.remoteAddr = conn->remoteAddr;
     key2.localPort = conn->localPort;
     key2.remotePort = conn->remotePort;
-    tcpConnMap.erase(key2);
-
-    // IMPORTANT: usedEphemeralPorts.erase(conn->localPort) is NOT GOOD because it
-    // deletes ALL occurrences of the port from the multiset.
-    std::multiset<ushort>::iterator it = usedEphemeralPorts.find(conn->localPort);
+    eraseSockPair(key2);
 
-    if (it != usedEphemeralPorts.end())
-        usedEphemeralPorts.erase(it);
+    // the port may be used by several connections (e.g. forked ones), so only
+    // one usage is released
+    releaseEphemeralPort(conn->localPort);
 
     delete conn;
 }
 
 void TCP::finish()
 {
-    tcpEV << getFullPath() << ": finishing with " << tcpConnMap.size() << " connections open.\n";
+    tcpEV << getFullPath() << ": finishing with " << tcpConnTable.size() + tcpListenMap.size() << " connections open.\n";
 }
 
 TCPSendQueue* TCP::createSendQueue(TCPDataTransferMode transferModeP)
@@ -20,11 +20,12 @@
 #define __INET_TCPMAIN_H
 
 #include <map>
-#include <set>
+#include <vector>
 
 #include "INETDefs.h"
 
 #include "IPvXAddress.h"
+#include "OpenAddressingHashTable.h"
 #include "TCPCommand_m.h"
 
 // Forward declarations:
@@ -134,6 +135,28 @@ class INET_API TCP : public cSimpleModule
             else
                 return localPort < b.localPort;
         }
+
+        inline bool operator==(const SockPair& b) const
+        {
+            return localPort == b.localPort && remotePort == b.remotePort &&
+                   remoteAddr == b.remoteAddr && localAddr == b.localAddr;
+        }
+    };
+
+    /** Hash function of socket pairs, for SockPairTable. */
+    struct SockPairHash
+    {
+        unsigned int operator()(const SockPair& key) const;
+    };
+
+    /**
+     * Hash table that maps socket pairs to connections, so a lookup costs
+     * O(1) on average independent of the number of connections.
+     */
+    class SockPairTable : public OpenAddressingHashTable<SockPair, TCPConnection *, SockPairHash>
+    {
+      public:
+        SockPairTable() : OpenAddressingHashTable<SockPair, TCPConnection *, SockPairHash>(NULL, 64) {}
     };
 
   protected:
@@ -141,10 +164,13 @@ class INET_API TCP : public cSimpleModule
     typedef std::map<SockPair, TCPConnection*> TcpConnMap;
 
     TcpAppConnMap tcpAppConnMap;
-    TcpConnMap tcpConnMap;
+    SockPairTable tcpConnTable; // connections with a specified remote socket
+    TcpConnMap tcpListenMap;    // connections with an unspecified remote socket (i.e. listening ones)
 
     ushort lastEphemeralPort;
-    std::multiset<ushort> usedEphemeralPorts;
+    std::vector<int> ephemeralPortUsage;    // number of connections using each port of the ephemeral range
+    std::vector<uint32> ephemeralPortBitmap; // bit set for each used port of the ephemeral range
+    int numUsedEphemeralPorts;
 
   protected:
     /** Factory method; may be overriden for customizing TCP */
@@ -157,6 +183,17 @@ class INET_API TCP : public cSimpleModule
     virtual void removeConnection(TCPConnection *conn);
     virtual void updateDisplayString();
 
+    // socket pair registration: dispatches between tcpConnTable and tcpListenMap
+    static bool isListeningSockPair(const SockPair& key) {return key.remotePort == -1 && key.remoteAddr.isUnspecified();}
+    virtual TCPConnection *lookupSockPair(const SockPair& key);
+    virtual bool insertSockPair(const SockPair& key, TCPConnection *conn);
+    virtual bool eraseSockPair(const SockPair& key);
+
+    // ephemeral port bookkeeping
+    virtual int findUnusedEphemeralPort(int from, int to);
+    virtual void markEphemeralPortUsed(int port);
+    virtual void releaseEphemeralPort(int port);
+
   public:
     static bool testing;    // switches between tcpEV and testingEV
     static bool logverbose; // if !testing, turns on more verbose logging
@@ -23,17 +23,22 @@
 TCPSACKRexmitQueue::TCPSACKRexmitQueue()
 {
     conn = NULL;
+    root = NULL;
+    randomState = 2463534242u;
+    beginOffset = 0;
     begin = end = 0;
 }
 
 TCPSACKRexmitQueue::~TCPSACKRexmitQueue()
 {
-    while (!rexmitQueue.empty())
-        rexmitQueue.pop_front();
+    deleteRegions(root);
 }
 
 void TCPSACKRexmitQueue::init(uint32 seqNum)
 {
+    deleteRegions(root);
+    root = NULL;
+    beginOffset = seqNum; // so that the low 32 bits of unwrapped sequence numbers are the sequence numbers
     begin = seqNum;
     end = seqNum;
 }
@@ -51,34 +56,271 @@ void TCPSACKRexmitQueue::info() const
     tcpEV << str() << endl;
 
     uint j = 1;
+    printRegions(root, j);
+}
+
+void TCPSACKRexmitQueue::printRegions(const Region *subtree, uint& j) const
+{
+    if (!subtree)
+        return;
+
+    printRegions(subtree->left, j);
+    tcpEV << j << ". region: [" << (uint32)subtree->beginSeqNum << ".." << (uint32)subtree->endSeqNum
+          << ") \t sacked=" << subtree->sacked << "\t rexmitted=" << subtree->rexmitted
+          << endl;
+    j++;
+    printRegions(subtree->right, j);
+}
+
+//
+// Summaries
+//
+void TCPSACKRexmitQueue::concatSummary(Summary& a, const Summary& b)
+{
+    if (b.numRegions == 0)
+        return;
+
+    if (a.numRegions == 0)
+    {
+        a = b;
+        return;
+    }
+
+    a.sackRuns += b.sackRuns;
+    if (a.lastSacked && b.firstSacked)
+        a.sackRuns--; // the two runs are adjacent, so they form a single run
+
+    a.numRegions += b.numRegions;
+    a.sackedBytes += b.sackedBytes;
+    a.numRexmitted += b.numRexmitted;
+    a.lastSacked = b.lastSacked;
+}
+
+TCPSACKRexmitQueue::Summary TCPSACKRexmitQueue::emptySummary()
+{
+    Summary s;
+    s.numRegions = s.sackedBytes = s.sackRuns = s.numRexmitted = 0;
+    s.firstSacked = s.lastSacked = false;
+    return s;
+}
 
-    for (RexmitQueue::const_iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
+TCPSACKRexmitQueue::Summary TCPSACKRexmitQueue::regionSummary(const Region *region)
+{
+    Summary s;
+    s.numRegions = 1;
+    s.sackedBytes = region->sacked ? (uint32)(region->endSeqNum - region->beginSeqNum) : 0;
+    s.sackRuns = region->sacked ? 1 : 0;
+    s.numRexmitted = region->rexmitted ? 1 : 0;
+    s.firstSacked = s.lastSacked = region->sacked;
+    return s;
+}
+
+void TCPSACKRexmitQueue::updateSummary(Region *region)
+{
+    Summary s = region->left ? region->left->summary : emptySummary();
+    concatSummary(s, regionSummary(region));
+    if (region->right)
+        concatSummary(s, region->right->summary);
+    region->summary = s;
+}
+
+TCPSACKRexmitQueue::Summary TCPSACKRexmitQueue::summarizeRegionsAbove(uint64 seqNum) const
+{
+    // collect the regions with endSeqNum > seqNum from right to left: whenever
+    // a region qualifies, so does its right subtree, and both precede the
+    // regions collected so far
+    Summary result = emptySummary();
+    const Region *region = root;
+
+    while (region)
     {
-        tcpEV << j << ". region: [" << i->beginSeqNum << ".." << i->endSeqNum
-              << ") \t sacked=" << i->sacked << "\t rexmitted=" << i->rexmitted
-              << endl;
-        j++;
+        if (region->endSeqNum > seqNum)
+        {
+            Summary s = regionSummary(region);
+            if (region->right)
+                concatSummary(s, region->right->summary);
+            concatSummary(s, result);
+            result = s;
+            region = region->left;
+        }
+        else
+            region = region->right;
     }
+
+    return result;
+}
+
+//
+// Treap operations
+//
+TCPSACKRexmitQueue::Region *TCPSACKRexmitQueue::createRegion(uint64 beginSeqNum, uint64 endSeqNum, bool sacked, bool rexmitted)
+{
+    // xorshift; deterministic, and independent of the simulation's RNGs
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+
+    Region *region = new Region();
+    region->beginSeqNum = beginSeqNum;
+    region->endSeqNum = endSeqNum;
+    region->sacked = sacked;
+    region->rexmitted = rexmitted;
+    region->priority = randomState;
+    region->left = region->right = NULL;
+    updateSummary(region);
+    return region;
 }
 
+TCPSACKRexmitQueue::Region *TCPSACKRexmitQueue::rotateLeft(Region *region)
+{
+    Region *newRoot = region->right;
+    region->right = newRoot->left;
+    newRoot->left = region;
+    updateSummary(region);
+    updateSummary(newRoot);
+    return newRoot;
+}
+
+TCPSACKRexmitQueue::Region *TCPSACKRexmitQueue::rotateRight(Region *region)
+{
+    Region *newRoot = region->left;
+    region->left = newRoot->right;
+    newRoot->right = region;
+    updateSummary(region);
+    updateSummary(newRoot);
+    return newRoot;
+}
+
+TCPSACKRexmitQueue::Region *TCPSACKRexmitQueue::insertRegion(Region *subtree, Region *region)
+{
+    if (!subtree)
+        return region;
+
+    if (region->beginSeqNum < subtree->beginSeqNum)
+    {
+        subtree->left = insertRegion(subtree->left, region);
+        updateSummary(subtree);
+        if (subtree->left->priority > subtree->priority)
+            subtree = rotateRight(subtree);
+    }
+    else
+    {
+        subtree->right = insertRegion(subtree->right, region);
+        updateSummary(subtree);
+        if (subtree->right->priority > subtree->priority)
+            subtree = rotateLeft(subtree);
+    }
+    return subtree;
+}
+
+void TCPSACKRexmitQueue::refreshPath(Region *subtree, uint64 beginSeqNum)
+{
+    if (!subtree)
+        return;
+
+    if (beginSeqNum < subtree->beginSeqNum)
+        refreshPath(subtree->left, beginSeqNum);
+    else if (beginSeqNum > subtree->beginSeqNum)
+        refreshPath(subtree->right, beginSeqNum);
+    updateSummary(subtree);
+}
+
+TCPSACKRexmitQueue::Region *TCPSACKRexmitQueue::discardRegions(Region *subtree, uint64 seqNum)
+{
+    // removes regions with endSeqNum <= seqNum
+    if (!subtree)
+        return NULL;
+
+    if (subtree->endSeqNum <= seqNum)
+    {
+        // the region and its left subtree go; the right subtree may partly remain
+        Region *remaining = discardRegions(subtree->right, seqNum);
+        deleteRegions(subtree->left);
+        delete subtree;
+        return remaining;
+    }
+
+    subtree->left = discardRegions(subtree->left, seqNum);
+    updateSummary(subtree);
+    return subtree;
+}
+
+void TCPSACKRexmitQueue::deleteRegions(Region *subtree)
+{
+    if (subtree)
+    {
+        deleteRegions(subtree->left);
+        deleteRegions(subtree->right);
+        delete subtree;
+    }
+}
+
+void TCPSACKRexmitQueue::resetFlags(Region *subtree, bool resetSacked, bool resetRexmitted)
+{
+    if (!subtree)
+        return;
+
+    resetFlags(subtree->left, resetSacked, resetRexmitted);
+    resetFlags(subtree->right, resetSacked, resetRexmitted);
+    if (resetSacked)
+        subtree->sacked = false;
+    if (resetRexmitted)
+        subtree->rexmitted = false;
+    updateSummary(subtree);
+}
+
+TCPSACKRexmitQueue::Region *TCPSACKRexmitQueue::findRegion(uint64 seqNum) const
+{
+    Region *region = root;
+
+    while (region)
+    {
+        if (seqNum < region->beginSeqNum)
+            region = region->left;
+        else if (seqNum >= region->endSeqNum)
+            region = region->right;
+        else
+            return region;
+    }
+
+    return NULL;
+}
+
+TCPSACKRexmitQueue::Region *TCPSACKRexmitQueue::splitRegion(Region *region, uint64 seqNum)
+{
+    ASSERT(region->beginSeqNum < seqNum && seqNum < region->endSeqNum);
+
+    Region *second = createRegion(seqNum, region->endSeqNum, region->sacked, region->rexmitted);
+    region->endSeqNum = seqNum;
+    regionChanged(region);
+    root = insertRegion(root, second);
+    return second;
+}
+
+//
+// Queue operations
+//
 void TCPSACKRexmitQueue::discardUpTo(uint32 seqNum)
 {
     ASSERT(seqLE(begin, seqNum) && seqLE(seqNum, end));
 
-    if (!rexmitQueue.empty())
-    {
-        RexmitQueue::iterator i = rexmitQueue.begin();
+    uint64 seq = unwrap(seqNum);
 
-        while ((i != rexmitQueue.end()) && seqLE(i->endSeqNum, seqNum)) // discard/delete regions from rexmit queue, which have been acked
-            i = rexmitQueue.erase(i);
+    if (root)
+    {
+        root = discardRegions(root, seq); // discard/delete regions from rexmit queue, which have been acked
 
-        if (i != rexmitQueue.end())
+        if (root)
         {
-            ASSERT(seqLE(i->beginSeqNum, seqNum) && seqLess(seqNum, i->endSeqNum));
-            i->beginSeqNum = seqNum;
+            // the first remaining region may be partially acked
+            Region *first = findRegion(seq);
+            ASSERT(first && first->beginSeqNum <= seq);
+            first->beginSeqNum = seq; // still the smallest key, so the tree order is not affected
+            regionChanged(first);
         }
     }
 
+    beginOffset = seq;
     begin = seqNum;
 
     // TESTING queue:
@@ -90,69 +332,61 @@ void TCPSACKRexmitQueue::enqueueSentData(uint32 fromSeqNum, uint32 toSeqNum)
     ASSERT(seqLE(begin, fromSeqNum) && seqLE(fromSeqNum, end));
 
     bool found = false;
-    Region region;
 
     tcpEV << "rexmitQ: " << str() << " enqueueSentData [" << fromSeqNum << ".." << toSeqNum << ")\n";
 
     ASSERT(seqLess(fromSeqNum, toSeqNum));
 
-    if (rexmitQueue.empty() || (end == fromSeqNum))
+    uint64 from = unwrap(fromSeqNum);
+    uint64 to = unwrap(toSeqNum);
+
+    if (!root || (end == fromSeqNum))
     {
-        region.beginSeqNum = fromSeqNum;
-        region.endSeqNum = toSeqNum;
-        region.sacked = false;
-        region.rexmitted = false;
-        rexmitQueue.push_back(region);
+        root = insertRegion(root, createRegion(from, to, false, false));
         found = true;
-        fromSeqNum = toSeqNum;
+        from = to;
     }
     else
     {
-        RexmitQueue::iterator i = rexmitQueue.begin();
+        Region *i = findRegion(from);
 
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum))
-            i++;
+        ASSERT(i != NULL);
 
-        ASSERT(i != rexmitQueue.end());
-        ASSERT(seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
+        if (i->beginSeqNum != from)
+            i = splitRegion(i, from); // chunk item
 
-        if (i->beginSeqNum != fromSeqNum)
+        while (i && i->endSeqNum <= to)
         {
-            // chunk item
-            region = *i;
-            region.endSeqNum = fromSeqNum;
-            rexmitQueue.insert(i, region);
-            i->beginSeqNum = fromSeqNum;
-        }
-
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, toSeqNum))
-        {
-            i->rexmitted = true;
-            fromSeqNum = i->endSeqNum;
+            if (!i->rexmitted)
+            {
+                i->rexmitted = true;
+                regionChanged(i);
+            }
+            from = i->endSeqNum;
             found = true;
-            i++;
+            i = getNextRegion(i);
         }
 
-        if (fromSeqNum != toSeqNum)
+        if (from != to)
         {
-            bool beforeEnd = (i != rexmitQueue.end());
-
-            ASSERT(i == rexmitQueue.end() || seqLess(i->beginSeqNum, toSeqNum));
-
-            region.beginSeqNum = fromSeqNum;
-            region.endSeqNum = toSeqNum;
-            region.sacked = beforeEnd ? i->sacked : false;
-            region.rexmitted = beforeEnd;
-            rexmitQueue.insert(i, region);
+            if (i)
+            {
+                // the region [from..to) inherits the sacked bit of i
+                ASSERT(i->beginSeqNum < to);
+                splitRegion(i, to);
+                i->rexmitted = true;
+                regionChanged(i);
+            }
+            else
+            {
+                root = insertRegion(root, createRegion(from, to, false, false));
+            }
             found = true;
-            fromSeqNum = toSeqNum;
-
-            if (beforeEnd)
-                i->beginSeqNum = toSeqNum;
+            from = to;
         }
     }
 
-    ASSERT(fromSeqNum == toSeqNum);
+    ASSERT(from == to);
 
     if (!found)
     {
@@ -162,8 +396,16 @@ void TCPSACKRexmitQueue::enqueueSentData(uint32 fromSeqNum, uint32 toSeqNum)
 
     ASSERT(found);
 
-    begin = rexmitQueue.front().beginSeqNum;
-    end = rexmitQueue.back().endSeqNum;
+    Region *first = root;
+    while (first->left)
+        first = first->left;
+    Region *last = root;
+    while (last->right)
+        last = last->right;
+
+    beginOffset = first->beginSeqNum;
+    begin = (uint32)first->beginSeqNum;
+    end = (uint32)last->endSeqNum;
 
     // TESTING queue:
     ASSERT(checkQueue());
@@ -171,19 +413,26 @@ void TCPSACKRexmitQueue::enqueueSentData(uint32 fromSeqNum, uint32 toSeqNum)
     // tcpEV << "rexmitQ: rexmitQLength=" << getQueueLength() << "\n";
 }
 
-bool TCPSACKRexmitQueue::checkQueue() const
+bool TCPSACKRexmitQueue::checkRegions(const Region *subtree, uint64& expectedBegin) const
 {
-    uint32 b = begin;
-    bool f = true;
+    if (!subtree)
+        return true;
+
+    bool f = checkRegions(subtree->left, expectedBegin);
+    f = f && (expectedBegin == subtree->beginSeqNum);
+    f = f && (subtree->beginSeqNum < subtree->endSeqNum);
+    f = f && (!subtree->left || subtree->left->priority <= subtree->priority);
+    f = f && (!subtree->right || subtree->right->priority <= subtree->priority);
+    expectedBegin = subtree->endSeqNum;
+    return f && checkRegions(subtree->right, expectedBegin);
+}
 
-    for (RexmitQueue::const_iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-    {
-        f = f && (b == i->beginSeqNum);
-        f = f && seqLess(i->beginSeqNum, i->endSeqNum);
-        b = i->endSeqNum;
-    }
+bool TCPSACKRexmitQueue::checkQueue() const
+{
+    uint64 b = beginOffset;
+    bool f = checkRegions(root, b);
 
-    f = f && (b == end);
+    f = f && ((uint32)b == end);
 
     if (!f)
     {
@@ -205,43 +454,33 @@ void TCPSACKRexmitQueue::setSackedBit(uint32 fromSeqNum, uint32 toSeqNum)
 
     bool found = false;
 
-    if (!rexmitQueue.empty())
+    if (root)
     {
-        RexmitQueue::iterator i = rexmitQueue.begin();
-
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum))
-            i++;
+        uint64 from = unwrap(fromSeqNum);
+        uint64 to = unwrap(toSeqNum);
+        Region *i = findRegion(from);
 
-        ASSERT(i != rexmitQueue.end() && seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
+        ASSERT(i != NULL);
 
-        if (i->beginSeqNum != fromSeqNum)
-        {
-            Region region = *i;
-
-            region.endSeqNum = fromSeqNum;
-            rexmitQueue.insert(i, region);
-            i->beginSeqNum = fromSeqNum;
-        }
+        if (i->beginSeqNum != from)
+            i = splitRegion(i, from);
 
-        while (i != rexmitQueue.end() && seqLE(i->endSeqNum, toSeqNum))
+        while (i && i->endSeqNum <= to)
         {
-            if (seqGE(i->beginSeqNum, fromSeqNum)) // Search region in queue!
+            found = true;
+            if (!i->sacked)
             {
-                found = true;
                 i->sacked = true; // set sacked bit
+                regionChanged(i);
             }
-
-            i++;
+            i = getNextRegion(i);
         }
 
-        if (i != rexmitQueue.end() && seqLess(i->beginSeqNum, toSeqNum) && seqLess(toSeqNum, i->endSeqNum))
+        if (i && i->beginSeqNum < to && to < i->endSeqNum)
         {
-            Region region = *i;
-
-            region.endSeqNum = toSeqNum;
-            region.sacked = true;
-            rexmitQueue.insert(i, region);
-            i->beginSeqNum = toSeqNum;
+            splitRegion(i, to);
+            i->sacked = true;
+            regionChanged(i);
         }
     }
 
@@ -255,25 +494,31 @@ bool TCPSACKRexmitQueue::getSackedBit(uint32 seqNum) const
 {
     ASSERT(seqLE(begin, seqNum) && seqLE(seqNum, end));
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
-
     if (end == seqNum)
         return false;
 
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, seqNum))
-        i++;
+    Region *i = findRegion(unwrap(seqNum));
 
-    ASSERT((i != rexmitQueue.end()) && seqLE(i->beginSeqNum, seqNum) && seqLess(seqNum, i->endSeqNum));
+    ASSERT(i != NULL);
 
     return i->sacked;
 }
 
 uint32 TCPSACKRexmitQueue::getHighestSackedSeqNum() const
 {
-    for (RexmitQueue::const_reverse_iterator i = rexmitQueue.rbegin(); i != rexmitQueue.rend(); i++)
+    // descend towards the last sacked region, using the subtree summaries
+    const Region *i = root;
+
+    while (i)
     {
-        if (i->sacked)
-            return i->endSeqNum;
+        if (i->right && i->right->summary.sackRuns > 0)
+            i = i->right;
+        else if (i->sacked)
+            return (uint32)i->endSeqNum;
+        else if (i->left && i->left->summary.sackRuns > 0)
+            i = i->left;
+        else
+            break;
     }
 
     return begin;
@@ -281,10 +526,19 @@ uint32 TCPSACKRexmitQueue::getHighestSackedSeqNum() const
 
 uint32 TCPSACKRexmitQueue::getHighestRexmittedSeqNum() const
 {
-    for (RexmitQueue::const_reverse_iterator i = rexmitQueue.rbegin(); i != rexmitQueue.rend(); i++)
+    // descend towards the last rexmitted region, using the subtree summaries
+    const Region *i = root;
+
+    while (i)
     {
-        if (i->rexmitted)
-            return i->endSeqNum;
+        if (i->right && i->right->summary.numRexmitted > 0)
+            i = i->right;
+        else if (i->rexmitted)
+            return (uint32)i->endSeqNum;
+        else if (i->left && i->left->summary.numRexmitted > 0)
+            i = i->left;
+        else
+            break;
     }
 
     return begin;
@@ -294,22 +548,16 @@ uint32 TCPSACKRexmitQueue::checkRexmitQueueForSackedOrRexmittedSegments(uint32 f
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLE(fromSeqNum, end));
 
-    if (rexmitQueue.empty() || (end == fromSeqNum))
+    if (!root || (end == fromSeqNum))
         return 0;
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
+    uint64 from = unwrap(fromSeqNum);
     uint32 bytes = 0;
 
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum))
-        i++;
-
-    while (i != rexmitQueue.end() && ((i->sacked || i->rexmitted)))
+    for (Region *i = findRegion(from); i && (i->sacked || i->rexmitted); i = getNextRegion(i))
     {
-        ASSERT(seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
-
-        bytes += (i->endSeqNum - fromSeqNum);
-        fromSeqNum = i->endSeqNum;
-        i++;
+        bytes += (uint32)(i->endSeqNum - from);
+        from = i->endSeqNum;
     }
 
     return bytes;
@@ -317,47 +565,33 @@ uint32 TCPSACKRexmitQueue::checkRexmitQueueForSackedOrRexmittedSegments(uint32 f
 
 void TCPSACKRexmitQueue::resetSackedBit()
 {
-    for (RexmitQueue::iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-        i->sacked = false; // reset sacked bit
+    resetFlags(root, true, false); // reset sacked bit
 }
 
 void TCPSACKRexmitQueue::resetRexmittedBit()
 {
-    for (RexmitQueue::iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-        i->rexmitted = false; // reset rexmitted bit
+    resetFlags(root, false, true); // reset rexmitted bit
 }
 
 uint32 TCPSACKRexmitQueue::getTotalAmountOfSackedBytes() const
 {
-    uint32 bytes = 0;
-
-    for (RexmitQueue::const_iterator i = rexmitQueue.begin(); i != rexmitQueue.end(); i++)
-    {
-        if (i->sacked)
-            bytes += (i->endSeqNum - i->beginSeqNum);
-    }
-
-    return bytes;
+    return root ? root->summary.sackedBytes : 0;
 }
 
 uint32 TCPSACKRexmitQueue::getAmountOfSackedBytes(uint32 fromSeqNum) const
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLE(fromSeqNum, end));
 
-    uint32 bytes = 0;
-    RexmitQueue::const_reverse_iterator i = rexmitQueue.rbegin();
+    if (!root || (fromSeqNum == end))
+        return 0;
 
-    for (; i != rexmitQueue.rend() && seqLE(fromSeqNum, i->beginSeqNum); i++)
-    {
-        if (i->sacked)
-            bytes += (i->endSeqNum - i->beginSeqNum);
-    }
+    uint64 from = unwrap(fromSeqNum);
+    uint32 bytes = summarizeRegionsAbove(from).sackedBytes;
 
-    if ( i != rexmitQueue.rend()
-            && seqLess(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum) && i->sacked)
-    {
-        bytes += (i->endSeqNum - fromSeqNum);
-    }
+    // only the part above fromSeqNum counts from the region containing it
+    Region *i = findRegion(from);
+    if (i && i->sacked)
+        bytes -= (uint32)(from - i->beginSeqNum);
 
     return bytes;
 }
@@ -366,43 +600,23 @@ uint32 TCPSACKRexmitQueue::getNumOfDiscontiguousSacks(uint32 fromSeqNum) const
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLE(fromSeqNum, end));
 
-    if (rexmitQueue.empty() || (fromSeqNum == end))
+    if (!root || (fromSeqNum == end))
         return 0;
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
-    uint32 counter = 0;
-
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum)) // search for seqNum
-        i++;
-
-    // search for discontiguous sacked regions
-    bool prevSacked = false;
-
-    while (i != rexmitQueue.end())
-    {
-        if (i->sacked && !prevSacked)
-            counter++;
-
-        prevSacked = i->sacked;
-        i++;
-    }
-
-    return counter;
+    // the region containing fromSeqNum starts a new run, whatever precedes it
+    return summarizeRegionsAbove(unwrap(fromSeqNum)).sackRuns;
 }
 
 void TCPSACKRexmitQueue::checkSackBlock(uint32 fromSeqNum, uint32 &length, bool &sacked, bool &rexmitted) const
 {
     ASSERT(seqLE(begin, fromSeqNum) && seqLess(fromSeqNum, end));
 
-    RexmitQueue::const_iterator i = rexmitQueue.begin();
-
-    while (i != rexmitQueue.end() && seqLE(i->endSeqNum, fromSeqNum)) // search for seqNum
-        i++;
+    uint64 from = unwrap(fromSeqNum);
+    Region *i = findRegion(from);
 
-    ASSERT(i != rexmitQueue.end());
-    ASSERT(seqLE(i->beginSeqNum, fromSeqNum) && seqLess(fromSeqNum, i->endSeqNum));
+    ASSERT(i != NULL);
 
-    length = (i->endSeqNum - fromSeqNum);
+    length = (uint32)(i->endSeqNum - from);
     sacked = i->sacked;
     rexmitted = i->rexmitted;
 }
@@ -26,26 +26,60 @@
 
 /**
  * Retransmission data for SACK.
+ *
+ * The queue is a sequence of contiguous, non-overlapping regions, each with
+ * a sacked and a rexmitted flag. The regions are stored in a treap (a
+ * randomized balanced binary search tree) ordered by sequence number, and
+ * every node caches a summary of its subtree (number of sacked bytes,
+ * number of runs of adjacent sacked regions, number of rexmitted regions).
+ * This makes looking up a region, updating the SACK scoreboard, and the
+ * queries used by the RFC 3517 IsLost() and NextSeg() routines O(log n)
+ * in the number of regions, instead of walking the whole queue.
+ *
+ * Sequence numbers are stored unwrapped to 64 bits inside the tree, so that
+ * they can be compared as plain integers.
  */
 class INET_API TCPSACKRexmitQueue
 {
   public:
     TCPConnection *conn;  // the connection that owns this queue
 
+  protected:
+    struct Summary
+    {
+        uint32 numRegions;
+        uint32 sackedBytes;    // total length of sacked regions
+        uint32 sackRuns;       // number of maximal runs of adjacent sacked regions
+        uint32 numRexmitted;   // number of rexmitted regions
+        bool firstSacked;      // whether the first region is sacked
+        bool lastSacked;       // whether the last region is sacked
+    };
+
     struct Region
     {
-        uint32 beginSeqNum;
-        uint32 endSeqNum;
+        uint64 beginSeqNum;
+        uint64 endSeqNum;
         bool sacked;      // indicates whether region has already been sacked by data receiver
         bool rexmitted;   // indicates whether region has already been retransmitted by data sender
+
+        uint32 priority;  // treap heap priority
+        Region *left;
+        Region *right;
+        Summary summary;  // summary of the subtree rooted at this region
     };
 
-    typedef std::list<Region> RexmitQueue;
-    RexmitQueue rexmitQueue; // rexmitQueue is ordered by seqnum, and doesn't have overlapped Regions
+    Region *root;         // regions are ordered by seqnum, and don't overlap
+    uint32 randomState;   // for treap priorities (the simulation's RNGs are deliberately not used)
+    uint64 beginOffset;   // 'begin', unwrapped
 
     uint32 begin;  // 1st sequence number stored
     uint32 end;    // last sequence number stored + 1
 
+  private:
+    // copying not supported: following are private and also left undefined
+    TCPSACKRexmitQueue(const TCPSACKRexmitQueue& other);
+    TCPSACKRexmitQueue& operator=(const TCPSACKRexmitQueue& other);
+
   public:
     /**
      * Ctor
@@ -120,7 +154,7 @@ class INET_API TCPSACKRexmitQueue
     /**
      * Returns the number of blocks currently buffered in queue.
      */
-    virtual uint32 getQueueLength() const { return rexmitQueue.size(); }
+    virtual uint32 getQueueLength() const { return root ? root->summary.numRegions : 0; }
 
     /**
      * Returns the highest sequence number sacked by data receiver.
@@ -177,6 +211,39 @@ class INET_API TCPSACKRexmitQueue
      * Returns if TCPSACKRexmitQueue is valid or not.
      */
     bool checkQueue() const;
+
+    // treap utilities
+    uint64 unwrap(uint32 seqNum) const { return beginOffset + (uint32)(seqNum - begin); }
+    Region *createRegion(uint64 beginSeqNum, uint64 endSeqNum, bool sacked, bool rexmitted);
+    static Summary emptySummary();
+    static Summary regionSummary(const Region *region);
+    static void concatSummary(Summary& a, const Summary& b);
+    static void updateSummary(Region *region);
+    static Region *rotateLeft(Region *region);
+    static Region *rotateRight(Region *region);
+    static Region *insertRegion(Region *subtree, Region *region);
+    static void refreshPath(Region *subtree, uint64 beginSeqNum);
+    static Region *discardRegions(Region *subtree, uint64 seqNum);
+    static void deleteRegions(Region *subtree);
+    static void resetFlags(Region *subtree, bool resetSacked, bool resetRexmitted);
+
+    /** Returns the region containing seqNum, or NULL. */
+    Region *findRegion(uint64 seqNum) const;
+
+    /** Returns the region following the given one, or NULL. */
+    Region *getNextRegion(const Region *region) const { return findRegion(region->endSeqNum); }
+
+    /** Cuts the region into two at seqNum (both keep the flags), and returns the second one. */
+    Region *splitRegion(Region *region, uint64 seqNum);
+
+    /** Marks the region's flags as modified: updates the summaries on the path from the root. */
+    void regionChanged(Region *region) { refreshPath(root, region->beginSeqNum); }
+
+    /** Returns the summary of the regions ending above seqNum. */
+    Summary summarizeRegionsAbove(uint64 seqNum) const;
+
+    void printRegions(const Region *subtree, uint& j) const;
+    bool checkRegions(const Region *subtree, uint64& expectedBegin) const;
 };
 
 #endif
@@ -43,19 +43,20 @@ bool TCPByteStreamRcvQueue::Region::merge(const TCPVirtualDataRcvQueue::Region*
 
     if (nbegin != begin || nend != end)
     {
-        char *buff = new char[nend-nbegin];
+        // build the merged region from slices of the two regions, without copying bytes
+        ByteArrayBuffer ndata;
 
         if (nbegin != begin)
-            other->data.copyDataToBuffer(buff, begin - nbegin);
+            ndata.push(other->data, 0, begin - nbegin);
 
-        data.copyDataToBuffer(buff + begin - nbegin, end - begin);
+        ndata.push(data, 0, end - begin);
 
         if (nend != end)
-            other->data.copyDataToBuffer(buff + end - nbegin, nend - end);
+            ndata.push(other->data, end - other->begin, nend - end);
 
         begin = nbegin;
         end = nend;
-        data.assignBuffer(buff, end - begin);
+        data = ndata;
     }
 
     return true;
@@ -66,19 +67,20 @@ TCPByteStreamRcvQueue::Region* TCPByteStreamRcvQueue::Region::split(uint32 seq)
     ASSERT(seqGreater(seq, begin) && seqLess(seq, end));
 
     Region *reg = new Region(begin, seq);
-    reg->data.setDataFromByteArray(data, 0, seq - begin);
-    data.truncateData(seq - begin);
+    reg->data.push(data, 0, seq - begin);
+    data.drop(seq - begin);
     begin = seq;
     return reg;
 }
 
 void TCPByteStreamRcvQueue::Region::copyTo(cPacket* msg_) const
 {
-    ASSERT(getLength() == data.getDataArraySize());
+    ASSERT(getLength() == data.getLength());
 
     ByteArrayMessage *msg = check_and_cast<ByteArrayMessage *>(msg_);
     TCPVirtualDataRcvQueue::Region::copyTo(msg);
-    msg->setByteArray(data);
+    // shares the bytes if they come from a single slice
+    data.getBytesToByteArray(msg->getByteArray(), getLength());
 }
 
 ////////////////////////////////////////////////////////////////////
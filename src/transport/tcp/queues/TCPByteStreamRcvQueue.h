@@ -26,7 +26,7 @@
 
 #include "TCPSegment.h"
 #include "TCPVirtualDataRcvQueue.h"
-#include "ByteArray.h"
+#include "ByteArrayBuffer.h"
 
 /**
  * TCP send queue that stores actual bytes.
@@ -39,12 +39,12 @@ class INET_API TCPByteStreamRcvQueue : public TCPVirtualDataRcvQueue
     class Region : public TCPVirtualDataRcvQueue::Region
     {
       protected:
-        ByteArray data;
+        ByteArrayBuffer data;   // slices of the segment payloads, shared with the segments
 
       public:
         Region(uint32 _begin, uint32 _end) : TCPVirtualDataRcvQueue::Region(_begin, _end) {};
-        Region(uint32 _begin, uint32 _end, ByteArray _data)
-                : TCPVirtualDataRcvQueue::Region(_begin, _end), data(_data) {};
+        Region(uint32 _begin, uint32 _end, const ByteArray& _data)
+                : TCPVirtualDataRcvQueue::Region(_begin, _end) { data.push(_data); };
 
         virtual ~Region() {};
 
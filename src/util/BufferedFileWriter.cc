@@ -0,0 +1,218 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <errno.h>
+
+#include "BufferedFileWriter.h"
+
+
+BufferedFileWriter::BufferedFileWriter()
+{
+    file = NULL;
+    fillIndex = 0;
+    bytesWritten = 0;
+}
+
+BufferedFileWriter::~BufferedFileWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (std::exception& e)
+    {
+        EV << "Error closing file: " << e.what() << "\n";
+    }
+}
+
+void BufferedFileWriter::open(const char *name, size_t bufferSize)
+{
+    if (file)
+        throw cRuntimeError("Cannot open file [%s]: file [%s] is already open", name, fileName.c_str());
+
+    file = fopen(name, "wb");
+    if (!file)
+        throw cRuntimeError("Cannot open file [%s] for writing: %s", name, strerror(errno));
+
+    fileName = name;
+    for (int i = 0; i < 2; i++)
+    {
+        buffers[i].data.resize(bufferSize);
+        buffers[i].length = 0;
+    }
+    fillIndex = 0;
+    bytesWritten = 0;
+
+#ifdef INET_BUFFEREDFILEWRITER_THREAD
+    writeIndex = -1;
+    stopping = false;
+    writeError = 0;
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&cond, NULL);
+    if (pthread_create(&thread, NULL, threadMain, this) != 0)
+    {
+        pthread_cond_destroy(&cond);
+        pthread_mutex_destroy(&mutex);
+        fclose(file);
+        file = NULL;
+        throw cRuntimeError("Cannot start the I/O thread for file [%s]", name);
+    }
+#endif
+}
+
+#ifdef INET_BUFFEREDFILEWRITER_THREAD
+void *BufferedFileWriter::threadMain(void *arg)
+{
+    ((BufferedFileWriter *)arg)->writeBuffers();
+    return NULL;
+}
+
+void BufferedFileWriter::writeBuffers()
+{
+    pthread_mutex_lock(&mutex);
+    while (true)
+    {
+        while (writeIndex == -1 && !stopping)
+            pthread_cond_wait(&cond, &mutex);
+        if (writeIndex == -1)
+            break;
+
+        // the caller doesn't touch the buffer until writeIndex is reset
+        Buffer& buffer = buffers[writeIndex];
+        pthread_mutex_unlock(&mutex);
+        bool ok = fwrite(&buffer.data[0], 1, buffer.length, file) == buffer.length;
+        int error = errno;
+        pthread_mutex_lock(&mutex);
+
+        if (!ok && writeError == 0)
+            writeError = error != 0 ? error : EIO;
+        buffer.length = 0;
+        writeIndex = -1;
+        pthread_cond_broadcast(&cond);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+#endif
+
+void BufferedFileWriter::checkWriteError(int error)
+{
+    if (error != 0)
+        throw cRuntimeError("Cannot write file [%s]: %s", fileName.c_str(), strerror(error));
+}
+
+int BufferedFileWriter::waitForWrite()
+{
+#ifdef INET_BUFFEREDFILEWRITER_THREAD
+    pthread_mutex_lock(&mutex);
+    while (writeIndex != -1)
+        pthread_cond_wait(&cond, &mutex);
+    int error = writeError;
+    pthread_mutex_unlock(&mutex);
+    return error;
+#else
+    return 0;
+#endif
+}
+
+int BufferedFileWriter::submitBuffer()
+{
+    Buffer& buffer = buffers[fillIndex];
+    if (buffer.length == 0)
+        return 0;
+
+#ifdef INET_BUFFEREDFILEWRITER_THREAD
+    // hand the buffer over to the I/O thread, and continue with the other one
+    // once the I/O thread is done with it
+    pthread_mutex_lock(&mutex);
+    while (writeIndex != -1)
+        pthread_cond_wait(&cond, &mutex);
+    int error = writeError;
+    if (error == 0)
+    {
+        writeIndex = fillIndex;
+        fillIndex = 1 - fillIndex;
+        pthread_cond_broadcast(&cond);
+    }
+    pthread_mutex_unlock(&mutex);
+    return error;
+#else
+    size_t length = buffer.length;
+    buffer.length = 0;
+    if (fwrite(&buffer.data[0], 1, length, file) != length)
+        return errno != 0 ? errno : EIO;
+    return 0;
+#endif
+}
+
+unsigned char *BufferedFileWriter::reserve(size_t length)
+{
+    ASSERT(file != NULL);
+    Buffer *buffer = &buffers[fillIndex];
+    if (buffer->length + length > buffer->data.size())
+    {
+        checkWriteError(submitBuffer());
+        buffer = &buffers[fillIndex];
+        ASSERT(buffer->length == 0);
+        if (length > buffer->data.size())
+            buffer->data.resize(length);  // only the caller uses this buffer now
+    }
+    return &buffer->data[buffer->length];
+}
+
+void BufferedFileWriter::flush()
+{
+    if (!file)
+        return;
+    checkWriteError(submitBuffer());
+    checkWriteError(waitForWrite());
+    if (fflush(file) != 0)
+        checkWriteError(errno);
+}
+
+void BufferedFileWriter::close()
+{
+    if (!file)
+        return;
+
+    // the file is closed even if some data could not be written, and the
+    // first error is reported
+    int error = submitBuffer();
+    if (error == 0)
+        error = waitForWrite();
+
+#ifdef INET_BUFFEREDFILEWRITER_THREAD
+    pthread_mutex_lock(&mutex);
+    stopping = true;
+    if (error == 0)
+        error = writeError;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&mutex);
+    pthread_join(thread, NULL);
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+#endif
+
+    if (fclose(file) != 0 && error == 0)
+        error = errno;
+    file = NULL;
+    for (int i = 0; i < 2; i++)
+    {
+        std::vector<unsigned char>().swap(buffers[i].data);
+        buffers[i].length = 0;
+    }
+    checkWriteError(error);
+}
+
@@ -0,0 +1,131 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_BUFFEREDFILEWRITER_H
+#define __INET_BUFFEREDFILEWRITER_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "INETDefs.h"
+
+#if !defined(_WIN32) && !defined(__WIN32__) && !defined(WIN32) && !defined(__CYGWIN__) && !defined(_WIN64)
+#define INET_BUFFEREDFILEWRITER_THREAD
+#include <pthread.h>
+#endif
+
+
+/**
+ * Writes a binary file through two large buffers: the caller fills one of
+ * them while the other one is written to the file by a background I/O
+ * thread, so the simulation only blocks on the disk if it produces data
+ * faster than the disk can take it. (Where POSIX threads are not available,
+ * full buffers are written synchronously.)
+ *
+ * Records are appended with reserve() and commit(), so that they can be
+ * serialized directly into the buffer, or with write().
+ */
+class INET_API BufferedFileWriter
+{
+  protected:
+    struct Buffer
+    {
+        std::vector<unsigned char> data;
+        size_t length;    // number of bytes used
+    };
+
+    FILE *file;
+    std::string fileName;
+    Buffer buffers[2];
+    int fillIndex;        // buffer being filled by the caller
+    uint64 bytesWritten;  // total number of bytes committed
+
+#ifdef INET_BUFFEREDFILEWRITER_THREAD
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;  // signals changes of writeIndex and stopping
+    int writeIndex;       // buffer being written by the I/O thread, or -1
+    bool stopping;
+    int writeError;       // errno of the first failed write, or 0
+
+    static void *threadMain(void *arg);
+    void writeBuffers();
+#endif
+
+  protected:
+    // these return the errno of the first failed write, or 0
+    int submitBuffer();
+    int waitForWrite();
+    void checkWriteError(int error);
+
+  public:
+    BufferedFileWriter();
+
+    /**
+     * Flushes and closes the file if it is open. Errors are written to the
+     * log, as a destructor cannot throw.
+     */
+    ~BufferedFileWriter();
+
+    /**
+     * Creates (truncates) the given file, and allocates two buffers of the
+     * given size. Throws an exception if the file cannot be opened.
+     */
+    void open(const char *fileName, size_t bufferSize);
+
+    /**
+     * Returns true if the file is currently open.
+     */
+    bool isOpen() const { return file != NULL; }
+
+    /**
+     * Returns a pointer to at least length bytes of free space at the end of
+     * the buffered data. The contents of the space is undefined. The pointer
+     * is valid until the next call to commit(), which appends (a prefix of)
+     * the space to the file.
+     */
+    unsigned char *reserve(size_t length);
+
+    /**
+     * Appends the first length bytes of the space returned by the last
+     * reserve() call to the file.
+     */
+    void commit(size_t length) { buffers[fillIndex].length += length; bytesWritten += length; }
+
+    /**
+     * Appends the given bytes to the file.
+     */
+    void write(const void *data, size_t length) { memcpy(reserve(length), data, length); commit(length); }
+
+    /**
+     * Returns the number of bytes appended since the file was opened.
+     */
+    uint64 getBytesWritten() const { return bytesWritten; }
+
+    /**
+     * Writes all buffered data to the file, and waits until it is done.
+     */
+    void flush();
+
+    /**
+     * Flushes and closes the file if it is open. Throws an exception if
+     * some of the data could not be written.
+     */
+    void close();
+};
+
+#endif
+
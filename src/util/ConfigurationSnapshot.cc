@@ -0,0 +1,205 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <stdio.h>
+#include <platdep/platmisc.h>   // getpid()
+
+#include "ConfigurationSnapshot.h"
+
+#define SNAPSHOT_MAGIC            "INETSNAP"
+#define SNAPSHOT_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define SNAPSHOT_VERSION          1
+
+#define FNV_OFFSET_BASIS  ((((uint64)0xcbf29ce4) << 32) | 0x84222325)
+#define FNV_PRIME         ((((uint64)0x00000100) << 32) | 0x000001b3)
+
+static uint64 fnvHash(uint64 hash, const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ p[i]) * FNV_PRIME;
+    return hash;
+}
+
+ConfigurationSnapshot::Key::Key()
+{
+    hash = FNV_OFFSET_BASIS;
+}
+
+void ConfigurationSnapshot::Key::add(const void *data, size_t size)
+{
+    hash = fnvHash(hash, data, size);
+}
+
+void ConfigurationSnapshot::Key::add(const char *s)
+{
+    // including the terminating zero, so that consecutive strings cannot run together
+    add(s, strlen(s) + 1);
+}
+
+void ConfigurationSnapshot::Key::addXML(cXMLElement *element)
+{
+    if (!element)
+    {
+        add(0);
+        return;
+    }
+    add(1);
+    add(element->getTagName());
+    const cXMLAttributeMap& attributes = element->getAttributes();
+    add((int)attributes.size());
+    for (cXMLAttributeMap::const_iterator it = attributes.begin(); it != attributes.end(); ++it)
+    {
+        add(it->first);
+        add(it->second);
+    }
+    add(element->getNodeValue() ? element->getNodeValue() : "");
+    cXMLElementList children = element->getChildren();
+    add((int)children.size());
+    for (int i = 0; i < (int)children.size(); i++)
+        addXML(children[i]);
+}
+
+void ConfigurationSnapshot::Key::addParameter(cComponent *component, const char *name)
+{
+    cPar& par = component->par(name);
+    add(name);
+    if (par.getType() == cPar::XML)
+        addXML(par.xmlValue());
+    else
+        add(par.str());
+}
+
+ConfigurationSnapshot::ConfigurationSnapshot(const char *directory, const char *type, const Key& key)
+{
+    this->key = key.getHash();
+    readPosition = 0;
+    readError = false;
+    if (directory && *directory)
+    {
+        std::string dir = directory;
+        if (dir[dir.size() - 1] != '/' && dir[dir.size() - 1] != '\\')
+            dir += "/";
+        char keyText[20];
+        sprintf(keyText, "%08x%08x", (unsigned int)(this->key >> 32), (unsigned int)this->key);
+        fileName = dir + type + "-" + keyText + ".snapshot";
+    }
+}
+
+bool ConfigurationSnapshot::load()
+{
+    data.clear();
+    readPosition = 0;
+    readError = false;
+    if (!isEnabled())
+        return false;
+
+    FILE *f = fopen(fileName.c_str(), "rb");
+    if (!f)
+        return false;
+
+    char magic[8];
+    uint32 header[2];
+    uint64 fileKey, size, checksum;
+    bool valid = fread(magic, sizeof(magic), 1, f) == 1 && !memcmp(magic, SNAPSHOT_MAGIC, 8) &&
+                 fread(header, sizeof(header), 1, f) == 1 && header[0] == SNAPSHOT_BYTE_ORDER_MAGIC && header[1] == SNAPSHOT_VERSION &&
+                 fread(&fileKey, sizeof(fileKey), 1, f) == 1 && fileKey == key &&
+                 fread(&size, sizeof(size), 1, f) == 1 && size < ((uint64)1 << 40);
+    if (valid)
+    {
+        data.resize((size_t)size);
+        valid = (size == 0 || fread(&data[0], (size_t)size, 1, f) == 1) &&
+                fread(&checksum, sizeof(checksum), 1, f) == 1 &&
+                checksum == fnvHash(FNV_OFFSET_BASIS, data.empty() ? NULL : &data[0], data.size());
+    }
+    fclose(f);
+    if (!valid)
+        data.clear();
+    return valid;
+}
+
+bool ConfigurationSnapshot::save()
+{
+    if (!isEnabled())
+        return false;
+
+    std::string tempFileName = fileName + "." + opp_stringf("%d", (int)getpid()) + ".tmp";
+    FILE *f = fopen(tempFileName.c_str(), "wb");
+    if (!f)
+        return false;
+
+    uint32 header[2] = { SNAPSHOT_BYTE_ORDER_MAGIC, SNAPSHOT_VERSION };
+    uint64 size = data.size();
+    uint64 checksum = fnvHash(FNV_OFFSET_BASIS, data.empty() ? NULL : &data[0], data.size());
+    bool ok = fwrite(SNAPSHOT_MAGIC, 8, 1, f) == 1 &&
+              fwrite(header, sizeof(header), 1, f) == 1 &&
+              fwrite(&key, sizeof(key), 1, f) == 1 &&
+              fwrite(&size, sizeof(size), 1, f) == 1 &&
+              (data.empty() || fwrite(&data[0], data.size(), 1, f) == 1) &&
+              fwrite(&checksum, sizeof(checksum), 1, f) == 1;
+    ok = fclose(f) == 0 && ok;
+
+    // another simulation may have stored the same snapshot in the meantime,
+    // and on some platforms rename() does not replace an existing file
+    if (ok && rename(tempFileName.c_str(), fileName.c_str()) != 0)
+    {
+        remove(fileName.c_str());
+        ok = rename(tempFileName.c_str(), fileName.c_str()) == 0;
+    }
+    if (!ok)
+        remove(tempFileName.c_str());
+    return ok;
+}
+
+void ConfigurationSnapshot::write(const void *buffer, size_t size)
+{
+    const char *p = (const char *)buffer;
+    data.insert(data.end(), p, p + size);
+}
+
+void ConfigurationSnapshot::writeString(const std::string& s)
+{
+    writeUint32(s.size());
+    write(s.data(), s.size());
+}
+
+void ConfigurationSnapshot::read(void *buffer, size_t size)
+{
+    if (readError || size > data.size() - readPosition)
+    {
+        readError = true;
+        memset(buffer, 0, size);
+        return;
+    }
+    if (size == 0)
+        return;
+    memcpy(buffer, &data[readPosition], size);
+    readPosition += size;
+}
+
+std::string ConfigurationSnapshot::readString()
+{
+    uint32 size = readUint32();
+    if (readError || size > data.size() - readPosition)
+    {
+        readError = true;
+        return "";
+    }
+    if (size == 0)
+        return "";
+    std::string s(&data[readPosition], size);
+    readPosition += size;
+    return s;
+}
@@ -0,0 +1,134 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_CONFIGURATIONSNAPSHOT_H
+#define __INET_CONFIGURATIONSNAPSHOT_H
+
+#include <string>
+#include <vector>
+
+#include "INETDefs.h"
+
+
+/**
+ * A file in a content-addressed on-disk cache of network configurations.
+ * Network configurators use it to store the addresses and routes they
+ * calculated, so that repeated runs of the same network (e.g. the
+ * repetitions of a parameter study) can load them instead of calculating
+ * them again.
+ *
+ * The file name contains a hash (the Key) of everything the configuration
+ * depends on: the extracted topology, the parameters and the XML
+ * configuration of the configurator. The contents are opaque to this class;
+ * the configurator writes and reads them as a sequence of integers and
+ * strings in native byte order:
+ *
+ * <pre>
+ * char magic[8];           // "INETSNAP"
+ * uint32 byteOrderMagic;   // 0x1A2B3C4D
+ * uint32 version;
+ * uint64 key;
+ * uint64 size;             // the size of data
+ * char data[size];
+ * uint64 checksum;         // hash of data
+ * </pre>
+ *
+ * Files are written to a temporary file first and then renamed, so that
+ * simulations running in parallel never see a partially written file.
+ */
+class INET_API ConfigurationSnapshot
+{
+  public:
+    /**
+     * Incremental 64-bit FNV-1a hash of the inputs of a configuration.
+     */
+    class INET_API Key
+    {
+      protected:
+        uint64 hash;
+      public:
+        Key();
+        void add(const void *data, size_t size);
+        void add(int value) { add(&value, sizeof(value)); }
+        void add(uint32 value) { add(&value, sizeof(value)); }
+        void add(double value) { add(&value, sizeof(value)); }
+        void add(const char *s);
+        void add(const std::string& s) { add(s.c_str()); }
+
+        /**
+         * Adds the tag, the attributes, the text and the children of
+         * the element; NULL is allowed.
+         */
+        void addXML(cXMLElement *element);
+
+        /**
+         * Adds the value of the given parameter of the module; XML parameters
+         * are added with addXML().
+         */
+        void addParameter(cComponent *component, const char *name);
+
+        uint64 getHash() const { return hash; }
+    };
+
+  protected:
+    std::string fileName;
+    uint64 key;
+    std::vector<char> data;
+    size_t readPosition;
+    bool readError;
+
+  public:
+    /**
+     * The file of the snapshot is in the given directory, its name is made
+     * of the type (e.g. the configurator class name) and the key. An empty
+     * directory name disables the cache: isEnabled() returns false.
+     */
+    ConfigurationSnapshot(const char *directory, const char *type, const Key& key);
+
+    bool isEnabled() const { return !fileName.empty(); }
+    const char *getFileName() const { return fileName.c_str(); }
+
+    /**
+     * Reads the file, and returns true if it exists and it is a valid
+     * snapshot with the same key; data can then be read from the beginning.
+     */
+    bool load();
+
+    /**
+     * Writes the data written so far into the file. Returns false if the file
+     * cannot be written, the cache is optional so this is not an error.
+     */
+    bool save();
+
+    /** @name Writing data */
+    //@{
+    void write(const void *buffer, size_t size);
+    void writeInt(int value) { write(&value, sizeof(value)); }
+    void writeUint32(uint32 value) { write(&value, sizeof(value)); }
+    void writeString(const std::string& s);
+    //@}
+
+    /** @name Reading data; reading past the end returns zeros and sets the error flag */
+    //@{
+    void read(void *buffer, size_t size);
+    int readInt() { int value; read(&value, sizeof(value)); return value; }
+    uint32 readUint32() { uint32 value; read(&value, sizeof(value)); return value; }
+    std::string readString();
+    bool hasReadError() const { return readError; }
+    bool isAtEnd() const { return readPosition == data.size(); }
+    //@}
+};
+
+#endif
@@ -0,0 +1,152 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <errno.h>
+
+#include "MappedFile.h"
+
+#ifdef INET_MAPPEDFILE_WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+MappedFile::MappedFile()
+{
+    data = NULL;
+    size = 0;
+#ifdef INET_MAPPEDFILE_WIN32
+    fileHandle = NULL;
+    mappingHandle = NULL;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef INET_MAPPEDFILE_WIN32
+
+void MappedFile::open(const char *name)
+{
+    if (isOpen())
+        throw cRuntimeError("Cannot open file [%s]: file [%s] is already open", name, fileName.c_str());
+
+    HANDLE file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        throw cRuntimeError("Cannot open file [%s]: error %lu", name, (unsigned long)GetLastError());
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        throw cRuntimeError("Cannot open file [%s]: error %lu", name, (unsigned long)GetLastError());
+    }
+
+    HANDLE mapping = NULL;
+    const char *view = NULL;
+    if (fileSize.QuadPart > 0)
+    {
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+            view = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view)
+        {
+            DWORD error = GetLastError();
+            if (mapping)
+                CloseHandle(mapping);
+            CloseHandle(file);
+            throw cRuntimeError("Cannot map file [%s]: error %lu", name, (unsigned long)error);
+        }
+    }
+
+    fileName = name;
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = view;
+    size = (size_t)fileSize.QuadPart;
+}
+
+void MappedFile::close()
+{
+    if (!isOpen())
+        return;
+    if (data)
+        UnmapViewOfFile(data);
+    if (mappingHandle)
+        CloseHandle((HANDLE)mappingHandle);
+    CloseHandle((HANDLE)fileHandle);
+    fileName.clear();
+    fileHandle = NULL;
+    mappingHandle = NULL;
+    data = NULL;
+    size = 0;
+}
+
+#else
+
+void MappedFile::open(const char *name)
+{
+    if (isOpen())
+        throw cRuntimeError("Cannot open file [%s]: file [%s] is already open", name, fileName.c_str());
+
+    int fd = ::open(name, O_RDONLY);
+    if (fd < 0)
+        throw cRuntimeError("Cannot open file [%s]: %s", name, strerror(errno));
+
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        int error = errno;
+        ::close(fd);
+        throw cRuntimeError("Cannot open file [%s]: %s", name, strerror(error));
+    }
+
+    const char *view = NULL;
+    if (st.st_size > 0)
+    {
+        void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            int error = errno;
+            ::close(fd);
+            throw cRuntimeError("Cannot map file [%s]: %s", name, strerror(error));
+        }
+        view = (const char *)p;
+    }
+    ::close(fd);  // the mapping stays valid
+
+    fileName = name;
+    data = view;
+    size = st.st_size;
+}
+
+void MappedFile::close()
+{
+    if (!isOpen())
+        return;
+    if (data)
+        munmap((void *)data, size);
+    fileName.clear();
+    data = NULL;
+    size = 0;
+}
+
+#endif
@@ -0,0 +1,91 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_MAPPEDFILE_H
+#define __INET_MAPPEDFILE_H
+
+#include <string>
+
+#include "INETDefs.h"
+
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32) || defined(_WIN64)
+#define INET_MAPPEDFILE_WIN32
+#endif
+
+
+/**
+ * Maps a file into memory read-only, so that it can be accessed like an
+ * array without reading it: the operating system loads the pages that are
+ * actually used, and can drop them again under memory pressure. Used for
+ * large input files, e.g. mobility traces.
+ */
+class INET_API MappedFile
+{
+  protected:
+    std::string fileName;
+    const char *data;
+    size_t size;
+#ifdef INET_MAPPEDFILE_WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#endif
+
+  private:
+    // copying not supported: following are private and also left undefined
+    MappedFile(const MappedFile& other);
+    MappedFile& operator=(const MappedFile& other);
+
+  public:
+    MappedFile();
+
+    /**
+     * Unmaps the file if it is mapped.
+     */
+    ~MappedFile();
+
+    /**
+     * Maps the given file. Throws an exception if it cannot be opened.
+     */
+    void open(const char *name);
+
+    /**
+     * Unmaps the file if it is mapped.
+     */
+    void close();
+
+    /**
+     * Returns true if a file is mapped.
+     */
+    bool isOpen() const { return !fileName.empty(); }
+
+    /**
+     * Returns the name of the mapped file.
+     */
+    const char *getFileName() const { return fileName.c_str(); }
+
+    /**
+     * Returns the contents of the file; it is not null-terminated. May be NULL
+     * if the file is empty.
+     */
+    const char *getData() const { return data; }
+
+    /**
+     * Returns the size of the file in bytes.
+     */
+    size_t getSize() const { return size; }
+};
+
+
+#endif // __INET_MAPPEDFILE_H
@@ -63,25 +63,21 @@ struct pcaprec_hdr {
 
 PcapDump::PcapDump()
 {
-     dumpfile = NULL;
 }
 
 PcapDump::~PcapDump()
 {
-    closePcap();
+    // dumpfile is closed by its destructor
 }
 
-void PcapDump::openPcap(const char* filename, unsigned int snaplen_par)
+void PcapDump::openPcap(const char* filename, unsigned int snaplen_par, unsigned int bufferSize)
 {
     struct pcap_hdr fh;
 
     if (!filename || !filename[0])
         throw cRuntimeError("Cannot open pcap file: file name is empty");
 
-    dumpfile = fopen(filename, "wb");
-
-    if (!dumpfile)
-        throw cRuntimeError("Cannot open pcap file [%s] for writing: %s", filename, strerror(errno));
+    dumpfile.open(filename, std::max(bufferSize, (unsigned int)(2 * MAXBUFLENGTH)));
 
     snaplen = snaplen_par;
 
@@ -92,17 +88,24 @@ void PcapDump::openPcap(const char* filename, unsigned int snaplen_par)
     fh.sigfigs = 0;
     fh.snaplen = snaplen;
     fh.network = 0;
-    fwrite(&fh, sizeof(fh), 1, dumpfile);
+    dumpfile.write(&fh, sizeof(fh));
 }
 
 void PcapDump::writeFrame(simtime_t stime, const IPv4Datagram *ipPacket)
 {
-    if (!dumpfile)
+    if (!dumpfile.isOpen())
         throw cRuntimeError("Cannot write frame: pcap output file is not open");
 
 #ifdef WITH_IPv4
-    uint8 buf[MAXBUFLENGTH];
-    memset((void*)&buf, 0, sizeof(buf));
+    // the record is serialized directly into the output buffer
+    const unsigned int headerLength = sizeof(struct pcaprec_hdr) + sizeof(uint32);
+    uint8 *record = dumpfile.reserve(headerLength + MAXBUFLENGTH);
+    uint8 *buf = record + headerLength;
+
+    // the serializers don't fill in the payload bytes, and they may write
+    // more than getByteLength() bytes, so everything that may get into the
+    // file (at most snaplen bytes) is cleared
+    memset(buf, 0, std::min(snaplen, (unsigned int)MAXBUFLENGTH));
 
     struct pcaprec_hdr ph;
     ph.ts_sec = (int32)stime.dbl();
@@ -110,13 +113,13 @@ void PcapDump::writeFrame(simtime_t stime, const IPv4Datagram *ipPacket)
      // Write Ethernet header
     uint32 hdr = 2; //AF_INET
 
-    int32 serialized_ip = IPv4Serializer().serialize(ipPacket, buf, sizeof(buf), true);
+    int32 serialized_ip = IPv4Serializer().serialize(ipPacket, buf, MAXBUFLENGTH, true);
     ph.orig_len = serialized_ip + sizeof(uint32);
 
     ph.incl_len = ph.orig_len > snaplen ? snaplen : ph.orig_len;
-    fwrite(&ph, sizeof(ph), 1, dumpfile);
-    fwrite(&hdr, sizeof(uint32), 1, dumpfile);
-    fwrite(buf, ph.incl_len - sizeof(uint32), 1, dumpfile);
+    memcpy(record, &ph, sizeof(ph));
+    memcpy(record + sizeof(ph), &hdr, sizeof(uint32));
+    dumpfile.commit(sizeof(ph) + ph.incl_len);
 #else
     throw cRuntimeError("Cannot write frame: INET compiled without IPv4 feature");
 #endif
@@ -124,10 +127,6 @@ void PcapDump::writeFrame(simtime_t stime, const IPv4Datagram *ipPacket)
 
 void PcapDump::closePcap()
 {
-    if (dumpfile)
-    {
-        fclose(dumpfile);
-        dumpfile = NULL;
-    }
+    dumpfile.close();
 }
 
@@ -24,6 +24,8 @@
 
 #include "INETDefs.h"
 
+#include "BufferedFileWriter.h"
+
 // Foreign declarations:
 class IPv4Datagram;
 
@@ -31,13 +33,13 @@ class IPv4Datagram;
 /**
  * Dumps packets into a PCAP file; see the "pcap-savefile" man page or
  * http://www.tcpdump.org/ for details on the file format.
- * Note: The file is currently recorded in the "classic" format,
- * not in the "Next Generation" file format also on tcpdump.org.
+ * Note: The file is recorded in the "classic" format; see PcapngDump for
+ * the "Next Generation" file format, which also supports other link types.
  */
 class PcapDump
 {
     protected:
-        FILE *dumpfile;         // pcap file
+        BufferedFileWriter dumpfile;    // pcap file
         unsigned int snaplen;   // max. length of packets in pcap file
 
     public:
@@ -53,15 +55,16 @@ class PcapDump
 
         /**
          * Opens a PCAP file with the given file name. The snaplen parameter
-         * is the length that packets will be truncated to. Throws an exception
-         * if the file cannot be opened.
+         * is the length that packets will be truncated to. The file is written
+         * through buffers of bufferSize bytes (see BufferedFileWriter).
+         * Throws an exception if the file cannot be opened.
          */
-        void openPcap(const char *filename, unsigned int snaplen);
+        void openPcap(const char *filename, unsigned int snaplen, unsigned int bufferSize = 1024*1024);
 
         /**
          * Returns true if the pcap file is currently open.
          */
-        bool isOpen() const { return dumpfile != NULL; }
+        bool isOpen() const { return dumpfile.isOpen(); }
 
         /**
          * Records the given packet into the output file if it is open,
@@ -26,6 +26,14 @@
 #include "IPv4Datagram.h"
 #endif
 
+#ifdef WITH_IPv6
+#include "IPv6Datagram.h"
+#endif
+
+#ifdef WITH_ETHERNET
+#include "EtherFrame_m.h"
+#endif
+
 
 //----
 
@@ -101,7 +109,16 @@ void PcapRecorder::initialize()
     }
 
     if (*file)
-        pcapDumper.openPcap(file, snaplen);
+    {
+        const char *fileFormat = par("fileFormat");
+        unsigned int bufferSize = par("bufferSize");
+        if (!strcmp(fileFormat, "pcap"))
+            pcapDumper.openPcap(file, snaplen, bufferSize);
+        else if (!strcmp(fileFormat, "pcapng"))
+            pcapngDumper.openPcapng(file, snaplen, bufferSize);
+        else
+            throw cRuntimeError("Unknown fileFormat '%s', must be 'pcap' or 'pcapng'", fileFormat);
+    }
 }
 
 void PcapRecorder::handleMessage(cMessage *msg)
@@ -118,11 +135,23 @@ void PcapRecorder::receiveSignal(cComponent *source, simsignal_t signalID, cObje
     {
         SignalList::const_iterator i = signalList.find(signalID);
         bool l2r = (i != signalList.end()) ? i->second : true;
-        recordPacket(packet, l2r);
+        recordPacket(packet, l2r, source);
     }
 }
 
-void PcapRecorder::recordPacket(cPacket *msg, bool l2r)
+int PcapRecorder::getInterfaceId(cComponent *source, int linkType)
+{
+    std::pair<int,int> key(source->getId(), linkType);
+    InterfaceMap::const_iterator it = interfaceIds.find(key);
+    if (it != interfaceIds.end())
+        return it->second;
+
+    int interfaceId = pcapngDumper.addInterface(source->getFullPath().c_str(), linkType);
+    interfaceIds[key] = interfaceId;
+    return interfaceId;
+}
+
+void PcapRecorder::recordPacket(cPacket *msg, bool l2r, cComponent *source)
 {
     if (!ev.isDisabled())
     {
@@ -130,6 +159,49 @@ void PcapRecorder::recordPacket(cPacket *msg, bool l2r)
         packetDumper.dumpPacket(l2r, msg);
     }
 
+    if (pcapngDumper.isOpen())
+    {
+        // record the outermost Ethernet frame or IP datagram, on an interface of the module that emitted it
+        bool hasBitError = false;
+        cPacket *frame = NULL;
+        int linkType = -1;
+
+        while (msg)
+        {
+            if (msg->hasBitError())
+                hasBitError = true;
+#ifdef WITH_ETHERNET
+            if (dynamic_cast<EtherFrame *>(msg))
+            {
+                frame = msg;
+                linkType = PCAP_LINKTYPE_ETHERNET;
+                break;
+            }
+#endif
+#ifdef WITH_IPv4
+            if (dynamic_cast<IPv4Datagram *>(msg))
+            {
+                frame = msg;
+                linkType = PCAP_LINKTYPE_RAW;
+                break;
+            }
+#endif
+#ifdef WITH_IPv6
+            if (dynamic_cast<IPv6Datagram *>(msg))
+            {
+                frame = msg;
+                linkType = PCAP_LINKTYPE_RAW;
+                break;
+            }
+#endif
+            msg = msg->getEncapsulatedPacket();
+        }
+
+        if (frame && (dumpBadFrames || !hasBitError))
+            pcapngDumper.writeFrame(simulation.getSimTime(), getInterfaceId(source, linkType), frame);
+        return;
+    }
+
 #ifdef WITH_IPv4
     if (!pcapDumper.isOpen())
         return;
@@ -160,5 +232,6 @@ void PcapRecorder::finish()
 {
      packetDumper.dump("", "pcapRecorder finished");
      pcapDumper.closePcap();
+     pcapngDumper.closePcapng();
 }
 
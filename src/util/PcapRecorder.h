@@ -26,6 +26,7 @@
 
 #include "PacketDump.h"
 #include "PcapDump.h"
+#include "PcapngDump.h"
 
 
 /**
@@ -35,9 +36,12 @@ class INET_API PcapRecorder : public cSimpleModule, protected cListener
 {
     protected:
         typedef std::map<simsignal_t,bool> SignalList;
+        typedef std::map<std::pair<int,int>,int> InterfaceMap;  // (module id, link type) -> pcapng interface id
         SignalList signalList;
         PacketDump packetDumper;
         PcapDump pcapDumper;
+        PcapngDump pcapngDumper;
+        InterfaceMap interfaceIds;
         unsigned int snaplen;
         unsigned long first, last, space;
         bool dumpBadFrames;
@@ -49,7 +53,8 @@ class INET_API PcapRecorder : public cSimpleModule, protected cListener
         virtual void handleMessage(cMessage *msg);
         virtual void finish();
         virtual void receiveSignal(cComponent *source, simsignal_t signalID, cObject *obj);
-        virtual void recordPacket(cPacket *msg, bool l2r);
+        virtual void recordPacket(cPacket *msg, bool l2r, cComponent *source);
+        virtual int getInterfaceId(cComponent *source, int linkType);
 };
 
 #endif
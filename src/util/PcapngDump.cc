@@ -0,0 +1,219 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include "PcapngDump.h"
+
+#ifdef WITH_IPv4
+#include "IPv4Datagram.h"
+#include "IPv4Serializer.h"
+#endif
+
+#ifdef WITH_IPv6
+#include "IPv6Datagram.h"
+#include "IPv6Serializer.h"
+#endif
+
+#ifdef WITH_ETHERNET
+#include "EtherFrame_m.h"
+#include "EthernetSerializer.h"
+#endif
+
+
+#define MAXBUFLENGTH 65536
+
+#define PCAPNG_SECTION_HEADER_BLOCK          0x0A0D0D0A
+#define PCAPNG_INTERFACE_DESCRIPTION_BLOCK   0x00000001
+#define PCAPNG_ENHANCED_PACKET_BLOCK         0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC              0x1A2B3C4D
+
+#define PCAPNG_OPT_ENDOFOPT                  0
+#define PCAPNG_OPT_IF_NAME                   2
+#define PCAPNG_OPT_IF_TSRESOL                9
+
+/* Section Header Block, without options */
+struct pcapng_shb {
+     uint32 block_type;
+     uint32 block_total_length;
+     uint32 byte_order_magic;
+     uint16 major_version;
+     uint16 minor_version;
+     uint32 section_length_low;   /* section length, split so that the struct has no padding */
+     uint32 section_length_high;
+     uint32 block_total_length2;
+};
+
+/* Interface Description Block header; followed by options and the block total length */
+struct pcapng_idb {
+     uint32 block_type;
+     uint32 block_total_length;
+     uint16 link_type;
+     uint16 reserved;
+     uint32 snaplen;
+};
+
+/* Enhanced Packet Block header; followed by packet data, options and the block total length */
+struct pcapng_epb {
+     uint32 block_type;
+     uint32 block_total_length;
+     uint32 interface_id;
+     uint32 timestamp_high;       /* in units of the interface's if_tsresol */
+     uint32 timestamp_low;
+     uint32 captured_len;
+     uint32 packet_len;
+};
+
+static inline unsigned int pad4(unsigned int length)
+{
+    return (length + 3) & ~3U;
+}
+
+static unsigned int putOption(uint8 *buf, uint16 code, const void *value, uint16 length)
+{
+    memcpy(buf, &code, 2);
+    memcpy(buf + 2, &length, 2);
+    if (length > 0)
+        memcpy(buf + 4, value, length);
+    memset(buf + 4 + length, 0, pad4(length) - length);
+    return 4 + pad4(length);
+}
+
+
+PcapngDump::PcapngDump()
+{
+    numFrames = 0;
+}
+
+PcapngDump::~PcapngDump()
+{
+    // dumpfile is closed by its destructor
+}
+
+void PcapngDump::openPcapng(const char* filename, unsigned int snaplen_par, unsigned int bufferSize)
+{
+    if (!filename || !filename[0])
+        throw cRuntimeError("Cannot open pcapng file: file name is empty");
+
+    dumpfile.open(filename, std::max(bufferSize, (unsigned int)(2 * MAXBUFLENGTH)));
+
+    snaplen = snaplen_par;
+    linkTypes.clear();
+    numFrames = 0;
+
+    struct pcapng_shb shb;
+    shb.block_type = PCAPNG_SECTION_HEADER_BLOCK;
+    shb.block_total_length = sizeof(shb);
+    shb.byte_order_magic = PCAPNG_BYTE_ORDER_MAGIC;
+    shb.major_version = 1;
+    shb.minor_version = 0;
+    shb.section_length_low = 0xffffffff;   // not specified
+    shb.section_length_high = 0xffffffff;
+    shb.block_total_length2 = sizeof(shb);
+    dumpfile.write(&shb, sizeof(shb));
+}
+
+int PcapngDump::addInterface(const char *name, int linkType)
+{
+    if (!dumpfile.isOpen())
+        throw cRuntimeError("Cannot add interface: pcapng output file is not open");
+
+    uint16 nameLength = std::min(strlen(name), (size_t)0xfff0);
+    uint8 *block = dumpfile.reserve(sizeof(struct pcapng_idb) + 4 + pad4(nameLength) + 8 + 4 + 4);
+
+    unsigned int length = sizeof(struct pcapng_idb);
+    length += putOption(block + length, PCAPNG_OPT_IF_NAME, name, nameLength);
+    uint8 tsresol = -SimTime::getScaleExp();   // timestamps are raw simulation times
+    length += putOption(block + length, PCAPNG_OPT_IF_TSRESOL, &tsresol, 1);
+    length += putOption(block + length, PCAPNG_OPT_ENDOFOPT, NULL, 0);
+    length += 4;
+
+    struct pcapng_idb idb;
+    idb.block_type = PCAPNG_INTERFACE_DESCRIPTION_BLOCK;
+    idb.block_total_length = length;
+    idb.link_type = linkType;
+    idb.reserved = 0;
+    idb.snaplen = snaplen;
+    memcpy(block, &idb, sizeof(idb));
+    memcpy(block + length - 4, &length, 4);
+    dumpfile.commit(length);
+
+    linkTypes.push_back(linkType);
+    return linkTypes.size() - 1;
+}
+
+void PcapngDump::writeFrame(simtime_t stime, int interfaceId, const cPacket *frame)
+{
+    if (!dumpfile.isOpen())
+        throw cRuntimeError("Cannot write frame: pcapng output file is not open");
+    if (interfaceId < 0 || interfaceId >= (int)linkTypes.size())
+        throw cRuntimeError("Cannot write frame: invalid interface id %d", interfaceId);
+
+    // the block is serialized directly into the output buffer
+    uint8 *block = dumpfile.reserve(sizeof(struct pcapng_epb) + MAXBUFLENGTH + 4);
+    uint8 *buf = block + sizeof(struct pcapng_epb);
+
+    // the serializers don't fill in the payload bytes, and they may write
+    // more than getByteLength() bytes, so everything that may get into the
+    // file (at most snaplen bytes) is cleared
+    memset(buf, 0, std::min(snaplen, (unsigned int)MAXBUFLENGTH));
+
+    int packetLength = -1;
+    switch (linkTypes[interfaceId])
+    {
+#ifdef WITH_ETHERNET
+      case PCAP_LINKTYPE_ETHERNET:
+        packetLength = EthernetSerializer().serialize(check_and_cast<const EtherFrame *>(frame), buf, MAXBUFLENGTH);
+        break;
+#endif
+
+      case PCAP_LINKTYPE_RAW:
+#ifdef WITH_IPv4
+        if (dynamic_cast<const IPv4Datagram *>(frame))
+            packetLength = IPv4Serializer().serialize(static_cast<const IPv4Datagram *>(frame), buf, MAXBUFLENGTH, true);
+#endif
+#ifdef WITH_IPv6
+        if (dynamic_cast<const IPv6Datagram *>(frame))
+            packetLength = IPv6Serializer().serialize(static_cast<const IPv6Datagram *>(frame), buf, MAXBUFLENGTH);
+#endif
+        break;
+    }
+    if (packetLength < 0)
+        throw cRuntimeError("Cannot write frame: no serializer for (%s)%s on an interface with link type %d",
+                frame->getClassName(), frame->getName(), linkTypes[interfaceId]);
+
+    unsigned int capturedLength = std::min((unsigned int)packetLength, snaplen);
+    unsigned int paddedLength = pad4(capturedLength);
+    memset(buf + capturedLength, 0, paddedLength - capturedLength);
+
+    uint64 timestamp = stime.raw();
+    struct pcapng_epb epb;
+    epb.block_type = PCAPNG_ENHANCED_PACKET_BLOCK;
+    epb.block_total_length = sizeof(epb) + paddedLength + 4;
+    epb.interface_id = interfaceId;
+    epb.timestamp_high = (uint32)(timestamp >> 32);
+    epb.timestamp_low = (uint32)timestamp;
+    epb.captured_len = capturedLength;
+    epb.packet_len = packetLength;
+    memcpy(block, &epb, sizeof(epb));
+    memcpy(buf + paddedLength, &epb.block_total_length, 4);
+    dumpfile.commit(epb.block_total_length);
+    numFrames++;
+}
+
+void PcapngDump::closePcapng()
+{
+    dumpfile.close();
+}
+
@@ -0,0 +1,107 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_PCAPNGDUMP_H
+#define __INET_PCAPNGDUMP_H
+
+#include <vector>
+
+#include "INETDefs.h"
+
+#include "BufferedFileWriter.h"
+
+
+/**
+ * Link types of the recorded frames (see http://www.tcpdump.org/linktypes.html)
+ */
+enum PcapLinkType
+{
+    PCAP_LINKTYPE_ETHERNET = 1,   // EtherFrame, without preamble and FCS
+    PCAP_LINKTYPE_RAW = 101       // IPv4Datagram or IPv6Datagram
+};
+
+/**
+ * Dumps packets into a PCAP Next Generation (pcapng) file; see
+ * http://www.winpcap.org/ntar/draft/PCAP-DumpFileFormat.html for details
+ * on the file format.
+ *
+ * The file has a single section, with an interface description for each
+ * interface added by addInterface(); every frame refers to one of them, so
+ * frames of different link types can be recorded into the same file.
+ * Timestamps are recorded with the resolution of the simulation time.
+ *
+ * Frames are serialized directly into the buffers of a BufferedFileWriter,
+ * which writes them to the file in the background.
+ */
+class INET_API PcapngDump
+{
+    protected:
+        BufferedFileWriter dumpfile;     // pcapng file
+        unsigned int snaplen;            // max. length of packets in pcapng file
+        std::vector<int> linkTypes;      // link type of each interface, indexed by interface id
+        uint64 numFrames;
+
+    public:
+        /**
+         * Constructor. It does not open the output file.
+         */
+        PcapngDump();
+
+        /**
+         * Destructor. It closes the output file if it is open.
+         */
+        ~PcapngDump();
+
+        /**
+         * Opens a pcapng file with the given file name, and writes the section
+         * header. The snaplen parameter is the length that packets will be
+         * truncated to. The file is written through buffers of bufferSize bytes.
+         * Throws an exception if the file cannot be opened.
+         */
+        void openPcapng(const char *filename, unsigned int snaplen, unsigned int bufferSize = 4*1024*1024);
+
+        /**
+         * Returns true if the pcapng file is currently open.
+         */
+        bool isOpen() const { return dumpfile.isOpen(); }
+
+        /**
+         * Adds an interface description with the given name and link type
+         * (see PcapLinkType) to the file, and returns its interface id.
+         */
+        int addInterface(const char *name, int linkType);
+
+        /**
+         * Records the given frame into the output file if it is open, and
+         * throws an exception otherwise. The frame must match the link type
+         * of the given interface: an EtherFrame for PCAP_LINKTYPE_ETHERNET,
+         * or an IPv4Datagram or IPv6Datagram for PCAP_LINKTYPE_RAW.
+         */
+        void writeFrame(simtime_t time, int interfaceId, const cPacket *frame);
+
+        /**
+         * Returns the number of frames written since the file was opened.
+         */
+        uint64 getNumFrames() const { return numFrames; }
+
+        /**
+         * Closes the output file if it is open.
+         */
+        void closePcapng();
+};
+
+
+#endif // __INET_PCAPNGDUMP_H
+
@@ -22,23 +22,224 @@
 //#include <netinet/in.h>  // htonl, ntohl, ...
 //#endif
 
-uint16_t TCPIPchecksum::_checksum(const void *addr, unsigned int count)
+// The vectorized implementations need the target attribute of functions,
+// and __builtin_cpu_init() and __builtin_cpu_supports(). GCC has them since
+// 4.9. clang has had the target attribute and __builtin_cpu_supports() since
+// 3.8, but __builtin_cpu_init() only since 6.0 (Apple clang 10); older
+// clang versions use the scalar implementation.
+#if defined(__clang__)
+#if defined(__apple_build_version__)
+#define INET_CHECKSUM_COMPILER_OK (__clang_major__ >= 10)
+#else
+#define INET_CHECKSUM_COMPILER_OK (__clang_major__ >= 6)
+#endif
+#elif defined(__GNUC__)
+#define INET_CHECKSUM_COMPILER_OK (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#else
+#define INET_CHECKSUM_COMPILER_OK 0
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && INET_CHECKSUM_COMPILER_OK
+#define INET_CHECKSUM_X86
+#include <immintrin.h>
+#endif
+
+TCPIPchecksum::ChecksumFunction TCPIPchecksum::checksumFunction = &TCPIPchecksum::selectAndChecksum;
+
+static inline uint16_t fold(uint64_t sum)
 {
-    uint32_t sum = 0;
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)sum;
+}
 
-    while (count > 1)
+// Sums the 32-bit words into a 64-bit accumulator, which cannot overflow;
+// 2^16 = 1 (mod 2^16-1), so the folded sum is the sum of the 16-bit words.
+// The last odd byte is added as the low-order byte of a 16-bit word, i.e.
+// it is padded on the right on little-endian machines.
+static inline uint64_t sumTail(const uint8_t *p, unsigned int count, uint64_t sum)
+{
+    while (count >= 4)
+    {
+        uint32_t word;
+        memcpy(&word, p, 4);
+        sum += word;
+        p += 4;
+        count -= 4;
+    }
+    if (count >= 2)
     {
-        sum += *((const uint16_t *&)addr)++;
-        if (sum & 0x80000000)
-            sum = (sum & 0xFFFF) + (sum >> 16);
+        uint16_t word;
+        memcpy(&word, p, 2);
+        sum += word;
+        p += 2;
         count -= 2;
     }
-
     if (count)
-        sum += *(const uint8_t *)addr;
+        sum += *p;
+    return sum;
+}
 
-    while (sum >> 16)
-        sum = (sum & 0xFFFF) + (sum >> 16);
+uint16_t TCPIPchecksum::scalarChecksum(const void *addr, unsigned int count)
+{
+    const uint8_t *p = (const uint8_t *)addr;
+    uint64_t sum = 0;
 
-    return (uint16_t)sum;
+    // four independent 32-bit words per step
+    while (count >= 16)
+    {
+        uint32_t words[4];
+        memcpy(words, p, 16);
+        sum += (uint64_t)words[0] + words[1] + words[2] + words[3];
+        p += 16;
+        count -= 16;
+    }
+
+    return fold(sumTail(p, count, sum));
+}
+
+#ifdef INET_CHECKSUM_X86
+
+// The vector implementations widen the 32-bit words to 64-bit lanes by
+// interleaving them with zeros, and add them up in the lanes.
+
+__attribute__((target("sse2")))
+static uint16_t sse2Checksum(const void *addr, unsigned int count)
+{
+    const uint8_t *p = (const uint8_t *)addr;
+    __m128i zero = _mm_setzero_si128();
+    __m128i sum0 = _mm_setzero_si128();
+    __m128i sum1 = _mm_setzero_si128();
+
+    while (count >= 32)
+    {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)p);
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(p + 16));
+        sum0 = _mm_add_epi64(sum0, _mm_unpacklo_epi32(v0, zero));
+        sum1 = _mm_add_epi64(sum1, _mm_unpackhi_epi32(v0, zero));
+        sum0 = _mm_add_epi64(sum0, _mm_unpacklo_epi32(v1, zero));
+        sum1 = _mm_add_epi64(sum1, _mm_unpackhi_epi32(v1, zero));
+        p += 32;
+        count -= 32;
+    }
+    if (count >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        sum0 = _mm_add_epi64(sum0, _mm_unpacklo_epi32(v, zero));
+        sum1 = _mm_add_epi64(sum1, _mm_unpackhi_epi32(v, zero));
+        p += 16;
+        count -= 16;
+    }
+
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, _mm_add_epi64(sum0, sum1));
+    // the halves of the lanes are added separately, so the sum cannot overflow
+    uint64_t sum = (lanes[0] & 0xFFFFFFFF) + (lanes[0] >> 32) + (lanes[1] & 0xFFFFFFFF) + (lanes[1] >> 32);
+    return fold(sumTail(p, count, sum));
+}
+
+__attribute__((target("avx2")))
+static uint16_t avx2Checksum(const void *addr, unsigned int count)
+{
+    const uint8_t *p = (const uint8_t *)addr;
+    __m256i zero = _mm256_setzero_si256();
+    __m256i sum0 = _mm256_setzero_si256();
+    __m256i sum1 = _mm256_setzero_si256();
+
+    while (count >= 64)
+    {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)p);
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(p + 32));
+        sum0 = _mm256_add_epi64(sum0, _mm256_unpacklo_epi32(v0, zero));
+        sum1 = _mm256_add_epi64(sum1, _mm256_unpackhi_epi32(v0, zero));
+        sum0 = _mm256_add_epi64(sum0, _mm256_unpacklo_epi32(v1, zero));
+        sum1 = _mm256_add_epi64(sum1, _mm256_unpackhi_epi32(v1, zero));
+        p += 64;
+        count -= 64;
+    }
+    if (count >= 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        sum0 = _mm256_add_epi64(sum0, _mm256_unpacklo_epi32(v, zero));
+        sum1 = _mm256_add_epi64(sum1, _mm256_unpackhi_epi32(v, zero));
+        p += 32;
+        count -= 32;
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(sum0, sum1));
+    uint64_t sum = 0;
+    for (int i = 0; i < 4; i++)
+        sum += (lanes[i] & 0xFFFFFFFF) + (lanes[i] >> 32);
+    return fold(sumTail(p, count, sum));
+}
+
+#endif // INET_CHECKSUM_X86
+
+uint16_t TCPIPchecksum::selectAndChecksum(const void *addr, unsigned int count)
+{
+    selectImplementation(AUTO);
+    return (*checksumFunction)(addr, count);
+}
+
+bool TCPIPchecksum::isImplementationSupported(Implementation implementation)
+{
+    switch (implementation)
+    {
+        case AUTO:
+        case SCALAR:
+            return true;
+#ifdef INET_CHECKSUM_X86
+        case SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+void TCPIPchecksum::selectImplementation(Implementation implementation)
+{
+    if (implementation == AUTO)
+        implementation = isImplementationSupported(AVX2) ? AVX2 : isImplementationSupported(SSE2) ? SSE2 : SCALAR;
+    else if (!isImplementationSupported(implementation))
+        throw cRuntimeError("TCPIPchecksum: implementation %d is not supported on this processor", implementation);
+
+    switch (implementation)
+    {
+#ifdef INET_CHECKSUM_X86
+        case SSE2: checksumFunction = &sse2Checksum; break;
+        case AVX2: checksumFunction = &avx2Checksum; break;
+#endif
+        default: checksumFunction = &scalarChecksum; break;
+    }
+}
+
+const char *TCPIPchecksum::getImplementationName()
+{
+    if (checksumFunction == &selectAndChecksum)
+        selectImplementation(AUTO);
+#ifdef INET_CHECKSUM_X86
+    if (checksumFunction == &sse2Checksum)
+        return "SSE2";
+    if (checksumFunction == &avx2Checksum)
+        return "AVX2";
+#endif
+    return "scalar";
+}
+
+uint16_t TCPIPchecksum::updateChecksum(uint16_t checksum, const void *oldData, const void *newData, unsigned int count)
+{
+    // RFC 1624 eqn. 3: HC' = ~(~HC + ~m + m'), with the sums of the changed words as m and m'
+    uint32_t sum = (uint16_t)~checksum + (uint32_t)(uint16_t)~_checksum(oldData, count) + _checksum(newData, count);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)~sum;
 }
@@ -23,10 +23,32 @@
 #include "INETDefs.h"
 
 /**
- * Calculates checksum.
+ * Calculates the Internet checksum (RFC 1071), and updates it incrementally
+ * (RFC 1624) after some words of the checksummed data have been changed.
+ *
+ * On x86 processors the sum is computed with SSE2 or AVX2 instructions,
+ * whichever is the best the processor supports (selected at the first call);
+ * elsewhere a portable implementation summing 32-bit words is used. All
+ * implementations give the same result.
+ *
+ * Words are summed in host byte order, like the words of a header in network
+ * byte order loaded from a buffer; as the one's complement sum is byte order
+ * independent, the result can be stored into the buffer as is.
  */
 class TCPIPchecksum
 {
+    public:
+        /**
+         * Implementations of _checksum(); see selectImplementation().
+         */
+        enum Implementation
+        {
+            AUTO,     // the best one supported by the processor
+            SCALAR,   // portable C++
+            SSE2,     // x86 SSE2, 16 bytes per step
+            AVX2      // x86 AVX2, 32 bytes per step
+        };
+
     public:
         TCPIPchecksum() {}
 
@@ -42,7 +64,59 @@ class TCPIPchecksum
             return ~ _checksum(addr, count);
         }
 
-        static uint16_t _checksum(const void *addr, unsigned int count);
+        /**
+         * Returns the one's complement sum of all 16 bit words, without
+         * complementing it.
+         */
+        static uint16_t _checksum(const void *addr, unsigned int count)
+        {
+            return (*checksumFunction)(addr, count);
+        }
+
+        /**
+         * Returns the checksum after the 16 bit word oldWord of the checksummed
+         * data has been replaced by newWord, e.g. the TTL and protocol word
+         * of an IPv4 header after the TTL has been decremented (RFC 1624 eqn. 3).
+         */
+        static uint16_t updateChecksum(uint16_t checksum, uint16_t oldWord, uint16_t newWord)
+        {
+            uint32_t sum = (uint16_t)~checksum + (uint32_t)(uint16_t)~oldWord + newWord;
+            sum = (sum & 0xFFFF) + (sum >> 16);
+            sum = (sum & 0xFFFF) + (sum >> 16);
+            return (uint16_t)~sum;
+        }
+
+        /**
+         * Returns the checksum after count bytes (an even number) of the
+         * checksummed data have been replaced, e.g. the address and port of
+         * a packet rewritten by a NAT. oldData and newData point to the old
+         * and the new contents of the changed bytes.
+         */
+        static uint16_t updateChecksum(uint16_t checksum, const void *oldData, const void *newData, unsigned int count);
+
+        /**
+         * Selects the implementation used by _checksum() and checksum(); for
+         * testing and benchmarking. Throws an exception if the processor
+         * does not support the given implementation.
+         */
+        static void selectImplementation(Implementation implementation);
+
+        /**
+         * Returns true if the processor supports the given implementation.
+         */
+        static bool isImplementationSupported(Implementation implementation);
+
+        /**
+         * Returns the name of the implementation currently in use.
+         */
+        static const char *getImplementationName();
+
+    protected:
+        typedef uint16_t (*ChecksumFunction)(const void *addr, unsigned int count);
+        static ChecksumFunction checksumFunction;
+
+        static uint16_t selectAndChecksum(const void *addr, unsigned int count);
+        static uint16_t scalarChecksum(const void *addr, unsigned int count);
 };
 
 #endif
@@ -0,0 +1,139 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm> // std::min
+#include <platdep/sockets.h>
+
+#include "EthernetSerializer.h"
+
+#ifdef WITH_IPv4
+#include "ARPPacket_m.h"
+#include "IPv4Datagram.h"
+#include "IPv4Serializer.h"
+#endif
+
+#ifdef WITH_IPv6
+#include "IPv6Datagram.h"
+#include "IPv6Serializer.h"
+#endif
+
+
+#define ETHER_HEADER_BYTES     14     /* dest(6)+src(6)+length/type(2) */
+#define ETHER_MIN_FRAME_BYTES  60     /* minimum frame length without FCS */
+#define ETHERTYPE_FLOW_CONTROL 0x8808
+#define ARP_PACKET_BYTES       28     /* for Ethernet hardware and IPv4 protocol addresses */
+
+
+static void putUint16(unsigned char *buf, uint16 value)
+{
+    buf[0] = value >> 8;
+    buf[1] = value & 0xff;
+}
+
+static void putUint32(unsigned char *buf, uint32 value)
+{
+    uint32 netValue = htonl(value);
+    memcpy(buf, &netValue, 4);
+}
+
+#ifdef WITH_IPv4
+static int serializeARP(const ARPPacket *arp, unsigned char *buf, unsigned int bufsize)
+{
+    if (bufsize < ARP_PACKET_BYTES)
+        throw cRuntimeError(arp, "EthernetSerializer: buffer too small for ARP packet");
+
+    putUint16(buf, 1);            // hardware type: Ethernet
+    putUint16(buf + 2, 0x0800);   // protocol type: IPv4
+    buf[4] = 6;
+    buf[5] = 4;
+    putUint16(buf + 6, arp->getOpcode());
+    arp->getSrcMACAddress().getAddressBytes(buf + 8);
+    putUint32(buf + 14, arp->getSrcIPAddress().getInt());
+    arp->getDestMACAddress().getAddressBytes(buf + 18);
+    putUint32(buf + 24, arp->getDestIPAddress().getInt());
+    return ARP_PACKET_BYTES;
+}
+#endif
+
+int EthernetSerializer::serialize(const EtherFrame *frame, unsigned char *buf, unsigned int bufsize)
+{
+    if (bufsize < ETHER_MIN_FRAME_BYTES)
+        throw cRuntimeError(frame, "EthernetSerializer: buffer too small for Ethernet frame");
+
+    frame->getDest().getAddressBytes(buf);
+    frame->getSrc().getAddressBytes(buf + 6);
+
+    unsigned int offset = ETHER_HEADER_BYTES;
+    bool hasLengthField = false;
+    uint16 etherType = 0;
+
+    if (const EthernetIIFrame *ethernetIIFrame = dynamic_cast<const EthernetIIFrame *>(frame))
+    {
+        etherType = ethernetIIFrame->getEtherType();
+    }
+    else if (const EtherFrameWithLLC *llcFrame = dynamic_cast<const EtherFrameWithLLC *>(frame))
+    {
+        hasLengthField = true;
+        buf[offset++] = llcFrame->getDsap();
+        buf[offset++] = llcFrame->getSsap();
+        buf[offset++] = llcFrame->getControl();
+        if (const EtherFrameWithSNAP *snapFrame = dynamic_cast<const EtherFrameWithSNAP *>(frame))
+        {
+            int orgCode = snapFrame->getOrgCode();
+            buf[offset++] = (orgCode >> 16) & 0xff;
+            buf[offset++] = (orgCode >> 8) & 0xff;
+            buf[offset++] = orgCode & 0xff;
+            putUint16(buf + offset, snapFrame->getLocalcode());
+            offset += 2;
+        }
+    }
+    else if (const EtherPauseFrame *pauseFrame = dynamic_cast<const EtherPauseFrame *>(frame))
+    {
+        etherType = ETHERTYPE_FLOW_CONTROL;
+        putUint16(buf + offset, 1);   // opcode: PAUSE
+        putUint16(buf + offset + 2, pauseFrame->getPauseTime());
+        offset += 4;
+    }
+
+    cPacket *encapPacket = frame->getEncapsulatedPacket();
+    unsigned int payloadLength = 0;
+
+    if (!encapPacket)
+        ;
+#ifdef WITH_IPv4
+    else if (IPv4Datagram *ipv4Datagram = dynamic_cast<IPv4Datagram *>(encapPacket))
+        payloadLength = IPv4Serializer().serialize(ipv4Datagram, buf + offset, bufsize - offset, true);
+    else if (ARPPacket *arpPacket = dynamic_cast<ARPPacket *>(encapPacket))
+        payloadLength = serializeARP(arpPacket, buf + offset, bufsize - offset);
+#endif
+#ifdef WITH_IPv6
+    else if (IPv6Datagram *ipv6Datagram = dynamic_cast<IPv6Datagram *>(encapPacket))
+        payloadLength = IPv6Serializer().serialize(ipv6Datagram, buf + offset, bufsize - offset);
+#endif
+    else
+        payloadLength = std::min((unsigned int)encapPacket->getByteLength(), bufsize - offset);
+
+    // the length field covers the LLC/SNAP header and the payload
+    putUint16(buf + 12, hasLengthField ? offset - ETHER_HEADER_BYTES + payloadLength : etherType);
+
+    unsigned int length = offset + payloadLength;
+    if (length < ETHER_MIN_FRAME_BYTES)
+    {
+        memset(buf + length, 0, ETHER_MIN_FRAME_BYTES - length);
+        length = ETHER_MIN_FRAME_BYTES;
+    }
+    return length;
+}
+
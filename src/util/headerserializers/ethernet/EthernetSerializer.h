@@ -0,0 +1,44 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_ETHERNETSERIALIZER_H
+#define __INET_ETHERNETSERIALIZER_H
+
+#include "EtherFrame_m.h"
+
+
+/**
+ * Converts an EtherFrame to a binary (network byte order) Ethernet frame
+ * without preamble and FCS, as found in packet traces.
+ *
+ * IPv4, IPv6 and ARP payloads are serialized; other payloads only have the
+ * right length. Short frames are padded to the minimum frame size. Bytes
+ * not written by the serializers are left untouched, so the buffer should
+ * be zeroed by the caller.
+ */
+class EthernetSerializer
+{
+    public:
+        EthernetSerializer() {}
+
+        /**
+         * Serializes an EtherFrame. Returns the length of data written
+         * into buffer.
+         */
+        int serialize(const EtherFrame *frame, unsigned char *buf, unsigned int bufsize);
+};
+
+#endif
+
@@ -0,0 +1,116 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <algorithm> // std::min
+#include <platdep/sockets.h>
+
+#include "IPv6Serializer.h"
+
+#include "IPProtocolId_m.h"
+#include "ICMPv6Message_m.h"
+
+#ifdef WITH_UDP
+#include "UDPPacket.h"
+#include "UDPSerializer.h"
+#endif
+
+#ifdef WITH_TCP_COMMON
+#include "TCPSegment.h"
+#include "TCPSerializer.h"
+#endif
+
+
+#define IPv6_HEADER_BYTES  40
+
+
+static void serializeAddress(const IPv6Address& address, unsigned char *buf)
+{
+    const uint32 *words = address.words();
+    for (int i = 0; i < 4; i++)
+    {
+        uint32 word = htonl(words[i]);
+        memcpy(buf + 4 * i, &word, 4);
+    }
+}
+
+int IPv6Serializer::serialize(const IPv6Datagram *dgram, unsigned char *buf, unsigned int bufsize)
+{
+    unsigned int headerLength = dgram->calculateHeaderByteLength();
+    if (headerLength > bufsize)
+        throw cRuntimeError(dgram, "IPv6Serializer: buffer too small for the header");
+
+    // the extension headers are chained by their next header fields
+    IPv6Datagram *datagram = const_cast<IPv6Datagram *>(dgram);
+    unsigned int numExtensionHeaders = datagram->getExtensionHeaderArraySize();
+    unsigned char nextHeader = numExtensionHeaders > 0 ?
+            datagram->getExtensionHeader(0)->getExtensionType() : dgram->getTransportProtocol();
+
+    uint32 firstWord = htonl((6U << 28) | ((uint32)dgram->getTrafficClass() << 20) | (dgram->getFlowLabel() & 0xfffff));
+    memcpy(buf, &firstWord, 4);
+    buf[6] = nextHeader;
+    buf[7] = dgram->getHopLimit();
+    serializeAddress(dgram->getSrcAddress(), buf + 8);
+    serializeAddress(dgram->getDestAddress(), buf + 24);
+
+    unsigned int offset = IPv6_HEADER_BYTES;
+    for (unsigned int i = 0; i < numExtensionHeaders; i++)
+    {
+        IPv6ExtensionHeader *eh = datagram->getExtensionHeader(i);
+        unsigned int length = eh->getByteLength();
+        memset(buf + offset, 0, length);
+        buf[offset] = (i + 1 < numExtensionHeaders) ?
+                datagram->getExtensionHeader(i + 1)->getExtensionType() : dgram->getTransportProtocol();
+        buf[offset + 1] = length / 8 - 1;  // in 8-octet units, not including the first 8 octets
+        offset += length;
+    }
+
+    cPacket *encapPacket = dgram->getEncapsulatedPacket();
+    unsigned int payloadLength = 0;
+    unsigned char *payload = buf + offset;
+    unsigned int payloadBufsize = bufsize - offset;
+
+    switch (dgram->getTransportProtocol())
+    {
+#ifdef WITH_UDP
+      case IP_PROT_UDP:
+        payloadLength = UDPSerializer().serialize(check_and_cast<UDPPacket *>(encapPacket), payload, payloadBufsize);
+        break;
+#endif
+
+#ifdef WITH_TCP_COMMON
+      case IP_PROT_TCP:
+        payloadLength = TCPSerializer().serialize(check_and_cast<TCPSegment *>(encapPacket), payload, payloadBufsize,
+                                                  dgram->getSrcAddress(), dgram->getDestAddress());
+        break;
+#endif
+
+      case IP_PROT_IPv6_ICMP:
+        payloadLength = std::min((unsigned int)encapPacket->getByteLength(), payloadBufsize);
+        if (payloadLength > 0)
+            payload[0] = check_and_cast<ICMPv6Message *>(encapPacket)->getType();
+        break;
+
+      default:
+        if (encapPacket)
+            payloadLength = std::min((unsigned int)encapPacket->getByteLength(), payloadBufsize);
+        break;
+    }
+
+    uint16 payloadLengthField = htons(offset - IPv6_HEADER_BYTES + payloadLength);
+    memcpy(buf + 4, &payloadLengthField, 2);
+
+    return offset + payloadLength;
+}
+
@@ -0,0 +1,45 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IPV6SERIALIZER_H
+#define __INET_IPV6SERIALIZER_H
+
+#include "IPv6Datagram.h"
+
+
+/**
+ * Converts an IPv6Datagram to binary (network byte order) IPv6 header,
+ * for packet traces.
+ *
+ * Extension headers are written as empty option headers of the right
+ * length and type. UDP and TCP payloads are serialized; the payload of
+ * ICMPv6 messages and other protocols only has the right length. Bytes not
+ * written by the serializers are left untouched, so the buffer should be
+ * zeroed by the caller.
+ */
+class IPv6Serializer
+{
+    public:
+        IPv6Serializer() {}
+
+        /**
+         * Serializes an IPv6Datagram. Returns the length of data written
+         * into buffer.
+         */
+        int serialize(const IPv6Datagram *dgram, unsigned char *buf, unsigned int bufsize);
+};
+
+#endif
+
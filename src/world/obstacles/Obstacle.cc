@@ -22,6 +22,7 @@
 
 Obstacle::Obstacle(std::string id, double attenuationPerWall, double attenuationPerMeter) :
     visualRepresentation(0),
+    lastVisit(0),
     id(id),
     attenuationPerWall(attenuationPerWall),
     attenuationPerMeter(attenuationPerMeter) {
@@ -17,6 +17,7 @@
 // Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 //
 
+#include <algorithm>
 #include <sstream>
 #include <map>
 #include <set>
@@ -33,9 +34,21 @@ ObstacleControl::~ObstacleControl() {
 void ObstacleControl::initialize(int stage) {
     if (stage == 1) {
         debug = par("debug");
+        gridCellSize = par("gridCellSize");
+        if (gridCellSize <= 0) error("gridCellSize must be positive");
+        cachePositionResolution = par("cachePositionResolution");
+        if (cachePositionResolution < 0) error("cachePositionResolution must not be negative");
+        int cacheSizePar = par("cacheSize");
+        if (cacheSizePar < 0) error("cacheSize must not be negative");
+        cacheSize = cacheSizePar;
 
         obstacles.clear();
-        cacheEntries.clear();
+        clearCache();
+        visitCounter = 0;
+        numCacheHits = 0;
+        numCacheMisses = 0;
+        WATCH(numCacheHits);
+        WATCH(numCacheMisses);
 
         annotations = AnnotationManagerAccess().getIfExists();
         if (annotations) annotationGroup = annotations->createGroup("obstacles");
@@ -47,6 +60,9 @@ void ObstacleControl::initialize(int stage) {
 }
 
 void ObstacleControl::finish() {
+    recordScalar("cacheHits", numCacheHits);
+    recordScalar("cacheMisses", numCacheMisses);
+
     for (Obstacles::iterator i = obstacles.begin(); i != obstacles.end(); ++i) {
         for (ObstacleGridRow::iterator j = i->begin(); j != i->end(); ++j) {
             while (j->begin() != j->end()) erase(*j->begin());
@@ -111,10 +127,10 @@ void ObstacleControl::addFromXml(cXMLElement* xml) {
 void ObstacleControl::add(Obstacle obstacle) {
     Obstacle* o = new Obstacle(obstacle);
 
-    size_t fromRow = std::max(0, int(o->getBboxP1().x / GRIDCELL_SIZE));
-    size_t toRow = std::max(0, int(o->getBboxP2().x / GRIDCELL_SIZE));
-    size_t fromCol = std::max(0, int(o->getBboxP1().y / GRIDCELL_SIZE));
-    size_t toCol = std::max(0, int(o->getBboxP2().y / GRIDCELL_SIZE));
+    size_t fromRow = std::max(0, int(o->getBboxP1().x / gridCellSize));
+    size_t toRow = std::max(0, int(o->getBboxP2().x / gridCellSize));
+    size_t fromCol = std::max(0, int(o->getBboxP1().y / gridCellSize));
+    size_t toCol = std::max(0, int(o->getBboxP2().y / gridCellSize));
     for (size_t row = fromRow; row <= toRow; ++row) {
         for (size_t col = fromCol; col <= toCol; ++col) {
             if (obstacles.size() < col+1) obstacles.resize(col+1);
@@ -126,7 +142,7 @@ void ObstacleControl::add(Obstacle obstacle) {
     // visualize using AnnotationManager
     if (annotations) o->visualRepresentation = annotations->drawPolygon(o->getShape(), "red", annotationGroup);
 
-    cacheEntries.clear();
+    clearCache();
 }
 
 void ObstacleControl::erase(const Obstacle* obstacle) {
@@ -146,62 +162,122 @@ void ObstacleControl::erase(const Obstacle* obstacle) {
     if (annotations && obstacle->visualRepresentation) annotations->erase(obstacle->visualRepresentation);
     delete obstacle;
 
+    clearCache();
+}
+
+void ObstacleControl::clearCache() {
     cacheEntries.clear();
+    cacheList.clear();
+}
+
+Coord ObstacleControl::quantize(const Coord& pos) const {
+    if (cachePositionResolution <= 0) return pos;
+    return Coord(floor(pos.x / cachePositionResolution + 0.5) * cachePositionResolution,
+                 floor(pos.y / cachePositionResolution + 0.5) * cachePositionResolution,
+                 floor(pos.z / cachePositionResolution + 0.5) * cachePositionResolution);
+}
+
+bool ObstacleControl::segmentIntersectsBox(const Coord& p1, const Coord& p2, const Coord& boxP1, const Coord& boxP2) {
+    // Liang-Barsky clipping of the segment p1 + t * (p2 - p1), t in [0, 1]
+    double tMin = 0;
+    double tMax = 1;
+    const double p[2] = { p1.x, p1.y };
+    const double d[2] = { p2.x - p1.x, p2.y - p1.y };
+    const double lo[2] = { boxP1.x, boxP1.y };
+    const double hi[2] = { boxP2.x, boxP2.y };
+    for (int i = 0; i < 2; ++i) {
+        if (d[i] == 0) {
+            if (p[i] < lo[i] || p[i] > hi[i]) return false;
+            continue;
+        }
+        double t1 = (lo[i] - p[i]) / d[i];
+        double t2 = (hi[i] - p[i]) / d[i];
+        if (t1 > t2) std::swap(t1, t2);
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax) return false;
+    }
+    return true;
 }
 
 double ObstacleControl::calculateReceivedPower(double pSend, double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) const {
     Enter_Method_Silent();
 
     // return cached result, if available
-    CacheKey cacheKey(pSend, carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle);
+    CacheKey cacheKey(carrierFrequency, quantize(senderPos), senderAngle, quantize(receiverPos), receiverAngle);
     CacheEntries::const_iterator cacheEntryIter = cacheEntries.find(cacheKey);
-    if (cacheEntryIter != cacheEntries.end()) return cacheEntryIter->second;
+    if (cacheEntryIter != cacheEntries.end()) {
+        numCacheHits++;
+        cacheList.splice(cacheList.begin(), cacheList, cacheEntryIter->second);
+        return pSend * cacheEntryIter->second->second;
+    }
+    numCacheMisses++;
+
+    // attenuation is calculated for the quantized positions, so results do not depend on the cache contents
+    double attenuation = calculateAttenuation(carrierFrequency, cacheKey.senderPos, senderAngle, cacheKey.receiverPos, receiverAngle);
+
+    // cache result, evicting the least recently used entry
+    if (cacheSize > 0) {
+        cacheList.push_front(std::make_pair(cacheKey, attenuation));
+        cacheEntries.insert(std::make_pair(cacheKey, cacheList.begin()));
+        if (cacheEntries.size() > cacheSize) {
+            cacheEntries.erase(cacheList.back().first);
+            cacheList.pop_back();
+        }
+    }
+
+    return pSend * attenuation;
+}
 
+double ObstacleControl::calculateAttenuation(double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) const {
     // calculate bounding box of transmission
     Coord bboxP1 = Coord(std::min(senderPos.x, receiverPos.x), std::min(senderPos.y, receiverPos.y));
     Coord bboxP2 = Coord(std::max(senderPos.x, receiverPos.x), std::max(senderPos.y, receiverPos.y));
 
-    size_t fromRow = std::max(0, int(bboxP1.x / GRIDCELL_SIZE));
-    size_t toRow = std::max(0, int(bboxP2.x / GRIDCELL_SIZE));
-    size_t fromCol = std::max(0, int(bboxP1.y / GRIDCELL_SIZE));
-    size_t toCol = std::max(0, int(bboxP2.y / GRIDCELL_SIZE));
+    size_t fromRow = std::max(0, int(bboxP1.x / gridCellSize));
+    size_t toRow = std::max(0, int(bboxP2.x / gridCellSize));
+    size_t fromCol = std::max(0, int(bboxP1.y / gridCellSize));
+    size_t toCol = std::max(0, int(bboxP2.y / gridCellSize));
 
-    std::set<Obstacle*> processedObstacles;
+    // obstacles may be stored in several cells; process each only once
+    visitCounter++;
+
+    double attenuation = 1;
     for (size_t col = fromCol; col <= toCol; ++col) {
         if (col >= obstacles.size()) break;
         for (size_t row = fromRow; row <= toRow; ++row) {
             if (row >= obstacles[col].size()) break;
             const ObstacleGridCell& cell = (obstacles[col])[row];
+            if (cell.empty()) continue;
+
+            // skip cells the line of sight does not cross (first row/column also hold negative coordinates)
+            Coord cellP1(row == 0 ? -HUGE_VAL : row * gridCellSize, col == 0 ? -HUGE_VAL : col * gridCellSize);
+            Coord cellP2((row + 1) * gridCellSize, (col + 1) * gridCellSize);
+            if (!segmentIntersectsBox(senderPos, receiverPos, cellP1, cellP2)) continue;
+
             for (ObstacleGridCell::const_iterator k = cell.begin(); k != cell.end(); ++k) {
 
                 Obstacle* o = *k;
 
-                if (processedObstacles.find(o) != processedObstacles.end()) continue;
-                processedObstacles.insert(o);
+                if (o->lastVisit == visitCounter) continue;
+                o->lastVisit = visitCounter;
 
-                // bail if bounding boxes cannot overlap
-                if (o->getBboxP2().x < bboxP1.x) continue;
-                if (o->getBboxP1().x > bboxP2.x) continue;
-                if (o->getBboxP2().y < bboxP1.y) continue;
-                if (o->getBboxP1().y > bboxP2.y) continue;
+                // bail if line of sight does not cross the bounding box
+                if (!segmentIntersectsBox(senderPos, receiverPos, o->getBboxP1(), o->getBboxP2())) continue;
 
-                double pSendOld = pSend;
+                double attenuationOld = attenuation;
 
-                pSend = o->calculateReceivedPower(pSend, carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle);
+                attenuation = o->calculateReceivedPower(attenuation, carrierFrequency, senderPos, senderAngle, receiverPos, receiverAngle);
 
                 // draw a "hit!" bubble
-                if (annotations && (pSend < pSendOld)) annotations->drawBubble(o->getBboxP1(), "hit");
+                if (annotations && (attenuation < attenuationOld)) annotations->drawBubble(o->getBboxP1(), "hit");
 
-                // bail if attenuation is already extremely high
-                if (pSend < 1e-30) break;
+                // bail if attenuation is already extremely high (300 dB)
+                if (attenuation < 1e-30) return attenuation;
 
             }
         }
     }
 
-    // cache result
-    if (cacheEntries.size() >= 1000) cacheEntries.clear();
-    cacheEntries[cacheKey] = pSend;
-
-    return pSend;
+    return attenuation;
 }
@@ -22,6 +22,7 @@
 #define WORLD_OBSTACLE_OBSTACLECONTROL_H
 
 #include <list>
+#include <map>
 
 #include "INETDefs.h"
 
@@ -36,6 +37,10 @@
  * Each Obstacle is a polygon.
  * Transmissions that cross one of the polygon's lines will have
  * their receive power set to zero.
+ *
+ * Obstacles are indexed in a grid of square cells; a transmission is only
+ * checked against obstacles in the cells its line crosses, and whose
+ * bounding box it crosses. Results are kept in a size bounded LRU cache.
  */
 class INET_API ObstacleControl : public cSimpleModule
 {
@@ -57,16 +62,19 @@ class INET_API ObstacleControl : public cSimpleModule
         double calculateReceivedPower(double pSend, double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) const;
 
     protected:
+        /**
+         * Key of the attenuation cache. The attenuation does not depend on
+         * the sending power, so that is not part of the key. Positions are
+         * quantized (see the cachePositionResolution parameter).
+         */
         struct CacheKey {
-            const double pSend;
             const double carrierFrequency;
             const Coord senderPos;
             const double senderAngle;
             const Coord receiverPos;
             const double receiverAngle;
 
-            CacheKey(double pSend, double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) :
-                pSend(pSend),
+            CacheKey(double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) :
                 carrierFrequency(carrierFrequency),
                 senderPos(senderPos),
                 senderAngle(senderAngle),
@@ -82,8 +90,10 @@ class INET_API ObstacleControl : public cSimpleModule
                 if (receiverPos.x > o.receiverPos.x) return false;
                 if (receiverPos.y < o.receiverPos.y) return true;
                 if (receiverPos.y > o.receiverPos.y) return false;
-                if (pSend < o.pSend) return true;
-                if (pSend > o.pSend) return false;
+                if (senderPos.z < o.senderPos.z) return true;
+                if (senderPos.z > o.senderPos.z) return false;
+                if (receiverPos.z < o.receiverPos.z) return true;
+                if (receiverPos.z > o.receiverPos.z) return false;
                 if (senderAngle < o.senderAngle) return true;
                 if (senderAngle > o.senderAngle) return false;
                 if (receiverAngle < o.receiverAngle) return true;
@@ -94,20 +104,44 @@ class INET_API ObstacleControl : public cSimpleModule
             }
         };
 
-        enum { GRIDCELL_SIZE = 1024 };
-
         typedef std::list<Obstacle*> ObstacleGridCell;
         typedef std::vector<ObstacleGridCell> ObstacleGridRow;
         typedef std::vector<ObstacleGridRow> Obstacles;
-        typedef std::map<CacheKey, double> CacheEntries;
+        typedef std::list<std::pair<CacheKey, double> > CacheList; /**< attenuation factors, most recently used first */
+        typedef std::map<CacheKey, CacheList::iterator> CacheEntries;
 
         bool debug; /**< whether to emit debug messages */
         cXMLElement* obstaclesXml; /**< obstacles to add at startup */
+        double gridCellSize; /**< size of the cells obstacles are indexed by, in m */
+        double cachePositionResolution; /**< positions are rounded to this before cache lookup, in m; 0 means exact positions */
+        unsigned int cacheSize; /**< maximum number of cache entries */
 
         Obstacles obstacles;
         AnnotationManager* annotations;
         AnnotationManager::Group* annotationGroup;
+        mutable CacheList cacheList;
         mutable CacheEntries cacheEntries;
+        mutable unsigned int visitCounter; /**< marks obstacles already processed during a query */
+        mutable long numCacheHits;
+        mutable long numCacheMisses;
+
+    protected:
+        /**
+         * calculate the attenuation factor (0..1) caused by obstacles between the given positions
+         */
+        double calculateAttenuation(double carrierFrequency, const Coord& senderPos, double senderAngle, const Coord& receiverPos, double receiverAngle) const;
+
+        /**
+         * round the position to cachePositionResolution
+         */
+        Coord quantize(const Coord& pos) const;
+
+        /**
+         * check whether the segment p1-p2 crosses the axis aligned rectangle boxP1-boxP2 (in the x-y plane)
+         */
+        static bool segmentIntersectsBox(const Coord& p1, const Coord& p2, const Coord& boxP1, const Coord& boxP2);
+
+        void clearCache();
 };
 
 class ObstacleControlAccess
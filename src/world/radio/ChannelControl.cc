@@ -17,10 +17,9 @@
 
 #include "ChannelControl.h"
 #include "FWMath.h"
+#include <algorithm>
 #include <cassert>
 
-#include "AirFrame_m.h"
-
 #define coreEV (ev.isDisabled()||!coreDebug) ? ev : ev << "ChannelControl: "
 
 Define_Module(ChannelControl);
@@ -29,7 +28,7 @@ Define_Module(ChannelControl);
 std::ostream& operator<<(std::ostream& os, const ChannelControl::RadioEntry& radio)
 {
     os << radio.radioModule->getFullPath() << " (x=" << radio.pos.x << ",y=" << radio.pos.y << "), "
-       << radio.neighbors.size() << " neighbor(s)";
+       << radio.neighborList.size() << " neighbor(s)";
     return os;
 }
 
@@ -42,6 +41,10 @@ std::ostream& operator<<(std::ostream& os, const ChannelControl::TransmissionLis
 
 ChannelControl::ChannelControl()
 {
+    numReceptions = numPacketCopies = 0;
+    packetBytesSaved = 0;
+    numCulled = numNotCulled = numCullingValidations = numWrongCulls = 0;
+    maxCulledPowerRatio = maxTableError = 0;
 }
 
 ChannelControl::~ChannelControl()
@@ -49,6 +52,14 @@ ChannelControl::~ChannelControl()
     for (unsigned int i = 0; i < transmissions.size(); i++)
         for (TransmissionList::iterator it = transmissions[i].begin(); it != transmissions[i].end(); it++)
             delete *it;
+
+    // AirFrames still referring to a shared transmission cannot get the packet any more
+    for (SharedTransmissionSet::iterator it = sharedTransmissions.begin(); it != sharedTransmissions.end(); ++it)
+    {
+        delete (*it)->packet;
+        (*it)->packet = NULL;
+        (*it)->owner = NULL;
+    }
 }
 
 /**
@@ -68,10 +79,42 @@ void ChannelControl::initialize()
     lastOngoingTransmissionsUpdate = 0;
 
     maxInterferenceDistance = calcInterfDist();
+    useNeighborGrid = par("useNeighborGrid").boolValue() && maxInterferenceDistance > 0;
+    cullReceptions = par("cullReceptions");
+    cullingValidationInterval = par("cullingValidationInterval");
 
     WATCH(maxInterferenceDistance);
     WATCH_LIST(radios);
     WATCH_VECTOR(transmissions);
+    WATCH(numReceptions);
+    WATCH(numPacketCopies);
+    WATCH(packetBytesSaved);
+    WATCH(numCulled);
+    WATCH(numNotCulled);
+}
+
+void ChannelControl::finish()
+{
+    // transmissions that are still shared are not included
+    recordScalar("numReceptions", numReceptions);
+    recordScalar("numPacketCopies", numPacketCopies);
+    recordScalar("packetCopiesAvoided", numReceptions - numPacketCopies);
+    recordScalar("packetBytesSaved", packetBytesSaved);
+
+    if (cullReceptions)
+    {
+        recordScalar("numCulled", numCulled);
+        recordScalar("numNotCulled", numNotCulled);
+        if (numCulled + numNotCulled > 0)
+            recordScalar("culledFraction", (double)numCulled / (numCulled + numNotCulled));
+        recordScalar("numCullingValidations", numCullingValidations);
+        recordScalar("numWrongCulls", numWrongCulls);
+        if (numCullingValidations > 0)
+        {
+            recordScalar("maxCulledPower", maxCulledPowerRatio > 0 ? 10 * log10(maxCulledPowerRatio) : -INFINITY, "dB");
+            recordScalar("maxTableError", maxTableError, "dB");
+        }
+    }
 }
 
 /**
@@ -122,11 +165,17 @@ ChannelControl::RadioRef ChannelControl::registerRadio(cModule *radio, cGate *ra
     RadioEntry re;
     re.radioModule = radio;
     re.radioInGate = radioInGate->getPathStartGate();
-    re.isNeighborListValid = false;
     re.channel = 0;  // for now
+    re.gridX = re.gridY = 0;
     re.isActive = true;
+    re.powerTable = NULL;
+    re.minReceivePower = 0;
+    re.cullingPSend = re.cullingDistance = -1;
     radios.push_back(re);
-    return &radios.back(); // last element
+    radioRef = &radios.back(); // last element
+    if (useNeighborGrid)
+        addToGrid(radioRef);
+    return radioRef;
 }
 
 void ChannelControl::unregisterRadio(RadioRef r)
@@ -137,14 +186,11 @@ void ChannelControl::unregisterRadio(RadioRef r)
         if (it->radioModule == r->radioModule)
         {
             RadioRef radioToRemove = &*it;
-            // erase radio from all registered radios' neighbor list
-            for (RadioList::iterator i2 = radios.begin(); i2 != radios.end(); ++i2)
-            {
-                RadioRef otherRadio = &*i2;
-                otherRadio->neighbors.erase(radioToRemove);
-                otherRadio->isNeighborListValid = false;
-                radioToRemove->isNeighborListValid = false;
-            }
+            // erase radio from its neighbors' neighbor list
+            while (!radioToRemove->neighborList.empty())
+                removeNeighbor(radioToRemove, radioToRemove->neighborList.back());
+            if (useNeighborGrid)
+                removeFromGrid(radioToRemove);
 
             // erase radio from registered radios
             radios.erase(it);
@@ -167,51 +213,108 @@ ChannelControl::RadioRef ChannelControl::lookupRadio(cModule *radio)
 const ChannelControl::RadioRefVector& ChannelControl::getNeighbors(RadioRef h)
 {
     Enter_Method_Silent();
-    if (!h->isNeighborListValid)
-    {
-        h->neighborList.clear();
-        for (std::set<RadioRef,RadioEntry::Compare>::iterator it = h->neighbors.begin(); it != h->neighbors.end(); it++)
-            h->neighborList.push_back(*it);
-        h->isNeighborListValid = true;
-    }
     return h->neighborList;
 }
 
-void ChannelControl::updateConnections(RadioRef h)
+void ChannelControl::addNeighbor(RadioRef h, RadioRef hi)
 {
-    Coord& hpos = h->pos;
-    double maxDistSquared = maxInterferenceDistance * maxInterferenceDistance;
-    for (RadioList::iterator it = radios.begin(); it != radios.end(); ++it)
-    {
-        RadioEntry *hi = &(*it);
-        if (hi == h)
-            continue;
+    RadioEntry::Compare less;
+    RadioRefVector::iterator it = std::lower_bound(h->neighborList.begin(), h->neighborList.end(), hi, less);
+    if (it != h->neighborList.end() && *it == hi)
+        return;  // already connected
+    h->neighborList.insert(it, hi);
+    hi->neighborList.insert(std::lower_bound(hi->neighborList.begin(), hi->neighborList.end(), h, less), h);
+}
+
+void ChannelControl::removeNeighbor(RadioRef h, RadioRef hi)
+{
+    RadioEntry::Compare less;
+    RadioRefVector::iterator it = std::lower_bound(h->neighborList.begin(), h->neighborList.end(), hi, less);
+    if (it == h->neighborList.end() || *it != hi)
+        return;  // not connected
+    h->neighborList.erase(it);
+    hi->neighborList.erase(std::lower_bound(hi->neighborList.begin(), hi->neighborList.end(), h, less));
+}
 
-        // get the distance between the two radios.
-        // (omitting the square root (calling sqrdist() instead of distance()) saves about 5% CPU)
-        bool inRange = hpos.sqrdist(hi->pos) < maxDistSquared;
+void ChannelControl::updateConnection(RadioRef h, RadioRef hi)
+{
+    // get the distance between the two radios.
+    // (omitting the square root (calling sqrdist() instead of distance()) saves about 5% CPU)
+    bool inRange = h->pos.sqrdist(hi->pos) < maxInterferenceDistance * maxInterferenceDistance;
+
+    if (inRange)
+        addNeighbor(h, hi);     // nodes within communication range: connect
+    else
+        removeNeighbor(h, hi);  // out of range: disconnect
+}
 
-        if (inRange)
+void ChannelControl::updateConnections(RadioRef h)
+{
+    if (!useNeighborGrid)
+    {
+        for (RadioList::iterator it = radios.begin(); it != radios.end(); ++it)
         {
-            // nodes within communication range: connect
-            if (h->neighbors.insert(hi).second == true)
-            {
-                hi->neighbors.insert(h);
-                h->isNeighborListValid = hi->isNeighborListValid = false;
-            }
+            RadioEntry *hi = &(*it);
+            if (hi != h)
+                updateConnection(h, hi);
         }
-        else
+        return;
+    }
+
+    updateGridCell(h);
+
+    // current neighbors may have got out of range; this also covers those
+    // outside the surrounding cells (iterate on a copy, as the list may shrink)
+    RadioRefVector oldNeighbors = h->neighborList;
+    for (RadioRefVector::iterator it = oldNeighbors.begin(); it != oldNeighbors.end(); ++it)
+        updateConnection(h, *it);
+
+    // radios in range can only be in the surrounding cells, as the cell
+    // size equals the interference distance
+    for (int x = h->gridX - 1; x <= h->gridX + 1; x++)
+    {
+        for (int y = h->gridY - 1; y <= h->gridY + 1; y++)
         {
-            // out of range: disconnect
-            if (h->neighbors.erase(hi))
-            {
-                hi->neighbors.erase(h);
-                h->isNeighborListValid = hi->isNeighborListValid = false;
-            }
+            NeighborGrid::iterator cell = grid.find(GridCell(x, y));
+            if (cell == grid.end())
+                continue;
+            RadioRefVector& cellRadios = cell->second;
+            for (RadioRefVector::iterator it = cellRadios.begin(); it != cellRadios.end(); ++it)
+                if (*it != h)
+                    updateConnection(h, *it);
         }
     }
 }
 
+void ChannelControl::addToGrid(RadioRef h)
+{
+    h->gridX = getGridCoordinate(h->pos.x);
+    h->gridY = getGridCoordinate(h->pos.y);
+    grid[GridCell(h->gridX, h->gridY)].push_back(h);
+}
+
+void ChannelControl::removeFromGrid(RadioRef h)
+{
+    NeighborGrid::iterator cell = grid.find(GridCell(h->gridX, h->gridY));
+    ASSERT(cell != grid.end());
+    RadioRefVector& cellRadios = cell->second;
+    RadioRefVector::iterator it = std::find(cellRadios.begin(), cellRadios.end(), h);
+    ASSERT(it != cellRadios.end());
+    *it = cellRadios.back();
+    cellRadios.pop_back();
+    if (cellRadios.empty())
+        grid.erase(cell);
+}
+
+void ChannelControl::updateGridCell(RadioRef h)
+{
+    if (getGridCoordinate(h->pos.x) != h->gridX || getGridCoordinate(h->pos.y) != h->gridY)
+    {
+        removeFromGrid(h);
+        addToGrid(h);
+    }
+}
+
 void ChannelControl::checkChannel(int channel)
 {
     if (channel >= numChannels || channel < 0)
@@ -233,6 +336,15 @@ void ChannelControl::setRadioChannel(RadioRef r, int channel)
     r->channel = channel;
 }
 
+void ChannelControl::setRadioReceivedPowerTable(RadioRef r, const ReceivedPowerTable *table, double minReceivePower)
+{
+    Enter_Method_Silent();
+
+    r->powerTable = cullReceptions ? table : NULL;
+    r->minReceivePower = minReceivePower;
+    r->cullingPSend = r->cullingDistance = -1;
+}
+
 const ChannelControl::TransmissionList& ChannelControl::getOngoingTransmissions(int channel)
 {
     Enter_Method_Silent();
@@ -287,10 +399,87 @@ void ChannelControl::purgeOngoingTransmissions()
     }
 }
 
+bool ChannelControl::isCulled(RadioRef r, AirFrame *airFrame, double distance)
+{
+    const ReceivedPowerTable *table = r->powerTable;
+    double carrierFrequency = airFrame->getCarrierFrequency();
+    if (carrierFrequency > 0 && carrierFrequency != table->getCarrierFrequency())
+        return false;
+
+    // radios usually send with the same power, so the culling distance is cached
+    double pSend = airFrame->getPSend();
+    if (pSend != r->cullingPSend)
+    {
+        r->cullingPSend = pSend;
+        r->cullingDistance = table->getCullingDistance(pSend, r->minReceivePower);
+    }
+    if (distance < r->cullingDistance)
+    {
+        numNotCulled++;
+        return false;
+    }
+
+    numCulled++;
+    if (cullingValidationInterval > 0 && numCulled % cullingValidationInterval == 0)
+        validateCulling(r, pSend, distance);
+    return true;
+}
+
+void ChannelControl::validateCulling(RadioRef r, double pSend, double distance)
+{
+    // the radio does not calculate with smaller distances either
+    distance = std::max(distance, r->powerTable->getMinDistance());
+    double power = r->powerTable->calculateReceivedPower(pSend, distance);
+    double tabulatedPower = r->powerTable->getReceivedPower(pSend, distance);
+
+    numCullingValidations++;
+    if (power >= r->minReceivePower)
+    {
+        numWrongCulls++;
+        coreEV << "wrong cull: " << r->radioModule->getFullPath() << " would receive " << power << "mW\n";
+    }
+    maxCulledPowerRatio = std::max(maxCulledPowerRatio, power / r->minReceivePower);
+    if (power > 0 && tabulatedPower > 0)
+        maxTableError = std::max(maxTableError, fabs(10 * log10(tabulatedPower / power)));
+}
+
+void ChannelControl::shareTransmission(AirFrame *airFrame)
+{
+    Enter_Method_Silent();
+
+    // the decapsulated packet becomes owned by this module
+    AirFrame::SharedTransmission *transmission = airFrame->sharePacket(this);
+    if (transmission)
+        sharedTransmissions.insert(transmission);
+}
+
+cPacket *ChannelControl::releaseTransmission(AirFrame::SharedTransmission *transmission, bool keepPacket)
+{
+    // NOTE: no Enter_Method()! The packet is handed over to the calling module
+
+    cPacket *packet = transmission->packet;
+    numReceptions += transmission->numReceptions;
+    numPacketCopies += transmission->numPacketCopies;
+    packetBytesSaved += (double)(transmission->numReceptions - transmission->numPacketCopies) * packet->getByteLength();
+    sharedTransmissions.erase(transmission);
+
+    if (keepPacket)
+    {
+        drop(packet);
+        return packet;
+    }
+    delete packet;
+    return NULL;
+}
+
 void ChannelControl::sendToChannel(RadioRef srcRadio, AirFrame *airFrame)
 {
     // NOTE: no Enter_Method()! We pretend this method is part of ChannelAccess
 
+    // the copies sent to the radios only refer to the packet, and copy it
+    // only if they decode the frame (see AirFrame)
+    shareTransmission(airFrame);
+
     // loop through all radios in range
     const RadioRefVector& neighbors = getNeighbors(srcRadio);
     int n = neighbors.size();
@@ -305,10 +494,16 @@ void ChannelControl::sendToChannel(RadioRef srcRadio, AirFrame *airFrame)
         }
         if (r->channel == channel)
         {
+            double distance = srcRadio->pos.distance(r->pos);
+            if (r->powerTable && isCulled(r, airFrame, distance))
+            {
+                coreEV << "skipping radio that would receive the message below its noise level\n";
+                continue;
+            }
             coreEV << "sending message to radio listening on the same channel\n";
             // account for propagation delay, based on distance in meters
             // Over 300m, dt=1us=10 bit times @ 10Mbps
-            simtime_t delay = srcRadio->pos.distance(r->pos) / LIGHT_SPEED;
+            simtime_t delay = distance / LIGHT_SPEED;
             check_and_cast<cSimpleModule*>(srcRadio->radioModule)->sendDirect(airFrame->dup(), delay, airFrame->getDuration(), r->radioInGate);
         }
         else
@@ -19,14 +19,14 @@
 
 #include <vector>
 #include <list>
+#include <map>
 #include <set>
 
 #include "INETDefs.h"
 #include "Coord.h"
 #include "IChannelControl.h"
-
-// Forward declarations
-class AirFrame;
+#include "AirFrame.h"
+#include "ReceivedPowerTable.h"
 
 #define LIGHT_SPEED 3.0E+8
 #define TRANSMISSION_PURGE_INTERVAL 1.0
@@ -48,12 +48,17 @@ struct IChannelControl::RadioEntry {
             return lhs->radioModule->getId() < rhs->radioModule->getId();
         }
     };
-    // we cache neighbors set in an std::vector, because std::set iteration is slow;
-    // std::vector is created and updated on demand
-    std::set<RadioRef, Compare> neighbors; // cached neighbor list
+    // cached neighbors, kept sorted by module id (see Compare) and updated
+    // incrementally as radios move; std::vector because std::set iteration is slow
     std::vector<RadioRef> neighborList;
-    bool isNeighborListValid;
+    int gridX, gridY; // cell of the neighbor grid the radio is stored in
     bool isActive;
+
+    // transmission culling, see ChannelControl::isCulled()
+    const ReceivedPowerTable *powerTable;  // NULL if not known
+    double minReceivePower;
+    double cullingPSend;     // the transmitter power cullingDistance was calculated for
+    double cullingDistance;
 };
 
 /**
@@ -62,7 +67,7 @@ struct IChannelControl::RadioEntry {
  * @ingroup channelControl
  * @see ChannelAccess
  */
-class INET_API ChannelControl : public cSimpleModule, public IChannelControl
+class INET_API ChannelControl : public cSimpleModule, public IChannelControl, public AirFrame::ISharedTransmissionOwner
 {
   protected:
     typedef std::list<RadioEntry> RadioList;
@@ -92,15 +97,89 @@ class INET_API ChannelControl : public cSimpleModule, public IChannelControl
     /** the number of controlled channels */
     int numChannels;
 
+    /** if true, radios are indexed in a grid of maxInterferenceDistance sized cells,
+     * so a moving radio is only compared to radios in the surrounding cells */
+    bool useNeighborGrid;
+
+    typedef std::pair<int, int> GridCell;
+    typedef std::map<GridCell, RadioRefVector> NeighborGrid;
+    NeighborGrid grid;
+
+    /** transmissions whose packet is owned by this module, see shareTransmission() */
+    typedef std::set<AirFrame::SharedTransmission *> SharedTransmissionSet;
+    SharedTransmissionSet sharedTransmissions;
+
+    /** statistics of the shared transmissions released so far */
+    long numReceptions;       // AirFrames sent to the radios in range
+    long numPacketCopies;     // packets copied by the radios that decoded the frame
+    double packetBytesSaved;  // length of the packets not copied
+
+    /** if true, transmissions are not sent to radios that would receive them below their minReceivePower */
+    bool cullReceptions;
+
+    /** every this many culled transmissions the received power is calculated for the statistics; 0 means never */
+    int cullingValidationInterval;
+
+    /** @name Culling statistics */
+    //@{
+    long numCulled;              // transmissions not sent to radios with a power table
+    long numNotCulled;           // transmissions sent to radios with a power table
+    long numCullingValidations;  // culled transmissions whose received power was calculated
+    long numWrongCulls;          // of these, received above minReceivePower
+    double maxCulledPowerRatio;  // the maximum of received power / minReceivePower of these
+    double maxTableError;        // the maximum difference of the tabulated and the calculated received power, in dB
+    //@}
+
   protected:
     virtual void updateConnections(RadioRef h);
 
+    /** Checks the distance between the two radios and connects or disconnects them */
+    virtual void updateConnection(RadioRef h, RadioRef hi);
+
+    /** Inserts the radio into the grid cell of its current position */
+    virtual void addToGrid(RadioRef h);
+
+    /** Removes the radio from the grid cell it is stored in */
+    virtual void removeFromGrid(RadioRef h);
+
+    /** Moves the radio to another grid cell if its position requires */
+    virtual void updateGridCell(RadioRef h);
+
+    /** Returns the grid coordinate of the given position coordinate */
+    virtual int getGridCoordinate(double coordinate) { return (int)floor(coordinate / maxInterferenceDistance); }
+
+    /** Insert/remove the radios into/from each other's neighbor list */
+    virtual void addNeighbor(RadioRef h, RadioRef hi);
+    virtual void removeNeighbor(RadioRef h, RadioRef hi);
+
     /** Calculate interference distance*/
     virtual double calcInterfDist();
 
     /** Reads init parameters and calculates a maximal interference distance*/
     virtual void initialize();
 
+    /** Records the packet copy statistics */
+    virtual void finish();
+
+    /**
+     * Moves the packet of the AirFrame into a shared transmission owned by
+     * this module, so that the copies sent to the radios do not copy it.
+     */
+    virtual void shareTransmission(AirFrame *airFrame);
+
+    /**
+     * Returns true if the transmission need not be sent to the radio,
+     * because the power table of the radio says it would be received below
+     * its minReceivePower. Updates the culling statistics.
+     */
+    virtual bool isCulled(RadioRef r, AirFrame *airFrame, double distance);
+
+    /** Calculates the received power of a culled transmission for the statistics */
+    virtual void validateCulling(RadioRef r, double pSend, double distance);
+
+    /** Deletes the packet of the shared transmission or hands it over to the calling module */
+    virtual cPacket *releaseTransmission(AirFrame::SharedTransmission *transmission, bool keepPacket);
+
     /** Throws away expired transmissions. */
     virtual void purgeOngoingTransmissions();
 
@@ -141,6 +220,9 @@ class INET_API ChannelControl : public cSimpleModule, public IChannelControl
     /** Called when host switches channel */
     virtual void setRadioChannel(RadioRef r, int channel);
 
+    /** Enables transmission culling for the radio if the cullReceptions parameter is true */
+    virtual void setRadioReceivedPowerTable(RadioRef r, const ReceivedPowerTable *table, double minReceivePower);
+
     /** Returns the number of radio channels (frequencies) simulated */
     virtual int getNumChannels() { return numChannels; }
 
@@ -25,6 +25,7 @@
 
 // Forward declarations
 class AirFrame;
+class ReceivedPowerTable;
 
 /**
  * Interface to implement for a module that controls radio frequency channel access.
@@ -62,6 +63,12 @@ class INET_API IChannelControl
     /** Called when host switches channel */
     virtual void setRadioChannel(RadioRef r, int channel) = 0;
 
+    /**
+     * Sets the received power table of the radio and the power below which
+     * transmissions need not be sent to it; NULL means unknown.
+     */
+    virtual void setRadioReceivedPowerTable(RadioRef r, const ReceivedPowerTable *table, double minReceivePower) = 0;
+
     /** Returns the number of radio channels (frequencies) simulated */
     virtual int getNumChannels() = 0;
 
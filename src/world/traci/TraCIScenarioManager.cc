@@ -97,6 +97,9 @@ void TraCIScenarioManager::initialize(int stage) {
     nextNodeVectorIndex = 0;
     hosts.clear();
     subscribedVehicles.clear();
+    queuedMessage.clear();
+    queuedCommands.clear();
+    receiveBuffersInUse = 0;
     activeVehicleCount = 0;
     autoShutdownTriggered = false;
 
@@ -112,6 +115,12 @@ void TraCIScenarioManager::initialize(int stage) {
 }
 
 std::string TraCIScenarioManager::receiveTraCIMessage() {
+    std::vector<char> buf;
+    receiveTraCIMessage(buf);
+    return buf.empty() ? std::string() : std::string(&buf[0], buf.size());
+}
+
+void TraCIScenarioManager::receiveTraCIMessage(std::vector<char>& buf) {
     if (!socketPtr) error("Connection to TraCI server lost");
 
     uint32_t msgLength;
@@ -134,12 +143,12 @@ std::string TraCIScenarioManager::receiveTraCIMessage() {
     }
 
     uint32_t bufLength = msgLength - sizeof(msgLength);
-    char buf[bufLength];
+    buf.resize(bufLength);
     {
         MYDEBUG << "Reading TraCI message of " << bufLength << " bytes" << endl;
         uint32_t bytesRead = 0;
         while (bytesRead < bufLength) {
-            int receivedBytes = ::recv(MYSOCKET, reinterpret_cast<char*>(&buf) + bytesRead, bufLength - bytesRead, 0);
+            int receivedBytes = ::recv(MYSOCKET, &buf[bytesRead], bufLength - bytesRead, 0);
             if (receivedBytes > 0) {
                 bytesRead += receivedBytes;
             } else if (receivedBytes == 0) {
@@ -151,7 +160,6 @@ std::string TraCIScenarioManager::receiveTraCIMessage() {
             }
         }
     }
-    return std::string(buf, bufLength);
 }
 
 void TraCIScenarioManager::sendTraCIMessage(std::string buf) {
@@ -200,32 +208,96 @@ std::string TraCIScenarioManager::makeTraCICommand(uint8_t commandId, TraCIBuffe
 }
 
 TraCIScenarioManager::TraCIBuffer TraCIScenarioManager::queryTraCI(uint8_t commandId, const TraCIBuffer& buf) {
-    sendTraCIMessage(makeTraCICommand(commandId, buf));
+    TraCIReader obuf = queryTraCIReader(commandId, buf);
+    TraCIBuffer result(obuf.str());
+    releaseTraCIResponse();
+    return result;
+}
 
-    TraCIBuffer obuf(receiveTraCIMessage());
-    uint8_t cmdLength; obuf >> cmdLength;
-    uint8_t commandResp; obuf >> commandResp;
-    ASSERT(commandResp == commandId);
-    uint8_t result; obuf >> result;
-    std::string description; obuf >> description;
-    if (result == RTYPE_NOTIMPLEMENTED) error("TraCI server reported command 0x%2x not implemented (\"%s\"). Might need newer version.", commandId, description.c_str());
-    if (result == RTYPE_ERR) error("TraCI server reported error executing command 0x%2x (\"%s\").", commandId, description.c_str());
-    ASSERT(result == RTYPE_OK);
+TraCIScenarioManager::TraCIBuffer TraCIScenarioManager::queryTraCIOptional(uint8_t commandId, const TraCIBuffer& buf, bool& success, std::string* errorMsg) {
+    TraCIReader obuf = queryTraCIReader(commandId, buf, &success, errorMsg);
+    TraCIBuffer result(obuf.str());
+    releaseTraCIResponse();
+    return result;
+}
+
+TraCIScenarioManager::TraCIReader TraCIScenarioManager::queryTraCIReader(uint8_t commandId, const TraCIBuffer& buf, bool* success, std::string* errorMsg) {
+    // send the command together with all queued ones, in one message
+    std::vector<QueuedCommand> commands;
+    commands.swap(queuedCommands);
+    std::string message;
+    message.swap(queuedMessage);
+    message += makeTraCICommand(commandId, buf);
+    sendTraCIMessage(message);
+
+    TraCIReader obuf = receiveTraCIResponse();
+    processQueuedResponses(obuf, commands);
+    bool ok = readStatusResponse(obuf, commandId, success != 0, errorMsg);
+    if (success) *success = ok;
     return obuf;
 }
 
-TraCIScenarioManager::TraCIBuffer TraCIScenarioManager::queryTraCIOptional(uint8_t commandId, const TraCIBuffer& buf, bool& success, std::string* errorMsg) {
-    sendTraCIMessage(makeTraCICommand(commandId, buf));
+TraCIScenarioManager::TraCIReader TraCIScenarioManager::receiveTraCIResponse() {
+    // responses are processed while a nested query is made (e.g. while a module is
+    // being added), so each nesting level needs a buffer of its own
+    if (receiveBuffersInUse == receiveBuffers.size()) receiveBuffers.push_back(std::vector<char>());
+    std::vector<char>& buf = receiveBuffers[receiveBuffersInUse++];
+    receiveTraCIMessage(buf);
+    return buf.empty() ? TraCIReader() : TraCIReader(&buf[0], buf.size());
+}
+
+void TraCIScenarioManager::releaseTraCIResponse() {
+    ASSERT(receiveBuffersInUse > 0);
+    receiveBuffersInUse--;
+}
+
+void TraCIScenarioManager::queueTraCICommand(uint8_t commandId, const TraCIBuffer& buf, bool isSubscription) {
+    queuedMessage += makeTraCICommand(commandId, buf);
+    queuedCommands.push_back(QueuedCommand(commandId, isSubscription));
+}
+
+void TraCIScenarioManager::flushTraCICommands() {
+    if (queuedCommands.empty()) return;
+
+    std::vector<QueuedCommand> commands;
+    commands.swap(queuedCommands);
+    std::string message;
+    message.swap(queuedMessage);
+    sendTraCIMessage(message);
 
-    TraCIBuffer obuf(receiveTraCIMessage());
-    uint8_t cmdLength; obuf >> cmdLength;
-    uint8_t commandResp; obuf >> commandResp;
+    TraCIReader obuf = receiveTraCIResponse();
+    processQueuedResponses(obuf, commands);
+    ASSERT(obuf.eof());
+    releaseTraCIResponse();
+}
+
+bool TraCIScenarioManager::readStatusResponse(TraCIReader& buf, uint8_t commandId, bool optional, std::string* errorMsg) {
+    uint8_t cmdLength; buf >> cmdLength;
+    if (cmdLength == 0) {
+        uint32_t cmdLengthX;
+        buf >> cmdLengthX;
+    }
+    uint8_t commandResp; buf >> commandResp;
     ASSERT(commandResp == commandId);
-    uint8_t result; obuf >> result;
-    std::string description; obuf >> description;
-    success = (result == RTYPE_OK);
+    uint8_t result; buf >> result;
+    if (!errorMsg && result == RTYPE_OK) {
+        buf.skipString();
+        return true;
+    }
+    std::string description; buf >> description;
     if (errorMsg) *errorMsg = description;
-    return obuf;
+    if (optional) return (result == RTYPE_OK);
+    if (result == RTYPE_NOTIMPLEMENTED) error("TraCI server reported command 0x%2x not implemented (\"%s\"). Might need newer version.", commandId, description.c_str());
+    if (result == RTYPE_ERR) error("TraCI server reported error executing command 0x%2x (\"%s\").", commandId, description.c_str());
+    ASSERT(result == RTYPE_OK);
+    return true;
+}
+
+void TraCIScenarioManager::processQueuedResponses(TraCIReader& buf, const std::vector<QueuedCommand>& commands) {
+    for (std::vector<QueuedCommand>::const_iterator i = commands.begin(); i != commands.end(); ++i) {
+        readStatusResponse(buf, i->commandId);
+        if (i->isSubscription) processSubcriptionResult(buf);
+    }
 }
 
 void TraCIScenarioManager::connect() {
@@ -310,9 +382,10 @@ void TraCIScenarioManager::init_traci() {
         uint8_t variable1 = VAR_DEPARTED_VEHICLES_IDS;
         uint8_t variable2 = VAR_ARRIVED_VEHICLES_IDS;
         uint8_t variable3 = VAR_TIME_STEP;
-        TraCIBuffer buf = queryTraCI(CMD_SUBSCRIBE_SIM_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber << variable1 << variable2 << variable3);
+        TraCIReader buf = queryTraCIReader(CMD_SUBSCRIBE_SIM_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber << variable1 << variable2 << variable3);
         processSubcriptionResult(buf);
         ASSERT(buf.eof());
+        releaseTraCIResponse();
     }
 
     {
@@ -322,11 +395,14 @@ void TraCIScenarioManager::init_traci() {
         std::string objectId = "";
         uint8_t variableNumber = 1;
         uint8_t variable1 = ID_LIST;
-        TraCIBuffer buf = queryTraCI(CMD_SUBSCRIBE_VEHICLE_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber << variable1);
+        TraCIReader buf = queryTraCIReader(CMD_SUBSCRIBE_VEHICLE_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber << variable1);
         processSubcriptionResult(buf);
         ASSERT(buf.eof());
+        releaseTraCIResponse();
     }
 
+    // subscribe to the variables of vehicles that are already driving
+    flushTraCICommands();
 }
 
 void TraCIScenarioManager::finish() {
@@ -334,6 +410,9 @@ void TraCIScenarioManager::finish() {
     executeOneTimestepTrigger = NULL;
     cancelAndDelete(connectAndStartTrigger);
     connectAndStartTrigger = NULL;
+    // commands queued during the last time step would not take effect any more
+    queuedMessage.clear();
+    queuedCommands.clear();
     if (socketPtr) {
         closesocket(MYSOCKET);
         delete &MYSOCKET;
@@ -388,33 +467,31 @@ std::pair<uint32_t, std::string> TraCIScenarioManager::commandGetVersion() {
 void TraCIScenarioManager::commandSetSpeedMode(std::string nodeId, int32_t bitset) {
     uint8_t variableId = VAR_SPEEDSETMODE;
     uint8_t variableType = TYPE_INTEGER;
-    TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << bitset);
-    ASSERT(buf.eof());
+    queueTraCICommand(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << bitset);
 }
 
 void TraCIScenarioManager::commandSetSpeed(std::string nodeId, double speed) {
     uint8_t variableId = VAR_SPEED;
     uint8_t variableType = TYPE_DOUBLE;
-    TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << speed);
-    ASSERT(buf.eof());
+    queueTraCICommand(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << speed);
 }
 
 void TraCIScenarioManager::commandNewRoute(std::string nodeId, std::string roadId) {
     uint8_t variableId = LANE_EDGE_ID;
     uint8_t variableType = TYPE_STRING;
-    TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << roadId);
-    ASSERT(buf.eof());
+    queueTraCICommand(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << roadId);
 }
 
 void TraCIScenarioManager::commandSetVehicleParking(std::string nodeId) {
     uint8_t variableId = REMOVE;
     uint8_t variableType = TYPE_BYTE;
     uint8_t value = NOTIFICATION_PARKING;
-    TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << value);
-    ASSERT(buf.eof());
+    queueTraCICommand(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << value);
 }
 
 std::string TraCIScenarioManager::commandGetEdgeId(std::string nodeId) {
+    const VehicleVariables* variables = getVehicleVariables(nodeId);
+    if (variables) return variables->roadId;
     return genericGetString(CMD_GET_VEHICLE_VARIABLE, nodeId, VAR_ROAD_ID, RESPONSE_GET_VEHICLE_VARIABLE);
 }
 
@@ -423,10 +500,14 @@ std::string TraCIScenarioManager::commandGetCurrentEdgeOnRoute(std::string nodeI
 }
 
 std::string TraCIScenarioManager::commandGetLaneId(std::string nodeId) {
+    const VehicleVariables* variables = getVehicleVariables(nodeId);
+    if (variables) return variables->laneId;
     return genericGetString(CMD_GET_VEHICLE_VARIABLE, nodeId, VAR_LANE_ID, RESPONSE_GET_VEHICLE_VARIABLE);
 }
 
 double TraCIScenarioManager::commandGetLanePosition(std::string nodeId) {
+    const VehicleVariables* variables = getVehicleVariables(nodeId);
+    if (variables) return variables->lanePosition;
     return genericGetDouble(CMD_GET_VEHICLE_VARIABLE, nodeId, VAR_LANEPOSITION, RESPONSE_GET_VEHICLE_VARIABLE);
 }
 
@@ -451,23 +532,20 @@ void TraCIScenarioManager::commandChangeRoute(std::string nodeId, std::string ro
         std::string edgeId = roadId;
         uint8_t newTimeT = TYPE_DOUBLE;
         double newTime = travelTime;
-        TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId << newTimeT << newTime);
-        ASSERT(buf.eof());
+        queueTraCICommand(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId << newTimeT << newTime);
     } else {
         uint8_t variableId = VAR_EDGE_TRAVELTIME;
         uint8_t variableType = TYPE_COMPOUND;
         int32_t count = 1;
         uint8_t edgeIdT = TYPE_STRING;
         std::string edgeId = roadId;
-        TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId);
-        ASSERT(buf.eof());
+        queueTraCICommand(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId);
     }
     {
         uint8_t variableId = CMD_REROUTE_TRAVELTIME;
         uint8_t variableType = TYPE_COMPOUND;
         int32_t count = 0;
-        TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count);
-        ASSERT(buf.eof());
+        queueTraCICommand(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count);
     }
 }
 
@@ -503,18 +581,15 @@ void TraCIScenarioManager::commandStopNode(std::string nodeId, std::string roadI
     uint8_t durationT = TYPE_INTEGER;
     uint32_t duration = waittime * 1000;
 
-    TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId << stopPosT << stopPos << stopLaneT << stopLane << durationT << duration);
-    ASSERT(buf.eof());
+    queueTraCICommand(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId << stopPosT << stopPos << stopLaneT << stopLane << durationT << duration);
 }
 
 void TraCIScenarioManager::commandSetTrafficLightProgram(std::string trafficLightId, std::string program) {
-    TraCIBuffer buf = queryTraCI(CMD_SET_TL_VARIABLE, TraCIBuffer() << static_cast<uint8_t>(TL_PROGRAM) << trafficLightId << static_cast<uint8_t>(TYPE_STRING) << program);
-    ASSERT(buf.eof());
+    queueTraCICommand(CMD_SET_TL_VARIABLE, TraCIBuffer() << static_cast<uint8_t>(TL_PROGRAM) << trafficLightId << static_cast<uint8_t>(TYPE_STRING) << program);
 }
 
 void TraCIScenarioManager::commandSetTrafficLightPhaseIndex(std::string trafficLightId, int32_t index) {
-    TraCIBuffer buf = queryTraCI(CMD_SET_TL_VARIABLE, TraCIBuffer() << static_cast<uint8_t>(TL_PHASE_INDEX) << trafficLightId << static_cast<uint8_t>(TYPE_INTEGER) << index);
-    ASSERT(buf.eof());
+    queueTraCICommand(CMD_SET_TL_VARIABLE, TraCIBuffer() << static_cast<uint8_t>(TL_PHASE_INDEX) << trafficLightId << static_cast<uint8_t>(TYPE_INTEGER) << index);
 }
 
 std::list<std::string> TraCIScenarioManager::commandGetPolygonIds() {
@@ -537,8 +612,7 @@ void TraCIScenarioManager::commandSetPolygonShape(std::string polyId, std::list<
         TraCICoord pos = omnet2traci(*i);
         buf << static_cast<double>(pos.x) << static_cast<double>(pos.y);
     }
-    TraCIBuffer obuf = queryTraCI(CMD_SET_POLYGON_VARIABLE, buf);
-    ASSERT(obuf.eof());
+    queueTraCICommand(CMD_SET_POLYGON_VARIABLE, buf);
 }
 
 void TraCIScenarioManager::commandAddPolygon(std::string polyId, std::string polyType, const TraCIScenarioManager::Color& color, bool filled, int32_t layer, std::list<Coord> points) {
@@ -556,8 +630,7 @@ void TraCIScenarioManager::commandAddPolygon(std::string polyId, std::string pol
         p << static_cast<double>(pos.x) << static_cast<double>(pos.y);
     }
 
-    TraCIBuffer buf = queryTraCI(CMD_SET_POLYGON_VARIABLE, p);
-    ASSERT(buf.eof());
+    queueTraCICommand(CMD_SET_POLYGON_VARIABLE, p);
 }
 
 std::list<std::string> TraCIScenarioManager::commandGetLaneIds() {
@@ -640,8 +713,9 @@ void TraCIScenarioManager::addModule(std::string nodeId, std::string type, std::
 }
 
 cModule* TraCIScenarioManager::getManagedModule(std::string nodeId) {
-    if (hosts.find(nodeId) == hosts.end()) return 0;
-    return hosts[nodeId];
+    std::map<std::string, cModule*>::const_iterator i = hosts.find(nodeId);
+    if (i == hosts.end()) return 0;
+    return i->second;
 }
 
 bool TraCIScenarioManager::isModuleUnequipped(std::string nodeId) {
@@ -649,6 +723,12 @@ bool TraCIScenarioManager::isModuleUnequipped(std::string nodeId) {
     return true;
 }
 
+const TraCIScenarioManager::VehicleVariables* TraCIScenarioManager::getVehicleVariables(const std::string& nodeId) const {
+    std::map<std::string, VehicleVariables>::const_iterator i = subscribedVehicles.find(nodeId);
+    if ((i == subscribedVehicles.end()) || !i->second.complete) return 0;
+    return &i->second;
+}
+
 void TraCIScenarioManager::deleteModule(std::string nodeId) {
     cModule* mod = getManagedModule(nodeId);
     if (!mod) error("no vehicle with Id \"%s\" found", nodeId.c_str());
@@ -686,13 +766,17 @@ void TraCIScenarioManager::executeOneTimestep() {
     uint32_t targetTime = getCurrentTimeMs();
 
     if (targetTime > round(connectAt.dbl() * 1000)) {
-        TraCIBuffer buf = queryTraCI(CMD_SIMSTEP2, TraCIBuffer() << targetTime);
+        TraCIReader buf = queryTraCIReader(CMD_SIMSTEP2, TraCIBuffer() << targetTime);
 
         uint32_t count; buf >> count;
         MYDEBUG << "Getting " << count << " subscription results" << endl;
         for (uint32_t i = 0; i < count; ++i) {
             processSubcriptionResult(buf);
         }
+        releaseTraCIResponse();
+
+        // (un)subscribe vehicles that departed or arrived in this time step, adding their modules
+        flushTraCICommands();
     }
 
     if (!autoShutdownTriggered) scheduleAt(simTime()+updateInterval, executeOneTimestepTrigger);
@@ -885,35 +969,35 @@ double TraCIScenarioManager::omnet2traciAngle(double angle) const {
     return angle;
 }
 
-void TraCIScenarioManager::subscribeToVehicleVariables(std::string vehicleId) {
+void TraCIScenarioManager::subscribeToVehicleVariables(const std::string& vehicleId) {
     // subscribe to some attributes of the vehicle
     uint32_t beginTime = 0;
     uint32_t endTime = 0x7FFFFFFF;
     std::string objectId = vehicleId;
-    uint8_t variableNumber = 5;
+    uint8_t variableNumber = 7;
     uint8_t variable1 = VAR_POSITION;
     uint8_t variable2 = VAR_ROAD_ID;
     uint8_t variable3 = VAR_SPEED;
     uint8_t variable4 = VAR_ANGLE;
     uint8_t variable5 = VAR_SIGNALS;
+    uint8_t variable6 = VAR_LANE_ID;
+    uint8_t variable7 = VAR_LANEPOSITION;
 
-    TraCIBuffer buf = queryTraCI(CMD_SUBSCRIBE_VEHICLE_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber << variable1 << variable2 << variable3 << variable4 << variable5);
-    processSubcriptionResult(buf);
-    ASSERT(buf.eof());
+    // the response (with the first values) is processed when the queue is sent
+    queueTraCICommand(CMD_SUBSCRIBE_VEHICLE_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber << variable1 << variable2 << variable3 << variable4 << variable5 << variable6 << variable7, true);
 }
 
-void TraCIScenarioManager::unsubscribeFromVehicleVariables(std::string vehicleId) {
+void TraCIScenarioManager::unsubscribeFromVehicleVariables(const std::string& vehicleId) {
     // subscribe to some attributes of the vehicle
     uint32_t beginTime = 0;
     uint32_t endTime = 0x7FFFFFFF;
     std::string objectId = vehicleId;
     uint8_t variableNumber = 0;
 
-    TraCIBuffer buf = queryTraCI(CMD_SUBSCRIBE_VEHICLE_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber);
-    ASSERT(buf.eof());
+    queueTraCICommand(CMD_SUBSCRIBE_VEHICLE_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber);
 }
 
-void TraCIScenarioManager::processSimSubscription(std::string objectId, TraCIBuffer& buf) {
+void TraCIScenarioManager::processSimSubscription(const std::string& objectId, TraCIReader& buf) {
     uint8_t variableNumber_resp; buf >> variableNumber_resp;
     for (uint8_t j = 0; j < variableNumber_resp; ++j) {
         uint8_t variable1_resp; buf >> variable1_resp;
@@ -932,7 +1016,7 @@ void TraCIScenarioManager::processSimSubscription(std::string objectId, TraCIBuf
             uint32_t count; buf >> count;
             MYDEBUG << "TraCI reports " << count << " departed vehicles." << endl;
             for (uint32_t i = 0; i < count; ++i) {
-                std::string idstring; buf >> idstring;
+                buf.skipString();
                 // adding modules is handled on the fly when entering/leaving the ROI
             }
 
@@ -943,11 +1027,13 @@ void TraCIScenarioManager::processSimSubscription(std::string objectId, TraCIBuf
             ASSERT(varType == TYPE_STRINGLIST);
             uint32_t count; buf >> count;
             MYDEBUG << "TraCI reports " << count << " arrived vehicles." << endl;
+            std::string idstring;
             for (uint32_t i = 0; i < count; ++i) {
-                std::string idstring; buf >> idstring;
+                buf >> idstring;
 
-                if (subscribedVehicles.find(idstring) != subscribedVehicles.end()) {
-                    subscribedVehicles.erase(idstring);
+                std::map<std::string, VehicleVariables>::iterator vehicle = subscribedVehicles.find(idstring);
+                if (vehicle != subscribedVehicles.end()) {
+                    subscribedVehicles.erase(vehicle);
                     unsubscribeFromVehicleVariables(idstring);
                 }
 
@@ -978,14 +1064,11 @@ void TraCIScenarioManager::processSimSubscription(std::string objectId, TraCIBuf
     }
 }
 
-void TraCIScenarioManager::processVehicleSubscription(std::string objectId, TraCIBuffer& buf) {
-    bool isSubscribed = (subscribedVehicles.find(objectId) != subscribedVehicles.end());
-    double px;
-    double py;
-    std::string edge;
-    double speed;
-    double angle_traci;
-    int signals;
+void TraCIScenarioManager::processVehicleSubscription(const std::string& objectId, TraCIReader& buf) {
+    std::map<std::string, VehicleVariables>::iterator vehicle = subscribedVehicles.find(objectId);
+    bool isSubscribed = (vehicle != subscribedVehicles.end());
+    // values are stored where commandGetEdgeId() etc. find them
+    VehicleVariables& v = isSubscribed ? vehicle->second : unsubscribedVariables;
     int numRead = 0;
 
     uint8_t variableNumber_resp; buf >> variableNumber_resp;
@@ -1006,53 +1089,65 @@ void TraCIScenarioManager::processVehicleSubscription(std::string objectId, TraC
             uint32_t count; buf >> count;
             MYDEBUG << "TraCI reports " << count << " active vehicles." << endl;
             ASSERT(count == activeVehicleCount);
-            std::set<std::string> drivingVehicles;
+            if (activeVehicleIds.size() < count) activeVehicleIds.resize(count);
             for (uint32_t i = 0; i < count; ++i) {
-                std::string idstring; buf >> idstring;
-                drivingVehicles.insert(idstring);
-            }
-
-            // check for vehicles that need subscribing to
-            std::set<std::string> needSubscribe;
-            std::set_difference(drivingVehicles.begin(), drivingVehicles.end(), subscribedVehicles.begin(), subscribedVehicles.end(), std::inserter(needSubscribe, needSubscribe.begin()));
-            for (std::set<std::string>::const_iterator i = needSubscribe.begin(); i != needSubscribe.end(); ++i) {
-                subscribedVehicles.insert(*i);
-                subscribeToVehicleVariables(*i);
+                buf >> activeVehicleIds[i];
             }
-
-            // check for vehicles that need unsubscribing from
-            std::set<std::string> needUnsubscribe;
-            std::set_difference(subscribedVehicles.begin(), subscribedVehicles.end(), drivingVehicles.begin(), drivingVehicles.end(), std::inserter(needUnsubscribe, needUnsubscribe.begin()));
-            for (std::set<std::string>::const_iterator i = needUnsubscribe.begin(); i != needUnsubscribe.end(); ++i) {
-                subscribedVehicles.erase(*i);
-                unsubscribeFromVehicleVariables(*i);
+            std::sort(activeVehicleIds.begin(), activeVehicleIds.begin() + count);
+
+            // merge with the (sorted) subscribed vehicles: subscribe to vehicles
+            // that are new, unsubscribe from vehicles that are gone
+            std::map<std::string, VehicleVariables>::iterator subscribed = subscribedVehicles.begin();
+            uint32_t i = 0;
+            while ((i < count) || (subscribed != subscribedVehicles.end())) {
+                if ((subscribed == subscribedVehicles.end()) || ((i < count) && (activeVehicleIds[i] < subscribed->first))) {
+                    subscribedVehicles.insert(subscribed, std::make_pair(activeVehicleIds[i], VehicleVariables()));
+                    subscribeToVehicleVariables(activeVehicleIds[i]);
+                    ++i;
+                } else if ((i == count) || (subscribed->first < activeVehicleIds[i])) {
+                    unsubscribeFromVehicleVariables(subscribed->first);
+                    subscribedVehicles.erase(subscribed++);
+                } else {
+                    ++i;
+                    ++subscribed;
+                }
             }
 
         } else if (variable1_resp == VAR_POSITION) {
             uint8_t varType; buf >> varType;
             ASSERT(varType == POSITION_2D);
-            buf >> px;
-            buf >> py;
+            buf >> v.x;
+            buf >> v.y;
             numRead++;
         } else if (variable1_resp == VAR_ROAD_ID) {
             uint8_t varType; buf >> varType;
             ASSERT(varType == TYPE_STRING);
-            buf >> edge;
+            buf >> v.roadId;
             numRead++;
         } else if (variable1_resp == VAR_SPEED) {
             uint8_t varType; buf >> varType;
             ASSERT(varType == TYPE_DOUBLE);
-            buf >> speed;
+            buf >> v.speed;
             numRead++;
         } else if (variable1_resp == VAR_ANGLE) {
             uint8_t varType; buf >> varType;
             ASSERT(varType == TYPE_DOUBLE);
-            buf >> angle_traci;
+            buf >> v.angle;
             numRead++;
         } else if (variable1_resp == VAR_SIGNALS) {
             uint8_t varType; buf >> varType;
             ASSERT(varType == TYPE_INTEGER);
-            buf >> signals;
+            buf >> v.signals;
+            numRead++;
+        } else if (variable1_resp == VAR_LANE_ID) {
+            uint8_t varType; buf >> varType;
+            ASSERT(varType == TYPE_STRING);
+            buf >> v.laneId;
+            numRead++;
+        } else if (variable1_resp == VAR_LANEPOSITION) {
+            uint8_t varType; buf >> varType;
+            ASSERT(varType == TYPE_DOUBLE);
+            buf >> v.lanePosition;
             numRead++;
         } else {
             error("Received unhandled vehicle subscription result");
@@ -1063,17 +1158,20 @@ void TraCIScenarioManager::processVehicleSubscription(std::string objectId, TraC
     if (!isSubscribed) return;
 
     // make sure we got updates for all attributes
-    if (numRead != 5) return;
+    if (numRead != 7) return;
+    v.complete = true;
 
-    Coord p = traci2omnet(TraCICoord(px, py));
-    if ((p.x < 0) || (p.y < 0)) error("received bad node position (%.2f, %.2f), translated to (%.2f, %.2f)", px, py, p.x, p.y);
+    Coord p = traci2omnet(TraCICoord(v.x, v.y));
+    if ((p.x < 0) || (p.y < 0)) error("received bad node position (%.2f, %.2f), translated to (%.2f, %.2f)", v.x, v.y, p.x, p.y);
 
-    double angle = traci2omnetAngle(angle_traci);
+    double angle = traci2omnetAngle(v.angle);
+    const std::string& edge = v.roadId;
+    double speed = v.speed;
 
     cModule* mod = getManagedModule(objectId);
 
     // is it in the ROI?
-    bool inRoi = isInRegionOfInterest(TraCICoord(px, py), edge, speed, angle);
+    bool inRoi = isInRegionOfInterest(TraCICoord(v.x, v.y), edge, speed, angle);
     if (!inRoi) {
         if (mod) {
             deleteModule(objectId);
@@ -1107,7 +1205,7 @@ void TraCIScenarioManager::processVehicleSubscription(std::string objectId, TraC
 
 }
 
-void TraCIScenarioManager::processSubcriptionResult(TraCIBuffer& buf) {
+void TraCIScenarioManager::processSubcriptionResult(TraCIReader& buf) {
     uint8_t cmdLength_resp; buf >> cmdLength_resp;
     uint32_t cmdLengthExt_resp; buf >> cmdLengthExt_resp;
     uint8_t commandId_resp; buf >> commandId_resp;
@@ -24,6 +24,9 @@
 #include <utility>
 #include <map>
 #include <list>
+#include <deque>
+#include <set>
+#include <vector>
 #include <sstream>
 #include <iomanip>
 
@@ -95,6 +98,11 @@ class INET_API TraCIScenarioManager : public cSimpleModule
         void commandSetSpeed(std::string nodeId, double speed);
         void commandNewRoute(std::string nodeId, std::string roadId);
         void commandSetVehicleParking(std::string nodeId);
+        /**
+         * The edge id, lane id and lane position of vehicles are subscribed
+         * to, so these return the values received with the last time step
+         * without querying the server.
+         */
         std::string commandGetEdgeId(std::string nodeId);
         std::string commandGetCurrentEdgeOnRoute(std::string nodeId);
         std::string commandGetLaneId(std::string nodeId);
@@ -235,6 +243,93 @@ class INET_API TraCIScenarioManager : public cSimpleModule
                 size_t buf_index;
         };
 
+        /**
+         * Reads values in TraCI byte-order from a received message, in place:
+         * it neither copies the message nor allocates memory (strings are
+         * assigned to existing objects, reusing their storage).
+         */
+        class TraCIReader {
+            public:
+                TraCIReader() : pos(0), end(0) {}
+                TraCIReader(const char* data, size_t length) : pos(data), end(data + length) {}
+
+                template<typename T> T read() {
+                    if (sizeof(T) > static_cast<size_t>(end - pos)) throw cRuntimeError("Attempted to read past end of byte buffer");
+                    T value;
+                    unsigned char *p_value = reinterpret_cast<unsigned char*>(&value);
+                    if (isBigEndian()) {
+                        for (size_t i=0; i<sizeof(T); ++i) p_value[i] = pos[i];
+                    } else {
+                        for (size_t i=0; i<sizeof(T); ++i) p_value[sizeof(T)-1-i] = pos[i];
+                    }
+                    pos += sizeof(T);
+                    return value;
+                }
+
+                template<typename T> TraCIReader& operator >>(T& out) {
+                    out = read<T>();
+                    return *this;
+                }
+
+                TraCIReader& operator >>(std::string& out) {
+                    uint32_t length = read<uint32_t>();
+                    if (length > static_cast<size_t>(end - pos)) throw cRuntimeError("Attempted to read past end of byte buffer");
+                    out.assign(pos, length);
+                    pos += length;
+                    return *this;
+                }
+
+                void skipString() {
+                    uint32_t length = read<uint32_t>();
+                    if (length > static_cast<size_t>(end - pos)) throw cRuntimeError("Attempted to read past end of byte buffer");
+                    pos += length;
+                }
+
+                bool eof() const {
+                    return pos == end;
+                }
+
+                /** returns the unread part of the message */
+                std::string str() const {
+                    return std::string(pos, end);
+                }
+
+            protected:
+                static bool isBigEndian() {
+                    short a = 0x0102;
+                    unsigned char *p_a = reinterpret_cast<unsigned char*>(&a);
+                    return (p_a[0] == 0x01);
+                }
+
+                const char* pos;
+                const char* end;
+        };
+
+        /**
+         * Values of the subscribed variables of a vehicle, as of the last time step
+         */
+        struct VehicleVariables {
+            VehicleVariables() : x(0), y(0), speed(0), angle(0), signals(0), lanePosition(0), complete(false) {}
+            double x;
+            double y;
+            std::string roadId;
+            double speed;
+            double angle;
+            int32_t signals;
+            std::string laneId;
+            double lanePosition;
+            bool complete; /**< whether all variables have been received */
+        };
+
+        /**
+         * A command queued for sending in the next message, see queueTraCICommand()
+         */
+        struct QueuedCommand {
+            QueuedCommand(uint8_t commandId, bool isSubscription) : commandId(commandId), isSubscription(isSubscription) {}
+            uint8_t commandId;
+            bool isSubscription; /**< whether the response contains a subscription result besides the status */
+        };
+
         bool debug; /**< whether to emit debug messages */
         simtime_t connectAt; /**< when to connect to TraCI server (must be the initial timestep of the server) */
         simtime_t firstStepAt; /**< when to start synchronizing with the TraCI server (-1: immediately after connecting) */
@@ -257,12 +352,19 @@ class INET_API TraCIScenarioManager : public cSimpleModule
         size_t nextNodeVectorIndex; /**< next OMNeT++ module vector index to use */
         std::map<std::string, cModule*> hosts; /**< vector of all hosts managed by us */
         std::set<std::string> unEquippedHosts;
-        std::set<std::string> subscribedVehicles; /**< all vehicles we have already subscribed to */
+        std::map<std::string, VehicleVariables> subscribedVehicles; /**< all vehicles we have already subscribed to, with their variables */
         uint32_t activeVehicleCount; /**< number of vehicles reported as active by TraCI server */
         bool autoShutdownTriggered;
         cMessage* connectAndStartTrigger; /**< self-message scheduled for when to connect to TraCI server and start running */
         cMessage* executeOneTimestepTrigger; /**< self-message scheduled for when to next call executeOneTimestep */
 
+        std::string queuedMessage; /**< commands to be sent ahead of the next query */
+        std::vector<QueuedCommand> queuedCommands;
+        std::deque<std::vector<char> > receiveBuffers; /**< reused for every received message; one per nesting level of queries */
+        size_t receiveBuffersInUse;
+        std::vector<std::string> activeVehicleIds; /**< reused for parsing the list of active vehicles */
+        VehicleVariables unsubscribedVariables; /**< receives the variables of vehicles not subscribed to any more */
+
         uint32_t getCurrentTimeMs(); /**< get current simulation time (in ms) */
 
         void executeOneTimestep(); /**< read and execute all commands for the next timestep */
@@ -275,6 +377,7 @@ class INET_API TraCIScenarioManager : public cSimpleModule
         void deleteModule(std::string nodeId);
 
         bool isModuleUnequipped(std::string nodeId); /**< returns true if this vehicle is Unequipped */
+        const VehicleVariables* getVehicleVariables(const std::string& nodeId) const; /**< returns the subscribed variables of the vehicle, or 0 if not available */
 
         /**
          * returns whether a given position lies within the simulation's region of interest.
@@ -287,6 +390,31 @@ class INET_API TraCIScenarioManager : public cSimpleModule
          */
         TraCIBuffer queryTraCI(uint8_t commandId, const TraCIBuffer& buf = TraCIBuffer());
 
+        /**
+         * sends the queued commands and the given one in a single message, processes the responses to
+         * the queued commands, and checks the status response of the given command. Returns a reader
+         * for the additional responses, which reads from a receive buffer that stays valid until
+         * releaseTraCIResponse() is called. If success is given, errors are returned instead of raised.
+         */
+        TraCIReader queryTraCIReader(uint8_t commandId, const TraCIBuffer& buf, bool* success = 0, std::string* errorMsg = 0);
+
+        /**
+         * releases the receive buffer of the last response returned by queryTraCIReader()
+         */
+        void releaseTraCIResponse();
+
+        /**
+         * queues a command whose response is a status response and, for subscription commands,
+         * a subscription result; it is sent in the same message as the next query, or by
+         * flushTraCICommands(), and its response is checked then. This saves a round trip per command.
+         */
+        void queueTraCICommand(uint8_t commandId, const TraCIBuffer& buf, bool isSubscription = false);
+
+        /**
+         * sends the queued commands, and processes their responses
+         */
+        void flushTraCICommands();
+
         /**
          * sends a single command via TraCI, expects no reply, returns true if successful
          */
@@ -307,6 +435,27 @@ class INET_API TraCIScenarioManager : public cSimpleModule
          */
         std::string receiveTraCIMessage();
 
+        /**
+         * receives a message via TraCI into the given buffer (and strips the header)
+         */
+        void receiveTraCIMessage(std::vector<char>& buf);
+
+        /**
+         * reads a status response, and raises an error if it is not RTYPE_OK, unless optional is set;
+         * returns whether it is RTYPE_OK
+         */
+        bool readStatusResponse(TraCIReader& buf, uint8_t commandId, bool optional = false, std::string* errorMsg = 0);
+
+        /**
+         * receives a message into the next free receive buffer, and returns a reader for it
+         */
+        TraCIReader receiveTraCIResponse();
+
+        /**
+         * reads the responses to the given queued commands
+         */
+        void processQueuedResponses(TraCIReader& buf, const std::vector<QueuedCommand>& commands);
+
         /**
          * commonly employed technique to get string values via TraCI
          */
@@ -336,11 +485,11 @@ class INET_API TraCIScenarioManager : public cSimpleModule
          */
         double omnet2traciAngle(double angle) const;
 
-        void subscribeToVehicleVariables(std::string vehicleId);
-        void unsubscribeFromVehicleVariables(std::string vehicleId);
-        void processSimSubscription(std::string objectId, TraCIBuffer& buf);
-        void processVehicleSubscription(std::string objectId, TraCIBuffer& buf);
-        void processSubcriptionResult(TraCIBuffer& buf);
+        void subscribeToVehicleVariables(const std::string& vehicleId);
+        void unsubscribeFromVehicleVariables(const std::string& vehicleId);
+        void processSimSubscription(const std::string& objectId, TraCIReader& buf);
+        void processVehicleSubscription(const std::string& objectId, TraCIReader& buf);
+        void processSubcriptionResult(TraCIReader& buf);
 };
 
 template<> void TraCIScenarioManager::TraCIBuffer::write(std::string inv);
@@ -0,0 +1,11 @@
+#!/bin/sh
+#
+# Measures the time steps per second of TraCIScenarioManager against the mock
+# TraCI server, which prints the number of steps, messages and commands.
+# Arguments are passed to the mock server, e.g. "-n 1000" for 1000 vehicles.
+#
+
+python ../../etc/traci-mockserver.py -p 9998 "$@" &
+sleep 1
+opp_run -l../../src/inet -n"../../src;." -u Cmdenv -c Benchmark -r 0 > /dev/null
+wait